@@ -4,6 +4,10 @@
 #include "../telemetry_tasks/ClockTask.h"
 #include "../telemetry_tasks/FilesystemTask.h"
 #include "../telemetry_tasks/ImuTask.h"
+#include "../telemetry_tasks/GpsTask.h"
+#include "../telemetry_tasks/PowerTask.h"
+#include "../os/instrumentation.h"
+#include "../os/trace.h"
 
 namespace Cesium {
 
@@ -11,6 +15,8 @@ size_t PacketBroker::routed_packets = 0;
 
 Topic PacketBroker::route_packet(BasePacket &packet)
 {
+    PROBE_SCOPE("PacketBroker::route_packet");
+    TRACE_SCOPE("PacketBroker::route_packet");
     Topic topic = (Topic)packet.get_topic();
     switch(topic) {
     case Topic::SYSTEM_STATUS:
@@ -18,6 +24,11 @@ Topic PacketBroker::route_packet(BasePacket &packet)
         SystemStatusTask::route_packet(packet);
         break;
 
+    case Topic::POWER:
+        DEBUG("Received Power Packet - ");
+        PowerTask::route_packet(packet);
+        break;
+
     case Topic::CLOCK:
         DEBUG("Received Clock Packet - ");
         ClockTask::route_packet(packet);
@@ -28,6 +39,11 @@ Topic PacketBroker::route_packet(BasePacket &packet)
         FilesystemTask::route_packet(packet);
         break;
 
+    case Topic::GPS:
+        DEBUG("Received GPS Packet - ");
+        GpsTask::route_packet(packet);
+        break;
+
     case Topic::IMU:
         DEBUG("Received IMU Packet - ");
         ImuTask::route_packet(packet);
@@ -103,5 +103,12 @@ public:
     
 };
 
+// Appends raw (little-endian) bytes of value to a packet payload
+template <typename T>
+inline void append_bytes(std::vector<uint8_t>& buffer, const T& value)
+{
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), src, src + sizeof(T));
+}
 
 } // namespace Cesium
\ No newline at end of file
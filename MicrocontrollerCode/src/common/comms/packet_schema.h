@@ -40,6 +40,7 @@ enum class SystemStatusCMD {
     MCU_STATS = 5,
     SYSTEM_UPDATE = 6,
     SUM = 7,
+    TRACE_DUMP = 8,
     NOT_IMPLEMENTED = 15
 };
 
@@ -2,6 +2,8 @@
 #include "PacketBroker.h" //Importing PacketBroker
 
 #include "../telemetry_tasks/SystemStatusTask.h" // ACK
+#include "../os/instrumentation.h"
+#include "../os/trace.h"
 namespace Cesium {
 
 MockSerial* SerialComms::mock_port = nullptr;
@@ -9,6 +11,8 @@ MockSerial* SerialComms::mock_port = nullptr;
 SerialComms::SerialComms() {}
 
 void SerialComms::emit(std::vector<uint8_t> vec, CommsInterface interface) {
+    PROBE_SCOPE("SerialComms::emit");
+    TRACE_SCOPE("SerialComms::emit");
 
     switch(interface) {
 
@@ -26,6 +30,8 @@ void SerialComms::emit(std::vector<uint8_t> vec, CommsInterface interface) {
 
 void SerialComms::emit(String str, CommsInterface interface)
 {
+    PROBE_SCOPE("SerialComms::emit");
+    TRACE_SCOPE("SerialComms::emit");
     switch(interface) {
 
     case SERIAL_UART:
@@ -38,10 +44,14 @@ void SerialComms::emit(String str, CommsInterface interface)
 }
 
 void SerialComms::emit_packet(BasePacket& packet, CommsInterface interface) {
+    PROBE_SCOPE("SerialComms::emit_packet");
+    TRACE_SCOPE("SerialComms::emit_packet");
     emit(packet.get_packet(), interface);
 }
 
 void SerialComms::process_uart() {
+    PROBE_SCOPE("SerialComms::process_uart");
+    TRACE_SCOPE("SerialComms::process_uart");
     String message = Serial.readStringUntil(0x00);
 
     for (auto char_str : message) {
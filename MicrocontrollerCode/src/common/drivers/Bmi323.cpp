@@ -1,8 +1,11 @@
 #include "Bmi323.h"
 #include "../globals.h"
+#include "../../config/ConfigReader.h"
 extern "C" {
 #include "bosch_bmi3.h"
 }
+#include "../os/instrumentation.h"
+#include "../os/trace.h"
 
 namespace Cesium {
 namespace Sensor {
@@ -41,18 +44,42 @@ bool Bmi323::zero_structs()
     memset(&sensor_data, 0, sizeof(sensor_data));
     memset(&config, 0, sizeof(config));
 
+    // 8 g and 2000 dps, matching setup()
+    accel_mps2_per_lsb = lsb_to_mps2(1, BMI3_ACC_8G, 16);
+    w_rps_per_lsb = lsb_to_rps(1, 2000, 16);
+
+    fifo_sensortime_ticks = 0;
+    last_sensortime = 0;
+    fifo_time_valid = false;
+
+    spi_bus = nullptr;
+    spi_device = SpiBus::INVALID_DEVICE;
+
     return true;
 }
 
 
 bool Bmi323::configure(const char *config_name)
 {
-    // TODO: Add configuration JSON
-    return false;
+    JsonDocument config;
+    RETURN_FALSE_IF_FALSE(File::json_open(config_name, config));
+
+    Matrix3<float> R_body_to_sensor;
+    RETURN_FALSE_IF_FALSE(File::json_extract_body_to_sensor(config, R_body_to_sensor));
+    set_rotation_matrix(R_body_to_sensor);
+
+    Matrix3<float> R_sensor_to_body = transpose(R_body_to_sensor);
+    RETURN_FALSE_IF_FALSE(File::json_extract_calibration(config, "acceleration", R_sensor_to_body, accel_calibration));
+    RETURN_FALSE_IF_FALSE(File::json_extract_calibration(config, "gyroscope", R_sensor_to_body, gyro_calibration));
+
+    return true;
 }
 bool Bmi323::setup()
 {
-    pinMode(_cs_pin, OUTPUT);
+    // The IDF driver drives CS itself once the bus is attached
+    if (spi_bus == nullptr) {
+        pinMode(_cs_pin, OUTPUT);
+    }
 
     uint16_t buff;
     readReg(0, &buff, 0);
@@ -63,9 +90,9 @@ bool Bmi323::setup()
     - No averaging: 0x0000
     - Filtering to ODR/2: 0x0000
     - Range 8g: 0x0020
-    - ODR 50Hz: 0x0007
+    - ODR 800Hz: 0x000B (same as the gyro so every FIFO frame has fresh accel data)
     */
-    uint16_t buff_acc[1] = {0x4027};
+    uint16_t buff_acc[1] = {0x402B};
     writeReg(BMI3_REG_ACC_CONF, buff_acc, 1);
 
 
@@ -86,8 +113,13 @@ bool Bmi323::setup()
 }
 bool Bmi323::read()
 {
-    readAccelerometer((float*) &accel_mps2);
-    readGyroscope((float*) &w_rps);
+    PROBE_SCOPE("Bmi323::read");
+    TRACE_SCOPE("Bmi323::read");
+    SensorBase::read();
+
+    uint8_t data[DATA_BYTES];
+    RETURN_FALSE_IF_FALSE(readBurst(BMI3_REG_ACC_DATA_X, data, DATA_BYTES));
+    decode_data(data);
 
     DEBUG(accel_mps2[0][0]);
     DEBUG("\t");
@@ -105,6 +137,211 @@ bool Bmi323::read()
     return true;
 }
 
+void Bmi323::decode_data(const uint8_t *raw)
+{
+    int16_t words[DATA_BYTES / 2];
+    for (size_t i = 0; i < DATA_BYTES / 2; i++) {
+        words[i] = raw[2 * i] | ((uint16_t)raw[2 * i + 1] << 8);
+    }
+
+    for (size_t i = 0; i < 3; i++) {
+        accel_mps2[i][0] = words[i] * accel_mps2_per_lsb;
+        w_rps[i][0] = words[3 + i] * w_rps_per_lsb;
+    }
+
+    // 512 LSB/K, 0 = 23 C
+    temp_C = words[6] / 512.0f + 23.0f;
+
+    calibrate_accel();
+    calibrate_gyro();
+}
+
+////////////////////////////////////////////////////////////
+//                      SpiBus                            //
+////////////////////////////////////////////////////////////
+
+bool Bmi323::attach_spi_bus(SpiBus *bus)
+{
+    // Header plus the largest FIFO drain
+    spi_device = bus->add_device(_cs_pin, SPI_CLOCK_HZ, SPI_MODE0, 2 + sizeof(fifo_buffer));
+    RETURN_FALSE_IF_FALSE(spi_device != SpiBus::INVALID_DEVICE);
+
+    spi_bus = bus;
+    return true;
+}
+
+bool Bmi323::plan_read(bool *completed)
+{
+    if (spi_bus == nullptr) {
+        return false;
+    }
+
+    const uint8_t header[2] = {BMI3_SPI_RD_MASK | BMI3_REG_ACC_DATA_X, 0};
+    return spi_bus->plan_read(spi_device, header, sizeof(header), DATA_BYTES, planned_read_done, this, completed);
+}
+
+void Bmi323::planned_read_done(void *context, const uint8_t *rx, size_t len, uint64_t start_us)
+{
+    Bmi323* bmi323 = (Bmi323*)context;
+    bmi323->decode_data(rx);
+    bmi323->stamp_sample(start_us);
+}
+
+bool Bmi323::enable_drdy_interrupt()
+{
+    // INT2 active high, push-pull, output enabled
+    uint16_t io_int_ctrl[1] = {0};
+    RETURN_FALSE_IF_FALSE(readReg(BMI3_REG_IO_INT_CTRL, io_int_ctrl, 1));
+    io_int_ctrl[0] = (io_int_ctrl[0] & ~BMI3_INT2_OD_MASK) | BMI3_INT2_LVL_MASK | BMI3_INT2_OUTPUT_EN_MASK;
+    RETURN_FALSE_IF_FALSE(writeReg(BMI3_REG_IO_INT_CTRL, io_int_ctrl, 1));
+
+    // Gyro runs at the same ODR as the accel, so its DRDY covers both
+    uint16_t int_map2[1] = {0};
+    RETURN_FALSE_IF_FALSE(readReg(BMI3_REG_INT_MAP2, int_map2, 1));
+    int_map2[0] = (int_map2[0] & ~BMI3_GYR_DRDY_INT_MASK) | (BMI3_INT2 << BMI3_GYR_DRDY_INT_POS);
+    RETURN_FALSE_IF_FALSE(writeReg(BMI3_REG_INT_MAP2, int_map2, 1));
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////
+//                         FIFO                           //
+////////////////////////////////////////////////////////////
+
+bool Bmi323::configure_fifo(uint16_t watermark_frames)
+{
+    fifo_watermark_frames = watermark_frames;
+
+    // Headerless frames with every source. Oldest frames are overwritten when full
+    uint16_t fifo_conf[1] = {BMI3_FIFO_ACC_EN | BMI3_FIFO_GYR_EN | BMI3_FIFO_TEMP_EN | BMI3_FIFO_TIME_EN};
+    RETURN_FALSE_IF_FALSE(writeReg(BMI3_REG_FIFO_CONF, fifo_conf, 1));
+
+    uint16_t watermark_words[1] = {(uint16_t)std::min((size_t)watermark_frames * FIFO_FRAME_WORDS, (size_t)BMI3_FIFO_WATERMARK_MASK)};
+    RETURN_FALSE_IF_FALSE(writeReg(BMI3_REG_FIFO_WATERMARK, watermark_words, 1));
+
+    // INT1 active high, push-pull, output enabled
+    uint16_t io_int_ctrl[1] = {0};
+    RETURN_FALSE_IF_FALSE(readReg(BMI3_REG_IO_INT_CTRL, io_int_ctrl, 1));
+    io_int_ctrl[0] = (io_int_ctrl[0] & ~BMI3_INT1_OD_MASK) | BMI3_INT1_LVL_MASK | BMI3_INT1_OUTPUT_EN_MASK;
+    RETURN_FALSE_IF_FALSE(writeReg(BMI3_REG_IO_INT_CTRL, io_int_ctrl, 1));
+
+    // Watermark interrupt on INT1, leaving the other mappings alone
+    uint16_t int_map2[1] = {0};
+    RETURN_FALSE_IF_FALSE(readReg(BMI3_REG_INT_MAP2, int_map2, 1));
+    int_map2[0] = (int_map2[0] & ~BMI3_FIFO_WATERMARK_INT_MASK) | (BMI3_INT1 << BMI3_FIFO_WATERMARK_INT_POS);
+    RETURN_FALSE_IF_FALSE(writeReg(BMI3_REG_INT_MAP2, int_map2, 1));
+
+    return flush_fifo();
+}
+
+bool Bmi323::flush_fifo()
+{
+    uint16_t fifo_ctrl[1] = {BMI3_FIFO_FLUSH_MASK};
+    RETURN_FALSE_IF_FALSE(writeReg(BMI3_REG_FIFO_CTRL, fifo_ctrl, 1));
+
+    fifo_time_valid = false;
+    fifo_frames_read = 0;
+    fifo_frames_skipped = 0;
+
+    return true;
+}
+
+size_t Bmi323::get_fifo_frames()
+{
+    uint16_t fill_level[1] = {0};
+    readReg(BMI3_REG_FIFO_FILL_LEVEL, fill_level, 1);
+
+    return (fill_level[0] & BMI3_FIFO_FILL_LEVEL_MASK) / FIFO_FRAME_WORDS;
+}
+
+size_t Bmi323::read_fifo(ImuFifoSample *samples, size_t max_samples)
+{
+    PROBE_SCOPE("Bmi323::read_fifo");
+    TRACE_SCOPE("Bmi323::read_fifo");
+
+    size_t frames = std::min(get_fifo_frames(), max_samples);
+    frames = std::min(frames, sizeof(fifo_buffer) / FIFO_FRAME_BYTES);
+
+    if (frames == 0) {
+        return 0;
+    }
+
+    // Only whole frames are read, a partially read frame would be sent again
+    RETURN_WITH_CODE_IF_FALSE(0, readBurst(BMI3_REG_FIFO_DATA, fifo_buffer, frames * FIFO_FRAME_BYTES));
+
+    size_t decoded = decode_fifo(fifo_buffer, frames, samples);
+
+    // Newest sample also updates the single-sample outputs, before the block is moved to the body frame
+    if (decoded > 0) {
+        const ImuFifoSample& newest = samples[decoded - 1];
+        for (size_t i = 0; i < 3; i++) {
+            accel_mps2[i][0] = newest.accel_mps2[i];
+            w_rps[i][0] = newest.w_rps[i];
+        }
+        temp_C = newest.temp_C;
+        calibrate_accel();
+        calibrate_gyro();
+        SensorBase::read();
+
+        uint8_t* block = reinterpret_cast<uint8_t*>(samples);
+        accel_calibration.apply_batch(block, offsetof(ImuFifoSample, accel_mps2), sizeof(ImuFifoSample), decoded);
+        gyro_calibration.apply_batch(block, offsetof(ImuFifoSample, w_rps), sizeof(ImuFifoSample), decoded);
+    }
+
+    return decoded;
+}
+
+size_t Bmi323::decode_fifo(const uint8_t *raw, size_t frames, ImuFifoSample *samples)
+{
+    size_t decoded = 0;
+
+    for (size_t i = 0; i < frames; i++) {
+        const uint8_t* frame = raw + i * FIFO_FRAME_BYTES;
+
+        uint16_t words[FIFO_FRAME_WORDS];
+        for (size_t j = 0; j < FIFO_FRAME_WORDS; j++) {
+            words[j] = frame[2 * j] | ((uint16_t)frame[2 * j + 1] << 8);
+        }
+
+        // Sensor wasn't ready when the frame was written
+        if (words[0] == BMI3_FIFO_ACCEL_DUMMY_FRAME || words[3] == BMI3_FIFO_GYRO_DUMMY_FRAME) {
+            fifo_frames_skipped++;
+            continue;
+        }
+
+        uint16_t sensortime = words[7];
+        if (!fifo_time_valid) {
+            fifo_sensortime_ticks = sensortime;
+            fifo_time_valid = true;
+        } else {
+            fifo_sensortime_ticks += (uint16_t)(sensortime - last_sensortime);
+        }
+        last_sensortime = sensortime;
+
+        ImuFifoSample& sample = samples[decoded];
+
+        // 39.0625 us = 625 / 16 us, exact in integers
+        sample.time_us = fifo_sensortime_ticks * 625 / 16;
+
+        for (size_t j = 0; j < 3; j++) {
+            sample.accel_mps2[j] = (int16_t)words[j] * accel_mps2_per_lsb;
+            sample.w_rps[j] = (int16_t)words[3 + j] * w_rps_per_lsb;
+        }
+
+        // 512 LSB/K, 0 = 23 C
+        sample.temp_C = words[6] == BMI3_FIFO_TEMP_DUMMY_FRAME ? NAN : (int16_t)words[6] / 512.0f + 23.0f;
+
+        for (size_t j = 0; j < 3; j++) {
+            sample.B_uT[j] = NAN;
+        }
+
+        decoded++;
+        fifo_frames_read++;
+    }
+
+    return decoded;
+}
+
 bool Bmi323::read_chip_id()
 {
     uint16_t buffer[1] = {0};
@@ -136,9 +373,9 @@ bool Bmi323::readGyroscope(float& x, float& y, float& z) {
 
     readReg(BMI3_REG_GYR_DATA_X, buffer, 3);
 
-    x = lsb_to_dps(buffer[0], 2000, 16);
-    y = lsb_to_dps(buffer[1], 2000, 16);
-    z = lsb_to_dps(buffer[2], 2000, 16);
+    x = lsb_to_rps(buffer[0], 2000, 16);
+    y = lsb_to_rps(buffer[1], 2000, 16);
+    z = lsb_to_rps(buffer[2], 2000, 16);
 
     return true;
 }
@@ -163,15 +400,23 @@ bool Bmi323::readGyroscope(float *buff)
 
     readReg(BMI3_REG_GYR_DATA_X, buffer, 3);
 
-    buff[0] = lsb_to_dps(buffer[0], 2000, 16);
-    buff[1] = lsb_to_dps(buffer[1], 2000, 16);
-    buff[2] = lsb_to_dps(buffer[2], 2000, 16);
+    buff[0] = lsb_to_rps(buffer[0], 2000, 16);
+    buff[1] = lsb_to_rps(buffer[1], 2000, 16);
+    buff[2] = lsb_to_rps(buffer[2], 2000, 16);
 
     return true;
 }
 
 bool Bmi323::readReg(uint8_t reg, uint16_t *buffer, size_t len)
 {
+    if (spi_bus != nullptr) {
+        const uint8_t header[2] = {(uint8_t)(BMI3_SPI_RD_MASK | reg), 0};
+        RETURN_FALSE_IF_FALSE(spi_bus->read(spi_device, header, sizeof(header), (uint8_t*)buffer, len * 2));
+
+        // Little-endian on the wire and in memory, nothing to swap
+        return true;
+    }
+
     digitalWrite(_cs_pin, LOW);
     _spi_instance->beginTransaction(settings);
 
@@ -190,8 +435,43 @@ bool Bmi323::readReg(uint8_t reg, uint16_t *buffer, size_t len)
     return true;
 }
 
+bool Bmi323::readBurst(uint8_t reg, uint8_t *buffer, size_t len)
+{
+    if (spi_bus != nullptr) {
+        const uint8_t header[2] = {(uint8_t)(BMI3_SPI_RD_MASK | reg), 0};
+        return spi_bus->read(spi_device, header, sizeof(header), buffer, len);
+    }
+
+    digitalWrite(_cs_pin, LOW);
+    _spi_instance->beginTransaction(settings);
+
+    _spi_instance->write(BMI3_SPI_RD_MASK | reg);
+    _spi_instance->write(0); // Dummy byte
+
+    // FIFO_DATA auto-increments within itself, so this streams frames back to back
+    _spi_instance->transferBytes(nullptr, buffer, len);
+
+    _spi_instance->endTransaction();
+
+    digitalWrite(_cs_pin, HIGH);
+
+    return true;
+}
+
 bool Bmi323::writeReg(uint8_t reg, const uint16_t *buffer, size_t len)
 {
+    if (spi_bus != nullptr) {
+        uint8_t tx[1 + 2 * MAX_WRITE_WORDS];
+        RETURN_FALSE_IF_FALSE(len <= MAX_WRITE_WORDS);
+
+        tx[0] = BMI3_SPI_WR_MASK & reg;
+        for (size_t i = 0; i < len; i++) {
+            tx[1 + 2 * i] = buffer[i] & 0xFF;
+            tx[2 + 2 * i] = (buffer[i] >> 8) & 0xFF;
+        }
+        return spi_bus->write(spi_device, tx, 1 + 2 * len);
+    }
+
     digitalWrite(_cs_pin, LOW);
     _spi_instance->beginTransaction(settings);
 
@@ -10,6 +10,8 @@
 
 #include "sensor_bases/AccelerometerBase.h"
 #include "sensor_bases/GyroscopeBase.h"
+#include "sensor_bases/ImuFifoBase.h"
+#include "../os/spi_bus.h"
 
 #include "arduino_bmi323.h"
 extern "C" {
@@ -23,7 +25,18 @@ extern "C" {
 namespace Cesium {
 namespace Sensor {
 
-class Bmi323 : public AccelerometerBase, public GyroscopeBase {
+class Bmi323 : public AccelerometerBase, public GyroscopeBase, public ImuFifoBase {
+
+public:
+    // Headerless FIFO frame with every source enabled: accel xyz, gyro xyz, temperature, sensortime (16-bit words)
+    static constexpr size_t FIFO_FRAME_WORDS = 8;
+    static constexpr size_t FIFO_FRAME_BYTES = FIFO_FRAME_WORDS * 2;
+    static constexpr size_t FIFO_CAPACITY_WORDS = 1024;
+    static constexpr float SENSORTIME_US = 39.0625f;
+
+    // ACC_DATA_X through TEMP_DATA, one burst per sample
+    static constexpr size_t DATA_BYTES = 14;
+    static constexpr uint32_t SPI_CLOCK_HZ = 10000000;
 
 private:
     // BMI323 lower-level driver structs
@@ -38,9 +51,28 @@ private:
     SPIClass* spi_instance;
     SPISettings settings;
 
+    // Scale factors for the ranges set in setup()
+    float accel_mps2_per_lsb;
+    float w_rps_per_lsb;
 
+    // FIFO sensortime is the low 16 bits of the 39.0625 us sensor clock, unwrapped here
+    uint64_t fifo_sensortime_ticks;
+    uint16_t last_sensortime;
+    bool fifo_time_valid;
+
+    uint8_t fifo_buffer[FIFO_CAPACITY_WORDS * 2];
+
+    // Set by attach_spi_bus(), register access then goes through the IDF driver instead of SPIClass
+    SpiBus* spi_bus;
+    uint8_t spi_device;
+    static constexpr size_t MAX_WRITE_WORDS = 16;
 
     bool zero_structs();
+
+    static void planned_read_done(void* context, const uint8_t* rx, size_t len, uint64_t start_us);
+
+    // Whole transfer in one chip-select assertion
+    bool readBurst(uint8_t reg, uint8_t* buffer, size_t len);
 public:
     Bmi323();
 
@@ -52,6 +84,13 @@ public:
     bool setup();
     bool read();
 
+    // The CS pin moves to the bus's hardware CS
+    bool attach_spi_bus(SpiBus* bus);
+    bool plan_read(bool* completed = nullptr);
+
+    // Decodes a DATA_BYTES burst into accel_mps2, w_rps and temp_C
+    void decode_data(const uint8_t* raw);
+
     // Helper functions
     bool readAccelerometer(float& x, float& y, float& z);
     bool readGyroscope(float& x, float& y, float& z);
@@ -64,6 +103,19 @@ public:
     bool writeReg(uint8_t reg, const uint16_t *buffer, size_t len);
     bool read_chip_id();
 
+    // Gyro data ready on INT2, INT1 carries the FIFO watermark
+    bool enable_drdy_interrupt();
+
+    // FIFO
+    bool configure_fifo(uint16_t watermark_frames); // Also maps the watermark interrupt to INT1
+    bool flush_fifo();
+    size_t get_fifo_frames();
+    size_t get_fifo_capacity_frames() const {return FIFO_CAPACITY_WORDS / FIFO_FRAME_WORDS;}
+    size_t read_fifo(ImuFifoSample* samples, size_t max_samples);
+
+    // Decodes raw frames (as read from FIFO_DATA) into calibrated samples, skipping dummy frames
+    size_t decode_fifo(const uint8_t* raw, size_t frames, ImuFifoSample* samples);
+
     float lsb_to_mps2(int16_t val, int8_t g_range, uint8_t bit_width);
     float lsb_to_dps(int16_t val, float dps, uint8_t bit_width);
     float lsb_to_rps(int16_t val, float dps, uint8_t bit_width);
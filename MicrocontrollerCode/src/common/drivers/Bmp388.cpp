@@ -1,16 +1,24 @@
 #include "Bmp388.h"
 #include "../globals.h"
+#include "../math/fast_math.h"
+#include "../os/instrumentation.h"
+#include "../os/trace.h"
+#include <esp_timer.h>
 
 namespace Cesium {
 namespace Sensor {
 
 Bmp388::Bmp388()
+    : dev{}
+    , cs_pin{0}
+    , settings(SPI_CLOCK_HZ, MSBFIRST, SPI_MODE0)
+    , state{ConversionState::IDLE}
 {
-
     temp_C = 0;
 }
 
 Bmp388::Bmp388(uint8_t cs_pin, SPIClass * spi_instance)
+    : Bmp388()
 {
     _spi_instance = spi_instance;
     interface = Interfaces::SPI;
@@ -29,9 +37,18 @@ bool Bmp388::configure(const char * config_name)
 
 bool Bmp388::setup()
 {
-    DEBUGLN("BRUH");
+    pinMode(cs_pin, OUTPUT);
+    digitalWrite(cs_pin, HIGH);
+
+    dev.intf = BMP3_SPI_INTF;
+    dev.intf_ptr = this;
+    dev.read = spi_read;
+    dev.write = spi_write;
+    dev.delay_us = delay_us;
+
+    // Chip ID, soft reset and calibration
     size_t retries = 0;
-    while(!device.begin_SPI(cs_pin, _spi_instance)) {
+    while (bmp3_init(&dev) != BMP3_OK) {
         retries++;
 
         if (retries >= 300) {
@@ -42,35 +59,126 @@ bool Bmp388::setup()
         delay(10);
     }
 
-    device.setTemperatureOversampling(BMP3_OVERSAMPLING_8X);
-    device.setPressureOversampling(BMP3_OVERSAMPLING_4X);
-    device.setIIRFilterCoeff(BMP3_IIR_FILTER_COEFF_3);
-    device.setOutputDataRate(BMP3_ODR_50_HZ);
+    // Forced mode only, so no ODR
+    dev.settings.press_en = BMP3_ENABLE;
+    dev.settings.temp_en = BMP3_ENABLE;
+    dev.settings.odr_filter.temp_os = BMP3_OVERSAMPLING_8X;
+    dev.settings.odr_filter.press_os = BMP3_OVERSAMPLING_4X;
+    dev.settings.odr_filter.iir_filter = BMP3_IIR_FILTER_COEFF_3;
+
+    uint16_t selected = BMP3_SEL_PRESS_EN | BMP3_SEL_TEMP_EN | BMP3_SEL_PRESS_OS | BMP3_SEL_TEMP_OS | BMP3_SEL_IIR_FILTER;
+    RETURN_FALSE_IF_FALSE(bmp3_set_sensor_settings(selected, &dev) == BMP3_OK);
+
+    state = ConversionState::IDLE;
     return true;
 }
 
 bool Bmp388::read()
 {
-    DEBUGLN("BRUH");
-    if (! device.performReading()) {
-        DEBUG("Failed to perform reading on BMI388");
+    PROBE_SCOPE("Bmp388::read");
+    TRACE_SCOPE("Bmp388::read");
+
+    if (state == ConversionState::IDLE) {
+        if (sample_due()) {
+            last_sample_start_us = esp_timer_get_time();
+            start_conversion();
+        }
         return false;
     }
-    else {
-        temp_C = device.temperature;
-        pressure_kPa = device.pressure / 1000.0;
-        altitude_m = device.readAltitude(_sea_level_pressure_hPa);
+
+    if (!conversion_elapsed()) {
+        return false;
     }
+    state = ConversionState::IDLE;
+
+    // Pressure and temperature come from the same measurement, so temperature can't be skipped here
+    struct bmp3_data data = {};
+    if (bmp3_get_sensor_data(BMP3_PRESS | BMP3_TEMP, &data, &dev) != BMP3_OK) {
+        DEBUG("Failed to perform reading on BMP388");
+        return false;
+    }
+
+    temp_C = data.temperature;
+    pressure_kPa = data.pressure / 1000.0;
+    altitude_m = HotMath::baro_altitude(data.pressure / 100.0f / _sea_level_pressure_hPa, 0.1903f, 44330.0f);
+
+    stamp_sample(conversion_start_us + conversion_time_us / 2);
+
+    // Next one right away if the interval is already up
+    if (sample_due()) {
+        last_sample_start_us = esp_timer_get_time();
+        start_conversion();
+    }
+
     return true;
 }
 
+bool Bmp388::start_conversion()
+{
+    // Pressure and temperature enabled, forced mode. Back to sleep on its own when done
+    uint8_t reg = BMP3_REG_PWR_CTRL;
+    uint8_t pwr_ctrl = BMP3_ENABLE | (BMP3_ENABLE << 1) | (BMP3_MODE_FORCED << 4);
+    RETURN_FALSE_IF_FALSE(bmp3_set_regs(&reg, &pwr_ctrl, 1, &dev) == BMP3_OK);
 
+    conversion_started(measurement_time_us());
+    state = ConversionState::CONVERTING;
 
+    return true;
+}
+
+uint32_t Bmp388::measurement_time_us() const
+{
+    uint32_t time_us = 234;
+    time_us += 392 + (1UL << dev.settings.odr_filter.press_os) * 2020;
+    time_us += 163 + (1UL << dev.settings.odr_filter.temp_os) * 2020;
+    return time_us;
+}
+
+////////////////////////////////////////////////////////////
+//                   Bosch API callbacks                  //
+////////////////////////////////////////////////////////////
+
+// The API has already set the read bit and strips its own dummy byte
+BMP3_INTF_RET_TYPE Bmp388::spi_read(uint8_t reg_addr, uint8_t *data, uint32_t len, void *intf_ptr)
+{
+    Bmp388* bmp388 = (Bmp388*)intf_ptr;
+
+    digitalWrite(bmp388->cs_pin, LOW);
+    bmp388->_spi_instance->beginTransaction(bmp388->settings);
+
+    bmp388->_spi_instance->transfer(reg_addr);
+    bmp388->_spi_instance->transferBytes(nullptr, data, len);
 
+    bmp388->_spi_instance->endTransaction();
+    digitalWrite(bmp388->cs_pin, HIGH);
 
+    return BMP3_OK;
+}
+
+// Multi-register writes arrive as data0, addr1, data1, ... after reg_addr
+BMP3_INTF_RET_TYPE Bmp388::spi_write(uint8_t reg_addr, const uint8_t *data, uint32_t len, void *intf_ptr)
+{
+    Bmp388* bmp388 = (Bmp388*)intf_ptr;
 
+    digitalWrite(bmp388->cs_pin, LOW);
+    bmp388->_spi_instance->beginTransaction(bmp388->settings);
+
+    bmp388->_spi_instance->transfer(reg_addr);
+    for (uint32_t i = 0; i < len; i++) {
+        bmp388->_spi_instance->transfer(data[i]);
+    }
 
+    bmp388->_spi_instance->endTransaction();
+    digitalWrite(bmp388->cs_pin, HIGH);
 
+    return BMP3_OK;
+}
+
+// Only used by the API during setup (soft reset)
+void Bmp388::delay_us(uint32_t period, void *intf_ptr)
+{
+    delayMicroseconds(period);
+}
 
 } // namespace Sensor
 } // namespace Cesium
\ No newline at end of file
@@ -5,36 +5,61 @@
 // PURPOSE: Driver code for BMP 388
 
 #include <Arduino.h>
-#include <Adafruit_BMP3XX.h>
 #include <SPI.h>
 #include "../math/vector.h"
 
 #include "sensor_bases/BarometerBase.h"
 
+#include "bmp3.h"
+
 namespace Cesium {
 namespace Sensor {
 
 class Bmp388 : public BarometerBase {
+public:
+    static constexpr uint32_t SPI_CLOCK_HZ = 1000000;
+
+    enum class ConversionState : uint8_t {
+        IDLE,
+        CONVERTING
+    };
+
 private:
-    Adafruit_BMP3XX device;
+    // Bosch API with our own SPI callbacks, for calibration and compensation only
+    struct bmp3_dev dev;
 
     uint8_t cs_pin;
+    SPISettings settings;
+
+    ConversionState state;
 
     float _sea_level_pressure_hPa = 1016.30;
 
+    // Forced-mode measurement time for the current oversampling, datasheet section 3.9.2
+    uint32_t measurement_time_us() const;
+    bool start_conversion();
+
+    static BMP3_INTF_RET_TYPE spi_read(uint8_t reg_addr, uint8_t* data, uint32_t len, void* intf_ptr);
+    static BMP3_INTF_RET_TYPE spi_write(uint8_t reg_addr, const uint8_t* data, uint32_t len, void* intf_ptr);
+    static void delay_us(uint32_t period, void* intf_ptr);
+
 public:
 
     Bmp388();
     Bmp388(uint8_t cs_pin, SPIClass* spi_instance);
-    
+
     void set_sea_level_pressure(float sea_level_pressure_hPa);
     bool configure(const char* config_name);
     bool setup();
+
+    // Non-blocking. Triggers a forced measurement and reads it once it is done,
+    // true when a new sample was compensated
     bool read();
 
+    inline ConversionState get_state() const {return state;}
 };
 
 
 
 } // namespace Sensor
-} // namespace Cesium
\ No newline at end of file
+} // namespace Cesium
@@ -1,14 +1,25 @@
 #include "Ms5607.h"
 #include "../globals.h"
+#include "../math/fast_math.h"
+#include "../os/instrumentation.h"
+#include "../os/trace.h"
+#include <esp_timer.h>
 
 namespace Cesium {
 namespace Sensor {
 
-Ms5607::Ms5607(uint8_t cs_pin, SPIClass *spi_instance) : P_offsets{}
+Ms5607::Ms5607(uint8_t cs_pin, SPIClass *spi_instance)
+    : settings(SPI_CLOCK_HZ, MSBFIRST, SPI_MODE0)
+    , spi_bus{nullptr}
+    , spi_device{SpiBus::INVALID_DEVICE}
+    , prom{}
+    , state{ConversionState::IDLE}
+    , D1{0}
+    , D2{0}
+    , have_D2{false}
+    , pressures_since_D2{0}
+    , P_offsets{}
 {
-    device.setCSpin(cs_pin);
-    device.setSPIport(spi_instance);
-
     this->_spi_instance = spi_instance;
     this->interface = Interfaces::SPI;
     this->_cs_pin = cs_pin;
@@ -39,47 +50,232 @@ void Ms5607::set_P_offsets(float a, float b)
 
 bool Ms5607::setup()
 {
-    if (device.begin())
-    {
-        DEBUG("MS5607 found: ");
-        // DEBUGLN(ms5607.getDeviceID(), HEX);
+    // The IDF driver drives CS itself once the bus is attached
+    if (spi_bus == nullptr) {
+        pinMode(_cs_pin, OUTPUT);
+        digitalWrite(_cs_pin, HIGH);
     }
-    else {
-        DEBUG("MS5607 not found");
+
+    // Reloads the PROM, 2.8 ms
+    RETURN_FALSE_IF_FALSE(command(MS5607_CMD_RESET));
+    delay(3);
+
+    if (!read_prom()) {
+        DEBUGLN("MS5607 not found");
         return false;
     }
+    DEBUGLN("MS5607 found");
 
-    if (device.reset(1))
-    {
-        DEBUGLN("Conversion set to MS5607");
-    }
-    
+    state = ConversionState::IDLE;
+    have_D2 = false;
+    pressures_since_D2 = 0;
+
+    return true;
+}
+
+bool Ms5607::attach_spi_bus(SpiBus *bus)
+{
+    spi_device = bus->add_device(_cs_pin, SPI_CLOCK_HZ, SPI_MODE0, 4);
+    RETURN_FALSE_IF_FALSE(spi_device != SpiBus::INVALID_DEVICE);
+
+    spi_bus = bus;
     return true;
 }
 
 bool Ms5607::read()
 {
-    if (device.read() != MS5611_READ_OK) {
+    PROBE_SCOPE("Ms5607::read");
+    TRACE_SCOPE("Ms5607::read");
+
+    bool new_sample = false;
+    uint64_t pressure_mid_us = 0;
+
+    if (state != ConversionState::IDLE) {
+        if (!conversion_elapsed()) {
+            return false;
+        }
+
+        ConversionState finished = state;
+        state = ConversionState::IDLE;
+
+        // 0 means the conversion was cut short, just start over
+        uint32_t raw = 0;
+        if (!read_adc(raw) || raw == 0) {
+            return false;
+        }
+
+        if (finished == ConversionState::TEMPERATURE) {
+            D2 = raw;
+            have_D2 = true;
+            pressures_since_D2 = 0;
+        } else {
+            D1 = raw;
+            pressures_since_D2++;
+            new_sample = have_D2;
+
+            // Middle of the conversion, before the next one overwrites the start time
+            pressure_mid_us = conversion_start_us + conversion_time_us / 2;
+        }
+    }
+
+    // Temperature whenever it is stale, pressure at read_interval_ms
+    if (!have_D2 || pressures_since_D2 >= TEMPERATURE_EVERY) {
+        start_conversion(ConversionState::TEMPERATURE);
+    } else if (sample_due()) {
+        last_sample_start_us = esp_timer_get_time();
+        start_conversion(ConversionState::PRESSURE);
+    }
+
+    if (!new_sample) {
+        return false;
+    }
+
+    compensate(D1, D2);
+    stamp_sample(pressure_mid_us);
+
+    return true;
+}
+
+bool Ms5607::start_conversion(ConversionState next)
+{
+    uint8_t cmd = (next == ConversionState::TEMPERATURE ? MS5607_CMD_CONVERT_D2 : MS5607_CMD_CONVERT_D1) | MS5607_OSR_4096;
+    RETURN_FALSE_IF_FALSE(command(cmd));
+
+    conversion_started(CONVERSION_TIME_US);
+    state = next;
+
+    return true;
+}
+
+void Ms5607::compensate(uint32_t d1, uint32_t d2)
+{
+    int64_t C1 = prom[1], C2 = prom[2], C3 = prom[3], C4 = prom[4], C5 = prom[5], C6 = prom[6];
+
+    // MS5607 scaling, the MS5611 uses different powers of two for OFF and SENS
+    int64_t dT = (int64_t)d2 - (C5 << 8);
+    int64_t TEMP = 2000 + dT * C6 / (1LL << 23);
+    int64_t OFF = (C2 << 17) + C4 * dT / (1LL << 6);
+    int64_t SENS = (C1 << 16) + C3 * dT / (1LL << 7);
+
+    // Second order, below 20 C
+    if (TEMP < 2000) {
+        int64_t T2 = dT * dT / (1LL << 31);
+        int64_t OFF2 = 61 * (TEMP - 2000) * (TEMP - 2000) / 16;
+        int64_t SENS2 = 2 * (TEMP - 2000) * (TEMP - 2000);
+
+        if (TEMP < -1500) {
+            OFF2 += 15 * (TEMP + 1500) * (TEMP + 1500);
+            SENS2 += 8 * (TEMP + 1500) * (TEMP + 1500);
+        }
+
+        TEMP -= T2;
+        OFF -= OFF2;
+        SENS -= SENS2;
+    }
+
+    // 0.01 C and Pa
+    int64_t P = ((int64_t)d1 * SENS / (1LL << 21) - OFF) / (1LL << 15);
+
+    temp_C = TEMP / 100.0f;
+    pressure_kPa = P / 1000.0f;
+    altitude_m = HotMath::baro_altitude(pressure_kPa / SEALEVELPRESSURE_KPA, t_grad * R / g, t0 / t_grad);
+}
+
+////////////////////////////////////////////////////////////
+//                        PROM                            //
+////////////////////////////////////////////////////////////
+
+bool Ms5607::read_prom()
+{
+    uint16_t words[PROM_WORDS];
+
+    for (size_t i = 0; i < PROM_WORDS; i++) {
+        uint8_t rx[2] = {0};
+        RETURN_FALSE_IF_FALSE(transfer(MS5607_CMD_PROM_READ + 2 * i, rx, 2));
+        words[i] = (rx[0] << 8) | rx[1];
+    }
+
+    return load_prom(words);
+}
+
+bool Ms5607::load_prom(const uint16_t *words)
+{
+    // A floating or missing chip reads all zeros or all ones, and all zeros passes the CRC
+    if (words[1] == 0 || words[1] == 0xFFFF) {
+        return false;
+    }
+
+    if ((words[7] & 0x000F) != prom_crc4(words)) {
+        DEBUGLN("MS5607 PROM CRC mismatch");
         return false;
     }
 
-    temp_C = device.getTemperature();
-    pressure_kPa = device.getPressure() / 10;
-    altitude_m = t0 / t_grad * (1 - exp((t_grad * R / g) * log(pressure_kPa / SEALEVELPRESSURE_KPA)));
+    memcpy(prom, words, sizeof(prom));
+    return true;
+}
+
+// CRC-4 from AN520, over all eight words with the CRC nibble zeroed
+uint8_t Ms5607::prom_crc4(const uint16_t *words)
+{
+    uint16_t n_rem = 0;
+
+    for (size_t cnt = 0; cnt < 2 * PROM_WORDS; cnt++) {
+        uint16_t word = words[cnt >> 1];
+        if ((cnt >> 1) == 7) {
+            word &= 0xFF00;
+        }
+
+        n_rem ^= (cnt % 2 == 1) ? (word & 0x00FF) : (word >> 8);
+
+        for (uint8_t bit = 8; bit > 0; bit--) {
+            n_rem = (n_rem & 0x8000) ? (n_rem << 1) ^ 0x3000 : (n_rem << 1);
+        }
+    }
+
+    return (n_rem >> 12) & 0x000F;
+}
+
+////////////////////////////////////////////////////////////
+//                        SPI                             //
+////////////////////////////////////////////////////////////
+
+bool Ms5607::command(uint8_t cmd)
+{
+    if (spi_bus != nullptr) {
+        return spi_bus->write(spi_device, &cmd, 1);
+    }
+
+    return transfer(cmd, nullptr, 0);
+}
+
+bool Ms5607::transfer(uint8_t cmd, uint8_t *rx, size_t len)
+{
+    if (spi_bus != nullptr) {
+        return spi_bus->read(spi_device, &cmd, 1, rx, len);
+    }
+
+    digitalWrite(_cs_pin, LOW);
+    _spi_instance->beginTransaction(settings);
 
+    _spi_instance->transfer(cmd);
+    for (size_t i = 0; i < len; i++) {
+        rx[i] = _spi_instance->transfer(0);
+    }
 
-    // DEBUG("Altimeter 2 (MS5607): ");
-    DEBUG(temp_C);
-    DEBUG(", ");
-    // DEBUG(" *C, ");
-    DEBUG(pressure_kPa);
-    DEBUG(",");
-    // DEBUG(" Pa, ");
-    DEBUGLN(altitude_m);
+    _spi_instance->endTransaction();
+    digitalWrite(_cs_pin, HIGH);
 
     return true;
 }
 
+bool Ms5607::read_adc(uint32_t &value)
+{
+    uint8_t rx[3] = {0};
+    RETURN_FALSE_IF_FALSE(transfer(MS5607_CMD_ADC_READ, rx, 3));
+
+    value = ((uint32_t)rx[0] << 16) | ((uint32_t)rx[1] << 8) | rx[2];
+    return true;
+}
 
 }
 }
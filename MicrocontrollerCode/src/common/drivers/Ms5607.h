@@ -5,27 +5,71 @@
 // PURPOSE: Driver code for MS5611/MS5607
 
 #include <Arduino.h>
-#include <MS5611_SPI.h>
 #include <SPI.h>
 
 #include "sensor_bases/BarometerBase.h"
+#include "../os/spi_bus.h"
 
 namespace Cesium {
 namespace Sensor {
+
+// Command set, datasheet p.10
+#define MS5607_CMD_RESET 0x1E
+#define MS5607_CMD_CONVERT_D1 0x40
+#define MS5607_CMD_CONVERT_D2 0x50
+#define MS5607_CMD_ADC_READ 0x00
+#define MS5607_CMD_PROM_READ 0xA0
+
+#define MS5607_OSR_4096 0x08
+
 class Ms5607 : public BarometerBase {
-private:
-    MS5611_SPI device{(int)0, (SPIClass*)0}; // Redefining in Ms5607() with actual values
+public:
+    // OSR 4096 conversion takes up to 9.04 ms
+    static constexpr uint32_t CONVERSION_TIME_US = 9100;
+    static constexpr uint32_t SPI_CLOCK_HZ = 10000000;
+
+    // Temperature drifts slowly, so only every TEMPERATURE_EVERY-th conversion is D2
+    static constexpr uint8_t TEMPERATURE_EVERY = 10;
+
+    static constexpr size_t PROM_WORDS = 8;
+
+    enum class ConversionState : uint8_t {
+        IDLE,
+        PRESSURE,
+        TEMPERATURE
+    };
 
+private:
     uint8_t _cs_pin;
+    SPISettings settings;
+
+    // Set by attach_spi_bus(), commands then go through the IDF driver instead of SPIClass
+    SpiBus* spi_bus;
+    uint8_t spi_device;
+
+    // C1..C6 in words 1..6, CRC in the low nibble of word 7
+    uint16_t prom[PROM_WORDS];
+
+    ConversionState state;
+    uint32_t D1;
+    uint32_t D2;
+    bool have_D2;
+    uint8_t pressures_since_D2;
 
     float P_offsets[2]; // Linear fit (a,b, in ax + b)
 
     // Constants according to the datasheet
-    const float R = 287.052; // specific gas constant J/kg/K 
+    const float R = 287.052; // specific gas constant J/kg/K
     const float g = 9.80665; // standard gravity m/s^2
     const float t_grad = 0.0065; // gradient of temperature
     const float t0 = 273.15 + 15; // temperature at 0 altitude (15 degC)
 
+    bool command(uint8_t cmd);
+    bool transfer(uint8_t cmd, uint8_t* rx, size_t len);
+    bool read_adc(uint32_t& value);
+    bool read_prom();
+    bool start_conversion(ConversionState next);
+
 public:
 
 
@@ -35,17 +79,26 @@ public:
     bool calibrate(float current_alt_m = 0);
     void set_P_offsets(float a, float b);
     bool setup();
+
+    // The CS pin moves to the bus's hardware CS
+    bool attach_spi_bus(SpiBus* bus);
+
+    // Non-blocking. Each call reads a finished conversion and starts the next one,
+    // true when a new pressure sample was computed
     bool read();
 
-    float SEALEVELPRESSURE_KPA = 101.89; // Sea level pressure of LA 
+    // Stores the PROM if its CRC matches
+    bool load_prom(const uint16_t* words);
+    static uint8_t prom_crc4(const uint16_t* words);
 
+    // First and second order compensation (datasheet p.8-9) of raw D1 and D2 into temp_C, pressure_kPa and altitude_m
+    void compensate(uint32_t d1, uint32_t d2);
 
+    inline ConversionState get_state() const {return state;}
 
-    float get_temp_C() {return temp_C;}
-    float get_pressure_kPa() {return pressure_kPa;}
-    float get_altitude_m() {return altitude_m;}
+    float SEALEVELPRESSURE_KPA = 101.89; // Sea level pressure of LA
 };
 
 
 } // namespace Sensor
-} // namespace Cesium
\ No newline at end of file
+} // namespace Cesium
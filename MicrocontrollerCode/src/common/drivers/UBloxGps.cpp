@@ -1,13 +1,29 @@
 #include "UBloxGps.h"
 #include "../globals.h"
+#include "../os/instrumentation.h"
+#include "../os/trace.h"
+#include <esp_timer.h>
+
 namespace Cesium {
 namespace Sensor {
+
+static constexpr uint8_t DEFAULT_NAV_RATE_HZ = 10;
+
+template <typename T>
+static inline T get_le(const uint8_t* payload, size_t offset)
+{
+    T value;
+    memcpy(&value, payload + offset, sizeof(T));
+    return value;
+}
+
 UBloxGps::UBloxGps(uint8_t cs_pin, SPIClass* spi_instance)
 {
     this->cs_pin = cs_pin;
     this->spi_instance = spi_instance;
     this->interface = Interfaces::SPI;
     this->clock_freq = 4000000;
+    this->nav_rate_hz = DEFAULT_NAV_RATE_HZ;
 }
 
 UBloxGps::UBloxGps(TwoWire* i2c_instance, uint8_t address)
@@ -16,12 +32,19 @@ UBloxGps::UBloxGps(TwoWire* i2c_instance, uint8_t address)
     this->interface = Interfaces::I2C;
     this->clock_freq = 100000;
     this->i2c_addr = address;
+    this->nav_rate_hz = DEFAULT_NAV_RATE_HZ;
 }
 
 UBloxGps::UBloxGps(HardwareSerial* serial_instance)
 {
     this->_serial_instance = serial_instance;
     this->interface = Interfaces::Serial;
+    this->nav_rate_hz = DEFAULT_NAV_RATE_HZ;
+}
+
+bool UBloxGps::configure(const char *config_name)
+{
+    return false;
 }
 
 bool UBloxGps::setup()
@@ -47,53 +70,167 @@ bool UBloxGps::setup()
     case Interfaces::Serial:
         if (!device.begin(*_serial_instance)) 
         {
-            DEBUGLN("u-blox GNSS not detected on I2C bus. Please check wiring.");
+            DEBUGLN("u-blox GNSS not detected on UART. Please check wiring.");
             return false;
         }
         break;
+
+    default:
+        return false;
     }
 
     device.factoryDefault(); delay(5000); // Uncomment this line to reset the module back to its factory defaults
 
-    device.setPortOutput(COM_PORT_SPI, COM_TYPE_UBX); //Set the SPI port to output UBX only (turn off NMEA noise)
+    // UBX only (turn off NMEA noise) on the port we are on
+    switch (interface) {
+    case Interfaces::SPI:
+        RETURN_FALSE_IF_FALSE(device.setSPIOutput(COM_TYPE_UBX));
+        break;
+    case Interfaces::I2C:
+        RETURN_FALSE_IF_FALSE(device.setI2COutput(COM_TYPE_UBX));
+        break;
+    default:
+        RETURN_FALSE_IF_FALSE(device.setUART1Output(COM_TYPE_UBX));
+        break;
+    }
     device.saveConfigSelective(VAL_CFG_SUBSEC_IOPORT); //Save (only) the communications port settings to flash and BBR
 
+    // NAV-PVT is pushed every solution, nothing is polled after this
+    RETURN_FALSE_IF_FALSE(device.setNavigationFrequency(nav_rate_hz));
+    RETURN_FALSE_IF_FALSE(device.setAutoPVT(true, true));
+
+    parser.reset();
+
     return true;
     
 }
 
 bool UBloxGps::read()
 {
+    PROBE_SCOPE("UBloxGps::read");
+    TRACE_SCOPE("UBloxGps::read");
 
-    latitude_scaled = device.getLatitude();
-    DEBUG(F("Lat: "));
-    DEBUG(latitude_scaled);
+    if (interface == Interfaces::Serial) {
+        return read_serial();
+    }
+    return read_library();
+}
 
-    longitude_scaled = device.getLongitude();
-    DEBUG(F(" Long: "));
-    DEBUG(longitude_scaled);
-    DEBUG(F(" (degrees * 10^-7)"));
+bool UBloxGps::read_serial()
+{
+    bool published = false;
 
-    altitude_m = device.getAltitude();
-    DEBUG(F(" Alt: "));
-    DEBUG(altitude_m);
-    DEBUG(F(" (mm)"));
+    size_t available = _serial_instance->available();
+    if (available > MAX_BYTES_PER_READ) {
+        available = MAX_BYTES_PER_READ;
+    }
 
-    satellites_in_view = device.getSIV();
-    DEBUG(F(" SIV: "));
-    DEBUG(satellites_in_view);
+    for (size_t i = 0; i < available; i++) {
+        int byte = _serial_instance->read();
+        if (byte < 0) {
+            break;
+        }
 
-    heading_scaled = device.getHeading();
-    DEBUG(F(" Heading: "));
-    DEBUG(heading_scaled);
+        if (!parser.parse(byte) || parser.get_class() != UBX_CLASS_NAV_ID || parser.get_id() != UBX_NAV_PVT_ID) {
+            continue;
+        }
 
-    ground_speed_mmps = device.getGroundSpeed(); // Scale this to altitude
-    DEBUG(F(" Heading: "));
-    DEBUG(ground_speed_mmps);
+        GpsFix fix;
+        if (decode_nav_pvt(parser.get_payload(), parser.get_length(), fix)) {
+            stamp_sample(fix.time_us);
+            publish_fix(fix);
+            published = true;
+        }
+    }
 
-    DEBUGLN();
-    return false;
+    return published;
+}
+
+bool UBloxGps::read_library()
+{
+    // With auto-PVT, getPVT() only drains what the module has already sent
+    if (!device.getPVT(0)) {
+        return false;
+    }
+
+    const UBX_NAV_PVT_data_t& data = device.packetUBXNAVPVT->data;
+
+    GpsFix fix;
+    fix.time_us = esp_timer_get_time();
+    fix.iTOW_ms = data.iTOW;
+    fix.year = data.year;
+    fix.month = data.month;
+    fix.day = data.day;
+    fix.hour = data.hour;
+    fix.minute = data.min;
+    fix.second = data.sec;
+    fix.valid = data.valid.all;
+    fix.t_acc_ns = data.tAcc;
+    fix.nano_ns = data.nano;
+    fix.fix_type = data.fixType;
+    fix.flags = data.flags.all;
+    fix.satellites = data.numSV;
+    fix.longitude_e7 = data.lon;
+    fix.latitude_e7 = data.lat;
+    fix.height_mm = data.height;
+    fix.height_msl_mm = data.hMSL;
+    fix.h_acc_mm = data.hAcc;
+    fix.v_acc_mm = data.vAcc;
+    fix.vel_n_mmps = data.velN;
+    fix.vel_e_mmps = data.velE;
+    fix.vel_d_mmps = data.velD;
+    fix.ground_speed_mmps = data.gSpeed;
+    fix.heading_motion_e5 = data.headMot;
+    fix.speed_acc_mmps = data.sAcc;
+    fix.heading_acc_e5 = data.headAcc;
+    fix.pdop_e2 = data.pDOP;
+
+    // Stale until the next frame arrives
+    device.flushPVT();
+
+    stamp_sample(fix.time_us);
+    publish_fix(fix);
+
+    return true;
 }
 
+bool UBloxGps::decode_nav_pvt(const uint8_t *payload, size_t len, GpsFix &fix)
+{
+    if (len < UBX_NAV_PVT_LENGTH) {
+        return false;
+    }
+
+    fix.time_us = esp_timer_get_time();
+    fix.iTOW_ms = get_le<uint32_t>(payload, 0);
+    fix.year = get_le<uint16_t>(payload, 4);
+    fix.month = payload[6];
+    fix.day = payload[7];
+    fix.hour = payload[8];
+    fix.minute = payload[9];
+    fix.second = payload[10];
+    fix.valid = payload[11];
+    fix.t_acc_ns = get_le<uint32_t>(payload, 12);
+    fix.nano_ns = get_le<int32_t>(payload, 16);
+    fix.fix_type = payload[20];
+    fix.flags = payload[21];
+    fix.satellites = payload[23];
+    fix.longitude_e7 = get_le<int32_t>(payload, 24);
+    fix.latitude_e7 = get_le<int32_t>(payload, 28);
+    fix.height_mm = get_le<int32_t>(payload, 32);
+    fix.height_msl_mm = get_le<int32_t>(payload, 36);
+    fix.h_acc_mm = get_le<uint32_t>(payload, 40);
+    fix.v_acc_mm = get_le<uint32_t>(payload, 44);
+    fix.vel_n_mmps = get_le<int32_t>(payload, 48);
+    fix.vel_e_mmps = get_le<int32_t>(payload, 52);
+    fix.vel_d_mmps = get_le<int32_t>(payload, 56);
+    fix.ground_speed_mmps = get_le<int32_t>(payload, 60);
+    fix.heading_motion_e5 = get_le<int32_t>(payload, 64);
+    fix.speed_acc_mmps = get_le<uint32_t>(payload, 68);
+    fix.heading_acc_e5 = get_le<uint32_t>(payload, 72);
+    fix.pdop_e2 = get_le<uint16_t>(payload, 76);
+
+    return true;
+}
+
+}
 }
-}
\ No newline at end of file
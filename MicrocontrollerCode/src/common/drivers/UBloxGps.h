@@ -11,10 +11,17 @@
 #include <SparkFun_u-blox_GNSS_Arduino_Library.h>
 
 #include "sensor_bases/GpsBase.h"
+#include "UbxParser.h"
 
 namespace Cesium {
 namespace Sensor {
 class UBloxGps : public GpsBase {
+public:
+    static constexpr uint8_t MAX_NAV_RATE_HZ = 25;
+
+    // Bytes handled per read(), about 5 NAV-PVT frames. The UART driver buffers the rest
+    static constexpr size_t MAX_BYTES_PER_READ = 512;
+
 private:
     SFE_UBLOX_GNSS device;
     uint64_t last_read_us = 0;
@@ -24,14 +31,35 @@ private:
     uint32_t clock_freq;
     uint8_t i2c_addr;
 
+    uint8_t nav_rate_hz;
+
+    // UART frames are parsed here, the library is only used for configuration
+    UbxParser parser;
+
+    // SPI and I2C still go through the library's auto-PVT buffer
+    bool read_library();
+    bool read_serial();
+
 public:
 
     UBloxGps(uint8_t cs_pin, SPIClass* spi_instance);
     UBloxGps(TwoWire* i2c_instance, uint8_t address = 0x42);
     UBloxGps(HardwareSerial* serial_instance); // Assumes correct baud rate is already specfied
+    bool configure(const char* config_name);
+
+    // Configures UBX-only output and auto NAV-PVT at nav_rate_hz (set before setup())
     bool setup();
+    inline void set_nav_rate_hz(uint8_t rate_hz) {nav_rate_hz = constrain(rate_hz, 1, MAX_NAV_RATE_HZ);}
+    inline uint8_t get_nav_rate_hz() const {return nav_rate_hz;}
+
+    // Non-blocking. Handles whatever has arrived, true when a new solution was published
     bool read();
 
+    // Payload of a UBX-NAV-PVT frame (interface description 3.15.13) into fix
+    static bool decode_nav_pvt(const uint8_t* payload, size_t len, GpsFix& fix);
+
+    inline const UbxParser& get_parser() const {return parser;}
+
     inline uint32_t get_latitude_scaled() {return latitude_scaled;}
     inline uint32_t get_longitude_scaled() {return longitude_scaled;}
     inline float get_latitude_deg() {return latitude_deg;}
@@ -43,4 +71,4 @@ public:
 };
 
 } // namespace Sensor
-} // namespace Cesium
\ No newline at end of file
+} // namespace Cesium
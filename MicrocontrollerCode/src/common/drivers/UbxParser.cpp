@@ -0,0 +1,129 @@
+#include "UbxParser.h"
+
+namespace Cesium {
+namespace Sensor {
+
+UbxParser::UbxParser()
+    : msg_class{0}
+    , msg_id{0}
+    , length{0}
+    , index{0}
+    , ck_a{0}
+    , ck_b{0}
+    , payload{}
+    , frames{0}
+    , checksum_errors{0}
+    , oversized{0}
+{
+    reset();
+}
+
+void UbxParser::reset()
+{
+    state = State::SYNC_1;
+    index = 0;
+}
+
+bool UbxParser::parse(uint8_t byte)
+{
+    switch (state) {
+    case State::SYNC_1:
+        if (byte == UBX_SYNC_1) {
+            state = State::SYNC_2;
+        }
+        return false;
+
+    case State::SYNC_2:
+        // A repeated first sync byte can still start a frame
+        state = byte == UBX_SYNC_2 ? State::CLASS : (byte == UBX_SYNC_1 ? State::SYNC_2 : State::SYNC_1);
+        return false;
+
+    case State::CLASS:
+        ck_a = 0;
+        ck_b = 0;
+        add_to_checksum(byte);
+        msg_class = byte;
+        state = State::ID;
+        return false;
+
+    case State::ID:
+        add_to_checksum(byte);
+        msg_id = byte;
+        state = State::LENGTH_1;
+        return false;
+
+    case State::LENGTH_1:
+        add_to_checksum(byte);
+        length = byte;
+        state = State::LENGTH_2;
+        return false;
+
+    case State::LENGTH_2:
+        add_to_checksum(byte);
+        length |= (uint16_t)byte << 8;
+        index = 0;
+        // Too long to keep, so resync right away rather than waiting out a length that may be garbage
+        if (length > MAX_PAYLOAD) {
+            oversized++;
+            state = State::SYNC_1;
+            return false;
+        }
+        state = length == 0 ? State::CHECKSUM_A : State::PAYLOAD;
+        return false;
+
+    case State::PAYLOAD:
+        add_to_checksum(byte);
+        payload[index++] = byte;
+        if (index == length) {
+            state = State::CHECKSUM_A;
+        }
+        return false;
+
+    case State::CHECKSUM_A:
+        state = byte == ck_a ? State::CHECKSUM_B : State::SYNC_1;
+        if (state == State::SYNC_1) {
+            checksum_errors++;
+        }
+        return false;
+
+    case State::CHECKSUM_B:
+        state = State::SYNC_1;
+        if (byte != ck_b) {
+            checksum_errors++;
+            return false;
+        }
+        frames++;
+        return true;
+    }
+
+    return false;
+}
+
+void UbxParser::checksum(const uint8_t *data, size_t len, uint8_t &ck_a, uint8_t &ck_b)
+{
+    ck_a = 0;
+    ck_b = 0;
+    for (size_t i = 0; i < len; i++) {
+        ck_a += data[i];
+        ck_b += ck_a;
+    }
+}
+
+size_t UbxParser::build_frame(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t len, uint8_t *out)
+{
+    out[0] = UBX_SYNC_1;
+    out[1] = UBX_SYNC_2;
+    out[2] = msg_class;
+    out[3] = msg_id;
+    out[4] = len & 0xFF;
+    out[5] = len >> 8;
+    if (len > 0) {
+        memcpy(&out[6], payload, len);
+    }
+
+    checksum(&out[2], len + 4, out[6 + len], out[7 + len]);
+    return len + FRAME_OVERHEAD;
+}
+
+} // namespace Sensor
+} // namespace Cesium
@@ -0,0 +1,80 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Incremental UBX frame parser, one byte at a time so it never waits on the port
+
+#include <Arduino.h>
+
+namespace Cesium {
+namespace Sensor {
+
+#define UBX_SYNC_1 0xB5
+#define UBX_SYNC_2 0x62
+
+#define UBX_CLASS_NAV_ID 0x01
+#define UBX_NAV_PVT_ID 0x07
+#define UBX_NAV_PVT_LENGTH 92
+
+class UbxParser {
+public:
+    // Longest payload kept, NAV-PVT is the largest message we ask for
+    static constexpr size_t MAX_PAYLOAD = 100;
+
+    // Sync + class + id + length + checksum
+    static constexpr size_t FRAME_OVERHEAD = 8;
+
+    enum class State : uint8_t {
+        SYNC_1,
+        SYNC_2,
+        CLASS,
+        ID,
+        LENGTH_1,
+        LENGTH_2,
+        PAYLOAD,
+        CHECKSUM_A,
+        CHECKSUM_B
+    };
+
+private:
+    State state;
+    uint8_t msg_class;
+    uint8_t msg_id;
+    uint16_t length;
+    uint16_t index;
+    uint8_t ck_a;
+    uint8_t ck_b;
+    uint8_t payload[MAX_PAYLOAD];
+
+    uint32_t frames;
+    uint32_t checksum_errors;
+    uint32_t oversized;         // Frames too long for payload, dropped at their length field
+
+    inline void add_to_checksum(uint8_t byte) {ck_a += byte; ck_b += ck_a;}
+
+public:
+    UbxParser();
+
+    // True when byte completed a frame with a good checksum. The frame stays readable until the next parse()
+    bool parse(uint8_t byte);
+    void reset();
+
+    inline uint8_t get_class() const {return msg_class;}
+    inline uint8_t get_id() const {return msg_id;}
+    inline uint16_t get_length() const {return length;}
+    inline const uint8_t* get_payload() const {return payload;}
+    inline State get_state() const {return state;}
+
+    inline uint32_t get_frames() const {return frames;}
+    inline uint32_t get_checksum_errors() const {return checksum_errors;}
+    inline uint32_t get_oversized() const {return oversized;}
+
+    // 8-bit Fletcher over class, id, length and payload (interface description 3.4)
+    static void checksum(const uint8_t* data, size_t len, uint8_t& ck_a, uint8_t& ck_b);
+
+    // Writes a whole frame to out, which needs len + FRAME_OVERHEAD bytes. Returns the frame length
+    static size_t build_frame(uint8_t msg_class, uint8_t msg_id, const uint8_t* payload, uint16_t len, uint8_t* out);
+};
+
+} // namespace Sensor
+} // namespace Cesium
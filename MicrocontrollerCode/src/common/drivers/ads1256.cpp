@@ -1,16 +1,49 @@
 #include "Ads1256.h"
 #include "../globals.h"
+#include "../os/instrumentation.h"
+#include "../os/trace.h"
+#include <esp_timer.h>
+
+// Set by the library's DRDY ISR, which drdy_isr() replaces
+extern volatile bool DRDY_value;
 
 namespace Cesium {
 
+int Ads1256::singleEndedChannels[] = {SING_0, SING_1, SING_2, SING_3, SING_4, SING_5, SING_6, SING_7}; //Array to store the single-ended channels
+int Ads1256::differentialChannels[] = {DIFF_0_1, DIFF_2_3, DIFF_4_5, DIFF_6_7}; //Array to store the differential channels
+
+// Datasheet timing at the 7.68 MHz CLKIN (p.6): t6 is 50 clocks from RDATA to the first data bit,
+// t11 is 24 clocks after SYNC/RDATAC/SDATAC and 4 after WREG before the next command
+static constexpr uint32_t T6_US = 7;
+static constexpr uint32_t T11_US = 4;
+static constexpr uint32_t T11_WREG_US = 1;
+
+// Self-calibration after a DRATE write takes up to 800 ms at 2 SPS, much less at the rates used here
+static constexpr uint32_t CALIBRATION_TIMEOUT_US = 100000;
+static constexpr uint32_t MODE_CHANGE_TIMEOUT_MS = 200;
+static constexpr uint32_t IDLE_WAIT_MS = 10;
+
 Ads1256::Ads1256(uint8_t cs_pin, uint8_t drdy_pin, SPIClass *spi_instance, size_t num_readings)
     : cs_pin(cs_pin)
     , drdy_pin(drdy_pin)
     , spi_instance_ptr(spi_instance)
-    
+    , settings(SPI_CLOCK_HZ, MSBFIRST, SPI_MODE1)
+    , pga(PGA_1)
+    , acquisition_handle(nullptr)
+    , mode(AcquisitionMode::STOPPED)
+    , requested_mode(AcquisitionMode::STOPPED)
+    , requested_channel(0)
+    , requested_drate(DRATE_30000SPS)
+    , current_channel(0)
+    , drdy_time_us(0)
+    , samples_acquired(0)
+    , samples_missed(0)
 {
-    constrain(num_readings, 0, 8);
-    channel_count = num_readings;
+    channel_count = constrain(num_readings, 0, 8);
+
+    calibrate_slopes.fill(1);
+    calibrate_intercepts.fill(0);
+    update_channel_gain();
 }
 
 bool Ads1256::set_calibration(float *slopes, float *intercepts)
@@ -35,6 +68,7 @@ bool Ads1256::set_calibration(float *slopes, float *intercepts)
         calibrate_slopes[i] = slopes[i];
         calibrate_intercepts[i] = intercepts[i];
     }
+    update_channel_gain();
     
     return true;
 }
@@ -45,7 +79,8 @@ bool Ads1256::setup()
 
     device.InitializeADC(spi_instance_ptr);
 
-    device.setPGA(PGA_1);  //0b00000000 - DEC: 0
+    pga = PGA_1;
+    device.setPGA(pga);  //0b00000000 - DEC: 0
     device.setMUX(DIFF_0_1); //0b01100111 - DEC: 103
     device.setDRATE(DRATE_1000SPS); //0b00010011 - DEC: 19
 
@@ -62,11 +97,21 @@ bool Ads1256::setup()
     DEBUGLN(device.readRegister(DRATE_REG));
     delay(100);
 
+    // Takes DRDY over from the library, drdy_isr() still sets its flag for the blocking calls
+    attachInterruptArg(digitalPinToInterrupt(drdy_pin), drdy_isr, this, FALLING);
+    update_channel_gain();
+
     return true;
 }
 
 bool Ads1256::read()
 {
+    PROBE_SCOPE("Ads1256::read");
+    TRACE_SCOPE("Ads1256::read");
+
+    if (mode != AcquisitionMode::STOPPED) {
+        return false;
+    }
     
     for (int i = 0; i < channel_count; i++)
     {
@@ -95,4 +140,256 @@ bool Ads1256::read()
 
 }
 
-}
\ No newline at end of file
+////////////////////////////////////////////////////////////
+//                  Acquisition engine                    //
+////////////////////////////////////////////////////////////
+
+bool Ads1256::start_continuous(uint8_t channel, uint8_t drate)
+{
+    if (channel >= 8) {
+        DEBUGLN("Invalid ADS1256 channel");
+        return false;
+    }
+    return request_mode(AcquisitionMode::CONTINUOUS, channel, drate);
+}
+
+bool Ads1256::start_scan(uint8_t drate)
+{
+    if (channel_count == 0) {
+        DEBUGLN("No ADS1256 channels to scan");
+        return false;
+    }
+    return request_mode(AcquisitionMode::SCAN, 0, drate);
+}
+
+bool Ads1256::stop()
+{
+    if (acquisition_handle == nullptr) {
+        return true;
+    }
+    return request_mode(AcquisitionMode::STOPPED, 0, requested_drate);
+}
+
+// Mode changes are done by the acquisition task itself so it stays the only one on the bus
+bool Ads1256::request_mode(AcquisitionMode next, uint8_t channel, uint8_t drate)
+{
+    if (acquisition_handle == nullptr) {
+        RETURN_FALSE_IF_FALSE(xTaskCreatePinnedToCore(acquisition_task, "ads1256", ACQUISITION_STACK, this,
+                                                      ACQUISITION_PRIORITY, &acquisition_handle, ACQUISITION_CORE) == pdPASS);
+    }
+
+    requested_channel = channel;
+    requested_drate = drate;
+    requested_mode = next;
+    xTaskNotifyGive(acquisition_handle);
+
+    // enter_mode() falls back to STOPPED if the chip never comes out of calibration
+    for (uint32_t waited_ms = 0; mode != requested_mode; waited_ms++) {
+        if (waited_ms >= MODE_CHANGE_TIMEOUT_MS) {
+            DEBUGLN("ADS1256 mode change timed out");
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+
+    return mode == next;
+}
+
+size_t Ads1256::read_samples(AdcReading *readings, size_t max_readings)
+{
+    PROBE_SCOPE("Ads1256::read_samples");
+
+    AdcSample batch[CALIBRATION_BATCH];
+    size_t total = 0;
+
+    while (total < max_readings) {
+        size_t wanted = min(CALIBRATION_BATCH, max_readings - total);
+        size_t count = ring.pop(batch, wanted);
+
+        // No queue atomics in here, just the multiply-add per sample
+        for (size_t i = 0; i < count; i++) {
+            AdcReading& reading = readings[total + i];
+            reading.time_us = batch[i].time_us;
+            reading.channel = batch[i].channel();
+            reading.volt = calibrate(batch[i]);
+        }
+        total += count;
+
+        if (count < wanted) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+float Ads1256::get_volts_per_lsb() const
+{
+    // Datasheet table 16, full scale is +-2 VREF / PGA over 2^23 counts
+    return 2 * VREF / 8388608 / (1 << pga);
+}
+
+void Ads1256::update_channel_gain()
+{
+    float volts_per_lsb = get_volts_per_lsb();
+    for (size_t i = 0; i < channel_gain.size(); i++) {
+        channel_gain[i] = calibrate_slopes[i] * volts_per_lsb;
+    }
+}
+
+void Ads1256::acquisition_task(void *arg)
+{
+    Ads1256* adc = (Ads1256*)arg;
+
+    for (;;) {
+        // One notification per DRDY edge, more than one means conversions were overwritten
+        uint32_t edges = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(IDLE_WAIT_MS));
+
+        if (adc->requested_mode != adc->mode) {
+            adc->leave_mode();
+            adc->enter_mode(adc->requested_mode);
+            continue;
+        }
+
+        if (edges == 0 || adc->mode == AcquisitionMode::STOPPED) {
+            continue;
+        }
+
+        adc->samples_missed += edges - 1;
+        adc->acquire(adc->drdy_time_us);
+    }
+}
+
+// The SPI transaction (and so the SPIClass lock) is held for as long as the engine runs
+void Ads1256::enter_mode(AcquisitionMode next)
+{
+    if (next == AcquisitionMode::STOPPED) {
+        return;
+    }
+
+    spi_instance_ptr->beginTransaction(settings);
+    digitalWrite(cs_pin, LOW);
+
+    current_channel = next == AcquisitionMode::CONTINUOUS ? requested_channel : 0;
+    write_register(MUX_REG, singleEndedChannels[current_channel]);
+    write_register(DRATE_REG, requested_drate);
+
+    // ACAL runs a self-calibration after the DRATE write, DRDY stays high until it is done
+    command(SYNC);
+    delayMicroseconds(T11_US);
+    command(WAKEUP);
+
+    if (!wait_drdy_low(CALIBRATION_TIMEOUT_US)) {
+        DEBUGLN("ADS1256 DRDY timed out");
+        digitalWrite(cs_pin, HIGH);
+        spi_instance_ptr->endTransaction();
+        requested_mode = AcquisitionMode::STOPPED;
+        return;
+    }
+
+    if (next == AcquisitionMode::CONTINUOUS) {
+        command(RDATAC);
+        delayMicroseconds(T11_US);
+    }
+
+    // Drop the wake-up from request_mode() so it isn't counted as a DRDY edge
+    ulTaskNotifyTake(pdTRUE, 0);
+    mode = next;
+}
+
+void Ads1256::leave_mode()
+{
+    if (mode == AcquisitionMode::STOPPED) {
+        return;
+    }
+
+    AcquisitionMode previous = mode;
+    mode = AcquisitionMode::STOPPED;
+
+    // SDATAC has to follow a DRDY low (datasheet p.35)
+    if (previous == AcquisitionMode::CONTINUOUS) {
+        wait_drdy_low(CALIBRATION_TIMEOUT_US);
+        command(SDATAC);
+        delayMicroseconds(T11_US);
+    }
+
+    digitalWrite(cs_pin, HIGH);
+    spi_instance_ptr->endTransaction();
+}
+
+void Ads1256::acquire(uint32_t time_us)
+{
+    uint8_t channel = current_channel;
+    uint32_t data;
+
+    if (mode == AcquisitionMode::CONTINUOUS) {
+        // The conversion result is shifted out directly, there is no command in RDATAC
+        data = read_data();
+    }
+    else {
+        // Pipelined cycling (datasheet figure 19): the next channel's MUX is set and its conversion
+        // started before the finished one is read out, so the chip is never idle waiting on SPI
+        uint8_t next = (current_channel + 1) % channel_count;
+        write_register(MUX_REG, singleEndedChannels[next]);
+        command(SYNC);
+        delayMicroseconds(T11_US);
+        command(WAKEUP);
+        command(RDATA);
+        delayMicroseconds(T6_US);
+        data = read_data();
+        current_channel = next;
+    }
+
+    samples_acquired++;
+    ring.push({time_us, (int32_t)(data << 8 | channel)});
+}
+
+bool Ads1256::wait_drdy_low(uint32_t timeout_us)
+{
+    int64_t start_us = esp_timer_get_time();
+    while (digitalRead(drdy_pin) != LOW) {
+        if (esp_timer_get_time() - start_us > timeout_us) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Ads1256::command(uint8_t cmd)
+{
+    spi_instance_ptr->transfer(cmd);
+}
+
+void Ads1256::write_register(uint8_t reg, uint8_t value)
+{
+    uint8_t tx[3] = {(uint8_t)(WREG | reg), 0, value};
+    spi_instance_ptr->transfer(tx, sizeof(tx));
+    delayMicroseconds(T11_WREG_US);
+}
+
+uint32_t Ads1256::read_data()
+{
+    uint8_t rx[3] = {0};
+    spi_instance_ptr->transfer(rx, sizeof(rx));
+    return (uint32_t)rx[0] << 16 | (uint32_t)rx[1] << 8 | rx[2];
+}
+
+void IRAM_ATTR Ads1256::drdy_isr(void *arg)
+{
+    Ads1256* adc = (Ads1256*)arg;
+    DRDY_value = true;
+
+    if (adc->mode == AcquisitionMode::STOPPED) {
+        return;
+    }
+
+    adc->drdy_time_us = esp_timer_get_time();
+
+    BaseType_t higher_priority_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(adc->acquisition_handle, &higher_priority_woken);
+    if (higher_priority_woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+}
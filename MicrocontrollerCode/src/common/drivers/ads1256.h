@@ -10,9 +10,43 @@
 #include <array>
 // #include "../math/vector.h"
 
+#include "../os/spsc_queue.h"
+
 namespace Cesium {
 
+// One conversion as captured by the acquisition task. The 24-bit result sits in the top
+// of value with the channel index in the low byte, so value >> 8 is the sign-extended raw count
+struct AdcSample {
+    uint32_t time_us; // DRDY falling edge, end of the conversion
+    int32_t value;
+
+    inline int32_t raw() const {return value >> 8;}
+    inline uint8_t channel() const {return value & 0xFF;}
+};
+
+struct AdcReading {
+    uint32_t time_us;
+    uint8_t channel;
+    float volt;
+};
+
 class Ads1256 {
+public:
+    enum class AcquisitionMode : uint8_t {
+        STOPPED,
+        CONTINUOUS, // RDATAC on one channel, up to 30 kSPS
+        SCAN        // MUX cycled through channel_count channels, one conversion each
+    };
+
+    static constexpr size_t RING_LENGTH = 4096; // 136 ms at 30 kSPS
+    static constexpr size_t CALIBRATION_BATCH = 64;
+
+    static constexpr BaseType_t ACQUISITION_CORE = 1;
+    static constexpr UBaseType_t ACQUISITION_PRIORITY = 22; // Above the pipeline's fast acquisition task
+    static constexpr uint32_t ACQUISITION_STACK = 3072;
+
+    static constexpr uint32_t SPI_CLOCK_HZ = 1920000; // CLKIN / 4
+
 private:
     ADS1256_Base device;
     std::array<float, 8> calibrate_slopes;
@@ -24,7 +58,39 @@ private:
     uint8_t cs_pin;
     uint8_t drdy_pin;
     SPIClass* spi_instance_ptr;
-    
+    SPISettings settings;
+    uint8_t pga;
+
+    // calibrate_slopes with the LSB size folded in, so a reading is raw * gain + intercept
+    std::array<float, 8> channel_gain;
+
+    // Acquisition engine. Everything on the SPI bus while it runs happens in acquisition_task
+    SpscQueue<AdcSample, RING_LENGTH> ring;
+    TaskHandle_t acquisition_handle;
+    volatile AcquisitionMode mode;
+    volatile AcquisitionMode requested_mode;
+    uint8_t requested_channel;
+    uint8_t requested_drate;
+    uint8_t current_channel;    // Channel of the conversion in progress
+
+    volatile uint32_t drdy_time_us;
+    uint32_t samples_acquired;
+    uint32_t samples_missed;    // DRDY edges the task was too late for
+
+    void update_channel_gain();
+    bool request_mode(AcquisitionMode next, uint8_t channel, uint8_t drate);
+
+    bool wait_drdy_low(uint32_t timeout_us);
+    void command(uint8_t cmd);
+    void write_register(uint8_t reg, uint8_t value);
+    uint32_t read_data();
+
+    void enter_mode(AcquisitionMode next);
+    void leave_mode();
+    void acquire(uint32_t time_us);
+
+    static void acquisition_task(void* arg);
+    static void IRAM_ATTR drdy_isr(void* arg);
 
 public:
 
@@ -32,8 +98,29 @@ public:
     Ads1256(uint8_t cs_pin, uint8_t drdy_pin, SPIClass* spi_instance, size_t num_readings);
     bool set_calibration(float* slopes = nullptr, float* intercepts = nullptr);
     bool setup();
+    // Blocking single-shot conversions of every channel, only while the engine is stopped
     bool read();
 
+    // Starts the acquisition task on the first call. The channel indexes singleEndedChannels
+    bool start_continuous(uint8_t channel, uint8_t drate = DRATE_30000SPS);
+    bool start_scan(uint8_t drate = DRATE_3750SPS);
+    bool stop();
+
+    // Pops up to max_readings samples and applies the calibration, returns the number written
+    size_t read_samples(AdcReading* readings, size_t max_readings);
+
+    inline AcquisitionMode get_mode() const {return mode;}
+    inline size_t available() const {return ring.size();}
+    inline uint32_t get_samples_acquired() const {return samples_acquired;}
+    inline uint32_t get_samples_dropped() const {return samples_missed + ring.get_dropped();}
+    inline size_t get_ring_high_water() const {return ring.get_high_water();}
+    float get_volts_per_lsb() const;
+
+    // Calibrated volts of one sample, the same math read_samples() runs in bulk
+    inline float calibrate(const AdcSample& sample) const {
+        return sample.raw() * channel_gain[sample.channel()] + calibrate_intercepts[sample.channel()];
+    }
+
     std::array<float, 8> voltage_raw;
     std::array<float, 8> voltage_volt;
 
@@ -45,8 +132,4 @@ public:
     static int differentialChannels[4];
 };
 
-int Ads1256::singleEndedChannels[] = {SING_0, SING_1, SING_2, SING_3, SING_4, SING_5, SING_6, SING_7}; //Array to store the single-ended channels
-int Ads1256::differentialChannels[] = {DIFF_0_1, DIFF_2_3, DIFF_4_5, DIFF_6_7}; //Array to store the differential channels
-
-
 } // namespace Cesium
\ No newline at end of file
@@ -2,20 +2,28 @@
 #include "../globals.h"
 #include "../../config/ConfigReader.h"
 #include <ArduinoJson.h>
+#include "../os/instrumentation.h"
+#include "../os/trace.h"
 
 namespace Cesium {
 namespace Sensor {
 Icm20948::Icm20948()
-    : accel_bias{}
-    , gyro_bias{}
-    , mag_bias{}
-    , cs_pin{0}
+    : cs_pin{0}
+    , settings(7000000, MSBFIRST, SPI_MODE0)
+    , current_bank{0xFF}
+    , accel_mps2_per_lsb{SENSORS_GRAVITY_EARTH / 2048.0f}
+    , w_rps_per_lsb{DEG2RAD / 16.4f}
+    , fifo_frame_index{0}
+    , last_B_uT{NAN, NAN, NAN}
+    , spi_bus{nullptr}
+    , spi_device{SpiBus::INVALID_DEVICE}
 {
     temp_C = 0;
     _spi_instance = &SPI;
 }
 
 Icm20948::Icm20948(uint8_t cs_pin, SPIClass* spi_instance)
+    : Icm20948()
 {
     _spi_instance = spi_instance;
     interface = Interfaces::SPI;
@@ -25,21 +33,25 @@ Icm20948::Icm20948(uint8_t cs_pin, SPIClass* spi_instance)
 bool Icm20948::configure(const char* config_name)
 {
     JsonDocument config;
-    File::json_open(config_name, config);
+    RETURN_FALSE_IF_FALSE(File::json_open(config_name, config));
 
-    RETURN_FALSE_IF_FALSE(File::json_extract(config, "body_to_sensor", body_to_sensor));
+    Matrix3<float> R_body_to_sensor;
+    RETURN_FALSE_IF_FALSE(File::json_extract_body_to_sensor(config, R_body_to_sensor));
+    set_rotation_matrix(R_body_to_sensor);
 
-    RETURN_FALSE_IF_FALSE(File::json_extract(config, "acceleration_bias", accel_bias));
-    RETURN_FALSE_IF_FALSE(File::json_extract(config, "gyroscope_bias", gyro_bias));
-    RETURN_FALSE_IF_FALSE(File::json_extract(config, "magnetometer_bias", mag_bias));
-    
-    return false;
+    // Magnetometer axes are already flipped onto the accel/gyro axes in decode_frame()
+    Matrix3<float> R_sensor_to_body = transpose(R_body_to_sensor);
+    RETURN_FALSE_IF_FALSE(File::json_extract_calibration(config, "acceleration", R_sensor_to_body, accel_calibration));
+    RETURN_FALSE_IF_FALSE(File::json_extract_calibration(config, "gyroscope", R_sensor_to_body, gyro_calibration));
+    RETURN_FALSE_IF_FALSE(File::json_extract_calibration(config, "magnetometer", R_sensor_to_body, mag_calibration));
+
+    return true;
 }
 
 bool Icm20948::setup()
 {
     bool setup = false;
-    for (int i=0; i<3000; i++) {
+    for (int i=0; i<3000 && spi_bus == nullptr; i++) {
         if(device.begin_SPI(cs_pin, _spi_instance)) {
             DEBUGLN("found!");
             setup = true;
@@ -49,127 +61,113 @@ bool Icm20948::setup()
         
     }
 
+    if (spi_bus != nullptr) {
+        setup = reset_device();
+    }
+
     if (!setup) {
         DEBUGLN("Failed to find imu20948 chip");
         return false;
     }
 
-    
-    // imu.setAccelRange(imu20948_ACCEL_RANGE_16_G);
-    DEBUG("Accelerometer range set to: ");
-    switch (device.getAccelRange()) {
-    case ICM20948_ACCEL_RANGE_2_G:
-        DEBUGLN("+-2G");
-        break;
-    case ICM20948_ACCEL_RANGE_4_G:
-        DEBUGLN("+-4G");
-        break;
-    case ICM20948_ACCEL_RANGE_8_G:
-        DEBUGLN("+-8G");
-        break;
-    case ICM20948_ACCEL_RANGE_16_G:
-        DEBUGLN("+-16G");
-        break;
-    }
-    DEBUGLN("OK");
-
-    // imu.setGyroRange(imu20948_GYRO_RANGE_2000_DPS);
-    DEBUG("Gyro range set to: ");
-    switch (device.getGyroRange()) {
-    case ICM20948_GYRO_RANGE_250_DPS:
-        DEBUGLN("250 degrees/s");
-        break;
-    case ICM20948_GYRO_RANGE_500_DPS:
-        DEBUGLN("500 degrees/s");
-        break;
-    case ICM20948_GYRO_RANGE_1000_DPS:
-        DEBUGLN("1000 degrees/s");
-        break;
-    case ICM20948_GYRO_RANGE_2000_DPS:
-        DEBUGLN("2000 degrees/s");
-        break;
-    }
-
-    // //  imu.setAccelRateDivisor(4095);
-    uint16_t accel_divisor = device.getAccelRateDivisor();
-    float accel_rate = 1125 / (1.0 + accel_divisor);
-
-    DEBUG("Accelerometer data rate divisor set to: ");
-    DEBUGLN(accel_divisor);
-    DEBUG("Accelerometer data rate (Hz) is approximately: ");
-    DEBUGLN(accel_rate);
-
-    //  imu.setGyroRateDivisor(255);
-    uint8_t gyro_divisor = device.getGyroRateDivisor();
-    float gyro_rate = 1100 / (1.0 + gyro_divisor);
-
-    DEBUG("Gyro data rate divisor set to: ");
-    DEBUGLN(gyro_divisor);
+    // Adafruit only does the reset and chip ID check, everything after is raw registers
+    current_bank = 0xFF;
+    RETURN_FALSE_IF_FALSE(setup_sampling());
+
+    if (!setup_i2c_master()) {
+        DEBUGLN("Failed to start AK09916");
+        return false;
+    }
+
+    DEBUGLN("Accelerometer range set to: +-16G");
+    DEBUGLN("Gyro range set to: 2000 degrees/s");
     DEBUG("Gyro data rate (Hz) is approximately: ");
-    DEBUGLN(gyro_rate);
+    DEBUGLN(1100 / (1.0 + SAMPLE_RATE_DIV));
 
-    // Setup magnetometer
-    // device.writeExternalRegister(ICM20X_B3_I2C_SLV0_ADDR, )
-    // Serial.println(device.enableI2CMaster(true));
-    // Serial.println(device.readExternalRegister(AK09916_I2C_ADDR, AK09916_WIA2));
-    
-    // Serial.println("Writing: " + String(device.writeExternalRegister(AK09916_I2C_ADDR, AK09916_CNTL2, 0x00))); // power down
-    // delay(100);
+    return true;
+}
+
+bool Icm20948::reset_device()
+{
+    // Reset also returns to bank 0
+    RETURN_FALSE_IF_FALSE(writeReg(0, ICM20X_B0_PWR_MGMT_1, 0x80));
+    delay(20);
+    current_bank = 0;
 
-    // Serial.println("Writing: " + String(device.writeExternalRegister(AK09916_I2C_ADDR, AK09916_ST2, 0x01))); // power down
-    // delay(100);
+    uint8_t chip_id = 0;
+    RETURN_FALSE_IF_FALSE(readBurst(0, ICM20X_B0_WHOAMI, &chip_id, 1));
+    RETURN_FALSE_IF_FALSE(chip_id == ICM20948_CHIP_ID);
 
+    // Out of sleep, best available clock
+    RETURN_FALSE_IF_FALSE(writeReg(0, ICM20X_B0_PWR_MGMT_1, 0x01));
+    delay(10);
 
+    return true;
+}
 
+bool Icm20948::setup_sampling()
+{
+    // Sample rate dividers written after this start on the same edge
+    RETURN_FALSE_IF_FALSE(writeReg(2, ICM20948_B2_ODR_ALIGN_EN, 0x01));
 
+    // 2000 dps, DLPF on (151.8 Hz)
+    RETURN_FALSE_IF_FALSE(writeReg(2, ICM20X_B2_GYRO_CONFIG_1, (1 << 3) | (ICM20948_GYRO_RANGE_2000_DPS << 1) | 0x01));
+    RETURN_FALSE_IF_FALSE(writeReg(2, ICM20X_B2_GYRO_SMPLRT_DIV, SAMPLE_RATE_DIV));
+
+    // 16 g, DLPF on (246 Hz)
+    RETURN_FALSE_IF_FALSE(writeReg(2, ICM20X_B2_ACCEL_CONFIG_1, (1 << 3) | (ICM20948_ACCEL_RANGE_16_G << 1) | 0x01));
+    RETURN_FALSE_IF_FALSE(writeReg(2, ICM20X_B2_ACCEL_SMPLRT_DIV_1, 0));
+    RETURN_FALSE_IF_FALSE(writeReg(2, ICM20X_B2_ACCEL_SMPLRT_DIV_2, SAMPLE_RATE_DIV));
+
+    // Raw data ready sets INT_STATUS_1, which planned reads check before decoding
+    RETURN_FALSE_IF_FALSE(writeReg(0, ICM20X_B0_REG_INT_ENABLE_1, 0x01));
 
-    // Serial.println("Writing: " + String(device.writeExternalRegister(AK09916_I2C_ADDR, AK09916_CNTL2, 0x04))); // Start conversion
-    // Serial.println("Reading: " + String(device.readExternalRegister(AK09916_I2C_ADDR, AK09916_CNTL2))); // Start conversion
-    
     return true;
 }
 
-bool Icm20948::read()
+bool Icm20948::setup_i2c_master()
 {
-    SensorBase::read();
+    // I2C master on, host I2C off since the ICM is only used over SPI
+    uint8_t user_ctrl = 0;
+    RETURN_FALSE_IF_FALSE(readBurst(0, ICM20X_B0_USER_CTRL, &user_ctrl, 1));
+    RETURN_FALSE_IF_FALSE(writeReg(0, ICM20X_B0_USER_CTRL, user_ctrl | 0x20 | 0x10));
+
+    // 345.6 kHz, stop between reads
+    RETURN_FALSE_IF_FALSE(writeReg(3, ICM20X_B3_I2C_MST_CTRL, 0x17));
+
+    uint8_t wia2 = 0;
+    RETURN_FALSE_IF_FALSE(readMagReg(AK09916_WIA2, wia2));
+    if (wia2 != ICM20948_MAG_ID) {
+        DEBUG("Unexpected AK09916 ID: ");
+        DEBUGLN(wia2);
+        return false;
+    }
 
-    /* Get a new normalized sensor event */
-    device.getAccelerometerSensor()->getEvent(&accel_event);
-    device.getGyroSensor()->getEvent(&gyro_event);
-    device.getTemperatureSensor()->getEvent(&temp_event);
-    // device.getMagnetometerSensor()->getEvent(&mag_event);
-
-    // uint8_t status1 = device.readExternalRegister(AK09916_I2C_ADDR, 0x10); // Status 1
-    // uint8_t status2 = device.readExternalRegister(AK09916_I2C_ADDR, 0x18); // Status 2
-    // uint8_t ctrl2 = device.readExternalRegister(AK09916_I2C_ADDR, AK09916_CNTL2); // Status 2
-
-    // Serial.print("Magnetometer Status 1: 0x");
-    // Serial.println(status1, HEX);
-    // Serial.print("Magnetometer Status 2: 0x");
-    // Serial.println(status2, HEX);
-    // Serial.print("Magnetometer Control 2: 0x");
-    // Serial.println(ctrl2, HEX);
-    // Serial.print(status1, HEX);
-    // uint8_t buffer[6];
-
-    // // Read 6 bytes of magnetometer data
-    // for (int i = 0; i < 6; i++) {
-    //     buffer[i] = device.readExternalRegister(AK09916_I2C_ADDR, AK09916_HXL + i);
-    // }
-    // for (int i = 0; i < 6; i++) {
-    //     Serial.print(" " + String(buffer[i]));
-    // }
-    // Serial.println();
-    
+    RETURN_FALSE_IF_FALSE(writeMagReg(AK09916_CNTL3, AK09916_CNTL3_SRST));
+    delay(10);
+    RETURN_FALSE_IF_FALSE(writeMagReg(AK09916_CNTL2, AK09916_CNTL2_CONTINUOUS_100HZ));
+
+    // Slave 0 reads ST1..ST2 into EXT_SLV_SENS_DATA every sample. Reading ST2 releases the data lock
+    RETURN_FALSE_IF_FALSE(writeReg(3, ICM20X_B3_I2C_SLV0_ADDR, ICM20948_I2C_SLV_RD_MASK | AK09916_I2C_ADDR));
+    RETURN_FALSE_IF_FALSE(writeReg(3, ICM20X_B3_I2C_SLV0_REG, AK09916_ST1));
+    RETURN_FALSE_IF_FALSE(writeReg(3, ICM20X_B3_I2C_SLV0_CTRL, 0x80 | MAG_BYTES));
+
+    return true;
+}
 
+bool Icm20948::read()
+{
+    PROBE_SCOPE("Icm20948::read");
+    TRACE_SCOPE("Icm20948::read");
+    SensorBase::read();
 
-    // device.getEvent(&accel_event, &gyro_event, &temp_event, &mag_event);
+    // Accel, gyro, temperature and the auto-read magnetometer block are contiguous
+    uint8_t frame[FIFO_FRAME_BYTES];
+    RETURN_FALSE_IF_FALSE(readBurst(0, ICM20X_B0_ACCEL_XOUT_H, frame, FIFO_FRAME_BYTES));
 
-    // If this doesn't work, just put "12" for the size
-    memcpy(  &accel_mps2,  &accel_event.acceleration, sizeof(accel_mps2)); // Copies as g's
-    memcpy(  &w_rps,  &gyro_event.gyro, sizeof(w_rps)); // Copies as deg/s
-    memcpy(  &temp_C,  &temp_event.temperature, sizeof(temp_C)); // Copies as degC
-    memcpy(  &B_uT,  &mag_event.magnetic, sizeof(B_uT)); // Copies as uT
+    ImuFifoSample sample;
+    decode_frame(frame, sample);
+    set_outputs(sample);
     
     DEBUG("Temp:");
     DEBUG(temp_C);
@@ -182,7 +180,7 @@ bool Icm20948::read()
     DEBUG(accel_mps2[1][0]);
     DEBUG(", Z: ");
     DEBUG(accel_mps2[2][0]);
-    DEBUG(" g, ");
+    DEBUG(" m/s^2, ");
 
     DEBUG("\t\tGyro X: ");
     DEBUG(w_rps[0][0]);
@@ -190,7 +188,7 @@ bool Icm20948::read()
     DEBUG(w_rps[1][0]);
     DEBUG(", Z: ");
     DEBUG(w_rps[2][0]);
-    DEBUGLN(" deg/s, ");
+    DEBUGLN(" rad/s, ");
 
     DEBUG("\t\tMag X: ");
     DEBUG(B_uT[0][0]);
@@ -200,9 +198,306 @@ bool Icm20948::read()
     DEBUG(B_uT[2][0]);
     DEBUGLN(" uT");
 
-    // Serial.print(mag_event.magnetic.x);
-    // Serial.print(","); Serial.print(mag_event.magnetic.y);
-    // Serial.print(","); Serial.print(mag_event.magnetic.z);
+    return true;
+}
+
+bool Icm20948::enable_drdy_interrupt()
+{
+    // Active high, push-pull, unlatched
+    RETURN_FALSE_IF_FALSE(writeReg(0, ICM20X_B0_REG_INT_PIN_CFG, 0x00));
+    RETURN_FALSE_IF_FALSE(writeReg(0, ICM20X_B0_REG_INT_ENABLE_1, 0x01));
+
+    return true;
+}
+
+void Icm20948::set_outputs(const ImuFifoSample& sample)
+{
+    for (size_t i = 0; i < 3; i++) {
+        accel_mps2[i][0] = sample.accel_mps2[i];
+        w_rps[i][0] = sample.w_rps[i];
+        B_uT[i][0] = sample.B_uT[i];
+    }
+    temp_C = sample.temp_C;
+
+    calibrate_accel();
+    calibrate_gyro();
+    calibrate_mag();
+}
+
+void Icm20948::decode_frame(const uint8_t* frame, ImuFifoSample& sample)
+{
+    for (size_t i = 0; i < 3; i++) {
+        sample.accel_mps2[i] = (int16_t)((frame[2 * i] << 8) | frame[2 * i + 1]) * accel_mps2_per_lsb;
+        sample.w_rps[i] = (int16_t)((frame[6 + 2 * i] << 8) | frame[7 + 2 * i]) * w_rps_per_lsb;
+    }
+
+    // 333.87 LSB/C, 0 = 21 C
+    sample.temp_C = (int16_t)((frame[12] << 8) | frame[13]) / 333.87f + 21.0f;
+
+    // ST1, HXL..HZH, TMPS, ST2
+    const uint8_t* mag = frame + 14;
+    if ((mag[0] & AK09916_ST1_DRDY) && !(mag[8] & AK09916_ST2_HOFL)) {
+        int16_t hx = mag[1] | (mag[2] << 8);
+        int16_t hy = mag[3] | (mag[4] << 8);
+        int16_t hz = mag[5] | (mag[6] << 8);
+
+        // AK09916 Y and Z point opposite the accel/gyro axes
+        last_B_uT[0] = hx * ICM20948_UT_PER_LSB;
+        last_B_uT[1] = -hy * ICM20948_UT_PER_LSB;
+        last_B_uT[2] = -hz * ICM20948_UT_PER_LSB;
+    }
+
+    memcpy(sample.B_uT, last_B_uT, sizeof(sample.B_uT));
+}
+
+////////////////////////////////////////////////////////////
+//                         FIFO                           //
+////////////////////////////////////////////////////////////
+
+bool Icm20948::configure_fifo(uint16_t watermark_frames)
+{
+    fifo_watermark_frames = watermark_frames;
+
+    // Slave 0 (magnetometer) after accel, gyro xyz and temperature
+    RETURN_FALSE_IF_FALSE(writeReg(0, ICM20948_B0_FIFO_EN_1, 0x01));
+    RETURN_FALSE_IF_FALSE(writeReg(0, ICM20948_B0_FIFO_EN_2, 0x1F));
+
+    // Stream mode, oldest data is overwritten when full
+    RETURN_FALSE_IF_FALSE(writeReg(0, ICM20948_B0_FIFO_MODE, 0x00));
+
+    uint8_t user_ctrl = 0;
+    RETURN_FALSE_IF_FALSE(readBurst(0, ICM20X_B0_USER_CTRL, &user_ctrl, 1));
+    RETURN_FALSE_IF_FALSE(writeReg(0, ICM20X_B0_USER_CTRL, user_ctrl | 0x40));
+
+    return flush_fifo();
+}
+
+bool Icm20948::flush_fifo()
+{
+    RETURN_FALSE_IF_FALSE(writeReg(0, ICM20948_B0_FIFO_RST, 0x1F));
+    RETURN_FALSE_IF_FALSE(writeReg(0, ICM20948_B0_FIFO_RST, 0x00));
+
+    fifo_frame_index = 0;
+    fifo_frames_read = 0;
+    fifo_frames_skipped = 0;
+
+    return true;
+}
+
+size_t Icm20948::get_fifo_frames()
+{
+    uint8_t count[2] = {0};
+    readBurst(0, ICM20948_B0_FIFO_COUNTH, count, 2);
+
+    return (((count[0] & 0x1F) << 8) | count[1]) / FIFO_FRAME_BYTES;
+}
+
+size_t Icm20948::read_fifo(ImuFifoSample *samples, size_t max_samples)
+{
+    PROBE_SCOPE("Icm20948::read_fifo");
+    TRACE_SCOPE("Icm20948::read_fifo");
+
+    size_t waiting = get_fifo_frames();
+
+    // Frames aren't a divisor of the FIFO size, so an overwritten FIFO has lost its frame alignment
+    if (waiting >= get_fifo_capacity_frames()) {
+        // The counters only restart on a flush the caller asked for
+        uint32_t frames_read = fifo_frames_read;
+        uint32_t frames_skipped = fifo_frames_skipped + waiting;
+        RETURN_WITH_CODE_IF_FALSE(0, flush_fifo());
+        fifo_frames_read = frames_read;
+        fifo_frames_skipped = frames_skipped;
+        return 0;
+    }
+
+    size_t frames = std::min(waiting, max_samples);
+
+    if (frames == 0) {
+        return 0;
+    }
+
+    RETURN_WITH_CODE_IF_FALSE(0, readBurst(0, ICM20948_B0_FIFO_R_W, fifo_buffer, frames * FIFO_FRAME_BYTES));
+
+    size_t decoded = decode_fifo(fifo_buffer, frames, samples);
+
+    // Newest sample also updates the single-sample outputs, before the block is moved to the body frame
+    set_outputs(samples[decoded - 1]);
+    SensorBase::read();
+
+    uint8_t* block = reinterpret_cast<uint8_t*>(samples);
+    accel_calibration.apply_batch(block, offsetof(ImuFifoSample, accel_mps2), sizeof(ImuFifoSample), decoded);
+    gyro_calibration.apply_batch(block, offsetof(ImuFifoSample, w_rps), sizeof(ImuFifoSample), decoded);
+    mag_calibration.apply_batch(block, offsetof(ImuFifoSample, B_uT), sizeof(ImuFifoSample), decoded);
+
+    return decoded;
+}
+
+size_t Icm20948::decode_fifo(const uint8_t *raw, size_t frames, ImuFifoSample *samples)
+{
+    for (size_t i = 0; i < frames; i++) {
+        samples[i].time_us = fifo_frame_index * FIFO_PERIOD_US;
+        decode_frame(raw + i * FIFO_FRAME_BYTES, samples[i]);
+
+        fifo_frame_index++;
+        fifo_frames_read++;
+    }
+
+    return frames;
+}
+
+////////////////////////////////////////////////////////////
+//                      SpiBus                            //
+////////////////////////////////////////////////////////////
+
+bool Icm20948::attach_spi_bus(SpiBus *bus)
+{
+    // Header plus a full FIFO drain
+    spi_device = bus->add_device(cs_pin, SPI_CLOCK_HZ, SPI_MODE0, 1 + FIFO_CAPACITY_BYTES);
+    RETURN_FALSE_IF_FALSE(spi_device != SpiBus::INVALID_DEVICE);
+
+    spi_bus = bus;
+    return true;
+}
+
+bool Icm20948::plan_read(bool *completed)
+{
+    if (spi_bus == nullptr || current_bank != 0) {
+        return false;
+    }
+
+    const uint8_t header = ICM20948_SPI_RD_MASK | ICM20948_B0_INT_STATUS_1;
+    return spi_bus->plan_read(spi_device, &header, 1, PLANNED_READ_BYTES, planned_read_done, this, completed);
+}
+
+void Icm20948::planned_read_done(void *context, const uint8_t *rx, size_t len, uint64_t start_us)
+{
+    Icm20948* icm20948 = (Icm20948*)context;
+
+    // Cleared by this read, so it is only set once per output sample
+    if (!(rx[0] & ICM20948_INT_STATUS_1_RAW_DATA_0_RDY)) {
+        return;
+    }
+
+    ImuFifoSample sample;
+    icm20948->decode_frame(rx + PLANNED_STATUS_BYTES, sample);
+    icm20948->set_outputs(sample);
+    icm20948->stamp_sample(start_us);
+}
+
+////////////////////////////////////////////////////////////
+//                      Registers                         //
+////////////////////////////////////////////////////////////
+
+bool Icm20948::selectBank(uint8_t bank)
+{
+    if (bank == current_bank) {
+        return true;
+    }
+
+    // REG_BANK_SEL is at the same address in every bank
+    if (spi_bus != nullptr) {
+        const uint8_t tx[2] = {ICM20X_B0_REG_BANK_SEL, (uint8_t)(bank << 4)};
+        RETURN_FALSE_IF_FALSE(spi_bus->write(spi_device, tx, sizeof(tx)));
+        current_bank = bank;
+        return true;
+    }
+
+    digitalWrite(cs_pin, LOW);
+    _spi_instance->beginTransaction(settings);
+
+    _spi_instance->write(ICM20X_B0_REG_BANK_SEL);
+    _spi_instance->write(bank << 4);
+
+    _spi_instance->endTransaction();
+    digitalWrite(cs_pin, HIGH);
+
+    current_bank = bank;
+    return true;
+}
+
+bool Icm20948::readBurst(uint8_t bank, uint8_t reg, uint8_t *buffer, size_t len)
+{
+    RETURN_FALSE_IF_FALSE(selectBank(bank));
+
+    if (spi_bus != nullptr) {
+        const uint8_t header = ICM20948_SPI_RD_MASK | reg;
+        return spi_bus->read(spi_device, &header, 1, buffer, len);
+    }
+
+    digitalWrite(cs_pin, LOW);
+    _spi_instance->beginTransaction(settings);
+
+    _spi_instance->write(ICM20948_SPI_RD_MASK | reg);
+
+    // Addresses auto-increment, except FIFO_R_W which streams frames back to back
+    _spi_instance->transferBytes(nullptr, buffer, len);
+
+    _spi_instance->endTransaction();
+    digitalWrite(cs_pin, HIGH);
+
+    return true;
+}
+
+bool Icm20948::writeReg(uint8_t bank, uint8_t reg, uint8_t value)
+{
+    RETURN_FALSE_IF_FALSE(selectBank(bank));
+
+    if (spi_bus != nullptr) {
+        const uint8_t tx[2] = {(uint8_t)(reg & ~ICM20948_SPI_RD_MASK), value};
+        return spi_bus->write(spi_device, tx, sizeof(tx));
+    }
+
+    digitalWrite(cs_pin, LOW);
+    _spi_instance->beginTransaction(settings);
+
+    _spi_instance->write(reg & ~ICM20948_SPI_RD_MASK);
+    _spi_instance->write(value);
+
+    _spi_instance->endTransaction();
+    digitalWrite(cs_pin, HIGH);
+
+    return true;
+}
+
+bool Icm20948::writeMagReg(uint8_t reg, uint8_t value)
+{
+    RETURN_FALSE_IF_FALSE(writeReg(3, ICM20X_B3_I2C_SLV4_ADDR, AK09916_I2C_ADDR));
+    RETURN_FALSE_IF_FALSE(writeReg(3, ICM20X_B3_I2C_SLV4_REG, reg));
+    RETURN_FALSE_IF_FALSE(writeReg(3, ICM20X_B3_I2C_SLV4_DO, value));
+    RETURN_FALSE_IF_FALSE(writeReg(3, ICM20X_B3_I2C_SLV4_CTRL, 0x80));
+
+    return waitSlv4Done();
+}
+
+bool Icm20948::readMagReg(uint8_t reg, uint8_t& value)
+{
+    RETURN_FALSE_IF_FALSE(writeReg(3, ICM20X_B3_I2C_SLV4_ADDR, ICM20948_I2C_SLV_RD_MASK | AK09916_I2C_ADDR));
+    RETURN_FALSE_IF_FALSE(writeReg(3, ICM20X_B3_I2C_SLV4_REG, reg));
+    RETURN_FALSE_IF_FALSE(writeReg(3, ICM20X_B3_I2C_SLV4_CTRL, 0x80));
+
+    RETURN_FALSE_IF_FALSE(waitSlv4Done());
+    return readBurst(3, ICM20X_B3_I2C_SLV4_DI, &value, 1);
+}
+
+bool Icm20948::waitSlv4Done()
+{
+    for (int i = 0; i < 100; i++) {
+        uint8_t status = 0;
+        RETURN_FALSE_IF_FALSE(readBurst(0, ICM20X_B0_I2C_MST_STATUS, &status, 1));
+
+        // I2C_SLV4_NACK
+        if (status & 0x10) {
+            return false;
+        }
+
+        // I2C_SLV4_DONE
+        if (status & 0x40) {
+            return true;
+        }
+        delay(1);
+    }
+
+    DEBUGLN("AK09916 transfer timed out");
     return false;
 }
 
@@ -12,21 +12,55 @@
 #include "sensor_bases/AccelerometerBase.h"
 #include "sensor_bases/GyroscopeBase.h"
 #include "sensor_bases/MagnetometerBase.h"
+#include "sensor_bases/ImuFifoBase.h"
+#include "../os/spi_bus.h"
 
 namespace Cesium {
 namespace Sensor {
 
 #define AK09916_I2C_ADDR 0x0C
+#define AK09916_ST1_DRDY 0x01
+#define AK09916_ST2_HOFL 0x08
+#define AK09916_CNTL2_CONTINUOUS_100HZ 0x08
+#define AK09916_CNTL3_SRST 0x01
+
+// Registers not in Adafruit_ICM20X.h
+#define ICM20948_B0_INT_STATUS_1 0x1A
+#define ICM20948_INT_STATUS_1_RAW_DATA_0_RDY 0x01
+#define ICM20948_B0_EXT_SLV_SENS_DATA_00 0x3B
+#define ICM20948_B0_FIFO_EN_1 0x66
+#define ICM20948_B0_FIFO_EN_2 0x67
+#define ICM20948_B0_FIFO_RST 0x68
+#define ICM20948_B0_FIFO_MODE 0x69
+#define ICM20948_B0_FIFO_COUNTH 0x70
+#define ICM20948_B0_FIFO_R_W 0x72
+#define ICM20948_B2_ODR_ALIGN_EN 0x09
+
+#define ICM20948_SPI_RD_MASK 0x80
+#define ICM20948_I2C_SLV_RD_MASK 0x80
+
+class Icm20948 : public AccelerometerBase, public GyroscopeBase, public MagnetometerBase, public ImuFifoBase {
+
+public:
+    // Frame in both the data registers and the FIFO: accel xyz, gyro xyz, temperature (big-endian),
+    // then the AK09916 ST1..ST2 block read by I2C slave 0 (little-endian)
+    static constexpr size_t MAG_BYTES = 9;
+    static constexpr size_t FIFO_FRAME_BYTES = 6 + 6 + 2 + MAG_BYTES;
+    static constexpr size_t FIFO_CAPACITY_BYTES = 512;
+
+    // 1100 / (1 + 10) = 100 Hz gyro, matching the magnetometer so every frame has a fresh field
+    static constexpr uint8_t SAMPLE_RATE_DIV = 10;
+    static constexpr uint32_t FIFO_PERIOD_US = 10000;
+
+    static constexpr uint32_t SPI_CLOCK_HZ = 7000000;
+
+    // Planned reads start at INT_STATUS_1, so a pass faster than the output rate can tell there is nothing new
+    static constexpr size_t PLANNED_STATUS_BYTES = ICM20X_B0_ACCEL_XOUT_H - ICM20948_B0_INT_STATUS_1;
+    static constexpr size_t PLANNED_READ_BYTES = PLANNED_STATUS_BYTES + FIFO_FRAME_BYTES;
 
-class Icm20948 : public AccelerometerBase, public GyroscopeBase, public MagnetometerBase {
 private:
     Adafruit_ICM20948 device;
 
-    // TODO: add calibration stuff
-    Vector3<float> accel_bias[3];
-    Vector3<float> gyro_bias[3];
-    Vector3<float> mag_bias[3];
-
     uint8_t cs_pin;
 
     // To make them class-wide
@@ -34,7 +68,45 @@ private:
     sensors_event_t gyro_event;
     sensors_event_t temp_event;
     sensors_event_t mag_event;
-    
+
+    SPISettings settings;
+    uint8_t current_bank;
+
+    // Scale factors for the ranges set in setup()
+    float accel_mps2_per_lsb;
+    float w_rps_per_lsb;
+
+    // The ICM FIFO has no timestamps, frames are FIFO_PERIOD_US apart since the last flush
+    uint64_t fifo_frame_index;
+    float last_B_uT[3];
+
+    uint8_t fifo_buffer[FIFO_CAPACITY_BYTES];
+
+    // Set by attach_spi_bus(), register access then goes through the IDF driver instead of SPIClass
+    SpiBus* spi_bus;
+    uint8_t spi_device;
+
+    // Whole transfer in one chip-select assertion
+    bool readBurst(uint8_t bank, uint8_t reg, uint8_t* buffer, size_t len);
+    bool writeReg(uint8_t bank, uint8_t reg, uint8_t value);
+    bool selectBank(uint8_t bank);
+
+    // Single transfers to the AK09916 through I2C slave 4
+    bool writeMagReg(uint8_t reg, uint8_t value);
+    bool readMagReg(uint8_t reg, uint8_t& value);
+    bool waitSlv4Done();
+
+    bool setup_sampling();
+    bool setup_i2c_master();
+
+    // Reset and chip ID check without the Adafruit driver, which only talks through SPIClass
+    bool reset_device();
+
+    // Decodes one frame, B_uT keeps the last valid magnetometer sample when the AK09916 had nothing new
+    void decode_frame(const uint8_t* frame, ImuFifoSample& sample);
+    void set_outputs(const ImuFifoSample& sample);
+
+    static void planned_read_done(void* context, const uint8_t* rx, size_t len, uint64_t start_us);
 
 public:
 
@@ -45,6 +117,26 @@ public:
     bool setup();
     bool read();
 
+    // The CS pin moves to the bus's hardware CS
+    bool attach_spi_bus(SpiBus* bus);
+
+    // Only plans from bank 0, any other bank means a blocking transfer is mid-sequence.
+    // The sample is only updated and stamped when the chip had new raw data
+    bool plan_read(bool* completed = nullptr);
+
+    // Raw data ready as a 50 us pulse on INT1
+    bool enable_drdy_interrupt();
+
+    // FIFO, the ICM20948 has no watermark interrupt so the watermark is only reported
+    bool configure_fifo(uint16_t watermark_frames);
+    bool flush_fifo();
+    size_t get_fifo_frames();
+    size_t get_fifo_capacity_frames() const {return FIFO_CAPACITY_BYTES / FIFO_FRAME_BYTES;}
+    size_t read_fifo(ImuFifoSample* samples, size_t max_samples);
+
+    // Decodes raw frames (as read from FIFO_R_W) into calibrated samples
+    size_t decode_fifo(const uint8_t* raw, size_t frames, ImuFifoSample* samples);
+
 };
 
 
@@ -1,30 +1,149 @@
-#include "Ina233.h"
+#include "ina233.h"
 #include "../globals.h"
+#include "../os/instrumentation.h"
+#include "../os/trace.h"
+#include <Wire.h>
+#include <esp_timer.h>
 
 namespace Cesium {
 namespace Sensor {
+
+// Continuous shunt and bus conversions (datasheet table 7-8)
+static constexpr uint16_t ADC_MODE_CONTINUOUS = 0x7;
+static constexpr uint16_t ADC_CONFIG_RESERVED = 0x4000;
     
-Ina233::Ina233(uint8_t ina_addr) : addr(ina_addr) {}
+Ina233::Ina233(uint8_t ina_addr)
+    : device(ina_addr)
+    , averaging(Averaging::AVG_16)
+    , conversion_time(ConversionTime::US_1100)
+    , last_counters{}
+    , have_counters(false)
+    , energy_J(0)
+    , addr(ina_addr)
+{}
 
 bool Ina233::setup()
 {
     device.begin();
 
     CAL = device.setCalibration(R_shunt_IC1,I_max_IC1,&Current_LSB,&Power_LSB,&m_c,&R_c,&m_p,&R_p,&Set_ERROR);
+    RETURN_FALSE_IF_FALSE(Set_ERROR == 0);
     
     // Changes polarity of ALERT pin
     device.wireWriteByte(MFR_DEVICE_CONFIG, 0x06);
 
+    device.wireWriteWord(MFR_ADC_CONFIG, adc_config_word(averaging, conversion_time));
+
+    // Accumulates from here, the first read() only sets the starting point
+    device.wireSendCmd(CLEAR_EIN);
+    have_counters = false;
+    energy_J = 0;
+
     return true;
 }
 
 bool Ina233::read()
 {
+    PROBE_SCOPE("Ina233::read");
+    TRACE_SCOPE("Ina233::read");
+
+    EnergyCounters counters;
+    RETURN_FALSE_IF_FALSE(read_energy(counters));
+
+    uint64_t now_us = esp_timer_get_time();
     bus_voltage_V = device.getBusVoltage_V();
-    DEBUG("Bus Voltage:   "); DEBUG(bus_voltage_V); DEBUGLN(" V, ");
+    bus_current_mA = device.getCurrent_mA();
+
+    bool first = !have_counters;
+    EnergyCounters previous = last_counters;
+    uint64_t previous_us = last_read_us;
+
+    last_counters = counters;
+    last_read_us = now_us;
+    have_counters = true;
+
+    if (first) {
+        return false;
+    }
+
+    float raw_power;
+    uint32_t samples;
+    if (!average_power_raw(previous, counters, raw_power, samples)) {
+        return false;
+    }
+
+    PowerReading reading;
+    reading.time_us = now_us;
+    reading.bus_voltage_V = bus_voltage_V;
+    reading.current_mA = bus_current_mA;
+    reading.average_power_mW = raw_power * Power_LSB;
+    reading.window_s = (now_us - previous_us) * 1e-6f;
+    reading.window_samples = samples;
+
+    // The accumulator covers every conversion, so mean power x wall time is the energy used
+    energy_J += reading.average_power_mW * 1e-3 * reading.window_s;
+    reading.energy_J = energy_J;
+
+    reading_slot.write(reading);
+
+    DEBUG("Bus Voltage:   "); DEBUG(bus_voltage_V); DEBUG(" V, Average power: "); DEBUG(reading.average_power_mW); DEBUGLN(" mW");
+
+    return true;
+}
+
+bool Ina233::read_energy(EnergyCounters &counters)
+{
+    Wire.beginTransmission(addr);
+    Wire.write(READ_EIN);
+    RETURN_FALSE_IF_FALSE(Wire.endTransmission(false) == 0);
+
+    // PMBus block read: byte count, then the block
+    RETURN_FALSE_IF_FALSE(Wire.requestFrom(addr, (uint8_t)(EIN_BYTES + 1), true) == EIN_BYTES + 1);
+    if (Wire.read() != EIN_BYTES) {
+        DEBUGLN("INA233 READ_EIN bad byte count");
+        return false;
+    }
+
+    uint8_t block[EIN_BYTES];
+    for (size_t i = 0; i < EIN_BYTES; i++) {
+        block[i] = Wire.read();
+    }
 
+    counters = decode_energy(block);
     return true;
 }
 
+EnergyCounters Ina233::decode_energy(const uint8_t *block)
+{
+    EnergyCounters counters;
+
+    // Accumulator low, high, rollover count, then sample count low, mid, high
+    counters.accumulator = (uint32_t)block[2] << 16 | (uint32_t)block[1] << 8 | block[0];
+    counters.sample_count = (uint32_t)block[5] << 16 | (uint32_t)block[4] << 8 | block[3];
+
+    return counters;
+}
+
+bool Ina233::average_power_raw(const EnergyCounters &previous, const EnergyCounters &current, float &raw_power, uint32_t &samples)
+{
+    samples = (current.sample_count - previous.sample_count) & COUNTER_MASK;
+    if (samples == 0) {
+        return false;
+    }
+
+    uint32_t accumulated = (current.accumulator - previous.accumulator) & COUNTER_MASK;
+    raw_power = (float)accumulated / samples;
+    return true;
+}
+
+uint16_t Ina233::adc_config_word(Averaging avg, ConversionTime conversion)
+{
+    return ADC_CONFIG_RESERVED
+        | (uint16_t)avg << 9
+        | (uint16_t)conversion << 6
+        | (uint16_t)conversion << 3
+        | ADC_MODE_CONTINUOUS;
+}
+
+}
 }
-}
\ No newline at end of file
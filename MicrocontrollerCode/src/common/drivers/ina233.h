@@ -7,21 +7,99 @@
 #include <Arduino.h>
 #include <infinityPV_INA233.h>
 
+#include "../os/spsc_queue.h"
+
 
 namespace Cesium {
 namespace Sensor {
 
+// One READ_EIN block. Both counters are 24 bits and wrap
+struct EnergyCounters {
+    uint32_t accumulator;   // Sum of raw power readings, rollover count in the top byte
+    uint32_t sample_count;
+};
+
+// What a poll measured, from the energy accumulator since the previous poll
+struct PowerReading {
+    uint64_t time_us;
+    float bus_voltage_V;        // Instantaneous
+    float current_mA;           // Instantaneous
+    float average_power_mW;     // Exact mean over every conversion in the window
+    float energy_J;             // Since setup() or reset_energy()
+    float window_s;
+    uint32_t window_samples;
+};
+
 class Ina233 {
+public:
+    // MFR_ADC_CONFIG AVG field, conversions averaged per result
+    enum class Averaging : uint8_t {
+        AVG_1 = 0,
+        AVG_4 = 1,
+        AVG_16 = 2,
+        AVG_64 = 3,
+        AVG_128 = 4,
+        AVG_256 = 5,
+        AVG_512 = 6,
+        AVG_1024 = 7
+    };
+
+    // MFR_ADC_CONFIG VBUSCT/VSHCT fields
+    enum class ConversionTime : uint8_t {
+        US_140 = 0,
+        US_204 = 1,
+        US_332 = 2,
+        US_588 = 3,
+        US_1100 = 4,
+        US_2116 = 5,
+        US_4156 = 6,
+        US_8244 = 7
+    };
+
+    static constexpr uint32_t COUNTER_MASK = 0xFFFFFF;
+    static constexpr uint8_t EIN_BYTES = 6;
+
 private:
     INA233 device;
     uint64_t last_read_us = 0;
 
+    Averaging averaging;
+    ConversionTime conversion_time;
+
+    EnergyCounters last_counters;
+    bool have_counters;
+    double energy_J;
+
+    SeqLock<PowerReading> reading_slot;
+
+    // The library's block read drops the PMBus byte count, so this one is done here
+    bool read_energy(EnergyCounters& counters);
+
 public:
 
     Ina233(uint8_t ina_addr);
+
+    // Averaging and conversion times are written by setup(). With 16 x 1.1 ms on both channels a
+    // result is ready every 35 ms, so the 24-bit accumulator can't wrap between 1 Hz polls
+    inline void set_adc_config(Averaging avg, ConversionTime conversion) {averaging = avg; conversion_time = conversion;}
     bool setup();
+
+    // One poll: READ_EIN plus the instantaneous bus voltage and current
     bool read();
 
+    inline void reset_energy() {energy_J = 0;}
+
+    // Newest poll from any task, false before the second read()
+    inline bool get_reading(PowerReading& reading) const {return reading_slot.read(reading);}
+
+    static EnergyCounters decode_energy(const uint8_t* block);
+
+    // Mean raw power between two READ_EINs, handling the 24-bit wrap. False if no conversion finished in between
+    static bool average_power_raw(const EnergyCounters& previous, const EnergyCounters& current, float& raw_power, uint32_t& samples);
+
+    // MFR_ADC_CONFIG word for continuous shunt and bus conversions
+    static uint16_t adc_config_word(Averaging avg, ConversionTime conversion);
+
     uint8_t addr = 0x40;
     float bus_current_mA = 0;
     float bus_voltage_V = 0;
@@ -46,4 +124,4 @@ public:
 };
 
 } // namespace Sensor
-} // namespace Cesium
\ No newline at end of file
+} // namespace Cesium
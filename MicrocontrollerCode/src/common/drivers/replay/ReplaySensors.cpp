@@ -0,0 +1,202 @@
+#include "ReplaySensors.h"
+#include <stddef.h>
+
+namespace Cesium {
+namespace Sensor {
+
+////////////////////////////////////////////////////////////
+//                         IMU                            //
+////////////////////////////////////////////////////////////
+
+ReplayImu::ReplayImu(Format format, uint8_t imu_id)
+    : format{format}
+    , source{format == Format::FIFO ? sizeof(ImuFifoSample) : sizeof(ImuSample)}
+    , fifo_source{format == Format::FIFO ? sizeof(ImuFifoSample) : sizeof(ImuSample)}
+{
+    if (format == Format::PIPELINE) {
+        source.set_id_filter(offsetof(ImuSample, imu_id), imu_id);
+    }
+}
+
+bool ReplayImu::configure(const char *config_name)
+{
+    return true;
+}
+
+bool ReplayImu::setup()
+{
+    return source.size() > 0;
+}
+
+bool ReplayImu::read()
+{
+    const uint8_t* record = source.next();
+    if (record == nullptr) {
+        return false;
+    }
+
+    ImuFifoSample sample;
+    to_fifo_sample(record, sample);
+    for (size_t i = 0; i < 3; i++) {
+        accel_mps2[i][0] = sample.accel_mps2[i];
+        w_rps[i][0] = sample.w_rps[i];
+    }
+    temp_C = sample.temp_C;
+
+    if (format == Format::FIFO) {
+        for (size_t i = 0; i < 3; i++) {
+            B_uT[i][0] = sample.B_uT[i];
+        }
+        calibrate_mag();
+    }
+
+    calibrate_accel();
+    calibrate_gyro();
+    stamp_sample(sample.time_us);
+    return true;
+}
+
+void ReplayImu::to_fifo_sample(const uint8_t *record, ImuFifoSample &sample) const
+{
+    // Copied out, the log is packed
+    if (format == Format::FIFO) {
+        memcpy(&sample, record, sizeof(sample));
+        return;
+    }
+
+    ImuSample imu_sample;
+    memcpy(&imu_sample, record, sizeof(imu_sample));
+    sample.time_us = imu_sample.time_us;
+    for (size_t i = 0; i < 3; i++) {
+        sample.accel_mps2[i] = imu_sample.accel_mps2[i];
+        sample.w_rps[i] = imu_sample.w_rps[i];
+        sample.B_uT[i] = NAN;
+    }
+    sample.temp_C = imu_sample.temp_C;
+}
+
+void ReplayImu::sync_fifo_source()
+{
+    if (fifo_source.get_data() != source.get_data()) {
+        fifo_source.share(source);
+    }
+}
+
+bool ReplayImu::configure_fifo(uint16_t watermark_frames)
+{
+    fifo_watermark_frames = watermark_frames;
+    sync_fifo_source();
+    return true;
+}
+
+bool ReplayImu::flush_fifo()
+{
+    sync_fifo_source();
+    while (fifo_source.next_due() != nullptr) {}
+
+    fifo_frames_read = 0;
+    fifo_frames_skipped = 0;
+    return true;
+}
+
+size_t ReplayImu::get_fifo_frames()
+{
+    sync_fifo_source();
+    // A full FIFO stops counting, like the hardware ones
+    return fifo_source.due_count(get_fifo_capacity_frames());
+}
+
+size_t ReplayImu::read_fifo(ImuFifoSample *samples, size_t max_samples)
+{
+    sync_fifo_source();
+
+    size_t count = 0;
+    const uint8_t* record;
+    while (count < max_samples && (record = fifo_source.next_due()) != nullptr) {
+        to_fifo_sample(record, samples[count++]);
+    }
+
+    // Body frame, like the hardware drivers leave their FIFO samples
+    uint8_t* block = reinterpret_cast<uint8_t*>(samples);
+    accel_calibration.apply_batch(block, offsetof(ImuFifoSample, accel_mps2), sizeof(ImuFifoSample), count);
+    gyro_calibration.apply_batch(block, offsetof(ImuFifoSample, w_rps), sizeof(ImuFifoSample), count);
+    if (format == Format::FIFO) {
+        mag_calibration.apply_batch(block, offsetof(ImuFifoSample, B_uT), sizeof(ImuFifoSample), count);
+    }
+
+    fifo_frames_read += count;
+    return count;
+}
+
+////////////////////////////////////////////////////////////
+//                      Barometer                         //
+////////////////////////////////////////////////////////////
+
+ReplayBarometer::ReplayBarometer(uint8_t baro_id)
+    : source{sizeof(BaroSample)}
+{
+    source.set_id_filter(offsetof(BaroSample, baro_id), baro_id);
+}
+
+bool ReplayBarometer::configure(const char *config_name)
+{
+    return true;
+}
+
+bool ReplayBarometer::setup()
+{
+    return source.size() > 0;
+}
+
+bool ReplayBarometer::read()
+{
+    const uint8_t* record = source.next();
+    if (record == nullptr) {
+        return false;
+    }
+
+    BaroSample sample;
+    memcpy(&sample, record, sizeof(sample));
+    pressure_kPa = sample.pressure_kPa;
+    altitude_m = sample.altitude_m;
+    temp_C = sample.temp_C;
+
+    stamp_sample(sample.time_us);
+    return true;
+}
+
+////////////////////////////////////////////////////////////
+//                         GPS                            //
+////////////////////////////////////////////////////////////
+
+ReplayGps::ReplayGps()
+    : source{sizeof(GpsFix)}
+{}
+
+bool ReplayGps::configure(const char *config_name)
+{
+    return true;
+}
+
+bool ReplayGps::setup()
+{
+    return source.size() > 0;
+}
+
+bool ReplayGps::read()
+{
+    const uint8_t* record = source.next();
+    if (record == nullptr) {
+        return false;
+    }
+
+    GpsFix fix;
+    memcpy(&fix, record, sizeof(fix));
+    stamp_sample(fix.time_us);
+    publish_fix(fix);
+
+    return true;
+}
+
+} // namespace Sensor
+} // namespace Cesium
@@ -0,0 +1,97 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Sensor drivers that play back recorded logs instead of talking to hardware
+
+#include <Arduino.h>
+
+#include "ReplaySource.h"
+#include "../sensor_bases/AccelerometerBase.h"
+#include "../sensor_bases/GyroscopeBase.h"
+#include "../sensor_bases/MagnetometerBase.h"
+#include "../sensor_bases/BarometerBase.h"
+#include "../sensor_bases/GpsBase.h"
+#include "../sensor_bases/ImuFifoBase.h"
+#include "../../os/log_records.h"
+
+namespace Cesium {
+namespace Sensor {
+
+// All of them: open() or attach() the log through get_source(), start the ReplayClock, then use them like the real
+// drivers. read() is false until the clock reaches the next record. Samples are stamped with their logged time_us
+
+// FIFO logs (ImuFifoSample) also carry the magnetometer. Pipeline IMU logs (ImuSample) hold every IMU,
+// so give the imu_id to replay. The FIFO interface drains the same log with its own cursor, like the
+// hardware FIFO filling alongside the data registers
+class ReplayImu : public AccelerometerBase, public GyroscopeBase, public MagnetometerBase, public ImuFifoBase {
+
+public:
+    enum class Format : uint8_t {
+        FIFO,
+        PIPELINE
+    };
+
+private:
+    Format format;
+    ReplaySource source;
+    ReplaySource fifo_source;
+
+    // Follows source, which may be opened after configure_fifo()
+    void sync_fifo_source();
+
+    // One record of either format as a FIFO frame, still in the log's frame
+    void to_fifo_sample(const uint8_t* record, ImuFifoSample& sample) const;
+
+public:
+    ReplayImu(Format format = Format::FIFO, uint8_t imu_id = ReplaySource::ANY_ID);
+
+    // The log is the configuration. Set calibrations directly, FIFO logs are already in the body frame
+    bool configure(const char* config_name);
+    bool setup();
+    bool read();
+
+    // Every due record is waiting in the FIFO, and it never overflows
+    bool configure_fifo(uint16_t watermark_frames);
+    bool flush_fifo();
+    size_t get_fifo_frames();
+    inline size_t get_fifo_capacity_frames() const {return UINT16_MAX;}
+    size_t read_fifo(ImuFifoSample* samples, size_t max_samples);
+
+    inline ReplaySource& get_source() {return source;}
+};
+
+class ReplayBarometer : public BarometerBase {
+
+private:
+    ReplaySource source;
+
+public:
+    // From a pipeline baro log (BaroSample)
+    ReplayBarometer(uint8_t baro_id = ReplaySource::ANY_ID);
+
+    bool configure(const char* config_name);
+    bool setup();
+    bool read();
+
+    inline ReplaySource& get_source() {return source;}
+};
+
+class ReplayGps : public GpsBase {
+
+private:
+    ReplaySource source;
+
+public:
+    // From a log of GpsFix structs, as get_fix() returns them
+    ReplayGps();
+
+    bool configure(const char* config_name);
+    bool setup();
+    bool read();
+
+    inline ReplaySource& get_source() {return source;}
+};
+
+} // namespace Sensor
+} // namespace Cesium
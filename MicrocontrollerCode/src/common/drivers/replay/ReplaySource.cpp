@@ -0,0 +1,313 @@
+#include "ReplaySource.h"
+#include <esp_timer.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Cesium {
+namespace Sensor {
+
+////////////////////////////////////////////////////////////
+//                        Clock                           //
+////////////////////////////////////////////////////////////
+
+ReplayClock::Mode ReplayClock::mode = ReplayClock::Mode::REAL_TIME;
+float ReplayClock::speed = 1.0f;
+uint64_t ReplayClock::log_start_us = 0;
+int64_t ReplayClock::wall_start_us = 0;
+uint64_t ReplayClock::manual_us = 0;
+ReplaySource* ReplayClock::sources[MAX_SOURCES] = {};
+size_t ReplayClock::source_count = 0;
+portMUX_TYPE ReplayClock::mux = portMUX_INITIALIZER_UNLOCKED;
+
+void ReplayClock::start(uint64_t log_start_us, Mode mode, float speed)
+{
+    ReplayClock::mode = mode;
+    ReplayClock::speed = speed > 0 ? speed : 1.0f;
+    ReplayClock::log_start_us = log_start_us;
+    wall_start_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&mux);
+    manual_us = log_start_us;
+    portEXIT_CRITICAL(&mux);
+}
+
+uint64_t ReplayClock::now_us()
+{
+    if (mode != Mode::REAL_TIME) {
+        portENTER_CRITICAL(&mux);
+        uint64_t now = manual_us;
+        portEXIT_CRITICAL(&mux);
+        return now;
+    }
+    return log_start_us + (uint64_t)((esp_timer_get_time() - wall_start_us) * (double)speed);
+}
+
+void ReplayClock::advance_to(uint64_t log_time_us)
+{
+    portENTER_CRITICAL(&mux);
+    if (mode == Mode::MANUAL && log_time_us > manual_us) {
+        manual_us = log_time_us;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+void ReplayClock::add_source(ReplaySource *source)
+{
+    portENTER_CRITICAL(&mux);
+    bool listed = false;
+    for (size_t i = 0; i < source_count; i++) {
+        listed |= sources[i] == source;
+    }
+    bool full = !listed && source_count >= MAX_SOURCES;
+    if (!listed && !full) {
+        sources[source_count++] = source;
+    }
+    portEXIT_CRITICAL(&mux);
+
+    if (full) {
+        DEBUGLN("Too many replay sources, FREE_RUNNING ignores this one");
+    }
+}
+
+void ReplayClock::remove_source(ReplaySource *source)
+{
+    portENTER_CRITICAL(&mux);
+    for (size_t i = 0; i < source_count; i++) {
+        if (sources[i] == source) {
+            sources[i] = sources[--source_count];
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+void ReplayClock::step()
+{
+    portENTER_CRITICAL(&mux);
+    // Records at or before now are already due, whether or not their source has read them yet
+    uint64_t earliest = UINT64_MAX;
+    for (size_t i = 0; i < source_count; i++) {
+        uint64_t pending = sources[i]->pending_us;
+        if (pending > manual_us && pending < earliest) {
+            earliest = pending;
+        }
+    }
+    if (mode == Mode::FREE_RUNNING && earliest != UINT64_MAX) {
+        manual_us = earliest;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+////////////////////////////////////////////////////////////
+//                        Source                          //
+////////////////////////////////////////////////////////////
+
+ReplaySource::ReplaySource(size_t record_size)
+    : data{nullptr}
+    , record_size{record_size}
+    , record_count{0}
+    , cursor{0}
+    , id_offset{0}
+    , id{ANY_ID}
+    , skipped{0}
+    , pending_us{UINT64_MAX}
+#if defined(__linux__)
+    , mapping{nullptr}
+    , mapping_len{0}
+#endif
+{}
+
+ReplaySource::~ReplaySource()
+{
+    close();
+}
+
+bool ReplaySource::open(const char *path)
+{
+#if defined(__linux__)
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        DEBUGLN("Could not open replay log");
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // Read-only and shared, so several sources can map the same pipeline log
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    // Replay reads front to back
+    madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+
+    mapping = mapped;
+    mapping_len = st.st_size;
+    attach((const uint8_t*)mapped, st.st_size);
+    return true;
+#else
+    // No mmap on the ESP32, load the log into memory and attach() it
+    return false;
+#endif
+}
+
+void ReplaySource::attach(const uint8_t *buffer, size_t len)
+{
+    data = buffer;
+    // A record cut off at the end of a log is ignored
+    record_count = buffer == nullptr ? 0 : len / record_size;
+    rewind();
+
+    if (buffer == nullptr) {
+        ReplayClock::remove_source(this);
+    } else {
+        ReplayClock::add_source(this);
+    }
+}
+
+void ReplaySource::close()
+{
+#if defined(__linux__)
+    if (mapping != nullptr) {
+        munmap(mapping, mapping_len);
+        mapping = nullptr;
+        mapping_len = 0;
+    }
+#endif
+    attach(nullptr, 0);
+}
+
+void ReplaySource::set_id_filter(size_t id_offset, uint8_t id)
+{
+    this->id_offset = id_offset;
+    this->id = id;
+    update_pending();
+}
+
+void ReplaySource::share(const ReplaySource &other)
+{
+    attach(other.data, other.record_count * record_size);
+    set_id_filter(other.id_offset, other.id);
+}
+
+bool ReplaySource::accepts(size_t index) const
+{
+    return id == ANY_ID || data[index * record_size + id_offset] == id;
+}
+
+void ReplaySource::update_pending()
+{
+    uint64_t pending = UINT64_MAX;
+    for (size_t i = cursor; i < record_count; i++) {
+        if (accepts(i)) {
+            pending = time_at(i);
+            break;
+        }
+    }
+
+    portENTER_CRITICAL(&ReplayClock::mux);
+    pending_us = pending;
+    portEXIT_CRITICAL(&ReplayClock::mux);
+}
+
+void ReplaySource::rewind()
+{
+    cursor = 0;
+    skipped = 0;
+    update_pending();
+}
+
+uint64_t ReplaySource::time_at(size_t index) const
+{
+    // Records are packed, so time_us may not be aligned
+    uint64_t time_us;
+    memcpy(&time_us, data + index * record_size, sizeof(time_us));
+    return time_us;
+}
+
+uint64_t ReplaySource::first_time_us() const
+{
+    for (size_t i = 0; i < record_count; i++) {
+        if (accepts(i)) {
+            return time_at(i);
+        }
+    }
+    return 0;
+}
+
+size_t ReplaySource::due_count(size_t max_count) const
+{
+    uint64_t now_us = ReplayClock::now_us();
+
+    size_t count = 0;
+    for (size_t i = cursor; i < record_count && count < max_count; i++) {
+        if (!accepts(i)) {
+            continue;
+        }
+        if (time_at(i) > now_us) {
+            break;
+        }
+        count++;
+    }
+    return count;
+}
+
+const uint8_t* ReplaySource::next(bool skip_stale)
+{
+    if (ReplayClock::get_mode() == ReplayClock::Mode::FREE_RUNNING && pending_us > ReplayClock::now_us()) {
+        ReplayClock::step();
+    }
+    return take_due(skip_stale);
+}
+
+const uint8_t* ReplaySource::next_due()
+{
+    return take_due(false);
+}
+
+const uint8_t* ReplaySource::take_due(bool skip_stale)
+{
+    uint64_t now_us = ReplayClock::now_us();
+
+    int found = -1;
+    while (cursor < record_count) {
+        if (!accepts(cursor)) {
+            cursor++;
+            continue;
+        }
+        if (time_at(cursor) > now_us) {
+            break;
+        }
+
+        if (found >= 0) {
+            skipped++;
+        }
+        found = cursor++;
+
+        if (!skip_stale) {
+            break;
+        }
+    }
+
+    update_pending();
+    if (found < 0) {
+        return nullptr;
+    }
+    return data + found * record_size;
+}
+
+} // namespace Sensor
+} // namespace Cesium
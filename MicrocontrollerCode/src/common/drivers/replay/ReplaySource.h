@@ -0,0 +1,134 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Read-only view of a recorded log and the clock that paces its replay
+
+#include <Arduino.h>
+#include "../../globals.h"
+
+namespace Cesium {
+namespace Sensor {
+
+class ReplaySource;
+
+// Log time every replay driver reads against. Log time is the time_us recorded in the log,
+// so replayed samples keep their original spacing whatever the speed
+class ReplayClock {
+
+public:
+    enum class Mode : uint8_t {
+        REAL_TIME,      // Log time follows esp_timer, scaled by speed (100 = 100x real time)
+        FREE_RUNNING,   // Log time steps to the next record of any source whenever a read() finds nothing due
+        MANUAL          // Log time only moves with advance_to(), for deterministic runs
+    };
+
+private:
+    static Mode mode;
+    static float speed;
+    static uint64_t log_start_us;
+    static int64_t wall_start_us;
+    static uint64_t manual_us;
+
+    // Every source with a log attached, so FREE_RUNNING keeps all of them in log time order
+    static constexpr size_t MAX_SOURCES = 16;
+    static ReplaySource* sources[MAX_SOURCES];
+    static size_t source_count;
+    static portMUX_TYPE mux;
+
+    friend class ReplaySource;
+    static void add_source(ReplaySource* source);
+    static void remove_source(ReplaySource* source);
+
+    // FREE_RUNNING only. Moves log time on to the earliest record a source is still waiting on
+    static void step();
+
+public:
+    // log_start_us is usually the first time_us in the logs being replayed
+    static void start(uint64_t log_start_us, Mode mode = Mode::REAL_TIME, float speed = 1.0f);
+
+    // Log time now. In FREE_RUNNING it is the record time last stepped to
+    static uint64_t now_us();
+
+    // MANUAL only, and never backwards
+    static void advance_to(uint64_t log_time_us);
+
+    static inline Mode get_mode() {return mode;}
+    static inline float get_speed() {return speed;}
+};
+
+// Fixed-size records, oldest first, each starting with its uint64_t time_us (ImuSample, BaroSample,
+// ImuFifoSample and GpsFix all do). Memory-mapped from a file on Linux, or any buffer that outlives the source
+class ReplaySource {
+
+public:
+    static constexpr uint8_t ANY_ID = 0xFF;
+
+private:
+    const uint8_t* data;
+    size_t record_size;
+    size_t record_count;
+    size_t cursor;          // Next record not yet handed out
+
+    // Only records with this id byte are replayed, so one pipeline log can feed several drivers
+    size_t id_offset;
+    uint8_t id;
+
+    uint32_t skipped;       // Due records passed over for a newer one
+
+    // time_us of the next accepted record, UINT64_MAX once finished. Written under the ReplayClock mux
+    uint64_t pending_us;
+
+#if defined(__linux__)
+    void* mapping;
+    size_t mapping_len;
+#endif
+
+    bool accepts(size_t index) const;
+    void update_pending();
+    const uint8_t* take_due(bool skip_stale);
+
+    friend class ReplayClock;
+
+public:
+    ReplaySource(size_t record_size);
+    ~ReplaySource();
+
+    // Linux only. The log stays mapped until close()
+    bool open(const char* path);
+    void attach(const uint8_t* buffer, size_t len);
+    void close();
+
+    void set_id_filter(size_t id_offset, uint8_t id);
+
+    // Same records and filter as other, with a cursor of its own. Does not own the log
+    void share(const ReplaySource& other);
+
+    // Oldest due record, or the newest due one and the rest skipped with skip_stale. nullptr if none is due.
+    // With nothing due, FREE_RUNNING first steps the clock, which may only make another source's record due
+    const uint8_t* next(bool skip_stale = true);
+
+    // Oldest due record without ever stepping the clock, for draining a backlog like a FIFO
+    const uint8_t* next_due();
+
+    void rewind();
+
+    inline size_t size() const {return record_count;}
+    inline size_t remaining() const {return record_count - cursor;}
+    inline bool finished() const {return cursor >= record_count;}
+    inline uint32_t get_skipped() const {return skipped;}
+    inline const uint8_t* get_data() const {return data;}
+
+    // Accepted records next_due() could return now, counting stops at max_count
+    size_t due_count(size_t max_count) const;
+
+    uint64_t time_at(size_t index) const;
+
+    // time_us of the first accepted record, 0 if there is none
+    uint64_t first_time_us() const;
+
+    DELETE_COPY_AND_ASSIGNMENT(ReplaySource)
+};
+
+} // namespace Sensor
+} // namespace Cesium
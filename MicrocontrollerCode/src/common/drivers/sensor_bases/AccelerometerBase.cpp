@@ -7,6 +7,7 @@ namespace Sensor {
 AccelerometerBase::AccelerometerBase()
     : accel_mps2{}
     , accel_body_mps2{}
+    , accel_calibration{}
 {}
 
 AccelerometerBase::~AccelerometerBase()
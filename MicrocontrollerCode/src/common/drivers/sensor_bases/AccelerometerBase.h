@@ -2,6 +2,8 @@
 
 #include "SensorBase.h"
 #include "../../math/vector.h"
+#include "TimedSample.h"
+#include "Calibration.h"
 
 namespace Cesium {
 namespace Sensor {
@@ -10,6 +12,10 @@ class AccelerometerBase : virtual public SensorBase {
 protected:
     Vector3<float> accel_mps2;
     Vector3<float> accel_body_mps2;
+    Calibration3 accel_calibration;
+
+    // Fills accel_body_mps2 from accel_mps2, for drivers to call once accel_mps2 is set
+    inline void calibrate_accel() {accel_calibration.apply(accel_mps2, accel_body_mps2);}
 
 
 public:
@@ -21,6 +27,13 @@ public:
 
     const Vector3<float>& get_accel_mps2() {return accel_mps2;}
     const Vector3<float>& get_accel_body_mps2() {return accel_body_mps2;}
+
+    // Stamped with the time of the last read(), for aligning with other sensors
+    inline TimedVector3 get_accel_sample() const {return {sample_time_us, accel_mps2};}
+    inline TimedVector3 get_accel_body_sample() const {return {sample_time_us, accel_body_mps2};}
+
+    void set_accel_calibration(const Calibration3& calibration) {accel_calibration = calibration;}
+    const Calibration3& get_accel_calibration() const {return accel_calibration;}
 };
 
 
@@ -1,4 +1,5 @@
 #include "BarometerBase.h"
+#include <esp_timer.h>
 
 namespace Cesium {
 namespace Sensor {
@@ -7,6 +8,9 @@ namespace Sensor {
 BarometerBase::BarometerBase()
     : altitude_m{}
     , pressure_kPa{}
+    , conversion_start_us{0}
+    , conversion_time_us{0}
+    , last_sample_start_us{0}
 {}
 
 BarometerBase::~BarometerBase()
@@ -19,5 +23,21 @@ bool BarometerBase::read()
     return SensorBase::read();
 }
 
+void BarometerBase::conversion_started(uint32_t time_us)
+{
+    conversion_start_us = esp_timer_get_time();
+    conversion_time_us = time_us;
+}
+
+bool BarometerBase::conversion_elapsed() const
+{
+    return esp_timer_get_time() - conversion_start_us >= conversion_time_us;
+}
+
+bool BarometerBase::sample_due() const
+{
+    return esp_timer_get_time() - last_sample_start_us >= (uint64_t)read_interval_ms * 1000;
+}
+
 } // namespace Sensor
 } // namespace Cesium
\ No newline at end of file
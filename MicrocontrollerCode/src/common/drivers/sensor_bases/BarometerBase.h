@@ -2,6 +2,7 @@
 
 #include "SensorBase.h"
 #include "../../math/vector.h"
+#include "TimedSample.h"
 
 namespace Cesium {
 namespace Sensor {
@@ -11,12 +12,30 @@ protected:
     float altitude_m;
     float pressure_kPa;
 
+    // Non-blocking conversions: start one, then come back once conversion_time_us has passed
+    uint64_t conversion_start_us;
+    uint32_t conversion_time_us;
+    uint64_t last_sample_start_us;
+
+    void conversion_started(uint32_t time_us);
+    bool conversion_elapsed() const;
+
+    // Whether read_interval_ms has passed since the last pressure sample was started
+    bool sample_due() const;
+
 public:
 
     BarometerBase();
     virtual ~BarometerBase();
 
+    // Drivers with a conversion state machine return false until a new pressure sample is ready
     virtual bool read(); 
+
+    inline float get_pressure_kPa() const {return pressure_kPa;}
+    inline float get_altitude_m() const {return altitude_m;}
+
+    // Stamped at the middle of the pressure conversion
+    inline TimedBaro get_baro_sample() const {return {sample_time_us, {pressure_kPa, altitude_m, temp_C}};}
 };
 
 
@@ -0,0 +1,43 @@
+#include "Calibration.h"
+
+namespace Cesium {
+namespace Sensor {
+
+Calibration3::Calibration3()
+    : M{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}
+    , offset{0, 0, 0}
+{}
+
+Calibration3::Calibration3(const Matrix3<float> &sensor_to_body, const Vector3<float> &bias)
+    : Calibration3(sensor_to_body, {{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}}, {{{1}, {1}, {1}}}, bias)
+{}
+
+Calibration3::Calibration3(const Matrix3<float> &sensor_to_body, const Matrix3<float> &misalignment,
+                           const Vector3<float> &scale, const Vector3<float> &bias)
+{
+    // Scale is diagonal, so it only scales the columns
+    Matrix3<float> fused = sensor_to_body * misalignment;
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            M[i][j] = fused[i][j] * scale[j][0];
+        }
+    }
+
+    for (size_t i = 0; i < 3; i++) {
+        offset[i] = -(M[i][0] * bias[0][0] + M[i][1] * bias[1][0] + M[i][2] * bias[2][0]);
+    }
+}
+
+void Calibration3::apply_batch(uint8_t *base, size_t field_offset, size_t stride, size_t count) const
+{
+    uint8_t* field = base + field_offset;
+    for (size_t i = 0; i < count; i++, field += stride) {
+        float vec[3];
+        memcpy(vec, field, sizeof(vec));
+        apply(vec, vec);
+        memcpy(field, vec, sizeof(vec));
+    }
+}
+
+} // namespace Sensor
+} // namespace Cesium
@@ -0,0 +1,57 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Sensor-to-body correction (rotation, misalignment, scale and bias) folded into one 3x3 and an offset
+
+#include <Arduino.h>
+#include "../../math/vector.h"
+#include "../../math/flat_matrix.h"
+
+namespace Cesium {
+namespace Sensor {
+
+// body = M * raw + offset, where M = sensor_to_body * misalignment * scale and offset = -M * bias.
+// Folded once when the config loads, so each vector costs 9 multiply-adds and 3 adds
+struct Calibration3 {
+    float M[3][3];
+    float offset[3];
+
+    // Identity, the body frame is the sensor frame
+    Calibration3();
+
+    Calibration3(const Matrix3<float>& sensor_to_body, const Vector3<float>& bias);
+    Calibration3(const Matrix3<float>& sensor_to_body, const Matrix3<float>& misalignment,
+                 const Vector3<float>& scale, const Vector3<float>& bias);
+
+    // in and out may be the same array
+    inline void apply(const float* in, float* out) const {
+        float x = in[0];
+        float y = in[1];
+        float z = in[2];
+        for (size_t i = 0; i < 3; i++) {
+            out[i] = offset[i] + M[i][0] * x + M[i][1] * y + M[i][2] * z;
+        }
+    }
+
+    inline void apply(const Vector3<float>& in, Vector3<float>& out) const {
+        float raw[3] = {in[0][0], in[1][0], in[2][0]};
+        float body[3];
+        apply(raw, body);
+        for (size_t i = 0; i < 3; i++) {
+            out[i][0] = body[i];
+        }
+    }
+
+    inline void apply(const Vec<float, 3>& in, Vec<float, 3>& out) const {
+        apply(in.data(), out.data());
+    }
+
+    // Corrects the vector field_offset bytes into each of count records, each stride bytes after the last.
+    // Copied in and out, so the records may be packed. For one field of a FIFO block:
+    // apply_batch((uint8_t*)samples, offsetof(ImuFifoSample, accel_mps2), sizeof(ImuFifoSample), count)
+    void apply_batch(uint8_t* base, size_t field_offset, size_t stride, size_t count) const;
+};
+
+} // namespace Sensor
+} // namespace Cesium
@@ -23,5 +23,29 @@ bool GpsBase::read()
     return SensorBase::read();
 }
 
+bool GpsBase::get_velocity_ned_sample(TimedVector3 &sample) const
+{
+    GpsFix fix;
+    RETURN_FALSE_IF_FALSE(get_fix(fix));
+
+    sample.time_us = fix.time_us;
+    sample.value = {{{fix.vel_n_mmps * 1e-3f}, {fix.vel_e_mmps * 1e-3f}, {fix.vel_d_mmps * 1e-3f}}};
+    return true;
+}
+
+void GpsBase::publish_fix(const GpsFix &fix)
+{
+    latitude_scaled = fix.latitude_e7;
+    longitude_scaled = fix.longitude_e7;
+    latitude_deg = fix.latitude_e7 * 1e-7;
+    longitude_deg = fix.longitude_e7 * 1e-7;
+    altitude_m = fix.height_msl_mm * 1e-3f;
+    satellites_in_view = fix.satellites;
+    heading_scaled = fix.heading_motion_e5;
+    ground_speed_mmps = fix.ground_speed_mmps;
+
+    fix_slot.write(fix);
+}
+
 } // namespace Sensor
 } // namespace Cesium
\ No newline at end of file
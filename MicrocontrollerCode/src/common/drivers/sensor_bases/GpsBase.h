@@ -2,9 +2,48 @@
 
 #include "SensorBase.h"
 #include "../../math/vector.h"
+#include "TimedSample.h"
+#include "../../os/spsc_queue.h"
 
 namespace Cesium {
 namespace Sensor {
+
+// One navigation solution, in the units of UBX-NAV-PVT
+struct GpsFix {
+    uint64_t time_us;           // esp_timer time the solution was received
+    uint32_t iTOW_ms;           // GPS time of week
+
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+    uint8_t valid;              // Bit 0 validDate, bit 1 validTime, bit 2 fullyResolved
+    uint32_t t_acc_ns;
+    int32_t nano_ns;
+
+    uint8_t fix_type;           // 0 none, 2 2D, 3 3D, 4 GNSS + dead reckoning
+    uint8_t flags;              // Bit 0 gnssFixOK
+    uint8_t satellites;
+
+    int32_t longitude_e7;       // deg * 1e7
+    int32_t latitude_e7;        // deg * 1e7
+    int32_t height_mm;          // Above the ellipsoid
+    int32_t height_msl_mm;
+    uint32_t h_acc_mm;
+    uint32_t v_acc_mm;
+
+    int32_t vel_n_mmps;
+    int32_t vel_e_mmps;
+    int32_t vel_d_mmps;
+    int32_t ground_speed_mmps;
+    int32_t heading_motion_e5;  // deg * 1e5
+    uint32_t speed_acc_mmps;
+    uint32_t heading_acc_e5;    // deg * 1e5
+    uint16_t pdop_e2;           // * 0.01
+};
+
 class GpsBase : public SensorBase {
 
 protected:
@@ -21,14 +60,27 @@ protected:
     uint32_t heading_scaled;
     uint32_t ground_speed_mmps;
 
+    // Whole solutions, so other tasks never see half of one
+    SeqLock<GpsFix> fix_slot;
+
+    // Updates the fields above and the slot. Only the reading task may call this
+    void publish_fix(const GpsFix& fix);
+
 public:
 
     GpsBase();
     virtual ~GpsBase();
 
     virtual bool read(); 
+
+    // Newest solution from any task, false if there has not been one yet
+    inline bool get_fix(GpsFix& fix) const {return fix_slot.read(fix);}
+    inline uint32_t get_fix_count() const {return fix_slot.get_version();}
+
+    // North, east, down velocity (m/s) of the newest solution, stamped like the fix
+    bool get_velocity_ned_sample(TimedVector3& sample) const;
 };
 
 
 } // namespace Sensor
-} // namespace Cesium
\ No newline at end of file
+} // namespace Cesium
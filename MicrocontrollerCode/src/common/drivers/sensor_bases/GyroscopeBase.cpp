@@ -7,6 +7,7 @@ namespace Sensor {
 GyroscopeBase::GyroscopeBase()
     : w_rps{}
     , w_body_rps{}
+    , gyro_calibration{}
 {}
 
 GyroscopeBase::~GyroscopeBase() {}
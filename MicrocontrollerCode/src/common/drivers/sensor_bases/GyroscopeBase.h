@@ -2,6 +2,8 @@
 
 #include "SensorBase.h"
 #include "../../math/vector.h"
+#include "TimedSample.h"
+#include "Calibration.h"
 
 namespace Cesium {
 namespace Sensor {
@@ -10,6 +12,10 @@ class GyroscopeBase : virtual public SensorBase {
 protected:
     Vector3<float> w_rps;
     Vector3<float> w_body_rps;
+    Calibration3 gyro_calibration;
+
+    // w_body_rps from w_rps
+    inline void calibrate_gyro() {gyro_calibration.apply(w_rps, w_body_rps);}
 
 public:
 
@@ -20,6 +26,12 @@ public:
 
     const Vector3<float>& get_w_rps() {return w_rps;}
     const Vector3<float>& get_w_body_rps() {return w_body_rps;}
+
+    inline TimedVector3 get_w_sample() const {return {sample_time_us, w_rps};}
+    inline TimedVector3 get_w_body_sample() const {return {sample_time_us, w_body_rps};}
+
+    void set_gyro_calibration(const Calibration3& calibration) {gyro_calibration = calibration;}
+    const Calibration3& get_gyro_calibration() const {return gyro_calibration;}
 };
 
 
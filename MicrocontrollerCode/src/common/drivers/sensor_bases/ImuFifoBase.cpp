@@ -0,0 +1,16 @@
+#include "ImuFifoBase.h"
+
+namespace Cesium {
+namespace Sensor {
+
+
+ImuFifoBase::ImuFifoBase()
+    : fifo_watermark_frames{0}
+    , fifo_frames_read{0}
+    , fifo_frames_skipped{0}
+{}
+
+ImuFifoBase::~ImuFifoBase() {}
+
+} // namespace Sensor
+} // namespace Cesium
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "SensorBase.h"
+
+namespace Cesium {
+namespace Sensor {
+
+// One decoded FIFO frame, written as-is to FIFO log files. read_fifo() leaves the vectors in the body frame
+struct __attribute__((packed)) ImuFifoSample {
+    uint64_t time_us;       // Sensor clock (unwrapped), not esp_timer
+    float accel_mps2[3];
+    float w_rps[3];
+    float temp_C;           // NAN if the frame had no temperature
+    float B_uT[3];          // Latest magnetometer sample, NAN if the IMU has none
+};
+
+// For IMUs with a hardware FIFO, drained in bursts instead of one register read per sample
+class ImuFifoBase : virtual public SensorBase {
+
+protected:
+    uint16_t fifo_watermark_frames;
+    uint32_t fifo_frames_read;      // Since the last flush
+    uint32_t fifo_frames_skipped;   // Dummy or invalid frames since the last flush
+
+public:
+
+    ImuFifoBase();
+    virtual ~ImuFifoBase();
+
+    virtual bool configure_fifo(uint16_t watermark_frames) = 0;
+    virtual bool flush_fifo() = 0;
+
+    // Complete frames currently waiting in the FIFO
+    virtual size_t get_fifo_frames() = 0;
+    virtual size_t get_fifo_capacity_frames() const = 0;
+
+    // Drains up to max_samples frames, returns the number of samples decoded
+    virtual size_t read_fifo(ImuFifoSample* samples, size_t max_samples) = 0;
+
+    inline uint16_t get_fifo_watermark_frames() const {return fifo_watermark_frames;}
+    inline uint32_t get_fifo_frames_read() const {return fifo_frames_read;}
+    inline uint32_t get_fifo_frames_skipped() const {return fifo_frames_skipped;}
+};
+
+
+} // namespace Sensor
+} // namespace Cesium
@@ -7,6 +7,7 @@ namespace Sensor {
 MagnetometerBase::MagnetometerBase()
     : B_uT{}
     , B_body_uT{}
+    , mag_calibration{}
 {}
 
 MagnetometerBase::~MagnetometerBase() {}
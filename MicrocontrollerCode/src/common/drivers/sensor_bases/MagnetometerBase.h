@@ -2,6 +2,8 @@
 
 #include "SensorBase.h"
 #include "../../math/vector.h"
+#include "TimedSample.h"
+#include "Calibration.h"
 
 namespace Cesium {
 namespace Sensor {
@@ -10,6 +12,10 @@ class MagnetometerBase : virtual public SensorBase {
 protected:
     Vector3<float> B_uT;
     Vector3<float> B_body_uT;
+    Calibration3 mag_calibration;
+
+    // B_body_uT from B_uT
+    inline void calibrate_mag() {mag_calibration.apply(B_uT, B_body_uT);}
 
 public:
 
@@ -20,6 +26,12 @@ public:
 
     const Vector3<float>& get_B_uT() {return B_uT;};
     const Vector3<float>& get_B_body_uT() {return B_body_uT;};
+
+    inline TimedVector3 get_B_sample() const {return {sample_time_us, B_uT};}
+    inline TimedVector3 get_B_body_sample() const {return {sample_time_us, B_body_uT};}
+
+    void set_mag_calibration(const Calibration3& calibration) {mag_calibration = calibration;}
+    const Calibration3& get_mag_calibration() const {return mag_calibration;}
 };
 
 
@@ -5,6 +5,7 @@
 #include "GyroscopeBase.h"
 #include "MagnetometerBase.h"
 #include "GpsBase.h"
+#include "ImuFifoBase.h"
 
 namespace Cesium {
 namespace Sensor {
@@ -171,8 +172,62 @@ public:
     inline uint32_t get_heading_scaled() {return heading_scaled;}
     inline uint32_t get_ground_speed_mmps() {return ground_speed_mmps;}
 
+    // Stands in for a parsed NAV-PVT
+    void inject_fix(const GpsFix& fix) {publish_fix(fix);}
+
 };
 
 
+// FIFO holding frames_waiting synthetic frames
+class MockImuFifo : public ImuFifoBase {
+
+public:
+    size_t frames_waiting = 0;
+
+    virtual bool configure(const char* config_name) {return false;};
+    virtual bool setup() {return false;};
+
+    virtual bool configure_fifo(uint16_t watermark_frames) {fifo_watermark_frames = watermark_frames; return flush_fifo();}
+    virtual bool flush_fifo() {frames_waiting = 0; fifo_frames_read = 0; fifo_frames_skipped = 0; return true;}
+    virtual size_t get_fifo_frames() {return frames_waiting;}
+    virtual size_t get_fifo_capacity_frames() const {return 128;}
+
+    virtual size_t read_fifo(ImuFifoSample* samples, size_t max_samples) {
+        size_t count = frames_waiting < max_samples ? frames_waiting : max_samples;
+
+        for (size_t i = 0; i < count; i++) {
+            samples[i].time_us = (fifo_frames_read + i) * 1250;
+            for (size_t j = 0; j < 3; j++) {
+                samples[i].accel_mps2[j] = j + 1.0f;
+                samples[i].w_rps[j] = -(j + 1.0f);
+                samples[i].B_uT[j] = NAN;
+            }
+            samples[i].temp_C = 25.0f;
+        }
+
+        frames_waiting -= count;
+        fifo_frames_read += count;
+        return count;
+    }
+};
+
+// Accel and gyro on one chip whose samples are set by the test
+class MockImuBase : public AccelerometerBase, public GyroscopeBase {
+
+public:
+    virtual bool configure(const char* config_name) {return false;};
+    virtual bool setup() {return false;};
+    virtual bool read() {return true;}
+
+    // Stands in for a read() at time_us
+    void inject_sample(uint64_t time_us, const Vector3<float>& accel, const Vector3<float>& w) {
+        accel_mps2 = accel;
+        w_rps = w;
+        calibrate_accel();
+        calibrate_gyro();
+        sample_time_us = time_us;
+    }
+};
+
 } // namespace Sensor
 } // namespace Cesium
\ No newline at end of file
@@ -1,8 +1,12 @@
 #include "SensorBase.h"
+#include <esp_timer.h>
 
 namespace Cesium {
 namespace Sensor {
 
+// Shared by every sensor, only held long enough to copy the DRDY timestamp
+static portMUX_TYPE drdy_mux = portMUX_INITIALIZER_UNLOCKED;
+
 SensorBase::SensorBase()
     : last_read_time_ms{0}
     , read_interval_ms{1000} // 1 second
@@ -12,6 +16,11 @@ SensorBase::SensorBase()
     , interface{Interfaces::NOT_SET}
     , body_to_sensor{}
     , temp_C{NAN}
+    , sample_time_us{0}
+    , drdy_time_us{0}
+    , drdy_pending{false}
+    , drdy_task{nullptr}
+    , drdy_notify_bits{0}
 {}
 
 SensorBase::~SensorBase() {}
@@ -34,12 +43,39 @@ void SensorBase::attach_serial(HardwareSerial *serial)
     interface = Interfaces::Serial;
 }
 
-// Gets current milliseconds
+const void* SensorBase::get_bus() const
+{
+    switch (interface) {
+    case Interfaces::SPI:
+        return _spi_instance;
+    case Interfaces::I2C:
+        return _i2c_instance;
+    case Interfaces::Serial:
+        return _serial_instance;
+    default:
+        return nullptr;
+    }
+}
+
+// Gets current milliseconds and the sample time
 bool SensorBase::read()
+{
+    stamp_sample(esp_timer_get_time());
+    return true;
+}
+
+void SensorBase::stamp_sample(uint64_t fallback_us)
 {
     last_read_time_ms = millis();
 
-    return true;
+    // Data was captured at the DRDY edge, not whenever the task got around to reading it
+    portENTER_CRITICAL(&drdy_mux);
+    bool pending = drdy_pending;
+    uint64_t edge_us = drdy_time_us;
+    drdy_pending = false;
+    portEXIT_CRITICAL(&drdy_mux);
+
+    sample_time_us = pending ? edge_us : fallback_us;
 }
 
 void SensorBase::attach_int_pin(uint8_t pin, void (*func)(), uint8_t mode)
@@ -47,5 +83,38 @@ void SensorBase::attach_int_pin(uint8_t pin, void (*func)(), uint8_t mode)
     attachInterrupt(digitalPinToInterrupt(pin), func, mode);
 }
 
+void SensorBase::set_drdy_notify(TaskHandle_t task, uint32_t notify_bits)
+{
+    drdy_task = task;
+    drdy_notify_bits = notify_bits;
+}
+
+void SensorBase::attach_drdy_pin(uint8_t pin, uint8_t mode)
+{
+    pinMode(pin, INPUT);
+    attachInterruptArg(digitalPinToInterrupt(pin), drdy_isr, this, mode);
+}
+
+void IRAM_ATTR SensorBase::drdy_isr(void *arg)
+{
+    SensorBase* sensor = (SensorBase*)arg;
+    uint64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&drdy_mux);
+    sensor->drdy_time_us = now_us;
+    sensor->drdy_pending = true;
+    portEXIT_CRITICAL_ISR(&drdy_mux);
+
+    if (sensor->drdy_task == nullptr) {
+        return;
+    }
+
+    BaseType_t higher_priority_woken = pdFALSE;
+    xTaskNotifyFromISR(sensor->drdy_task, sensor->drdy_notify_bits, eSetBits, &higher_priority_woken);
+    if (higher_priority_woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
 } // namespace Sensor
 } // namespace Cesium
\ No newline at end of file
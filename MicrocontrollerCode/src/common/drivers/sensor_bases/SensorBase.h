@@ -33,6 +33,18 @@ protected:
 
     // TODO: add temperature
     float temp_C;
+
+    // esp_timer time of the data from the last read(), the DRDY edge if there was one
+    uint64_t sample_time_us;
+
+    // Data-ready interrupt, written from drdy_isr
+    volatile uint64_t drdy_time_us;
+    volatile bool drdy_pending;
+    TaskHandle_t drdy_task;
+    uint32_t drdy_notify_bits;
+
+    // Sets the read times, using the pending DRDY edge if there is one and fallback_us otherwise
+    void stamp_sample(uint64_t fallback_us);
     
 public:
     SensorBase();
@@ -48,13 +60,33 @@ public:
     virtual bool read(); 
     virtual void attach_int_pin(uint8_t pin, void (*func)(), uint8_t mode = ONHIGH);
 
+    // DRDY edges timestamp the next read() and set notify_bits on task (eSetBits), so one task can serve several sensors
+    void set_drdy_notify(TaskHandle_t task, uint32_t notify_bits);
+    void attach_drdy_pin(uint8_t pin, uint8_t mode = RISING);
+
+    // Routes the sensor's own data-ready signal to its interrupt pin, false if the driver can't
+    virtual bool enable_drdy_interrupt() {return false;}
+
+    // Queues the next sample on the sensor's SpiBus plan, false if it has to be read with read().
+    // completed is set by SpiBus::collect() once the sample is decoded, or left false if the transfer failed
+    virtual bool plan_read(bool* completed = nullptr) {return false;}
+
+    // Public so tests can fire it as a mock interrupt source
+    static void IRAM_ATTR drdy_isr(void* arg);
+
     DELETE_COPY_AND_ASSIGNMENT(SensorBase)
 
     void set_rotation_matrix(Matrix3<float> matrix) {body_to_sensor = quat_from_R(matrix);}
+    void set_interval_ms(uint32_t interval_ms) {read_interval_ms = interval_ms;}
     uint32_t get_interval_ms() const {return read_interval_ms;}
     uint32_t get_last_read_time_ms() const {return last_read_time_ms;}
     Interfaces get_interface() const {return interface;}
+
+    // The peripheral the sensor talks over, so reads on the same bus can be grouped. nullptr if not attached
+    const void* get_bus() const;
     inline float get_temp_C() const {return temp_C;}
+    inline uint64_t get_sample_time_us() const {return sample_time_us;}
+    inline bool is_drdy_pending() const {return drdy_pending;}
 };
 
 } // namespace Sensor
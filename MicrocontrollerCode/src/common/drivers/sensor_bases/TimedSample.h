@@ -0,0 +1,58 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Sensor readings stamped with the esp_timer time they were measured at
+
+#include <Arduino.h>
+#include "../../math/vector.h"
+
+namespace Cesium {
+namespace Sensor {
+
+// 64-bit microseconds, the same clock as esp_timer_get_time() and SensorBase::get_sample_time_us()
+template <typename T>
+struct Timed {
+    uint64_t time_us;
+    T value;
+};
+
+typedef Timed<Vector3<float>> TimedVector3;
+
+struct BaroReading {
+    float pressure_kPa;
+    float altitude_m;
+    float temp_C;
+};
+
+typedef Timed<BaroReading> TimedBaro;
+
+// Linear blend, fraction 0 gives a and 1 gives b. Used by SampleAligner
+inline float interpolate(float a, float b, float fraction)
+{
+    return a + (b - a) * fraction;
+}
+
+template <typename T, size_t row, size_t col>
+Matrix<T, row, col> interpolate(const Matrix<T, row, col>& a, const Matrix<T, row, col>& b, float fraction)
+{
+    Matrix<T, row, col> result;
+    for (size_t i = 0; i < row; i++) {
+        for (size_t j = 0; j < col; j++) {
+            result[i][j] = interpolate(a[i][j], b[i][j], fraction);
+        }
+    }
+    return result;
+}
+
+inline BaroReading interpolate(const BaroReading& a, const BaroReading& b, float fraction)
+{
+    return {
+        interpolate(a.pressure_kPa, b.pressure_kPa, fraction),
+        interpolate(a.altitude_m, b.altitude_m, fraction),
+        interpolate(a.temp_C, b.temp_C, fraction)
+    };
+}
+
+} // namespace Sensor
+} // namespace Cesium
@@ -0,0 +1,208 @@
+#include "FusedImu.h"
+#include "../os/instrumentation.h"
+#include "../os/trace.h"
+#include <algorithm>
+
+namespace Cesium {
+namespace Sensor {
+
+FusedImu::FusedImu(float accel_threshold_mps2, float gyro_threshold_rps, uint32_t max_age_us)
+    : unit_count{0}
+    , accel_threshold_mps2{accel_threshold_mps2}
+    , gyro_threshold_rps{gyro_threshold_rps}
+    , max_age_us{max_age_us}
+    , last_fused_us{0}
+    , accel_mask{0}
+    , gyro_mask{0}
+{}
+
+bool FusedImu::add_unit(AccelerometerBase *accel, GyroscopeBase *gyro, float accel_variance, float gyro_variance)
+{
+    if (unit_count >= MAX_UNITS || accel == nullptr || gyro == nullptr || accel_variance <= 0 || gyro_variance <= 0) {
+        DEBUGLN("Could not add unit to fused IMU");
+        return false;
+    }
+
+    Unit& unit = units[unit_count];
+    unit.accel = accel;
+    unit.gyro = gyro;
+    unit.accel_weight = 1.0f / accel_variance;
+    unit.gyro_weight = 1.0f / gyro_variance;
+    unit.accel_history = SampleAligner<Vector3<float>, HISTORY>(SampleAligner<Vector3<float>, HISTORY>::Mode::INTERPOLATE, max_age_us);
+    unit.gyro_history = SampleAligner<Vector3<float>, HISTORY>(SampleAligner<Vector3<float>, HISTORY>::Mode::INTERPOLATE, max_age_us);
+    unit.accel_rejections = 0;
+    unit.gyro_rejections = 0;
+
+    unit_count++;
+    return true;
+}
+
+bool FusedImu::configure(const char *config_name)
+{
+    // Units are added in code, nothing to load
+    return true;
+}
+
+bool FusedImu::setup()
+{
+    // The units are set up by their own drivers
+    return unit_count > 0;
+}
+
+////////////////////////////////////////////////////////////
+//                        Fusion                          //
+////////////////////////////////////////////////////////////
+
+bool FusedImu::read()
+{
+    PROBE_SCOPE("FusedImu::read");
+    TRACE_SCOPE("FusedImu::read");
+
+    uint64_t newest_us = 0;
+    for (size_t i = 0; i < unit_count; i++) {
+        update_history(units[i]);
+
+        if (units[i].accel_history.size() > 0 && units[i].accel_history.newest().time_us > newest_us) {
+            newest_us = units[i].accel_history.newest().time_us;
+        }
+    }
+
+    if (newest_us <= last_fused_us) {
+        return false;
+    }
+
+    Vector3<float> accel, w;
+    uint8_t new_accel_mask = fuse(newest_us, false, accel);
+    uint8_t new_gyro_mask = fuse(newest_us, true, w);
+    if (new_accel_mask == 0 || new_gyro_mask == 0) {
+        return false;
+    }
+
+    accel_mask = new_accel_mask;
+    gyro_mask = new_gyro_mask;
+    accel_mps2 = accel;
+    accel_body_mps2 = accel;
+    w_rps = w;
+    w_body_rps = w;
+
+    float temp_sum = 0;
+    size_t temp_count = 0;
+    for (size_t i = 0; i < unit_count; i++) {
+        float unit_temp_C = static_cast<SensorBase*>(units[i].accel)->get_temp_C();
+        if ((accel_mask & (1 << i)) && !isnan(unit_temp_C)) {
+            temp_sum += unit_temp_C;
+            temp_count++;
+        }
+    }
+    temp_C = temp_count > 0 ? temp_sum / temp_count : NAN;
+
+    stamp_sample(newest_us);
+    last_fused_us = newest_us;
+    return true;
+}
+
+void FusedImu::update_history(Unit &unit)
+{
+    TimedVector3 accel = unit.accel->get_accel_body_sample();
+    if (accel.time_us > 0 && (unit.accel_history.size() == 0 || accel.time_us > unit.accel_history.newest().time_us)) {
+        unit.accel_history.push(accel);
+    }
+
+    TimedVector3 w = unit.gyro->get_w_body_sample();
+    if (w.time_us > 0 && (unit.gyro_history.size() == 0 || w.time_us > unit.gyro_history.newest().time_us)) {
+        unit.gyro_history.push(w);
+    }
+}
+
+uint8_t FusedImu::fuse(uint64_t time_us, bool gyro, Vector3<float> &result)
+{
+    Vector3<float> values[MAX_UNITS];
+    size_t ids[MAX_UNITS];
+    size_t count = 0;
+
+    for (size_t i = 0; i < unit_count; i++) {
+        const SampleAligner<Vector3<float>, HISTORY>& history = gyro ? units[i].gyro_history : units[i].accel_history;
+        if (history.sample_at(time_us, values[count])) {
+            ids[count++] = i;
+        }
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    bool keep[MAX_UNITS];
+    vote(values, count, gyro ? gyro_threshold_rps : accel_threshold_mps2, keep);
+
+    Vector3<float> sum{};
+    float weight_sum = 0;
+    uint8_t mask = 0;
+
+    for (size_t j = 0; j < count; j++) {
+        Unit& unit = units[ids[j]];
+        if (!keep[j]) {
+            (gyro ? unit.gyro_rejections : unit.accel_rejections)++;
+            continue;
+        }
+
+        float weight = gyro ? unit.gyro_weight : unit.accel_weight;
+        for (size_t k = 0; k < 3; k++) {
+            sum[k][0] += weight * values[j][k][0];
+        }
+        weight_sum += weight;
+        mask |= 1 << ids[j];
+    }
+
+    for (size_t k = 0; k < 3; k++) {
+        result[k][0] = sum[k][0] / weight_sum;
+    }
+    return mask;
+}
+
+size_t FusedImu::vote(const Vector3<float> *values, size_t count, float threshold, bool *keep)
+{
+    for (size_t i = 0; i < count; i++) {
+        keep[i] = true;
+    }
+
+    // Two units that disagree can't say which one is wrong
+    if (count < 3) {
+        return count;
+    }
+
+    Vector3<float> median;
+    for (size_t k = 0; k < 3; k++) {
+        float axis[MAX_UNITS];
+        for (size_t i = 0; i < count; i++) {
+            axis[i] = values[i][k][0];
+        }
+        std::sort(axis, axis + count);
+        median[k][0] = (count % 2 == 1) ? axis[count / 2] : 0.5f * (axis[count / 2 - 1] + axis[count / 2]);
+    }
+
+    size_t kept = 0;
+    size_t closest = 0;
+    float closest_residual = INFINITY;
+
+    for (size_t i = 0; i < count; i++) {
+        float residual = norm(values[i] - median);
+        keep[i] = residual <= threshold;
+        kept += keep[i];
+
+        if (residual < closest_residual) {
+            closest_residual = residual;
+            closest = i;
+        }
+    }
+
+    // Everything disagrees, so trust whichever is nearest the median
+    if (kept == 0) {
+        keep[closest] = true;
+        kept = 1;
+    }
+
+    return kept;
+}
+
+} // namespace Sensor
+} // namespace Cesium
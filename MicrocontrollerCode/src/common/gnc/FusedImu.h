@@ -0,0 +1,83 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Virtual IMU that votes out faulty units and inverse-variance averages the rest in the body frame
+
+#include <Arduino.h>
+
+#include "../drivers/sensor_bases/AccelerometerBase.h"
+#include "../drivers/sensor_bases/GyroscopeBase.h"
+#include "SampleAligner.h"
+
+namespace Cesium {
+namespace Sensor {
+
+// Never touches a bus. read() combines the body-frame samples the units last read, so call it from the task
+// that reads them and give each unit its calibration first. The outputs are in the body frame (accel_mps2 == accel_body_mps2)
+class FusedImu : public AccelerometerBase, public GyroscopeBase {
+public:
+    static constexpr size_t MAX_UNITS = 4;
+
+    // 20 ms of an 800 Hz unit, enough to interpolate it at a 100 Hz unit's time
+    static constexpr size_t HISTORY = 16;
+
+private:
+    struct Unit {
+        AccelerometerBase* accel;
+        GyroscopeBase* gyro;
+        float accel_weight;     // 1 / variance
+        float gyro_weight;
+        SampleAligner<Vector3<float>, HISTORY> accel_history;   // Body frame
+        SampleAligner<Vector3<float>, HISTORY> gyro_history;
+        uint32_t accel_rejections;
+        uint32_t gyro_rejections;
+    };
+
+    Unit units[MAX_UNITS];
+    size_t unit_count;
+
+    float accel_threshold_mps2;
+    float gyro_threshold_rps;
+    uint32_t max_age_us;
+
+    uint64_t last_fused_us;
+    uint8_t accel_mask;
+    uint8_t gyro_mask;
+
+    // Pushes any body-frame sample newer than the unit's history
+    void update_history(Unit& unit);
+
+    // Inverse-variance mean at time_us of the units that survive the vote. Returns the mask of units used
+    uint8_t fuse(uint64_t time_us, bool gyro, Vector3<float>& result);
+
+public:
+
+    // Units further than the threshold from the median are dropped (needs 3+ units).
+    // A unit with nothing newer than max_age_us at the fused time is left out
+    FusedImu(float accel_threshold_mps2 = 2.0f, float gyro_threshold_rps = 0.2f, uint32_t max_age_us = 20000);
+
+    // accel and gyro are usually the same chip. Variances come from each unit's noise density over its bandwidth
+    bool add_unit(AccelerometerBase* accel, GyroscopeBase* gyro, float accel_variance, float gyro_variance);
+
+    bool configure(const char* config_name);
+    bool setup();
+
+    // Fuses at the newest unit sample time, the others interpolated or held to it.
+    // False if nothing is newer than the last fused sample or no unit is fresh enough
+    bool read();
+
+    // Bit i set if unit i went into the last fused sample
+    inline uint8_t get_accel_mask() const {return accel_mask;}
+    inline uint8_t get_gyro_mask() const {return gyro_mask;}
+    inline uint32_t get_accel_rejections(size_t unit_id) const {return unit_id < unit_count ? units[unit_id].accel_rejections : 0;}
+    inline uint32_t get_gyro_rejections(size_t unit_id) const {return unit_id < unit_count ? units[unit_id].gyro_rejections : 0;}
+    inline size_t get_unit_count() const {return unit_count;}
+
+    // Median voting. Sets keep[i] for values within threshold of the per-axis median, keeps everything below 3 values.
+    // Returns how many were kept
+    static size_t vote(const Vector3<float>* values, size_t count, float threshold, bool* keep);
+};
+
+} // namespace Sensor
+} // namespace Cesium
@@ -0,0 +1,90 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Resamples one sensor's timestamped samples onto the estimator tick
+
+#include <Arduino.h>
+#include "../drivers/sensor_bases/TimedSample.h"
+
+namespace Cesium {
+
+// Keeps the last N samples of one stream. The estimator asks for the value at its own tick,
+// so an 800 Hz gyro, a 100 Hz mag and a 50 Hz baro all line up on the same time
+template <typename T, size_t N>
+class SampleAligner {
+
+public:
+    enum class Mode : uint8_t {
+        HOLD,           // Newest sample at or before the tick
+        INTERPOLATE     // Linear between the samples either side of the tick, held past the newest one
+    };
+
+    SampleAligner(Mode mode = Mode::INTERPOLATE, uint32_t max_age_us = 100000)
+        : mode{mode}
+        , max_age_us{max_age_us}
+        , head{0}
+        , count{0}
+    {}
+
+    // Samples have to arrive in time order, older or repeated ones are dropped
+    bool push(const Sensor::Timed<T>& sample) {
+        if (count > 0 && sample.time_us <= newest().time_us) {
+            return false;
+        }
+
+        history[head] = sample;
+        head = (head + 1) % N;
+        if (count < N) {
+            count++;
+        }
+        return true;
+    }
+
+    inline bool push(uint64_t time_us, const T& value) {return push(Sensor::Timed<T>{time_us, value});}
+
+    // False if the tick is older than the history, or if the sample it would use is more than max_age_us old
+    bool sample_at(uint64_t tick_us, T& value) const {
+        if (count == 0 || tick_us < at(0).time_us) {
+            return false;
+        }
+
+        // Newest sample at or before the tick
+        size_t before = count - 1;
+        while (at(before).time_us > tick_us) {
+            before--;
+        }
+
+        const Sensor::Timed<T>& held = at(before);
+        if (tick_us - held.time_us > max_age_us) {
+            return false;
+        }
+
+        if (mode == Mode::HOLD || before == count - 1 || held.time_us == tick_us) {
+            value = held.value;
+            return true;
+        }
+
+        const Sensor::Timed<T>& after = at(before + 1);
+        float fraction = (float)(tick_us - held.time_us) / (float)(after.time_us - held.time_us);
+        value = Sensor::interpolate(held.value, after.value, fraction);
+        return true;
+    }
+
+    inline const Sensor::Timed<T>& newest() const {return at(count - 1);}
+    inline size_t size() const {return count;}
+    inline void clear() {head = 0; count = 0;}
+
+private:
+    Mode mode;
+    uint32_t max_age_us;
+
+    Sensor::Timed<T> history[N];
+    size_t head;
+    size_t count;
+
+    // 0 is the oldest sample kept
+    inline const Sensor::Timed<T>& at(size_t i) const {return history[(head + N - count + i) % N];}
+};
+
+} // namespace Cesium
@@ -0,0 +1,116 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: abs, sqrt, sin and cos that also work in constant expressions, for the math templates
+
+#include <math.h>
+
+// GCC (ours on the ESP32 and the host) evaluates its math builtins in constant expressions and
+// calls libm at runtime, so those are used as-is. Other compilers get the portable versions,
+// which are slower at runtime but exact to float precision.
+
+namespace ConstexprMath {
+
+template <typename T>
+constexpr T portable_sqrt(T x) {
+    if (!(x >= 0)) {
+        return x == 0 ? x : (T)NAN;
+    }
+    if (x == 0 || x == (T)INFINITY) {
+        return x;
+    }
+
+    // Newton from above converges without oscillating
+    T guess = x > 1 ? x : 1;
+    for (int i = 0; i < 100; i++) {
+        T next = (guess + x / guess) / 2;
+        if (next >= guess) {
+            break;
+        }
+        guess = next;
+    }
+    return guess;
+}
+
+// Reduced to [-pi, pi], then the Taylor series to well past float precision
+template <typename T>
+constexpr T reduce_angle(T x) {
+    constexpr long double FULL_TURN = 6.283185307179586476925286766559L;
+    long double reduced = x - FULL_TURN * (long long)(x / FULL_TURN);
+    if (reduced > FULL_TURN / 2) {
+        reduced -= FULL_TURN;
+    }
+    else if (reduced < -FULL_TURN / 2) {
+        reduced += FULL_TURN;
+    }
+    return (T)reduced;
+}
+
+template <typename T>
+constexpr T portable_sin(T x) {
+    long double reduced = reduce_angle(x);
+    long double term = reduced;
+    long double sum = reduced;
+    for (int n = 1; n < 15; n++) {
+        term *= -reduced * reduced / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return (T)sum;
+}
+
+template <typename T>
+constexpr T portable_cos(T x) {
+    long double reduced = reduce_angle(x);
+    long double term = 1;
+    long double sum = 1;
+    for (int n = 1; n < 15; n++) {
+        term *= -reduced * reduced / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return (T)sum;
+}
+
+template <typename T>
+constexpr T const_abs(T x) {
+    return x < 0 ? -x : x;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+
+constexpr float const_sqrt(float x) {return __builtin_sqrtf(x);}
+constexpr double const_sqrt(double x) {return __builtin_sqrt(x);}
+constexpr float const_sin(float x) {return __builtin_sinf(x);}
+constexpr double const_sin(double x) {return __builtin_sin(x);}
+constexpr float const_cos(float x) {return __builtin_cosf(x);}
+constexpr double const_cos(double x) {return __builtin_cos(x);}
+
+// Anything else, like the int overloads of <math.h>, goes through double
+template <typename T>
+constexpr T const_sqrt(T x) {return (T)const_sqrt((double)x);}
+template <typename T>
+constexpr T const_sin(T x) {return (T)const_sin((double)x);}
+template <typename T>
+constexpr T const_cos(T x) {return (T)const_cos((double)x);}
+
+#else
+
+template <typename T>
+constexpr T const_sqrt(T x) {return portable_sqrt(x);}
+template <typename T>
+constexpr T const_sin(T x) {return portable_sin(x);}
+template <typename T>
+constexpr T const_cos(T x) {return portable_cos(x);}
+
+#endif
+
+} // namespace ConstexprMath
+
+// The math the templates use on T. Number types that aren't built in, like Fixed, specialise it
+template <typename T>
+struct MathTraits {
+    static constexpr T abs(T x) {return ConstexprMath::const_abs(x);}
+    static constexpr T sqrt(T x) {return ConstexprMath::const_sqrt(x);}
+    static constexpr T sin(T x) {return ConstexprMath::const_sin(x);}
+    static constexpr T cos(T x) {return ConstexprMath::const_cos(x);}
+};
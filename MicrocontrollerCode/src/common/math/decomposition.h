@@ -0,0 +1,447 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: LDL^T (Cholesky), LU with partial pivoting, inverses and triangular solves for fixed-size matrices
+
+#include "matrix.h"
+
+// Everything takes its size from the template, so the loops have constant bounds. They're unrolled for
+// up to 15 iterations, the biggest filter state, even at -Os where the compiler wouldn't otherwise.
+// That's several times the code per size, so build with -D DECOMPOSITION_NO_UNROLL if flash matters more.
+// Outputs may alias inputs. The functions that can fail return false instead of a result full of inf/nan.
+//
+// Covariances are symmetric, so SymMatrix keeps only the lower triangle. Its LDL^T, inverse and
+// F P F^T touch half the elements the dense versions do.
+#if defined(DECOMPOSITION_NO_UNROLL)
+#define DECOMPOSITION_UNROLL
+#elif defined(__clang__)
+#define DECOMPOSITION_UNROLL _Pragma("unroll 15")
+#elif defined(__GNUC__) && __GNUC__ >= 8
+#define DECOMPOSITION_UNROLL _Pragma("GCC unroll 15")
+#else
+#define DECOMPOSITION_UNROLL
+#endif
+
+// Symmetric N x N matrix, lower triangle packed row by row. sym(i, j) and sym(j, i) are the same element
+template <typename T, size_t N>
+struct SymMatrix {
+    T elements[N * (N + 1) / 2];
+
+    static constexpr size_t size() {return N * (N + 1) / 2;}
+    static constexpr size_t index(size_t i, size_t j) {return i >= j ? i * (i + 1) / 2 + j : j * (j + 1) / 2 + i;}
+
+    constexpr T& operator()(size_t i, size_t j) {return elements[index(i, j)];}
+    constexpr const T& operator()(size_t i, size_t j) const {return elements[index(i, j)];}
+};
+
+////////////////////////////////////////////////////////////
+//                      Conversion                        //
+////////////////////////////////////////////////////////////
+
+// From the lower triangle of mat
+template <typename T, size_t N>
+constexpr SymMatrix<T, N> sym_pack(const Matrix<T, N, N>& mat) {
+    SymMatrix<T, N> result{};
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = 0; j <= i; j++) {
+            result(i, j) = mat[i][j];
+        }
+    }
+    return result;
+}
+
+template <typename T, size_t N>
+constexpr Matrix<T, N, N> sym_unpack(const SymMatrix<T, N>& sym) {
+    Matrix<T, N, N> result{};
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = 0; j < N; j++) {
+            result[i][j] = sym(i, j);
+        }
+    }
+    return result;
+}
+
+namespace Decomposition {
+
+// One element access for both storages, so the algorithms below are written once
+template <typename T, size_t N>
+constexpr T& entry(Matrix<T, N, N>& mat, size_t i, size_t j) {return mat[i][j];}
+template <typename T, size_t N>
+constexpr const T& entry(const Matrix<T, N, N>& mat, size_t i, size_t j) {return mat[i][j];}
+template <typename T, size_t N>
+constexpr T& entry(SymMatrix<T, N>& sym, size_t i, size_t j) {return sym(i, j);}
+template <typename T, size_t N>
+constexpr const T& entry(const SymMatrix<T, N>& sym, size_t i, size_t j) {return sym(i, j);}
+
+// A = L D L^T in place, reading only the lower triangle. L (unit diagonal) goes below the diagonal, D on it
+template <typename T, size_t N, typename Storage>
+constexpr bool ldlt_in_place(Storage& A) {
+    DECOMPOSITION_UNROLL
+    for (size_t j = 0; j < N; j++) {
+
+        // Row j of L times D, used by every row below
+        T ld[N]{};
+        T d = entry<T, N>(A, j, j);
+        DECOMPOSITION_UNROLL
+        for (size_t k = 0; k < j; k++) {
+            ld[k] = entry<T, N>(A, j, k) * entry<T, N>(A, k, k);
+            d -= ld[k] * entry<T, N>(A, j, k);
+        }
+
+        // Not positive definite, or too close to tell
+        if (!(d > 0)) {
+            return false;
+        }
+        entry<T, N>(A, j, j) = d;
+
+        T d_inv = 1 / d;
+        DECOMPOSITION_UNROLL
+        for (size_t i = j + 1; i < N; i++) {
+            T sum = entry<T, N>(A, i, j);
+            DECOMPOSITION_UNROLL
+            for (size_t k = 0; k < j; k++) {
+                sum -= entry<T, N>(A, i, k) * ld[k];
+            }
+            entry<T, N>(A, i, j) = sum * d_inv;
+        }
+    }
+    return true;
+}
+
+// x = A^-1 b, from the L and D of ldlt_in_place
+template <typename T, size_t N, size_t M, typename Storage>
+constexpr Matrix<T, N, M> ldlt_solve(const Storage& LD, const Matrix<T, N, M>& b) {
+    Matrix<T, N, M> x = b;
+
+    // L y = b
+    DECOMPOSITION_UNROLL
+    for (size_t i = 1; i < N; i++) {
+        DECOMPOSITION_UNROLL
+        for (size_t k = 0; k < i; k++) {
+            for (size_t m = 0; m < M; m++) {
+                x[i][m] -= entry<T, N>(LD, i, k) * x[k][m];
+            }
+        }
+    }
+
+    // D z = y
+    DECOMPOSITION_UNROLL
+    for (size_t i = 0; i < N; i++) {
+        T d_inv = 1 / entry<T, N>(LD, i, i);
+        for (size_t m = 0; m < M; m++) {
+            x[i][m] *= d_inv;
+        }
+    }
+
+    // L^T x = z, counted up so the loop can be unrolled
+    DECOMPOSITION_UNROLL
+    for (size_t n = 1; n < N; n++) {
+        size_t i = N - 1 - n;
+        DECOMPOSITION_UNROLL
+        for (size_t k = i + 1; k < N; k++) {
+            for (size_t m = 0; m < M; m++) {
+                x[i][m] -= entry<T, N>(LD, k, i) * x[k][m];
+            }
+        }
+    }
+    return x;
+}
+
+// A^-1 = L^-T D^-1 L^-1 from the L and D of ldlt_in_place. Fills the lower triangle of result only
+template <typename T, size_t N, typename Storage, typename Result>
+constexpr void ldlt_inverse_lower(const Storage& LD, Result& result) {
+
+    // L^-1 is unit lower triangular too, column by column
+    Matrix<T, N, N> L_inv{};
+    DECOMPOSITION_UNROLL
+    for (size_t j = 0; j < N; j++) {
+        L_inv[j][j] = 1;
+        DECOMPOSITION_UNROLL
+        for (size_t i = j + 1; i < N; i++) {
+            T sum = -entry<T, N>(LD, i, j);
+            DECOMPOSITION_UNROLL
+            for (size_t k = j + 1; k < i; k++) {
+                sum -= entry<T, N>(LD, i, k) * L_inv[k][j];
+            }
+            L_inv[i][j] = sum;
+        }
+    }
+
+    T d_inv[N]{};
+    DECOMPOSITION_UNROLL
+    for (size_t k = 0; k < N; k++) {
+        d_inv[k] = 1 / entry<T, N>(LD, k, k);
+    }
+
+    // (i, j) = sum over k of L^-1[k][i] L^-1[k][j] / d_k, where both are nonzero only for k >= i >= j
+    DECOMPOSITION_UNROLL
+    for (size_t i = 0; i < N; i++) {
+        DECOMPOSITION_UNROLL
+        for (size_t j = 0; j <= i; j++) {
+            T sum = 0;
+            DECOMPOSITION_UNROLL
+            for (size_t k = i; k < N; k++) {
+                sum += L_inv[k][i] * d_inv[k] * L_inv[k][j];
+            }
+            entry<T, N>(result, i, j) = sum;
+        }
+    }
+}
+
+} // namespace Decomposition
+
+////////////////////////////////////////////////////////////
+//                 Triangular solves                      //
+////////////////////////////////////////////////////////////
+
+// x = L^-1 b for lower triangular L, reading only its lower triangle. L's diagonal must be nonzero,
+// or is taken as all ones with unit_diagonal
+template <typename T, size_t N, size_t M>
+constexpr Matrix<T, N, M> forward_substitution(const Matrix<T, N, N>& L, const Matrix<T, N, M>& b, bool unit_diagonal = false) {
+    Matrix<T, N, M> x = b;
+    DECOMPOSITION_UNROLL
+    for (size_t i = 0; i < N; i++) {
+        DECOMPOSITION_UNROLL
+        for (size_t k = 0; k < i; k++) {
+            for (size_t m = 0; m < M; m++) {
+                x[i][m] -= L[i][k] * x[k][m];
+            }
+        }
+        if (!unit_diagonal) {
+            T diag_inv = 1 / L[i][i];
+            for (size_t m = 0; m < M; m++) {
+                x[i][m] *= diag_inv;
+            }
+        }
+    }
+    return x;
+}
+
+// x = U^-1 b for upper triangular U, reading only its upper triangle
+template <typename T, size_t N, size_t M>
+constexpr Matrix<T, N, M> back_substitution(const Matrix<T, N, N>& U, const Matrix<T, N, M>& b, bool unit_diagonal = false) {
+    Matrix<T, N, M> x = b;
+    DECOMPOSITION_UNROLL
+    for (size_t n = 0; n < N; n++) {
+        size_t i = N - 1 - n;
+        DECOMPOSITION_UNROLL
+        for (size_t k = i + 1; k < N; k++) {
+            for (size_t m = 0; m < M; m++) {
+                x[i][m] -= U[i][k] * x[k][m];
+            }
+        }
+        if (!unit_diagonal) {
+            T diag_inv = 1 / U[i][i];
+            for (size_t m = 0; m < M; m++) {
+                x[i][m] *= diag_inv;
+            }
+        }
+    }
+    return x;
+}
+
+////////////////////////////////////////////////////////////
+//                       LDL^T                            //
+////////////////////////////////////////////////////////////
+
+// Cholesky without the square roots, A = L D L^T for symmetric positive definite A (only its lower
+// triangle is read). LD gets L below the diagonal, D on it and zeros above. False if A isn't positive definite
+template <typename T, size_t N>
+constexpr bool ldlt_decompose(const Matrix<T, N, N>& A, Matrix<T, N, N>& LD) {
+    Matrix<T, N, N> result = A;
+    if (!Decomposition::ldlt_in_place<T, N>(result)) {
+        return false;
+    }
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = i + 1; j < N; j++) {
+            result[i][j] = 0;
+        }
+    }
+    LD = result;
+    return true;
+}
+
+template <typename T, size_t N>
+constexpr bool ldlt_decompose(const SymMatrix<T, N>& A, SymMatrix<T, N>& LD) {
+    SymMatrix<T, N> result = A;
+    if (!Decomposition::ldlt_in_place<T, N>(result)) {
+        return false;
+    }
+    LD = result;
+    return true;
+}
+
+// x = A^-1 b, from ldlt_decompose(A, LD)
+template <typename T, size_t N, size_t M>
+constexpr Matrix<T, N, M> ldlt_solve(const Matrix<T, N, N>& LD, const Matrix<T, N, M>& b) {
+    return Decomposition::ldlt_solve<T, N, M>(LD, b);
+}
+
+template <typename T, size_t N, size_t M>
+constexpr Matrix<T, N, M> ldlt_solve(const SymMatrix<T, N>& LD, const Matrix<T, N, M>& b) {
+    return Decomposition::ldlt_solve<T, N, M>(LD, b);
+}
+
+////////////////////////////////////////////////////////////
+//                         LU                             //
+////////////////////////////////////////////////////////////
+
+// P A = L U, swapping in the largest pivot of each column. LU gets L (unit diagonal) below the diagonal
+// and U on and above it, and row i of P A is row perm[i] of A. False if A is singular
+template <typename T, size_t N>
+constexpr bool lu_decompose(const Matrix<T, N, N>& A, Matrix<T, N, N>& LU, std::array<size_t, N>& perm) {
+    Matrix<T, N, N> result = A;
+    for (size_t i = 0; i < N; i++) {
+        perm[i] = i;
+    }
+
+    DECOMPOSITION_UNROLL
+    for (size_t k = 0; k < N; k++) {
+        size_t pivot = k;
+        T pivot_abs = MathTraits<T>::abs(result[k][k]);
+        for (size_t i = k + 1; i < N; i++) {
+            T candidate = MathTraits<T>::abs(result[i][k]);
+            if (candidate > pivot_abs) {
+                pivot = i;
+                pivot_abs = candidate;
+            }
+        }
+        if (pivot_abs == 0) {
+            return false;
+        }
+
+        if (pivot != k) {
+            for (size_t j = 0; j < N; j++) {
+                T swap = result[k][j];
+                result[k][j] = result[pivot][j];
+                result[pivot][j] = swap;
+            }
+            size_t swap = perm[k];
+            perm[k] = perm[pivot];
+            perm[pivot] = swap;
+        }
+
+        T pivot_inv = 1 / result[k][k];
+        DECOMPOSITION_UNROLL
+        for (size_t i = k + 1; i < N; i++) {
+            T factor = result[i][k] * pivot_inv;
+            result[i][k] = factor;
+            DECOMPOSITION_UNROLL
+            for (size_t j = k + 1; j < N; j++) {
+                result[i][j] -= factor * result[k][j];
+            }
+        }
+    }
+
+    LU = result;
+    return true;
+}
+
+// x = A^-1 b, from lu_decompose(A, LU, perm)
+template <typename T, size_t N, size_t M>
+constexpr Matrix<T, N, M> lu_solve(const Matrix<T, N, N>& LU, const std::array<size_t, N>& perm, const Matrix<T, N, M>& b) {
+    Matrix<T, N, M> permuted{};
+    for (size_t i = 0; i < N; i++) {
+        permuted[i] = b[perm[i]];
+    }
+    return back_substitution(LU, forward_substitution(LU, permuted, true));
+}
+
+////////////////////////////////////////////////////////////
+//                       Inverse                          //
+////////////////////////////////////////////////////////////
+
+// Any nonsingular A, through LU. False, with result untouched, if A is singular
+template <typename T, size_t N>
+constexpr bool inverse(const Matrix<T, N, N>& A, Matrix<T, N, N>& result) {
+    Matrix<T, N, N> LU{};
+    std::array<size_t, N> perm{};
+    if (!lu_decompose(A, LU, perm)) {
+        return false;
+    }
+
+    Matrix<T, N, N> identity{};
+    for (size_t i = 0; i < N; i++) {
+        identity[i][i] = 1;
+    }
+    result = lu_solve(LU, perm, identity);
+    return true;
+}
+
+// Symmetric positive definite A, like a covariance, through LDL^T. About half the work of inverse(),
+// and the result is exactly symmetric. False, with result untouched, if A isn't positive definite
+template <typename T, size_t N>
+constexpr bool sym_inverse(const Matrix<T, N, N>& A, Matrix<T, N, N>& result) {
+    Matrix<T, N, N> LD{};
+    if (!ldlt_decompose(A, LD)) {
+        return false;
+    }
+
+    Decomposition::ldlt_inverse_lower<T, N>(LD, result);
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = i + 1; j < N; j++) {
+            result[i][j] = result[j][i];
+        }
+    }
+    return true;
+}
+
+template <typename T, size_t N>
+constexpr bool sym_inverse(const SymMatrix<T, N>& A, SymMatrix<T, N>& result) {
+    SymMatrix<T, N> LD{};
+    if (!ldlt_decompose(A, LD)) {
+        return false;
+    }
+    Decomposition::ldlt_inverse_lower<T, N>(LD, result);
+    return true;
+}
+
+////////////////////////////////////////////////////////////
+//                 Symmetric operations                   //
+////////////////////////////////////////////////////////////
+
+// F P F^T, the covariance propagation. F P is computed in full, then only the lower triangle of the result
+template <typename T, size_t N>
+constexpr SymMatrix<T, N> sym_transform(const Matrix<T, N, N>& F, const SymMatrix<T, N>& P) {
+    Matrix<T, N, N> FP{};
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = 0; j < N; j++) {
+            T sum = 0;
+            for (size_t k = 0; k < N; k++) {
+                sum += F[i][k] * P(k, j);
+            }
+            FP[i][j] = sum;
+        }
+    }
+
+    SymMatrix<T, N> result{};
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = 0; j <= i; j++) {
+            T sum = 0;
+            for (size_t k = 0; k < N; k++) {
+                sum += FP[i][k] * F[j][k];
+            }
+            result(i, j) = sum;
+        }
+    }
+    return result;
+}
+
+template <typename T, size_t N>
+constexpr SymMatrix<T, N> operator+(const SymMatrix<T, N>& lhs, const SymMatrix<T, N>& rhs) {
+    SymMatrix<T, N> result{};
+    for (size_t i = 0; i < SymMatrix<T, N>::size(); i++) {
+        result.elements[i] = lhs.elements[i] + rhs.elements[i];
+    }
+    return result;
+}
+
+template <typename T, size_t N>
+constexpr SymMatrix<T, N> operator-(const SymMatrix<T, N>& lhs, const SymMatrix<T, N>& rhs) {
+    SymMatrix<T, N> result{};
+    for (size_t i = 0; i < SymMatrix<T, N>::size(); i++) {
+        result.elements[i] = lhs.elements[i] - rhs.elements[i];
+    }
+    return result;
+}
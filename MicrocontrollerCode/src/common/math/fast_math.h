@@ -0,0 +1,238 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Float approximations of log, exp, pow, atan2, asin, acos and rsqrt for the per-sample sensor math
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// Each function here is a minimax polynomial on a reduced range, evaluated in float. The only branch on
+// the fast path is the range check, which hands zeros, negatives, infinities, NaNs and subnormals to libm,
+// so those still give the libm results. The error bounds are over the whole float domain, and
+// test_fast_math.cpp checks them against double libm:
+//     log, exp        3e-7 relative      rsqrt         2e-7 relative
+//     pow             3e-7 relative, plus 1.2e-7 |y ln x|
+//     sqrt            1.5e-7 relative    atan2, asin   2.5e-7 rad
+//     acos            3.5e-7 rad         baro_altitude 4e-7 relative, 5 mm at 30 km
+// Near pi a float step is 2.4e-7, so the angle bounds are about one step.
+//
+// HotMath is what the drivers and the quaternion helpers call. It's FastMath when built with
+// -D FAST_MATH, and LibMath, the libm functions with the same signatures, otherwise.
+
+namespace FastMath {
+
+constexpr float LN2 = 0.693147181f;
+constexpr float LN2_HI = 0.693359375f;  // 9 bits, so n * LN2_HI is exact
+constexpr float LN2_LO = -2.12194440e-4f;
+constexpr float LOG2E = 1.44269504f;
+constexpr float PI_F = 3.14159274f;
+constexpr float PI_LO = -8.74227766e-8f;  // pi - PI_F, added to the small part first so there's one rounding
+constexpr float HALF_PI_F = 1.57079637f;
+constexpr float HALF_PI_LO = -4.37113883e-8f;
+
+inline uint32_t float_bits(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+inline float bits_float(uint32_t bits) {
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+////////////////////////////////////////////////////////////
+//                      Log and exp                       //
+////////////////////////////////////////////////////////////
+
+// ln(1 + t) / t for t in [sqrt(1/2) - 1, sqrt(2) - 1], error 2.7e-8
+inline float log1p_over_t(float t) {
+    return 9.999999750e-01f + t * (-4.999997774e-01f + t * (3.333416045e-01f + t * (-2.500294614e-01f
+         + t * (1.995841719e-01f + t * (-1.654373712e-01f + t * (1.491737593e-01f
+         + t * (-1.448219091e-01f + t * 8.959922995e-02f)))))));
+}
+
+// 2^f for f in [-1/2, 1/2], relative error 1.9e-9
+inline float exp2_reduced(float f) {
+    return 1.000000001e+00f + f * (6.931472057e-01f + f * (2.402264689e-01f + f * (5.550328777e-02f
+         + f * (9.618488957e-03f + f * (1.339993122e-03f + f * 1.534581200e-04f)))));
+}
+
+// 2^n for n in [-126, 127]
+inline float pow2i(int32_t n) {
+    return bits_float((uint32_t)(n + 127) << 23);
+}
+
+inline float log(float x) {
+    if (!(x >= FLT_MIN && x <= FLT_MAX)) {
+        return logf(x);
+    }
+
+    // x = 2^e m with m in [sqrt(1/2), sqrt(2)), so ln(m) is small and keeps its relative accuracy near 1
+    uint32_t offset = float_bits(x) - 0x3f3504f3;
+    int32_t e = (int32_t)offset >> 23;
+    float t = bits_float((offset & 0x007fffff) + 0x3f3504f3) - 1;
+    return e * LN2 + t * log1p_over_t(t);
+}
+
+inline float exp(float x) {
+    // Where 2^n stays a normal float
+    if (!(x > -87.0f && x < 88.0f)) {
+        return expf(x);
+    }
+
+    // x = n ln2 + r, with r taken off in two parts so it stays exact
+    int32_t n = (int32_t)(x * LOG2E + 128.5f) - 128;
+    float r = (x - n * LN2_HI) - n * LN2_LO;
+    return exp2_reduced(r * LOG2E) * pow2i(n);
+}
+
+// e^y - 1, without losing everything to the subtraction when y is small
+inline float expm1(float y) {
+    if (!(y > -0.5f && y < 0.5f)) {
+        return exp(y) - 1;
+    }
+    return y * (9.999999998e-01f + y * (5.000000426e-01f + y * (1.666666836e-01f + y * (4.166530389e-02f
+         + y * (8.333052126e-03f + y * (1.399778300e-03f + y * 1.999682980e-04f))))));
+}
+
+// x^y for x > 0, libm's answer otherwise
+inline float pow(float x, float y) {
+    if (!(x >= FLT_MIN && x <= FLT_MAX)) {
+        return powf(x, y);
+    }
+    return exp(y * log(x));
+}
+
+// Height above the reference in the standard atmosphere troposphere, scale (1 - pressure_ratio^exponent).
+// As -scale expm1(exponent ln(pressure_ratio)), since 1 - pressure_ratio^exponent cancels near the ground
+inline float baro_altitude(float pressure_ratio, float exponent, float scale) {
+    return -scale * expm1(exponent * log(pressure_ratio));
+}
+
+////////////////////////////////////////////////////////////
+//                        Angles                          //
+////////////////////////////////////////////////////////////
+
+// atan(r) / r as a polynomial in u = r^2, u in [0, 1], error 1.4e-8
+inline float atan_over_r(float u) {
+    return 9.999999864e-01f + u * (-3.333309396e-01f + u * (1.999305413e-01f + u * (-1.420713386e-01f
+         + u * (1.065467822e-01f + u * (-7.533677877e-02f + u * (4.303938976e-02f
+         + u * (-1.628302168e-02f + u * 2.903555985e-03f)))))));
+}
+
+// asin(s) / s as a polynomial in u = s^2, u in [0, 1/4], relative error 4.4e-9
+inline float asin_over_s(float u) {
+    return 9.999999956e-01f + u * (1.666679011e-01f + u * (7.494434759e-02f + u * (4.555018542e-02f
+         + u * (2.385816911e-02f + u * 4.263564254e-02f))));
+}
+
+inline float atan2(float y, float x) {
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    float hi = ax > ay ? ax : ay;
+    float lo = ax > ay ? ay : ax;
+    if (!(hi >= FLT_MIN && hi <= FLT_MAX)) {
+        return atan2f(y, x);
+    }
+
+    // atan of the smaller over the larger, in [0, pi/4], then out to the octant as offset +- angle
+    float r = lo / hi;
+    float angle = r * atan_over_r(r * r);
+    bool steep = ay > ax;
+    bool left = x < 0;
+    float offset_hi = steep ? HALF_PI_F : (left ? PI_F : 0);
+    float offset_lo = steep ? HALF_PI_LO : (left ? PI_LO : 0);
+    angle = steep != left ? -angle : angle;
+    return copysignf((offset_lo + angle) + offset_hi, y);
+}
+
+inline float asin(float x) {
+    float ax = fabsf(x);
+    if (!(ax <= 1)) {
+        return asinf(x);
+    }
+
+    // Above 1/2, asin(x) = pi/2 - 2 asin(sqrt((1 - x) / 2)), whose argument is back under 1/2
+    bool upper = ax > 0.5f;
+    float u = upper ? (1 - ax) * 0.5f : ax * ax;
+    float s = upper ? sqrtf(u) : ax;
+    float angle = s * asin_over_s(u);
+    angle = upper ? (HALF_PI_LO - 2 * angle) + HALF_PI_F : angle;
+    return copysignf(angle, x);
+}
+
+inline float acos(float x) {
+    float ax = fabsf(x);
+    if (!(ax <= 1)) {
+        return acosf(x);
+    }
+
+    // Near +-1, acos(x) = 2 asin(sqrt((1 - |x|) / 2)) keeps the small angles accurate
+    if (ax <= 0.5f) {
+        return (HALF_PI_LO - x * asin_over_s(x * x)) + HALF_PI_F;
+    }
+    float u = (1 - ax) * 0.5f;
+    float s = sqrtf(u);
+    float angle = 2 * s * asin_over_s(u);
+    return x < 0 ? (PI_LO - angle) + PI_F : angle;
+}
+
+////////////////////////////////////////////////////////////
+//                        Roots                           //
+////////////////////////////////////////////////////////////
+
+// 1 / sqrt(x). The bit trick guess is within 3.5e-2, and each Newton step squares that
+inline float rsqrt(float x) {
+    if (!(x >= FLT_MIN && x <= FLT_MAX)) {
+        return 1 / sqrtf(x);
+    }
+
+    float half_x = 0.5f * x;
+    float y = bits_float(0x5f375a86 - (float_bits(x) >> 1));
+    y = y * (1.5f - half_x * y * y);
+    y = y * (1.5f - half_x * y * y);
+    y = y * (1.5f - half_x * y * y);
+    return y;
+}
+
+inline float sqrt(float x) {
+    if (!(x >= FLT_MIN && x <= FLT_MAX)) {
+        return sqrtf(x);
+    }
+    // x / sqrt(x), then one more Newton step on the root itself to take out the second rounding
+    float y = rsqrt(x);
+    float root = x * y;
+    return root + 0.5f * y * (x - root * root);
+}
+
+} // namespace FastMath
+
+// The same functions from libm. baro_altitude is in double, like the drivers always did it
+namespace LibMath {
+
+inline float log(float x) {return logf(x);}
+inline float exp(float x) {return expf(x);}
+inline float expm1(float y) {return expm1f(y);}
+inline float pow(float x, float y) {return powf(x, y);}
+inline float atan2(float y, float x) {return atan2f(y, x);}
+inline float asin(float x) {return asinf(x);}
+inline float acos(float x) {return acosf(x);}
+inline float rsqrt(float x) {return 1 / sqrtf(x);}
+inline float sqrt(float x) {return sqrtf(x);}
+
+inline float baro_altitude(float pressure_ratio, float exponent, float scale) {
+    return scale * (1.0 - ::pow((double)pressure_ratio, (double)exponent));
+}
+
+} // namespace LibMath
+
+#ifdef FAST_MATH
+namespace HotMath = FastMath;
+#else
+namespace HotMath = LibMath;
+#endif
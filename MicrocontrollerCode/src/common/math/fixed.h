@@ -0,0 +1,208 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Saturating Q-format fixed point, Fixed<IntBits, FracBits>, for the Matrix, Vector and Quaternion templates
+
+#include <stdint.h>
+#include "constexpr_math.h"
+
+// A signed 32-bit value with int_bits integer and frac_bits fraction bits, plus the sign.
+// Fixed<1, 30> (Q1.30) fits unit quaternions through quat_mult, Fixed<7, 24> also holds body rates in rad/s
+// for quat_integrate, and Fixed<15, 16> (Q15.16) suits general filter states.
+//
+// Arithmetic saturates at max() and min() instead of wrapping, and divide by zero saturates by sign.
+// int, float and double convert implicitly, so 0, 1 and 0.5 work in the templates; converting back is explicit.
+//
+// The operators, reciprocal() and sqrt() only use integer adds, shifts and 32x32->64 multiplies,
+// so they cost the same on every input and give bit-identical results on every core.
+
+template <int int_bits, int frac_bits>
+struct Fixed {
+    static_assert(int_bits >= 0 && frac_bits >= 0 && int_bits + frac_bits == 31,
+                  "Fixed is a sign bit plus 31 bits, so IntBits + FracBits must be 31");
+
+    static constexpr int INT_BITS = int_bits;
+    static constexpr int FRAC_BITS = frac_bits;
+    static constexpr int32_t ONE_RAW = frac_bits < 31 ? (int32_t)1 << frac_bits : INT32_MAX;
+
+    int32_t raw;
+
+    constexpr Fixed() : raw{0} {}
+    constexpr Fixed(int value) : raw{saturate((int64_t)value * ((int64_t)1 << frac_bits))} {}
+    constexpr Fixed(float value) : Fixed((double)value) {}
+    constexpr Fixed(double value) : raw{from_double(value)} {}
+
+    static constexpr Fixed from_raw(int32_t raw) {
+        Fixed result;
+        result.raw = raw;
+        return result;
+    }
+
+    static constexpr Fixed max() {return from_raw(INT32_MAX);}
+    static constexpr Fixed min() {return from_raw(-INT32_MAX);}
+    static constexpr Fixed epsilon() {return from_raw(1);}
+
+    explicit constexpr operator double() const {return (double)raw / ((int64_t)1 << frac_bits);}
+    explicit constexpr operator float() const {return (float)(double)*this;}
+
+    // Towards zero, like a float to int cast
+    explicit constexpr operator int() const {
+        return raw >= 0 ? (int)(raw >> frac_bits) : -(int)((-(int64_t)raw) >> frac_bits);
+    }
+
+    // -INT32_MAX is the floor, so negating never overflows
+    static constexpr int32_t saturate(int64_t value) {
+        return value > INT32_MAX ? INT32_MAX : (value < -INT32_MAX ? -INT32_MAX : (int32_t)value);
+    }
+
+    static constexpr int32_t from_double(double value) {
+        double scaled = value * ((int64_t)1 << frac_bits);
+        if (!(scaled == scaled)) {
+            return 0;
+        }
+        if (scaled >= (double)INT32_MAX) {
+            return INT32_MAX;
+        }
+        if (scaled <= -(double)INT32_MAX) {
+            return -INT32_MAX;
+        }
+        return (int32_t)(scaled >= 0 ? scaled + 0.5 : scaled - 0.5);
+    }
+
+    ////////////////////////////////////////////////////////////
+    //                      Operators                         //
+    ////////////////////////////////////////////////////////////
+
+    // Hidden friends, so an int or double on either side converts and nothing else competes for them
+
+    friend constexpr Fixed operator+(Fixed lhs, Fixed rhs) {return from_raw(saturate((int64_t)lhs.raw + rhs.raw));}
+    friend constexpr Fixed operator-(Fixed lhs, Fixed rhs) {return from_raw(saturate((int64_t)lhs.raw - rhs.raw));}
+    friend constexpr Fixed operator-(Fixed value) {return from_raw(-value.raw);}
+
+    // Rounded to nearest
+    friend constexpr Fixed operator*(Fixed lhs, Fixed rhs) {
+        int64_t product = (int64_t)lhs.raw * rhs.raw;
+        if (frac_bits == 0) {
+            return from_raw(saturate(product));
+        }
+        return from_raw(saturate((product + ((int64_t)1 << (frac_bits - 1))) >> frac_bits));
+    }
+
+    friend constexpr Fixed operator/(Fixed lhs, Fixed rhs) {
+        if (rhs.raw == 0) {
+            return lhs.raw >= 0 ? max() : min();
+        }
+        // 2^frac_bits fits in 64 bits with the 31-bit numerator, so this can't overflow
+        int64_t numerator = (int64_t)lhs.raw * ((int64_t)1 << frac_bits);
+        return from_raw(saturate(numerator / rhs.raw));
+    }
+
+    friend constexpr bool operator==(Fixed lhs, Fixed rhs) {return lhs.raw == rhs.raw;}
+    friend constexpr bool operator!=(Fixed lhs, Fixed rhs) {return lhs.raw != rhs.raw;}
+    friend constexpr bool operator<(Fixed lhs, Fixed rhs) {return lhs.raw < rhs.raw;}
+    friend constexpr bool operator>(Fixed lhs, Fixed rhs) {return lhs.raw > rhs.raw;}
+    friend constexpr bool operator<=(Fixed lhs, Fixed rhs) {return lhs.raw <= rhs.raw;}
+    friend constexpr bool operator>=(Fixed lhs, Fixed rhs) {return lhs.raw >= rhs.raw;}
+
+    constexpr Fixed& operator+=(Fixed rhs) {return *this = *this + rhs;}
+    constexpr Fixed& operator-=(Fixed rhs) {return *this = *this - rhs;}
+    constexpr Fixed& operator*=(Fixed rhs) {return *this = *this * rhs;}
+    constexpr Fixed& operator/=(Fixed rhs) {return *this = *this / rhs;}
+};
+
+////////////////////////////////////////////////////////////
+//                      Functions                         //
+////////////////////////////////////////////////////////////
+
+namespace FixedMath {
+
+constexpr int count_leading_zeros(uint32_t value) {
+    int count = 0;
+    for (uint32_t bit = (uint32_t)1 << 31; bit != 0 && (value & bit) == 0; bit >>= 1) {
+        count++;
+    }
+    return count;
+}
+
+// floor(sqrt(value)), one result bit per step
+constexpr uint64_t isqrt(uint64_t value) {
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+} // namespace FixedMath
+
+template <int int_bits, int frac_bits>
+constexpr Fixed<int_bits, frac_bits> abs(Fixed<int_bits, frac_bits> value) {
+    return value.raw < 0 ? -value : value;
+}
+
+// 1 / value by Newton-Raphson, without a divide. Within a couple of epsilon of 1 / value, saturating like operator/
+template <int int_bits, int frac_bits>
+constexpr Fixed<int_bits, frac_bits> reciprocal(Fixed<int_bits, frac_bits> value) {
+    using Q = Fixed<int_bits, frac_bits>;
+    if (value.raw == 0) {
+        return Q::max();
+    }
+
+    bool negative = value.raw < 0;
+    uint32_t magnitude = negative ? -value.raw : value.raw;
+
+    // d = magnitude << shift, in [0.5, 1) as Q2.30
+    int shift = FixedMath::count_leading_zeros(magnitude);
+    int64_t d = ((uint64_t)magnitude << shift) >> 2;
+
+    // 48/17 - 32/17 d is within 1/17 of 1/d on [0.5, 1), and each step squares the error
+    constexpr int64_t ONE = (int64_t)1 << 30;
+    int64_t y = (int64_t)(2.8235294117647058 * ONE) - ((int64_t)(1.8823529411764706 * ONE) * d >> 30);
+    for (int i = 0; i < 3; i++) {
+        y = y * (2 * ONE - (d * y >> 30)) >> 30;
+    }
+
+    // value = d * 2^(32 - shift - frac_bits), so 1 / value = y * 2^(shift + frac_bits - 32), as raw * 2^-frac_bits
+    int exponent = shift + 2 * frac_bits - 62;
+    int64_t raw = 0;
+    if (exponent >= 0) {
+        raw = exponent >= 32 ? INT64_MAX : y << exponent;
+        if (exponent >= 32 || raw > INT32_MAX) {
+            raw = INT32_MAX;
+        }
+    } else {
+        raw = exponent <= -63 ? 0 : (y + ((int64_t)1 << (-exponent - 1))) >> -exponent;
+    }
+    return Q::from_raw(negative ? -Q::saturate(raw) : Q::saturate(raw));
+}
+
+// sqrt(value) = isqrt(raw * 2^frac_bits), to the nearest epsilon below. 0 for negative values
+template <int int_bits, int frac_bits>
+constexpr Fixed<int_bits, frac_bits> sqrt(Fixed<int_bits, frac_bits> value) {
+    using Q = Fixed<int_bits, frac_bits>;
+    if (value.raw <= 0) {
+        return Q();
+    }
+    return Q::from_raw(Q::saturate(FixedMath::isqrt((uint64_t)value.raw << frac_bits)));
+}
+
+// The templates' abs and sqrt are the ones above. sin and cos go through double; nothing hot needs them
+template <int int_bits, int frac_bits>
+struct MathTraits<Fixed<int_bits, frac_bits>> {
+    using Q = Fixed<int_bits, frac_bits>;
+    static constexpr Q abs(Q x) {return ::abs(x);}
+    static constexpr Q sqrt(Q x) {return ::sqrt(x);}
+    static constexpr Q sin(Q x) {return Q(ConstexprMath::const_sin((double)x));}
+    static constexpr Q cos(Q x) {return Q(ConstexprMath::const_cos((double)x));}
+};
@@ -0,0 +1,265 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Flat, contiguous Vec<T,N> and Mat<T,R,C>, convertible to and from the Vector and Matrix aliases
+
+#include <math.h>
+#include <string.h>
+#include "matrix.h"
+#include "vector.h"
+
+// Both are aggregates over one row-major array, so
+//     Vec<float, 3> v = {1, 2, 3};
+//     Mat<float, 2, 2> m = {1, 0, 0, 1};
+// and data() is the whole object. Sizes that fill whole 16-byte vector registers (Vec<float, 4>,
+// Mat<float, 4, 4>, ...) are 16-byte aligned; anything else keeps the alignment of T so that a
+// Vec<float, 3> is exactly 12 bytes and can be loaded from a packed record or DMA buffer.
+//
+// Migrating: a Vec or Mat converts implicitly to the Vector/Matrix alias, and to_vec()/to_mat() go the other way.
+
+template <typename T, size_t bytes>
+constexpr size_t flat_alignment() {
+    return bytes % 16 == 0 ? 16 : alignof(T);
+}
+
+template <typename T, size_t N>
+struct alignas(flat_alignment<T, N * sizeof(T)>()) Vec {
+    T elements[N];
+
+    static constexpr size_t size() {return N;}
+
+    inline T* data() {return elements;}
+    inline const T* data() const {return elements;}
+    inline T* begin() {return elements;}
+    inline T* end() {return elements + N;}
+    inline const T* begin() const {return elements;}
+    inline const T* end() const {return elements + N;}
+
+    inline T& operator[](size_t i) {return elements[i];}
+    inline const T& operator[](size_t i) const {return elements[i];}
+
+    // From N packed Ts anywhere in memory, e.g. ImuFifoSample::accel_mps2
+    static inline Vec load(const T* src) {
+        Vec vec;
+        memcpy(vec.elements, src, sizeof(vec.elements));
+        return vec;
+    }
+
+    inline void store(T* dst) const {
+        memcpy(dst, elements, sizeof(elements));
+    }
+
+    inline operator Vector<T, N>() const {
+        Vector<T, N> vec;
+        for (size_t i = 0; i < N; i++) {
+            vec[i][0] = elements[i];
+        }
+        return vec;
+    }
+};
+
+template <typename T, size_t row, size_t col>
+struct alignas(flat_alignment<T, row * col * sizeof(T)>()) Mat {
+    T elements[row * col];
+
+    static constexpr size_t rows() {return row;}
+    static constexpr size_t cols() {return col;}
+    static constexpr size_t size() {return row * col;}
+
+    inline T* data() {return elements;}
+    inline const T* data() const {return elements;}
+
+    // mat[i][j], like the Matrix alias
+    inline T* operator[](size_t i) {return elements + i * col;}
+    inline const T* operator[](size_t i) const {return elements + i * col;}
+
+    inline T& operator()(size_t i, size_t j) {return elements[i * col + j];}
+    inline const T& operator()(size_t i, size_t j) const {return elements[i * col + j];}
+
+    static inline Mat identity() {
+        Mat mat{};
+        for (size_t i = 0; i < row && i < col; i++) {
+            mat(i, i) = 1;
+        }
+        return mat;
+    }
+
+    static inline Mat load(const T* src) {
+        Mat mat;
+        memcpy(mat.elements, src, sizeof(mat.elements));
+        return mat;
+    }
+
+    inline void store(T* dst) const {
+        memcpy(dst, elements, sizeof(elements));
+    }
+
+    inline operator Matrix<T, row, col>() const {
+        Matrix<T, row, col> mat;
+        memcpy(matrix_data(mat), elements, sizeof(elements));
+        return mat;
+    }
+};
+
+static_assert(sizeof(Vec<float, 3>) == 12, "Vec<float, 3> must overlay float[3]");
+static_assert(alignof(Mat<float, 4, 4>) == 16, "Mat<float, 4, 4> must be SIMD aligned");
+
+////////////////////////////////////////////////////////////
+//                      Conversion                        //
+////////////////////////////////////////////////////////////
+
+template <typename T, size_t N>
+inline Vec<T, N> to_vec(const Vector<T, N>& vec) {
+    Vec<T, N> result;
+    for (size_t i = 0; i < N; i++) {
+        result[i] = vec[i][0];
+    }
+    return result;
+}
+
+template <typename T, size_t row, size_t col>
+inline Mat<T, row, col> to_mat(const Matrix<T, row, col>& mat) {
+    return Mat<T, row, col>::load(matrix_data(mat));
+}
+
+////////////////////////////////////////////////////////////
+//                      Operators                         //
+////////////////////////////////////////////////////////////
+
+// Float goes through the MatrixKernels, other types the plain loops
+
+template <typename T>
+inline void flat_mult(const T* a, const T* b, T* c, size_t m, size_t n, size_t k) {
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < k; j++) {
+            T sum = 0;
+            for (size_t p = 0; p < n; p++) {
+                sum += a[i * n + p] * b[p * k + j];
+            }
+            c[i * k + j] = sum;
+        }
+    }
+}
+
+inline void flat_mult(const float* a, const float* b, float* c, size_t m, size_t n, size_t k) {
+    if (m == 3 && n == 3 && k == 3) {
+        MatrixKernels::mult_3x3x3_f32(a, b, c);
+    } else if (m == 3 && n == 3 && k == 1) {
+        MatrixKernels::mult_3x3x1_f32(a, b, c);
+    } else if (m == 4 && n == 4 && k == 4) {
+        MatrixKernels::mult_4x4x4_f32(a, b, c);
+    } else {
+        MatrixKernels::mult_f32(a, b, c, m, n, k);
+    }
+}
+
+template <typename T>
+inline void flat_add(const T* a, const T* b, T* c, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        c[i] = a[i] + b[i];
+    }
+}
+
+inline void flat_add(const float* a, const float* b, float* c, size_t len) {
+    MatrixKernels::add_f32(a, b, c, len);
+}
+
+template <typename T>
+inline void flat_sub(const T* a, const T* b, T* c, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        c[i] = a[i] - b[i];
+    }
+}
+
+inline void flat_sub(const float* a, const float* b, float* c, size_t len) {
+    MatrixKernels::sub_f32(a, b, c, len);
+}
+
+template <typename T, size_t row_f, size_t dim_int, size_t col_f>
+inline Mat<T, row_f, col_f> operator*(const Mat<T, row_f, dim_int>& lhs, const Mat<T, dim_int, col_f>& rhs) {
+    Mat<T, row_f, col_f> result;
+    flat_mult(lhs.data(), rhs.data(), result.data(), row_f, dim_int, col_f);
+    return result;
+}
+
+template <typename T, size_t row, size_t col>
+inline Vec<T, row> operator*(const Mat<T, row, col>& lhs, const Vec<T, col>& rhs) {
+    Vec<T, row> result;
+    flat_mult(lhs.data(), rhs.data(), result.data(), row, col, 1);
+    return result;
+}
+
+template <typename T, size_t row, size_t col>
+inline Mat<T, row, col> operator+(const Mat<T, row, col>& lhs, const Mat<T, row, col>& rhs) {
+    Mat<T, row, col> result;
+    flat_add(lhs.data(), rhs.data(), result.data(), row * col);
+    return result;
+}
+
+template <typename T, size_t row, size_t col>
+inline Mat<T, row, col> operator-(const Mat<T, row, col>& lhs, const Mat<T, row, col>& rhs) {
+    Mat<T, row, col> result;
+    flat_sub(lhs.data(), rhs.data(), result.data(), row * col);
+    return result;
+}
+
+template <typename T, size_t N>
+inline Vec<T, N> operator+(const Vec<T, N>& lhs, const Vec<T, N>& rhs) {
+    Vec<T, N> result;
+    flat_add(lhs.data(), rhs.data(), result.data(), N);
+    return result;
+}
+
+template <typename T, size_t N>
+inline Vec<T, N> operator-(const Vec<T, N>& lhs, const Vec<T, N>& rhs) {
+    Vec<T, N> result;
+    flat_sub(lhs.data(), rhs.data(), result.data(), N);
+    return result;
+}
+
+template <typename T, size_t N>
+inline Vec<T, N> operator*(const Vec<T, N>& vec, T scale) {
+    Vec<T, N> result;
+    for (size_t i = 0; i < N; i++) {
+        result[i] = vec[i] * scale;
+    }
+    return result;
+}
+
+template <typename T, size_t N>
+inline Vec<T, N> operator*(T scale, const Vec<T, N>& vec) {
+    return vec * scale;
+}
+
+template <typename T, size_t row, size_t col>
+inline Mat<T, col, row> transpose(const Mat<T, row, col>& mat) {
+    Mat<T, col, row> result;
+    for (size_t i = 0; i < row; i++) {
+        for (size_t j = 0; j < col; j++) {
+            result(j, i) = mat(i, j);
+        }
+    }
+    return result;
+}
+
+template <typename T, size_t N>
+inline T dot(const Vec<T, N>& lhs, const Vec<T, N>& rhs) {
+    T sum = 0;
+    for (size_t i = 0; i < N; i++) {
+        sum += lhs[i] * rhs[i];
+    }
+    return sum;
+}
+
+template <typename T>
+inline Vec<T, 3> cross(const Vec<T, 3>& lhs, const Vec<T, 3>& rhs) {
+    return {lhs[1] * rhs[2] - lhs[2] * rhs[1],
+            lhs[2] * rhs[0] - lhs[0] * rhs[2],
+            lhs[0] * rhs[1] - lhs[1] * rhs[0]};
+}
+
+template <typename T, size_t N>
+inline T norm(const Vec<T, N>& vec) {
+    return sqrt(dot(vec, vec));
+}
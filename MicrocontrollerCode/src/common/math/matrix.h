@@ -3,6 +3,8 @@
 #include <array>
 #include <Arduino.h>
 #include "../globals.h"
+#include "matrix_kernels.h"
+#include "constexpr_math.h"
 
 // Defining NxM matrix
 // Example call: Matrix<float, 3, 3> mat3x3 = {{{4, 7, 1}, {2, 6, 0}, {0, 5, 0}}};
@@ -15,10 +17,27 @@ using Matrix3 = std::array<std::array<T, 3>, 3>;
 
 // MATRIX MATH WOOO
 
+// Everything here is constexpr, so constant matrices can be built at compile time. The float kernels
+// can't run in a constant expression, so the compiler has to say when it is evaluating one. GCC 8 (the
+// ESP32 toolchain) can't, and there only 3x3 and 4x4 float products and non-float types work at compile time
+#if defined(__clang__)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define MATRIX_DETECTS_CONSTANT_EVALUATION
+#endif
+#elif defined(__GNUC__) && __GNUC__ >= 9
+#define MATRIX_DETECTS_CONSTANT_EVALUATION
+#endif
+#ifdef MATRIX_DETECTS_CONSTANT_EVALUATION
+#define MATRIX_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#ifndef MATRIX_CONSTANT_EVALUATED
+#define MATRIX_CONSTANT_EVALUATED() false
+#endif
+
 // Function to transpose a matrix
 template <typename T, size_t row, size_t col>
-Matrix<T, col, row> transpose(const Matrix<T, row, col>& mat) {
-    Matrix<T, col, row> result;
+constexpr Matrix<T, col, row> transpose(const Matrix<T, row, col>& mat) {
+    Matrix<T, col, row> result{};
     for (size_t i = 0; i < row; i++) {
         for (size_t j = 0; j < col; j++) {
             result[j][i] = mat[i][j];
@@ -27,13 +46,25 @@ Matrix<T, col, row> transpose(const Matrix<T, row, col>& mat) {
     return result;
 }
 
+// Element-wise static_cast, e.g. between Matrix<float> and Matrix<Fixed<15, 16>>
+template <typename U, typename T, size_t row, size_t col>
+constexpr Matrix<U, row, col> matrix_cast(const Matrix<T, row, col>& mat) {
+    Matrix<U, row, col> result{};
+    for (size_t i = 0; i < row; i++) {
+        for (size_t j = 0; j < col; j++) {
+            result[i][j] = static_cast<U>(mat[i][j]);
+        }
+    }
+    return result;
+}
+
 // Overload float matrix equality
 template <size_t row, size_t col>
-bool matrix_float_equals(const Matrix<float, row, col>& mat1, const Matrix<float, row, col>& mat2) {
+constexpr bool matrix_float_equals(const Matrix<float, row, col>& mat1, const Matrix<float, row, col>& mat2) {
 
     for (size_t i = 0; i < row; i++) {
         for (size_t j = 0; j < col; j++) {
-            if (abs(mat1[i][j] - mat2[i][j]) > 1e-6) {
+            if (ConstexprMath::const_abs(mat1[i][j] - mat2[i][j]) > 1e-6) {
                 return false;
             }
         }
@@ -43,7 +74,7 @@ bool matrix_float_equals(const Matrix<float, row, col>& mat1, const Matrix<float
 
 // Overload float matrix equality
 template <size_t row, size_t col>
-bool matrix_int_equals(const Matrix<int, row, col>& mat1, const Matrix<int, row, col>& mat2) {
+constexpr bool matrix_int_equals(const Matrix<int, row, col>& mat1, const Matrix<int, row, col>& mat2) {
 
     for (size_t i = 0; i < row; i++) {
         for (size_t j = 0; j < col; j++) {
@@ -55,46 +86,143 @@ bool matrix_int_equals(const Matrix<int, row, col>& mat1, const Matrix<int, row,
     return true;
 }
 
-// Overload operator* for matrix multiplication
+// Matrix<float> rows are packed back to back, which the float kernels rely on
+static_assert(sizeof(Matrix<float, 3, 5>) == 15 * sizeof(float), "Matrix<float> must be densely packed");
+
+// All of the elements as one array. Through the outer array, so kernels may read past the first row
+template <typename T, size_t row, size_t col>
+inline const T* matrix_data(const Matrix<T, row, col>& mat) {
+    return reinterpret_cast<const T*>(mat.data());
+}
+
+template <typename T, size_t row, size_t col>
+inline T* matrix_data(Matrix<T, row, col>& mat) {
+    return reinterpret_cast<T*>(mat.data());
+}
+
+// Reference loops. Any T, and what the float kernels are checked against
 template <typename T, size_t row_f, size_t dim_int, size_t col_f>
-Matrix<T, row_f, col_f> operator*(const Matrix<T, row_f, dim_int>& mat1, const Matrix<T, dim_int, col_f>& mat2) {
-    Matrix<T, row_f, col_f> result;
+constexpr void matrix_mult_scalar(const Matrix<T, row_f, dim_int>& mat1, const Matrix<T, dim_int, col_f>& mat2, Matrix<T, row_f, col_f>& result) {
     for (size_t i = 0; i < row_f; i++) {
         for (size_t j = 0; j < col_f; j++) {
 
             result[i][j] = 0;
             for (size_t k = 0; k < dim_int; k++) {
                 result[i][j] += mat1[i][k] * mat2[k][j];
-                // Serial.print(mat1[i][k] * mat2[k][j]);
-                // Serial.print("....");
-                // Serial.println();
             }
         }
     }
-    return result;
 }
 
-// Overload the + operator for Matrix addition
 template <typename T, size_t row, size_t col>
-Matrix<T, row, col> operator+(const Matrix<T, row, col>& lhs, const Matrix<T, row, col>& rhs) {
-    Matrix<T, row, col> result;
+constexpr void matrix_add_scalar(const Matrix<T, row, col>& lhs, const Matrix<T, row, col>& rhs, Matrix<T, row, col>& result) {
     for (size_t i = 0; i < row; i++) {
         for (size_t j = 0; j < col; j++) {
             result[i][j] = lhs[i][j] + rhs[i][j];
         }
     }
-    return result;
 }
 
-// Overload the - operator for Matrix subtraction
 template <typename T, size_t row, size_t col>
-Matrix<T, row, col> operator-(const Matrix<T, row, col>& lhs, const Matrix<T, row, col>& rhs) {
-    Matrix<T, row, col> result;
+constexpr void matrix_sub_scalar(const Matrix<T, row, col>& lhs, const Matrix<T, row, col>& rhs, Matrix<T, row, col>& result) {
     for (size_t i = 0; i < row; i++) {
         for (size_t j = 0; j < col; j++) {
             result[i][j] = lhs[i][j] - rhs[i][j];
         }
     }
+}
+
+// Backend selection. Overload resolution picks the unrolled sizes, then any float size, then the reference loops
+template <typename T, size_t row_f, size_t dim_int, size_t col_f>
+constexpr void matrix_mult(const Matrix<T, row_f, dim_int>& mat1, const Matrix<T, dim_int, col_f>& mat2, Matrix<T, row_f, col_f>& result) {
+    matrix_mult_scalar(mat1, mat2, result);
+}
+
+template <size_t row_f, size_t dim_int, size_t col_f>
+constexpr void matrix_mult(const Matrix<float, row_f, dim_int>& mat1, const Matrix<float, dim_int, col_f>& mat2, Matrix<float, row_f, col_f>& result) {
+    if (MATRIX_CONSTANT_EVALUATED()) {
+        matrix_mult_scalar(mat1, mat2, result);
+        return;
+    }
+    MatrixKernels::mult_f32(matrix_data(mat1), matrix_data(mat2), matrix_data(result), row_f, dim_int, col_f);
+}
+
+// Written out like MatrixKernels::mult_3x3x3_f32, but on the arrays so it stays constexpr everywhere
+constexpr void matrix_mult(const Matrix<float, 3, 3>& mat1, const Matrix<float, 3, 3>& mat2, Matrix<float, 3, 3>& result) {
+    for (size_t i = 0; i < 3; i++) {
+        const float a0 = mat1[i][0], a1 = mat1[i][1], a2 = mat1[i][2];
+        result[i][0] = a0 * mat2[0][0] + a1 * mat2[1][0] + a2 * mat2[2][0];
+        result[i][1] = a0 * mat2[0][1] + a1 * mat2[1][1] + a2 * mat2[2][1];
+        result[i][2] = a0 * mat2[0][2] + a1 * mat2[1][2] + a2 * mat2[2][2];
+    }
+}
+
+constexpr void matrix_mult(const Matrix<float, 3, 3>& mat1, const Matrix<float, 3, 1>& mat2, Matrix<float, 3, 1>& result) {
+    for (size_t i = 0; i < 3; i++) {
+        result[i][0] = mat1[i][0] * mat2[0][0] + mat1[i][1] * mat2[1][0] + mat1[i][2] * mat2[2][0];
+    }
+}
+
+// Without a way to tell, the loops. That's all the kernel does without SSE or NEON anyway
+constexpr void matrix_mult(const Matrix<float, 4, 4>& mat1, const Matrix<float, 4, 4>& mat2, Matrix<float, 4, 4>& result) {
+#ifdef MATRIX_DETECTS_CONSTANT_EVALUATION
+    if (!MATRIX_CONSTANT_EVALUATED()) {
+        MatrixKernels::mult_4x4x4_f32(matrix_data(mat1), matrix_data(mat2), matrix_data(result));
+        return;
+    }
+#endif
+    matrix_mult_scalar(mat1, mat2, result);
+}
+
+template <typename T, size_t row, size_t col>
+constexpr void matrix_add(const Matrix<T, row, col>& lhs, const Matrix<T, row, col>& rhs, Matrix<T, row, col>& result) {
+    matrix_add_scalar(lhs, rhs, result);
+}
+
+template <size_t row, size_t col>
+constexpr void matrix_add(const Matrix<float, row, col>& lhs, const Matrix<float, row, col>& rhs, Matrix<float, row, col>& result) {
+    if (MATRIX_CONSTANT_EVALUATED()) {
+        matrix_add_scalar(lhs, rhs, result);
+        return;
+    }
+    MatrixKernels::add_f32(matrix_data(lhs), matrix_data(rhs), matrix_data(result), row * col);
+}
+
+template <typename T, size_t row, size_t col>
+constexpr void matrix_sub(const Matrix<T, row, col>& lhs, const Matrix<T, row, col>& rhs, Matrix<T, row, col>& result) {
+    matrix_sub_scalar(lhs, rhs, result);
+}
+
+template <size_t row, size_t col>
+constexpr void matrix_sub(const Matrix<float, row, col>& lhs, const Matrix<float, row, col>& rhs, Matrix<float, row, col>& result) {
+    if (MATRIX_CONSTANT_EVALUATED()) {
+        matrix_sub_scalar(lhs, rhs, result);
+        return;
+    }
+    MatrixKernels::sub_f32(matrix_data(lhs), matrix_data(rhs), matrix_data(result), row * col);
+}
+
+// Overload operator* for matrix multiplication
+template <typename T, size_t row_f, size_t dim_int, size_t col_f>
+constexpr Matrix<T, row_f, col_f> operator*(const Matrix<T, row_f, dim_int>& mat1, const Matrix<T, dim_int, col_f>& mat2) {
+    Matrix<T, row_f, col_f> result{};
+    matrix_mult(mat1, mat2, result);
+    return result;
+}
+
+// Overload the + operator for Matrix addition
+template <typename T, size_t row, size_t col>
+constexpr Matrix<T, row, col> operator+(const Matrix<T, row, col>& lhs, const Matrix<T, row, col>& rhs) {
+    Matrix<T, row, col> result{};
+    matrix_add(lhs, rhs, result);
+    return result;
+}
+
+// Overload the - operator for Matrix subtraction
+template <typename T, size_t row, size_t col>
+constexpr Matrix<T, row, col> operator-(const Matrix<T, row, col>& lhs, const Matrix<T, row, col>& rhs) {
+    Matrix<T, row, col> result{};
+    matrix_sub(lhs, rhs, result);
     return result;
 }
 
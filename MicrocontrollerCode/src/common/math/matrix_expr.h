@@ -0,0 +1,242 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Lazy Matrix expressions, evaluated in one loop when assigned to a Matrix
+
+#include "matrix.h"
+
+// The plain operators in matrix.h return a Matrix per operation. Starting an expression with lazy()
+// builds it up instead and evaluates it once, straight into the destination:
+//     Matrix<float, 6, 6> P_next = lazy(F) * P * transpose(lazy(F)) + Q;
+//
+// +, - and scalar * are fused into that loop. A product needs each operand element many times, so an
+// operand that is itself an expression is evaluated once first. Nodes hold references to the matrices
+// they were built from, so assign an expression right away instead of keeping it in an auto variable.
+
+template <typename Derived, typename T, size_t row, size_t col>
+struct MatrixExpr {
+    inline const Derived& self() const {return static_cast<const Derived&>(*this);}
+
+    inline T operator()(size_t i, size_t j) const {return self().at(i, j);}
+
+    // Default evaluation, one element at a time. result must not be an operand
+    inline void assign_to(Matrix<T, row, col>& result) const {
+        for (size_t i = 0; i < row; i++) {
+            for (size_t j = 0; j < col; j++) {
+                result[i][j] = self().at(i, j);
+            }
+        }
+    }
+
+    // Evaluated into a new Matrix, so assigning back to an operand (P = lazy(F) * P) is safe
+    inline Matrix<T, row, col> eval() const {
+        Matrix<T, row, col> result;
+        self().assign_to(result);
+        return result;
+    }
+
+    inline operator Matrix<T, row, col>() const {return eval();}
+};
+
+////////////////////////////////////////////////////////////
+//                       Operands                         //
+////////////////////////////////////////////////////////////
+
+// An existing Matrix, by reference
+template <typename T, size_t row, size_t col>
+struct MatrixRef : MatrixExpr<MatrixRef<T, row, col>, T, row, col> {
+    const Matrix<T, row, col>& mat;
+
+    explicit MatrixRef(const Matrix<T, row, col>& mat) : mat{mat} {}
+    inline T at(size_t i, size_t j) const {return mat[i][j];}
+    inline const Matrix<T, row, col>& matrix() const {return mat;}
+};
+
+// An evaluated sub-expression, owned by the node that needed it
+template <typename T, size_t row, size_t col>
+struct MatrixValue : MatrixExpr<MatrixValue<T, row, col>, T, row, col> {
+    Matrix<T, row, col> mat;
+
+    template <typename E>
+    explicit MatrixValue(const MatrixExpr<E, T, row, col>& expr) {expr.self().assign_to(mat);}
+    inline T at(size_t i, size_t j) const {return mat[i][j];}
+    inline const Matrix<T, row, col>& matrix() const {return mat;}
+};
+
+template <typename T, size_t row, size_t col>
+inline MatrixRef<T, row, col> lazy(const Matrix<T, row, col>& mat) {
+    return MatrixRef<T, row, col>(mat);
+}
+
+////////////////////////////////////////////////////////////
+//                     Element-wise                       //
+////////////////////////////////////////////////////////////
+
+template <typename L, typename R, typename T, size_t row, size_t col>
+struct MatrixSum : MatrixExpr<MatrixSum<L, R, T, row, col>, T, row, col> {
+    L lhs;
+    R rhs;
+
+    MatrixSum(const L& lhs, const R& rhs) : lhs{lhs}, rhs{rhs} {}
+    inline T at(size_t i, size_t j) const {return lhs.at(i, j) + rhs.at(i, j);}
+};
+
+template <typename L, typename R, typename T, size_t row, size_t col>
+struct MatrixDifference : MatrixExpr<MatrixDifference<L, R, T, row, col>, T, row, col> {
+    L lhs;
+    R rhs;
+
+    MatrixDifference(const L& lhs, const R& rhs) : lhs{lhs}, rhs{rhs} {}
+    inline T at(size_t i, size_t j) const {return lhs.at(i, j) - rhs.at(i, j);}
+};
+
+template <typename E, typename T, size_t row, size_t col>
+struct MatrixScaled : MatrixExpr<MatrixScaled<E, T, row, col>, T, row, col> {
+    E expr;
+    T scale;
+
+    MatrixScaled(const E& expr, T scale) : expr{expr}, scale{scale} {}
+    inline T at(size_t i, size_t j) const {return expr.at(i, j) * scale;}
+};
+
+// row x col, of an expression that is col x row
+template <typename E, typename T, size_t row, size_t col>
+struct MatrixTransposed : MatrixExpr<MatrixTransposed<E, T, row, col>, T, row, col> {
+    E expr;
+
+    explicit MatrixTransposed(const E& expr) : expr{expr} {}
+    inline T at(size_t i, size_t j) const {return expr.at(j, i);}
+};
+
+////////////////////////////////////////////////////////////
+//                       Product                          //
+////////////////////////////////////////////////////////////
+
+// How a product keeps an operand. Matrices and their transposes are read in place, anything else is
+// evaluated once rather than per element
+template <typename E, typename T, size_t row, size_t col>
+struct ProductOperand {
+    using type = MatrixValue<T, row, col>;
+};
+
+template <typename T, size_t row, size_t col>
+struct ProductOperand<MatrixRef<T, row, col>, T, row, col> {
+    using type = MatrixRef<T, row, col>;
+};
+
+template <typename T, size_t row, size_t col>
+struct ProductOperand<MatrixValue<T, row, col>, T, row, col> {
+    using type = MatrixValue<T, row, col>;
+};
+
+template <typename T, size_t row, size_t col>
+struct ProductOperand<MatrixTransposed<MatrixRef<T, col, row>, T, row, col>, T, row, col> {
+    using type = MatrixTransposed<MatrixRef<T, col, row>, T, row, col>;
+};
+
+template <typename L, typename R, typename T, size_t row_f, size_t dim_int, size_t col_f>
+struct MatrixProduct : MatrixExpr<MatrixProduct<L, R, T, row_f, dim_int, col_f>, T, row_f, col_f> {
+    typename ProductOperand<L, T, row_f, dim_int>::type lhs;
+    typename ProductOperand<R, T, dim_int, col_f>::type rhs;
+
+    MatrixProduct(const L& lhs, const R& rhs) : lhs{lhs}, rhs{rhs} {}
+
+    inline T at(size_t i, size_t j) const {
+        T sum = 0;
+        for (size_t k = 0; k < dim_int; k++) {
+            sum += lhs.at(i, k) * rhs.at(k, j);
+        }
+        return sum;
+    }
+
+    // On its own, a product of two matrices goes to the matrix_mult kernels
+    inline void assign_to(Matrix<T, row_f, col_f>& result) const {
+        assign_product(lhs, rhs, result);
+    }
+
+private:
+    template <typename A, typename B>
+    static inline void assign_product(const A& a, const B& b, Matrix<T, row_f, col_f>& result) {
+        for (size_t i = 0; i < row_f; i++) {
+            for (size_t j = 0; j < col_f; j++) {
+                T sum = 0;
+                for (size_t k = 0; k < dim_int; k++) {
+                    sum += a.at(i, k) * b.at(k, j);
+                }
+                result[i][j] = sum;
+            }
+        }
+    }
+
+    template <template <typename, size_t, size_t> class A, template <typename, size_t, size_t> class B>
+    static inline void assign_product(const A<T, row_f, dim_int>& a, const B<T, dim_int, col_f>& b, Matrix<T, row_f, col_f>& result) {
+        matrix_mult(a.matrix(), b.matrix(), result);
+    }
+};
+
+////////////////////////////////////////////////////////////
+//                      Operators                         //
+////////////////////////////////////////////////////////////
+
+// At least one side is an expression, so these never compete with the eager Matrix operators
+
+template <typename L, typename R, typename T, size_t row, size_t col>
+inline MatrixSum<L, R, T, row, col> operator+(const MatrixExpr<L, T, row, col>& lhs, const MatrixExpr<R, T, row, col>& rhs) {
+    return {lhs.self(), rhs.self()};
+}
+
+template <typename L, typename T, size_t row, size_t col>
+inline MatrixSum<L, MatrixRef<T, row, col>, T, row, col> operator+(const MatrixExpr<L, T, row, col>& lhs, const Matrix<T, row, col>& rhs) {
+    return {lhs.self(), lazy(rhs)};
+}
+
+template <typename R, typename T, size_t row, size_t col>
+inline MatrixSum<MatrixRef<T, row, col>, R, T, row, col> operator+(const Matrix<T, row, col>& lhs, const MatrixExpr<R, T, row, col>& rhs) {
+    return {lazy(lhs), rhs.self()};
+}
+
+template <typename L, typename R, typename T, size_t row, size_t col>
+inline MatrixDifference<L, R, T, row, col> operator-(const MatrixExpr<L, T, row, col>& lhs, const MatrixExpr<R, T, row, col>& rhs) {
+    return {lhs.self(), rhs.self()};
+}
+
+template <typename L, typename T, size_t row, size_t col>
+inline MatrixDifference<L, MatrixRef<T, row, col>, T, row, col> operator-(const MatrixExpr<L, T, row, col>& lhs, const Matrix<T, row, col>& rhs) {
+    return {lhs.self(), lazy(rhs)};
+}
+
+template <typename R, typename T, size_t row, size_t col>
+inline MatrixDifference<MatrixRef<T, row, col>, R, T, row, col> operator-(const Matrix<T, row, col>& lhs, const MatrixExpr<R, T, row, col>& rhs) {
+    return {lazy(lhs), rhs.self()};
+}
+
+template <typename L, typename R, typename T, size_t row_f, size_t dim_int, size_t col_f>
+inline MatrixProduct<L, R, T, row_f, dim_int, col_f> operator*(const MatrixExpr<L, T, row_f, dim_int>& lhs, const MatrixExpr<R, T, dim_int, col_f>& rhs) {
+    return {lhs.self(), rhs.self()};
+}
+
+template <typename L, typename T, size_t row_f, size_t dim_int, size_t col_f>
+inline MatrixProduct<L, MatrixRef<T, dim_int, col_f>, T, row_f, dim_int, col_f> operator*(const MatrixExpr<L, T, row_f, dim_int>& lhs, const Matrix<T, dim_int, col_f>& rhs) {
+    return {lhs.self(), lazy(rhs)};
+}
+
+template <typename R, typename T, size_t row_f, size_t dim_int, size_t col_f>
+inline MatrixProduct<MatrixRef<T, row_f, dim_int>, R, T, row_f, dim_int, col_f> operator*(const Matrix<T, row_f, dim_int>& lhs, const MatrixExpr<R, T, dim_int, col_f>& rhs) {
+    return {lazy(lhs), rhs.self()};
+}
+
+template <typename E, typename T, size_t row, size_t col>
+inline MatrixScaled<E, T, row, col> operator*(const MatrixExpr<E, T, row, col>& expr, T scale) {
+    return {expr.self(), scale};
+}
+
+template <typename E, typename T, size_t row, size_t col>
+inline MatrixScaled<E, T, row, col> operator*(T scale, const MatrixExpr<E, T, row, col>& expr) {
+    return {expr.self(), scale};
+}
+
+template <typename E, typename T, size_t row, size_t col>
+inline MatrixTransposed<E, T, col, row> transpose(const MatrixExpr<E, T, row, col>& expr) {
+    return MatrixTransposed<E, T, col, row>(expr.self());
+}
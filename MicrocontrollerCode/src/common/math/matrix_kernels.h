@@ -0,0 +1,194 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Float kernels behind Matrix operator*, + and -, with the backend picked at compile time
+
+#include <stddef.h>
+
+// ESP-DSP on the ESP32, SSE/AVX or NEON on a host, plain loops otherwise.
+// Build with -D MATRIX_SCALAR to force the plain loops everywhere.
+#if defined(MATRIX_SCALAR)
+#define MATRIX_BACKEND_NAME "scalar"
+#elif defined(ARDUINO_ARCH_ESP32) && __has_include(<esp_dsp.h>)
+#include <esp_dsp.h>
+#define MATRIX_BACKEND_ESP_DSP
+#define MATRIX_BACKEND_NAME "esp-dsp"
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define MATRIX_BACKEND_AVX
+#define MATRIX_BACKEND_SSE
+#define MATRIX_BACKEND_NAME "avx"
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define MATRIX_BACKEND_SSE
+#define MATRIX_BACKEND_NAME "sse"
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MATRIX_BACKEND_NEON
+#define MATRIX_BACKEND_NAME "neon"
+#else
+#define MATRIX_BACKEND_NAME "scalar"
+#endif
+
+// All take row-major, densely packed matrices. Outputs must not alias the inputs
+namespace MatrixKernels {
+
+// ESP-DSP below this many multiply-adds costs more in the call than it saves
+constexpr size_t ESP_DSP_MIN_MACS = 64;
+
+////////////////////////////////////////////////////////////
+//                      Unrolled                          //
+////////////////////////////////////////////////////////////
+
+// The filters' common sizes, small enough that the compiler keeps everything in registers
+
+inline void mult_3x3x3_f32(const float* a, const float* b, float* c) {
+    for (size_t i = 0; i < 3; i++) {
+        const float a0 = a[3 * i], a1 = a[3 * i + 1], a2 = a[3 * i + 2];
+        c[3 * i]     = a0 * b[0] + a1 * b[3] + a2 * b[6];
+        c[3 * i + 1] = a0 * b[1] + a1 * b[4] + a2 * b[7];
+        c[3 * i + 2] = a0 * b[2] + a1 * b[5] + a2 * b[8];
+    }
+}
+
+inline void mult_3x3x1_f32(const float* a, const float* b, float* c) {
+    c[0] = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    c[1] = a[3] * b[0] + a[4] * b[1] + a[5] * b[2];
+    c[2] = a[6] * b[0] + a[7] * b[1] + a[8] * b[2];
+}
+
+inline void mult_4x4x4_f32(const float* a, const float* b, float* c) {
+    for (size_t i = 0; i < 4; i++) {
+#if defined(MATRIX_BACKEND_SSE)
+        __m128 sum = _mm_mul_ps(_mm_set1_ps(a[4 * i]), _mm_loadu_ps(b));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a[4 * i + 1]), _mm_loadu_ps(b + 4)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a[4 * i + 2]), _mm_loadu_ps(b + 8)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a[4 * i + 3]), _mm_loadu_ps(b + 12)));
+        _mm_storeu_ps(c + 4 * i, sum);
+#elif defined(MATRIX_BACKEND_NEON)
+        float32x4_t sum = vmulq_n_f32(vld1q_f32(b), a[4 * i]);
+        sum = vmlaq_n_f32(sum, vld1q_f32(b + 4), a[4 * i + 1]);
+        sum = vmlaq_n_f32(sum, vld1q_f32(b + 8), a[4 * i + 2]);
+        sum = vmlaq_n_f32(sum, vld1q_f32(b + 12), a[4 * i + 3]);
+        vst1q_f32(c + 4 * i, sum);
+#else
+        const float a0 = a[4 * i], a1 = a[4 * i + 1], a2 = a[4 * i + 2], a3 = a[4 * i + 3];
+        c[4 * i]     = a0 * b[0] + a1 * b[4] + a2 * b[8]  + a3 * b[12];
+        c[4 * i + 1] = a0 * b[1] + a1 * b[5] + a2 * b[9]  + a3 * b[13];
+        c[4 * i + 2] = a0 * b[2] + a1 * b[6] + a2 * b[10] + a3 * b[14];
+        c[4 * i + 3] = a0 * b[3] + a1 * b[7] + a2 * b[11] + a3 * b[15];
+#endif
+    }
+}
+
+////////////////////////////////////////////////////////////
+//                       General                          //
+////////////////////////////////////////////////////////////
+
+// c (m x k) = a (m x n) * b (n x k)
+inline void mult_f32(const float* a, const float* b, float* c, size_t m, size_t n, size_t k) {
+#if defined(MATRIX_BACKEND_ESP_DSP)
+    if (m * n * k >= ESP_DSP_MIN_MACS) {
+        dspm_mult_f32(a, b, c, m, n, k);
+        return;
+    }
+#endif
+
+    // Row i of c is a weighted sum of the rows of b, so whole rows go through the vector unit
+    for (size_t i = 0; i < m; i++) {
+        const float* a_row = a + i * n;
+        float* c_row = c + i * k;
+        size_t j = 0;
+
+#if defined(MATRIX_BACKEND_AVX)
+        for (; j + 8 <= k; j += 8) {
+            __m256 sum = _mm256_setzero_ps();
+            for (size_t p = 0; p < n; p++) {
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(a_row[p]), _mm256_loadu_ps(b + p * k + j)));
+            }
+            _mm256_storeu_ps(c_row + j, sum);
+        }
+#endif
+#if defined(MATRIX_BACKEND_SSE)
+        for (; j + 4 <= k; j += 4) {
+            __m128 sum = _mm_setzero_ps();
+            for (size_t p = 0; p < n; p++) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a_row[p]), _mm_loadu_ps(b + p * k + j)));
+            }
+            _mm_storeu_ps(c_row + j, sum);
+        }
+#elif defined(MATRIX_BACKEND_NEON)
+        for (; j + 4 <= k; j += 4) {
+            float32x4_t sum = vdupq_n_f32(0);
+            for (size_t p = 0; p < n; p++) {
+                sum = vmlaq_n_f32(sum, vld1q_f32(b + p * k + j), a_row[p]);
+            }
+            vst1q_f32(c_row + j, sum);
+        }
+#endif
+
+        // What's left of the row, and all of it on the scalar backend
+        for (; j < k; j++) {
+            float sum = 0;
+            for (size_t p = 0; p < n; p++) {
+                sum += a_row[p] * b[p * k + j];
+            }
+            c_row[j] = sum;
+        }
+    }
+}
+
+// c = a + b, element-wise over len floats
+inline void add_f32(const float* a, const float* b, float* c, size_t len) {
+#if defined(MATRIX_BACKEND_ESP_DSP)
+    dsps_add_f32(a, b, c, len, 1, 1, 1);
+#else
+    size_t i = 0;
+#if defined(MATRIX_BACKEND_AVX)
+    for (; i < len - len % 8; i += 8) {
+        _mm256_storeu_ps(c + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+#endif
+#if defined(MATRIX_BACKEND_SSE)
+    for (; i < len - len % 4; i += 4) {
+        _mm_storeu_ps(c + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+#elif defined(MATRIX_BACKEND_NEON)
+    for (; i < len - len % 4; i += 4) {
+        vst1q_f32(c + i, vaddq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+    }
+#endif
+    for (; i < len; i++) {
+        c[i] = a[i] + b[i];
+    }
+#endif
+}
+
+// c = a - b, element-wise over len floats
+inline void sub_f32(const float* a, const float* b, float* c, size_t len) {
+#if defined(MATRIX_BACKEND_ESP_DSP)
+    dsps_sub_f32(a, b, c, len, 1, 1, 1);
+#else
+    size_t i = 0;
+#if defined(MATRIX_BACKEND_AVX)
+    for (; i < len - len % 8; i += 8) {
+        _mm256_storeu_ps(c + i, _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+#endif
+#if defined(MATRIX_BACKEND_SSE)
+    for (; i < len - len % 4; i += 4) {
+        _mm_storeu_ps(c + i, _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+#elif defined(MATRIX_BACKEND_NEON)
+    for (; i < len - len % 4; i += 4) {
+        vst1q_f32(c + i, vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+    }
+#endif
+    for (; i < len; i++) {
+        c[i] = a[i] - b[i];
+    }
+#endif
+}
+
+} // namespace MatrixKernels
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "vector.h"
+#include "fast_math.h"
 #include "../globals.h" // RAD2DEG and DEG2RAD
 #include <math.h>
 template <typename T> // float or double
@@ -8,7 +9,7 @@ using Quaternion = Vector<T, 4>;
 
 //////////////////////  Vec as Quat //////////////////////
 template <typename T>
-Quaternion<T> vec_as_quat(const Vector3<T>& vec) {
+constexpr Quaternion<T> vec_as_quat(const Vector3<T>& vec) {
     Quaternion<T> result{};
     result[1][0] = vec[0][0];
     result[2][0] = vec[1][0];
@@ -18,10 +19,10 @@ Quaternion<T> vec_as_quat(const Vector3<T>& vec) {
 
 // First element needs to be 0
 template <typename T>
-Vector3<T> quat_as_vec(const Quaternion<T>& quat) {
+constexpr Vector3<T> quat_as_vec(const Quaternion<T>& quat) {
 
     // First element needs to be 0
-    if (abs(quat[0][0]) > 0.001) {
+    if (MathTraits<T>::abs(quat[0][0]) > 0.001) {
         return Vector3<T>();
     }
 
@@ -36,18 +37,18 @@ Vector3<T> quat_as_vec(const Quaternion<T>& quat) {
 
 // Quat from axis rot in float or double
 template <typename T>
-Quaternion<T> quat_from_axis_rot(float angle_deg, const Vector3<float>& axis) {
-    if (abs(angle_deg) < 0.001) {
+constexpr Quaternion<T> quat_from_axis_rot(float angle_deg, const Vector3<float>& axis) {
+    if (ConstexprMath::const_abs(angle_deg) < 0.001) {
         // Zero angle, so return {1,0,0,0}
         return {1,0,0,0};
     }
     float angle_rad = angle_deg * DEG2RAD;
     Vector3<float> normalized_axis = unit(axis);
     Quaternion<T> result = {{
-        {std::cos(angle_rad/2)},
-        {std::sin(angle_rad/2) * normalized_axis[0][0]},
-        {std::sin(angle_rad/2) * normalized_axis[1][0]},
-        {std::sin(angle_rad/2) * normalized_axis[2][0]}
+        {ConstexprMath::const_cos(angle_rad/2)},
+        {ConstexprMath::const_sin(angle_rad/2) * normalized_axis[0][0]},
+        {ConstexprMath::const_sin(angle_rad/2) * normalized_axis[1][0]},
+        {ConstexprMath::const_sin(angle_rad/2) * normalized_axis[2][0]}
     }};
 
     return result;
@@ -58,19 +59,21 @@ bool axis_rot_from_quat(const Quaternion<T>& quat, float& angle_deg, Vector3<flo
     //TODO: bounds checking
     Quaternion<T> normalized_quat = unit(quat);
 
-    float angle_rad = 2* std::acos(normalized_quat[0][0]);
+    float w = static_cast<float>(normalized_quat[0][0]);
+    float angle_rad = 2 * HotMath::acos(w);
 
     // 0 degrees
     if (angle_rad < 0.001) {
-        memset(&axis, 0, size(axis));
+        memset(&axis, 0, sizeof(axis));
         angle_deg = 0;
         return true;
     }
 
-    // Else set everything else
-    axis[0][0] = normalized_quat[1][0] / std::sin(angle_rad/2);
-    axis[1][0] = normalized_quat[2][0] / std::sin(angle_rad/2);
-    axis[2][0] = normalized_quat[3][0] / std::sin(angle_rad/2);
+    // Else set everything else. sin(angle / 2) = sqrt(1 - w^2) for a unit quaternion
+    float inv_sin_half = HotMath::rsqrt(1 - w * w);
+    axis[0][0] = static_cast<float>(normalized_quat[1][0]) * inv_sin_half;
+    axis[1][0] = static_cast<float>(normalized_quat[2][0]) * inv_sin_half;
+    axis[2][0] = static_cast<float>(normalized_quat[3][0]) * inv_sin_half;
 
     angle_deg = angle_rad * RAD2DEG;
 
@@ -79,30 +82,27 @@ bool axis_rot_from_quat(const Quaternion<T>& quat, float& angle_deg, Vector3<flo
 
 //////////////////////  Rotation Matrix //////////////////////
 
-// R from quat
+// R from quat. Scaled by 2 / |q|^2 instead of normalising, so it takes any non-zero quaternion without a sqrt
 template <typename T>
-Matrix3<T> R_from_quat(const Quaternion<T>& quat) {
-    // 0 bounds checking
-    // Identity quaternion
+constexpr Matrix3<T> R_from_quat(const Quaternion<T>& quat) {
+    T w = quat[0][0];
+    T i = quat[1][0];
+    T j = quat[2][0];
+    T k = quat[3][0];
 
-    Quaternion<T> unit_quat = unit(quat);
+    T s = 2 / (w*w + i*i + j*j + k*k);
 
-    T w = unit_quat[0][0];
-    T i = unit_quat[1][0];
-    T j = unit_quat[2][0];
-    T k = unit_quat[3][0];
+    T R00 = 1 - s * (j*j + k*k);
+    T R01 = s * (i*j - k*w);
+    T R02 = s * (i*k + j*w);
 
-    T R00 = 1 - 2*(j*j + k*k);
-    T R01 = 2 * (i*j - k*w);
-    T R02 = 2 * (i*k + j*w);
+    T R10 = s * (i*j + k*w);
+    T R11 = 1 - s * (i*i + k*k);
+    T R12 = s * (j*k - i*w);
 
-    T R10 = 2 * (i*j + k*w);
-    T R11 = 1 - 2 * (i*i + k*k);
-    T R12 = 2 * (j*k - i*w);
-
-    T R20 = 2 * (i*k - j*w);
-    T R21 = 2 * (j*k + i*w);
-    T R22 = 1 - 2*(i*i + j*j);
+    T R20 = s * (i*k - j*w);
+    T R21 = s * (j*k + i*w);
+    T R22 = 1 - s * (i*i + j*j);
 
     return {{{R00, R01, R02},
             {R10, R11, R12},
@@ -111,11 +111,11 @@ Matrix3<T> R_from_quat(const Quaternion<T>& quat) {
 
 // Quat from R
 template <typename T>
-Quaternion<T> quat_from_R(const Matrix3<T>& R) {
+constexpr Quaternion<T> quat_from_R(const Matrix3<T>& R) {
     Matrix3<T> R_T = transpose(R);
 
-    Quaternion<T> q;
-    T t;
+    Quaternion<T> q{};
+    T t = 0;
     // Insomniac games formula, but taking transpose 
     // because they use scaler last convection
     if (R_T[2][2] < 0) {
@@ -140,7 +140,7 @@ Quaternion<T> quat_from_R(const Matrix3<T>& R) {
     }
     
     
-    T scale = 0.5 / sqrt(abs(t));
+    T scale = 0.5 / MathTraits<T>::sqrt(MathTraits<T>::abs(t));
     for (auto& val : q) {
         val[0] *= scale;
     }
@@ -158,7 +158,7 @@ Quaternion<T> quat_from_R(const Matrix3<T>& R) {
 ////////////////////// Quat Operations //////////////////////
 // Multiply
 template <typename T>
-Quaternion<T> quat_mult(const Quaternion<T> quat1, const Quaternion<T> quat2) {
+constexpr Quaternion<T> quat_mult(const Quaternion<T> quat1, const Quaternion<T> quat2) {
     T w1 = quat1[0][0];
     T x1 = quat1[1][0];
     T y1 = quat1[2][0];
@@ -169,7 +169,7 @@ Quaternion<T> quat_mult(const Quaternion<T> quat1, const Quaternion<T> quat2) {
     T y2 = quat2[2][0];
     T z2 = quat2[3][0];
 
-    Quaternion<T> result;
+    Quaternion<T> result{};
 
     result[0][0] = w1*w2 - x1*x2 - y1*y2 - z1*z2;
     result[1][0] = w1*x2 + x1*w2 + y1*z2 - z1*y2;
@@ -181,7 +181,7 @@ Quaternion<T> quat_mult(const Quaternion<T> quat1, const Quaternion<T> quat2) {
 
 // Inverse flips i, j, k
 template <typename T>
-Quaternion<T> inv(const Quaternion<T>& quat) {
+constexpr Quaternion<T> inv(const Quaternion<T>& quat) {
     Quaternion<T> result = quat;
     result[1][0] *= -1;
     result[2][0] *= -1;
@@ -190,20 +190,125 @@ Quaternion<T> inv(const Quaternion<T>& quat) {
     return result;
 }
 
+// Normalise, exactly
+template <typename T>
+constexpr Quaternion<T> quat_normalize(const Quaternion<T>& quat) {
+    T norm_sq = quat[0][0]*quat[0][0] + quat[1][0]*quat[1][0] + quat[2][0]*quat[2][0] + quat[3][0]*quat[3][0];
+    T scale = 1 / MathTraits<T>::sqrt(norm_sq);
+
+    Quaternion<T> result{};
+    for (size_t i = 0; i < 4; i++) {
+        result[i][0] = quat[i][0] * scale;
+    }
+    return result;
+}
+
+// Pulls a nearly unit quaternion back to unit length with one Newton step of 1/sqrt around 1.
+// No sqrt or divide, and the error squares each call, so it suits renormalising after every integration step.
+// Written as 1 + (1 - |q|^2) / 2 so nothing leaves [-2, 2], which Fixed<1, 30> quaternions need
+template <typename T>
+constexpr Quaternion<T> quat_normalize_fast(const Quaternion<T>& quat) {
+    T norm_sq = quat[0][0]*quat[0][0] + quat[1][0]*quat[1][0] + quat[2][0]*quat[2][0] + quat[3][0]*quat[3][0];
+    T scale = 1 + (1 - norm_sq) / 2;
+
+    Quaternion<T> result{};
+    for (size_t i = 0; i < 4; i++) {
+        result[i][0] = quat[i][0] * scale;
+    }
+    return result;
+}
+
+// Integrates body angular rate w_rps over dt_s, q_next = q * dq. Exact for a constant rate over the step
+template <typename T>
+constexpr Quaternion<T> quat_integrate(const Quaternion<T>& quat, const Vector3<T>& w_rps, T dt_s) {
+    T wx = w_rps[0][0];
+    T wy = w_rps[1][0];
+    T wz = w_rps[2][0];
+
+    T half_angle = MathTraits<T>::sqrt(wx*wx + wy*wy + wz*wz) * dt_s / 2;
+
+    // sin(x) / x, with its series below where dividing would lose everything
+    T sinc = 1;
+    if (half_angle < (T)1e-4) {
+        sinc = 1 - half_angle * half_angle / 6;
+    } else {
+        sinc = MathTraits<T>::sin(half_angle) / half_angle;
+    }
+    T vec_scale = sinc * dt_s / 2;
+
+    Quaternion<T> delta = {{
+        {MathTraits<T>::cos(half_angle)},
+        {wx * vec_scale},
+        {wy * vec_scale},
+        {wz * vec_scale}
+    }};
+
+    return quat_normalize_fast(quat_mult(quat, delta));
+}
+
 ////////////////////// Operations //////////////////////
 
-// Apply to vector
+// Rotate by a unit quaternion. v' = v + w t + u x t with t = 2 u x v, 15 multiplies
+// instead of the 32 in q * v * inv(q)
 template <typename T>
-Vector3<T> quat_apply(const Quaternion<T>& quat, const Vector3<T>& vec) {
-    Quaternion<T> intermediate = quat_mult(quat, vec_as_quat(vec));
-    Quaternion<T> result = quat_mult(intermediate, inv(quat));
-
-    if (abs(result[0][0]) > 0.001) {
-        // Quaternion was not normalized
-        // raise(bruh)
-        // return quat_apply(unit(quat), vec);
-        return Vector3<T>();
+constexpr Vector3<T> quat_rotate(const Quaternion<T>& quat, const Vector3<T>& vec) {
+    T w = quat[0][0];
+    T ux = quat[1][0];
+    T uy = quat[2][0];
+    T uz = quat[3][0];
+
+    T vx = vec[0][0];
+    T vy = vec[1][0];
+    T vz = vec[2][0];
+
+    T tx = 2 * (uy*vz - uz*vy);
+    T ty = 2 * (uz*vx - ux*vz);
+    T tz = 2 * (ux*vy - uy*vx);
+
+    return {{
+        {vx + w*tx + (uy*tz - uz*ty)},
+        {vy + w*ty + (uz*tx - ux*tz)},
+        {vz + w*tz + (ux*ty - uy*tx)}
+    }};
+}
+
+// Apply to vector. quat must be unit, see quat_normalize()
+template <typename T>
+constexpr Vector3<T> quat_apply(const Quaternion<T>& quat, const Vector3<T>& vec) {
+    return quat_rotate(quat, vec);
+}
+
+// Rotates count vectors in place, held as separate x, y and z arrays. With one quaternion for the whole
+// batch, it's cheaper as R: 9 multiplies per vector, and the loop vectorises
+template <typename T>
+void quat_rotate_batch(const Quaternion<T>& quat, T* x, T* y, T* z, size_t count) {
+    Matrix3<T> R = R_from_quat(quat);
+    for (size_t n = 0; n < count; n++) {
+        T vx = x[n];
+        T vy = y[n];
+        T vz = z[n];
+        x[n] = R[0][0]*vx + R[0][1]*vy + R[0][2]*vz;
+        y[n] = R[1][0]*vx + R[1][1]*vy + R[1][2]*vz;
+        z[n] = R[2][0]*vx + R[2][1]*vy + R[2][2]*vz;
     }
+}
 
-    return quat_as_vec(result);
-}
\ No newline at end of file
+// Same, for the xyz field field_offset bytes into each of count records, each stride bytes after the last.
+// Copied in and out, so the records may be packed. For one field of a FIFO block:
+// quat_rotate_batch(quat, (uint8_t*)samples, offsetof(ImuFifoSample, accel_mps2), sizeof(ImuFifoSample), count)
+template <typename T>
+void quat_rotate_batch(const Quaternion<T>& quat, uint8_t* base, size_t field_offset, size_t stride, size_t count) {
+    Matrix3<T> R = R_from_quat(quat);
+    uint8_t* field = base + field_offset;
+    for (size_t n = 0; n < count; n++, field += stride) {
+        T vec[3];
+        memcpy(vec, field, sizeof(vec));
+        T vx = vec[0];
+        T vy = vec[1];
+        T vz = vec[2];
+        vec[0] = R[0][0]*vx + R[0][1]*vy + R[0][2]*vz;
+        vec[1] = R[1][0]*vx + R[1][1]*vy + R[1][2]*vz;
+        vec[2] = R[2][0]*vx + R[2][1]*vy + R[2][2]*vz;
+        memcpy(field, vec, sizeof(vec));
+    }
+}
@@ -13,7 +13,7 @@ using Vector3 = Vector<T, 3>;
 
 // Function to dot product a vector TODO: fix this this is so damn wrong
 template <typename T, size_t rows>
-T dot(const Vector<T, rows>& vec1, const Vector<T, rows>& vec2) {
+constexpr T dot(const Vector<T, rows>& vec1, const Vector<T, rows>& vec2) {
     T sum = 0;
     for (size_t i = 0; i < rows; i++) {
         sum += vec1[i][0] * vec2[i][0];
@@ -21,30 +21,28 @@ T dot(const Vector<T, rows>& vec1, const Vector<T, rows>& vec2) {
     return sum;
 }
 
-// Function to cross product a vector
+// Function to cross product a vector, written out instead of multiplying by the skew matrix of vec1
 template <typename T>
-Vector3<T> cross(const Vector3<T>& vec1, const Vector3<T>& vec2) {
-    Matrix<T, 3, 3> decomposed_vec1 = {{
-        {0, -vec1[2][0], vec1[1][0]},
-        {vec1[2][0], 0, -vec1[0][0]},
-        {-vec1[1][0], vec1[0][0], 0},
+constexpr Vector3<T> cross(const Vector3<T>& vec1, const Vector3<T>& vec2) {
+    return {{
+        {vec1[1][0] * vec2[2][0] - vec1[2][0] * vec2[1][0]},
+        {vec1[2][0] * vec2[0][0] - vec1[0][0] * vec2[2][0]},
+        {vec1[0][0] * vec2[1][0] - vec1[1][0] * vec2[0][0]},
     }};
-
-    return decomposed_vec1 * vec2;
 }
 
 // Norm (TODO: test)
 template <typename T, size_t N>
-T norm(const Vector<T, N>& vec) {
+constexpr T norm(const Vector<T, N>& vec) {
     T dot_product = dot(vec, vec);
 
-    return sqrt(dot_product); 
+    return MathTraits<T>::sqrt(dot_product);
 }
 
 // TODO: unit
 // Function to unit-ize a vector
 template <typename T, size_t N>
-Vector<T, N> unit(const Vector<T, N>& vec1) {
+constexpr Vector<T, N> unit(const Vector<T, N>& vec1) {
     T length = norm(vec1);
     Vector<T, N> result = vec1;
     
@@ -1,5 +1,6 @@
 #include "filesystem.h"
 #include "../globals.h"
+#include "trace.h"
 #include <esp_littlefs.h>
 
 using namespace std;
@@ -29,6 +30,7 @@ bool FileSystem::end()
 
 vector<String> FileSystem::listDir(const char *dirname)
 {
+    TRACE_SCOPE("FileSystem::listDir");
     vector<String> files;
     DEBUG("Listing directory: ");
     DEBUGLN(dirname);
@@ -175,6 +177,7 @@ bool FileSystem::rmdir(const char *dirname, bool recursive)
 
 bool FileSystem::readFile(const char *path, String& result)
 {
+    TRACE_SCOPE("FileSystem::readFile");
     DEBUG("Reading file: ");
     DEBUGLN(path);
 
@@ -196,6 +199,7 @@ bool FileSystem::readFile(const char *path, String& result)
 
 bool FileSystem::readFile(const char *path, Stream& stream)
 {
+    TRACE_SCOPE("FileSystem::readFile");
     DEBUG("Reading file: ");
     DEBUGLN(path);
 
@@ -217,6 +221,7 @@ bool FileSystem::readFile(const char *path, Stream& stream)
 
 bool FileSystem::writeFile(const char *path, const char *message)
 {
+    TRACE_SCOPE("FileSystem::writeFile");
     DEBUG("Writing to file: ");
     DEBUGLN(path);
 
@@ -241,6 +246,7 @@ bool FileSystem::writeFile(const char *path, const char *message)
 
 bool FileSystem::writeFile(const char *path, const uint8_t *buffer, size_t len)
 {
+    TRACE_SCOPE("FileSystem::writeFile");
     DEBUG("Writing to file: ");
     DEBUGLN(path);
 
@@ -265,6 +271,7 @@ bool FileSystem::writeFile(const char *path, const uint8_t *buffer, size_t len)
 
 bool FileSystem::appendFile(const char *path, const char *message)
 {
+    TRACE_SCOPE("FileSystem::appendFile");
     DEBUG("Appending to file: ");
     DEBUGLN(path);
 
@@ -289,6 +296,7 @@ bool FileSystem::appendFile(const char *path, const char *message)
 
 bool FileSystem::appendFile(const char *path, const uint8_t *buffer, size_t len)
 {
+    TRACE_SCOPE("FileSystem::appendFile");
     DEBUG("Appending to file: ");
     DEBUGLN(path);
 
@@ -313,6 +321,7 @@ bool FileSystem::appendFile(const char *path, const uint8_t *buffer, size_t len)
 
 bool FileSystem::renameFile(const char *from_path, const char *to_path)
 {
+    TRACE_SCOPE("FileSystem::renameFile");
     DEBUG("Renaming file: ");
     DEBUGLN(from_path);
 
@@ -327,6 +336,7 @@ bool FileSystem::renameFile(const char *from_path, const char *to_path)
 
 bool FileSystem::deleteFile(const char *path)
 {
+    TRACE_SCOPE("FileSystem::deleteFile");
     DEBUG("Deleting file: ");
     DEBUGLN(path);
 
@@ -41,8 +41,8 @@ public:
 
 private:
     const char* partition_label = "spiffs";
-    void fileTreeHelper(File root, uint8_t tabs = 0);
-    File current_file;
+    void fileTreeHelper(fs::File root, uint8_t tabs = 0);
+    fs::File current_file;
 };
 
 }
@@ -0,0 +1,197 @@
+#include "instrumentation.h"
+#include "pipeline.h"
+#include "../comms/packet.h"
+
+using namespace std;
+
+namespace Cesium {
+
+ProbeStats Instrumentation::probes[2][MAX_PROBES] = {};
+const char* Instrumentation::probe_names[MAX_PROBES] = {nullptr};
+size_t Instrumentation::probe_count = 0;
+
+TaskHandle_t Instrumentation::tasks[MAX_TASKS] = {nullptr};
+size_t Instrumentation::task_count = 0;
+
+portMUX_TYPE Instrumentation::register_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void append_string(vector<uint8_t>& buffer, const char* str)
+{
+    uint8_t len = strnlen(str, 255);
+    buffer.push_back(len);
+    buffer.insert(buffer.end(), str, str + len);
+}
+
+////////////////////////////////////////////////////////////
+//                     Registration                       //
+////////////////////////////////////////////////////////////
+
+uint8_t Instrumentation::register_probe(const char *name)
+{
+    uint8_t id = INVALID_PROBE;
+
+    portENTER_CRITICAL(&register_mux);
+    for (size_t i = 0; i < probe_count; i++) {
+        if (strcmp(probe_names[i], name) == 0) {
+            id = i;
+            break;
+        }
+    }
+
+    if (id == INVALID_PROBE && probe_count < MAX_PROBES) {
+        probe_names[probe_count] = name;
+        id = probe_count;
+        probe_count++;
+    }
+    portEXIT_CRITICAL(&register_mux);
+
+    return id;
+}
+
+bool Instrumentation::register_task(TaskHandle_t task)
+{
+    if (task == nullptr || task_count >= MAX_TASKS) {
+        return false;
+    }
+
+    tasks[task_count] = task;
+    task_count++;
+    return true;
+}
+
+////////////////////////////////////////////////////////////
+//                        Stats                           //
+////////////////////////////////////////////////////////////
+
+ProbeStats Instrumentation::get_probe_stats(uint8_t probe_id)
+{
+    ProbeStats merged{};
+
+    if (probe_id >= probe_count) {
+        return merged;
+    }
+
+    for (size_t core = 0; core < 2; core++) {
+        const ProbeStats& stats = probes[core][probe_id];
+        if (stats.count == 0) {
+            continue;
+        }
+
+        if (merged.count == 0 || stats.min_cycles < merged.min_cycles) {
+            merged.min_cycles = stats.min_cycles;
+        }
+        if (stats.max_cycles > merged.max_cycles) {
+            merged.max_cycles = stats.max_cycles;
+        }
+
+        merged.count += stats.count;
+        merged.total_cycles += stats.total_cycles;
+
+        for (size_t i = 0; i < ProbeStats::BUCKETS; i++) {
+            merged.histogram[i] += stats.histogram[i];
+        }
+    }
+
+    return merged;
+}
+
+const char *Instrumentation::get_probe_name(uint8_t probe_id)
+{
+    if (probe_id >= probe_count) {
+        return "";
+    }
+    return probe_names[probe_id];
+}
+
+void Instrumentation::reset()
+{
+    // Names and ids stay registered, only the counters are cleared
+    // Minimum free heap can't be reset, it is always reported as the minimum since boot
+    memset(probes, 0, sizeof(probes));
+
+    if (Pipeline::is_running()) {
+        Pipeline::reset_stats();
+    }
+}
+
+////////////////////////////////////////////////////////////
+//                      Records                           //
+////////////////////////////////////////////////////////////
+
+/*
+SYSTEM record (little-endian)
+- u8  record type (0)
+- u32 uptime_ms
+- u32 cpu_freq_mhz
+- u32 heap_free_bytes
+- u32 heap_min_free_bytes
+- u32 heap_size_bytes
+- f32 core_load[2]
+- u8  probe count
+- u8  task count, then per task: u8 name length, name, u32 stack high-water mark (bytes)
+*/
+vector<uint8_t> Instrumentation::system_record()
+{
+    vector<uint8_t> data;
+    data.reserve(64 + task_count * 24);
+
+    data.push_back((uint8_t)StatsRecord::SYSTEM);
+    append_bytes(data, (uint32_t)millis());
+    append_bytes(data, (uint32_t)ESP.getCpuFreqMHz());
+    append_bytes(data, (uint32_t)ESP.getFreeHeap());
+    append_bytes(data, (uint32_t)ESP.getMinFreeHeap());
+    append_bytes(data, (uint32_t)ESP.getHeapSize());
+
+    PipelineStats pipeline_stats{};
+    if (Pipeline::is_running()) {
+        pipeline_stats = Pipeline::get_stats();
+    }
+    append_bytes(data, pipeline_stats.core_load[0]);
+    append_bytes(data, pipeline_stats.core_load[1]);
+
+    data.push_back((uint8_t)probe_count);
+
+    data.push_back((uint8_t)task_count);
+    for (size_t i = 0; i < task_count; i++) {
+        append_string(data, pcTaskGetName(tasks[i]));
+        append_bytes(data, (uint32_t)uxTaskGetStackHighWaterMark(tasks[i]));
+    }
+
+    return data;
+}
+
+/*
+PROBE record (little-endian)
+- u8  record type (1)
+- u8  probe id
+- u8  name length, name
+- u32 count
+- u32 min_cycles
+- u32 mean_cycles
+- u32 max_cycles
+- u8  bucket count, then u32 per bucket (bucket i = [2^i, 2^(i+1)) cycles)
+*/
+vector<uint8_t> Instrumentation::probe_record(uint8_t probe_id)
+{
+    ProbeStats stats = get_probe_stats(probe_id);
+
+    vector<uint8_t> data;
+    data.reserve(32 + ProbeStats::BUCKETS * sizeof(uint32_t));
+
+    data.push_back((uint8_t)StatsRecord::PROBE);
+    data.push_back(probe_id);
+    append_string(data, get_probe_name(probe_id));
+    append_bytes(data, stats.count);
+    append_bytes(data, stats.min_cycles);
+    append_bytes(data, stats.mean_cycles());
+    append_bytes(data, stats.max_cycles);
+
+    data.push_back((uint8_t)ProbeStats::BUCKETS);
+    for (size_t i = 0; i < ProbeStats::BUCKETS; i++) {
+        append_bytes(data, stats.histogram[i]);
+    }
+
+    return data;
+}
+
+} // namespace Cesium
@@ -0,0 +1,115 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Execution-time probes (CPU cycle counter) and MCU health stats for SystemStatusCMD::MCU_STATS
+
+#include <Arduino.h>
+#include <vector>
+
+#include "../globals.h"
+
+// Probes only exist when built with -D ENABLE_INSTRUMENTATION (debug and test envs).
+// Heap, stack and CPU load stats are always available since they cost nothing until requested.
+//
+// Usage, at the top of the function to time:
+//     PROBE_SCOPE("Bmi323::read");
+#ifdef ENABLE_INSTRUMENTATION
+#define PROBE_CONCAT_(a, b) a##b
+#define PROBE_CONCAT(a, b) PROBE_CONCAT_(a, b)
+#define PROBE_SCOPE(name) \
+    static const uint8_t PROBE_CONCAT(_probe_id_, __LINE__) = Cesium::Instrumentation::register_probe(name); \
+    Cesium::ProbeScope PROBE_CONCAT(_probe_scope_, __LINE__)(PROBE_CONCAT(_probe_id_, __LINE__))
+#else
+#define PROBE_SCOPE(name)
+#endif
+
+namespace Cesium {
+
+struct ProbeStats {
+    static constexpr size_t BUCKETS = 24; // Bucket i holds [2^i, 2^(i+1)) cycles, last bucket holds everything above
+
+    uint32_t count;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint32_t histogram[BUCKETS];
+
+    inline uint32_t mean_cycles() const {return count == 0 ? 0 : total_cycles / count;}
+};
+
+enum class StatsRecord {
+    SYSTEM = 0,
+    PROBE = 1,
+    SPI_BUS = 2,
+    SENSORS = 3
+};
+
+class Instrumentation {
+
+public:
+    static constexpr size_t MAX_PROBES = 32;
+    static constexpr size_t MAX_TASKS = 12;
+    static constexpr uint8_t INVALID_PROBE = 0xFF;
+
+    // Returns the existing id if the name was already registered
+    static uint8_t register_probe(const char* name);
+
+    // Called by ProbeScope, but can be used directly for code that doesn't fit a scope
+    static inline void record(uint8_t probe_id, uint32_t cycles) {
+        if (probe_id >= MAX_PROBES) {
+            return;
+        }
+
+        // Each core has its own copy so the two cores never write the same counters
+        ProbeStats& stats = probes[xPortGetCoreID()][probe_id];
+
+        stats.count++;
+        stats.total_cycles += cycles;
+        if (stats.count == 1 || cycles < stats.min_cycles) stats.min_cycles = cycles;
+        if (cycles > stats.max_cycles) stats.max_cycles = cycles;
+
+        size_t bucket = 31 - __builtin_clz(cycles | 1);
+        if (bucket >= ProbeStats::BUCKETS) bucket = ProbeStats::BUCKETS - 1;
+        stats.histogram[bucket]++;
+    }
+
+    // Tasks whose stack high-water mark should be reported
+    static bool register_task(TaskHandle_t task);
+
+    // Both cores merged
+    static ProbeStats get_probe_stats(uint8_t probe_id);
+    static const char* get_probe_name(uint8_t probe_id);
+    static inline size_t get_probe_count() {return probe_count;}
+
+    static void reset();
+
+    // Packet payloads: one SYSTEM record, then one PROBE record per probe
+    static std::vector<uint8_t> system_record();
+    static std::vector<uint8_t> probe_record(uint8_t probe_id);
+
+private:
+    static ProbeStats probes[2][MAX_PROBES];
+    static const char* probe_names[MAX_PROBES];
+    static size_t probe_count;
+
+    static TaskHandle_t tasks[MAX_TASKS];
+    static size_t task_count;
+
+    static portMUX_TYPE register_mux;
+};
+
+// Times from construction to destruction
+class ProbeScope {
+private:
+    uint8_t probe_id;
+    uint32_t start_cycles;
+
+public:
+    inline explicit ProbeScope(uint8_t id) : probe_id{id}, start_cycles{ESP.getCycleCount()} {}
+    inline ~ProbeScope() {Instrumentation::record(probe_id, ESP.getCycleCount() - start_cycles);}
+
+    DELETE_COPY_AND_ASSIGNMENT(ProbeScope)
+};
+
+} // namespace Cesium
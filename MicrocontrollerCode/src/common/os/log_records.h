@@ -0,0 +1,28 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Fixed-size records the pipeline logs, shared with the replay drivers that read them back
+
+#include <Arduino.h>
+
+namespace Cesium {
+
+// Written as-is to the log file, so keep these packed and fixed-size
+struct __attribute__((packed)) ImuSample {
+    uint64_t time_us;
+    uint8_t imu_id;
+    float accel_mps2[3];
+    float w_rps[3];
+    float temp_C;
+};
+
+struct __attribute__((packed)) BaroSample {
+    uint64_t time_us;
+    uint8_t baro_id;
+    float pressure_kPa;
+    float altitude_m;
+    float temp_C;
+};
+
+} // namespace Cesium
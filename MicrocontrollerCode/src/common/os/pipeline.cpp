@@ -0,0 +1,528 @@
+#include "pipeline.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "spi_bus.h"
+#include "sensor_manager.h"
+#include "../comms/serial_comms.h"
+#include <esp_timer.h>
+
+namespace Cesium {
+
+Sensor::AccelerometerBase* Pipeline::accels[MAX_IMUS] = {nullptr};
+Sensor::GyroscopeBase* Pipeline::gyros[MAX_IMUS] = {nullptr};
+int Pipeline::drdy_pins[MAX_IMUS] = {-1, -1, -1, -1};
+bool Pipeline::fused_imus[MAX_IMUS] = {false};
+size_t Pipeline::imu_count = 0;
+
+Sensor::BarometerBase* Pipeline::baros[MAX_BAROS] = {nullptr};
+size_t Pipeline::baro_count = 0;
+
+Sensor::GpsBase* Pipeline::gpses[MAX_GPSES] = {nullptr};
+size_t Pipeline::gps_count = 0;
+
+SpscQueue<ImuSample, Pipeline::IMU_QUEUE_LENGTH> Pipeline::imu_queue;
+SpscQueue<BaroSample, Pipeline::BARO_QUEUE_LENGTH> Pipeline::baro_queue;
+
+SeqLock<ImuSample> Pipeline::latest_imu_slots[MAX_IMUS];
+uint64_t Pipeline::published_time_us[MAX_IMUS] = {0};
+SeqLock<BaroSample> Pipeline::latest_baro_slots[MAX_BAROS];
+
+FileSystem* Pipeline::filesystem_ptr = nullptr;
+const char* Pipeline::imu_log_path = "/log_imu.bin";
+const char* Pipeline::baro_log_path = "/log_baro.bin";
+
+void (*Pipeline::telemetry_callback)() = nullptr;
+uint32_t Pipeline::telemetry_interval_ms = 100;
+void (*Pipeline::acquisition_callback)() = nullptr;
+uint32_t Pipeline::acquisition_interval_ms = 20;
+
+TaskHandle_t Pipeline::fast_acquisition_handle = nullptr;
+TaskHandle_t Pipeline::slow_acquisition_handle = nullptr;
+TaskHandle_t Pipeline::comms_handle = nullptr;
+TaskHandle_t Pipeline::logging_handle = nullptr;
+TaskHandle_t Pipeline::telemetry_handle = nullptr;
+esp_timer_handle_t Pipeline::acquisition_timer = nullptr;
+
+uint32_t Pipeline::acquisition_period_us = 1250;
+volatile uint32_t Pipeline::last_tick_us = 0;
+volatile uint32_t Pipeline::tick_count = 0;
+bool Pipeline::running = false;
+
+portMUX_TYPE Pipeline::stats_mux = portMUX_INITIALIZER_UNLOCKED;
+uint64_t Pipeline::busy_us[2] = {0, 0};
+int64_t Pipeline::stats_start_us = 0;
+volatile uint32_t Pipeline::acquisition_cycles = 0;
+volatile uint32_t Pipeline::max_jitter_us = 0;
+volatile uint32_t Pipeline::missed_ticks = 0;
+volatile uint32_t Pipeline::drdy_reads = 0;
+
+// Task parameters
+static constexpr uint32_t FAST_ACQUISITION_STACK = 4096;
+static constexpr uint32_t SLOW_ACQUISITION_STACK = 4096;
+static constexpr uint32_t COMMS_STACK = 8192;
+static constexpr uint32_t LOGGING_STACK = 4096;
+static constexpr uint32_t TELEMETRY_STACK = 4096;
+
+// esp_timer's own task runs at 22, so fast acquisition sits just below it
+static constexpr UBaseType_t FAST_ACQUISITION_PRIORITY = 20;
+static constexpr UBaseType_t SLOW_ACQUISITION_PRIORITY = 10;
+static constexpr UBaseType_t COMMS_PRIORITY = 5;
+static constexpr UBaseType_t TELEMETRY_PRIORITY = 4;
+static constexpr UBaseType_t LOGGING_PRIORITY = 3;
+
+static constexpr size_t LOG_BATCH = 32;
+static constexpr uint32_t LOGGING_INTERVAL_MS = 20;
+
+////////////////////////////////////////////////////////////
+//                     Registration                       //
+////////////////////////////////////////////////////////////
+
+bool Pipeline::add_imu(Sensor::AccelerometerBase *accel, Sensor::GyroscopeBase *gyro, int drdy_pin)
+{
+    if (running || imu_count >= MAX_IMUS || accel == nullptr || gyro == nullptr) {
+        DEBUGLN("Could not add IMU to pipeline");
+        return false;
+    }
+
+    accels[imu_count] = accel;
+    gyros[imu_count] = gyro;
+    drdy_pins[imu_count] = drdy_pin;
+    imu_count++;
+
+    return true;
+}
+
+bool Pipeline::add_fused_imu(Sensor::FusedImu *fused)
+{
+    RETURN_FALSE_IF_FALSE(add_imu(fused, fused));
+    fused_imus[imu_count - 1] = true;
+
+    return true;
+}
+
+bool Pipeline::add_barometer(Sensor::BarometerBase *baro, uint32_t interval_ms)
+{
+    if (running || baro_count >= MAX_BAROS || baro == nullptr) {
+        DEBUGLN("Could not add barometer to pipeline");
+        return false;
+    }
+
+    uint8_t sensor_id = SensorManager::add_sensor(baro, interval_ms, 0, SensorManager::ReadMode::POLLED,
+                                                  publish_baro, (void*)baro_count);
+    RETURN_FALSE_IF_FALSE(sensor_id != SensorManager::INVALID_SENSOR);
+
+    baros[baro_count] = baro;
+    baro_count++;
+
+    return true;
+}
+
+bool Pipeline::add_gps(Sensor::GpsBase *gps)
+{
+    if (running || gps_count >= MAX_GPSES || gps == nullptr) {
+        DEBUGLN("Could not add GPS to pipeline");
+        return false;
+    }
+
+    // The interval is the fastest nav rate, the driver parses whatever has arrived on every poll
+    uint8_t sensor_id = SensorManager::add_sensor(gps, 40, 1, SensorManager::ReadMode::POLLED);
+    RETURN_FALSE_IF_FALSE(sensor_id != SensorManager::INVALID_SENSOR);
+
+    gpses[gps_count] = gps;
+    gps_count++;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////
+//                        Start                           //
+////////////////////////////////////////////////////////////
+
+bool Pipeline::begin(uint32_t acquisition_rate_hz)
+{
+    if (running || acquisition_rate_hz == 0) {
+        return false;
+    }
+
+    acquisition_period_us = 1000000UL / acquisition_rate_hz;
+
+    // Acquisition core
+    RETURN_FALSE_IF_FALSE(xTaskCreatePinnedToCore(fast_acquisition_task, "acq_fast", FAST_ACQUISITION_STACK, nullptr,
+                                                  FAST_ACQUISITION_PRIORITY, &fast_acquisition_handle, ACQUISITION_CORE) == pdPASS);
+    RETURN_FALSE_IF_FALSE(xTaskCreatePinnedToCore(slow_acquisition_task, "acq_slow", SLOW_ACQUISITION_STACK, nullptr,
+                                                  SLOW_ACQUISITION_PRIORITY, &slow_acquisition_handle, ACQUISITION_CORE) == pdPASS);
+
+    // Comms core
+    RETURN_FALSE_IF_FALSE(xTaskCreatePinnedToCore(comms_task, "comms", COMMS_STACK, nullptr,
+                                                  COMMS_PRIORITY, &comms_handle, COMMS_CORE) == pdPASS);
+    RETURN_FALSE_IF_FALSE(xTaskCreatePinnedToCore(logging_task, "logging", LOGGING_STACK, nullptr,
+                                                  LOGGING_PRIORITY, &logging_handle, COMMS_CORE) == pdPASS);
+    RETURN_FALSE_IF_FALSE(xTaskCreatePinnedToCore(telemetry_task, "telemetry", TELEMETRY_STACK, nullptr,
+                                                  TELEMETRY_PRIORITY, &telemetry_handle, COMMS_CORE) == pdPASS);
+
+    // Reported in SystemStatusCMD::MCU_STATS
+    Instrumentation::register_task(fast_acquisition_handle);
+    Instrumentation::register_task(slow_acquisition_handle);
+    Instrumentation::register_task(comms_handle);
+    Instrumentation::register_task(logging_handle);
+    Instrumentation::register_task(telemetry_handle);
+
+    // DRDY edges notify fast acquisition directly, so it stays the only producer for imu_queue
+    for (size_t i = 0; i < imu_count; i++) {
+        if (drdy_pins[i] < 0) {
+            continue;
+        }
+
+        if (!accels[i]->enable_drdy_interrupt()) {
+            DEBUGLN("IMU has no data-ready interrupt, polling it instead");
+            drdy_pins[i] = -1;
+            continue;
+        }
+
+        accels[i]->set_drdy_notify(fast_acquisition_handle, 1UL << i);
+        accels[i]->attach_drdy_pin(drdy_pins[i]);
+    }
+
+    // Hardware-timed ticks instead of vTaskDelay, which only has 1 ms resolution
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = acquisition_timer_callback;
+    timer_args.arg = nullptr;
+    timer_args.dispatch_method = ESP_TIMER_TASK;
+    timer_args.name = "acq_tick";
+
+    RETURN_FALSE_IF_FALSE(esp_timer_create(&timer_args, &acquisition_timer) == ESP_OK);
+
+    reset_stats();
+    running = true;
+
+    RETURN_FALSE_IF_FALSE(esp_timer_start_periodic(acquisition_timer, acquisition_period_us) == ESP_OK);
+
+    return true;
+}
+
+void Pipeline::acquisition_timer_callback(void *arg)
+{
+    last_tick_us = (uint32_t)esp_timer_get_time();
+    tick_count++;
+    xTaskNotify(fast_acquisition_handle, TIMER_NOTIFY_BIT, eSetBits);
+}
+
+////////////////////////////////////////////////////////////
+//                  Acquisition core                      //
+////////////////////////////////////////////////////////////
+
+void Pipeline::fast_acquisition_task(void *arg)
+{
+    uint32_t handled_ticks = 0;
+
+    while (true) {
+        uint32_t notify_bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &notify_bits, portMAX_DELAY);
+        int64_t start_us = esp_timer_get_time();
+
+        // Data-ready IMUs, each already timestamped by its ISR
+        for (size_t i = 0; i < imu_count; i++) {
+            if (notify_bits & (1UL << i)) {
+                read_imu(i);
+                drdy_reads++;
+            }
+        }
+
+        if (!(notify_bits & TIMER_NOTIFY_BIT)) {
+            add_busy_time(start_us);
+            continue;
+        }
+
+        // Notification bits don't count, so the timer keeps its own tick count
+        uint32_t ticks = tick_count - handled_ticks;
+        handled_ticks += ticks;
+
+        if (ticks > 1) {
+            missed_ticks += ticks - 1;
+            TRACE_INSTANT("acquisition_missed_ticks", ticks - 1);
+        }
+
+        // Passes a period or more late are the worst case, so they count too. Negative means the next
+        // tick already fired after this pass started, and is left for the pass it belongs to
+        int32_t jitter_us = (int32_t)((uint32_t)start_us - last_tick_us);
+        if (jitter_us >= 0 && (uint32_t)jitter_us > max_jitter_us) {
+            max_jitter_us = jitter_us;
+        }
+
+        TRACE_BEGIN("acquisition_pass");
+
+        // IMUs on a SpiBus go out as one DMA batch, the rest are read while it runs
+        bool planned[MAX_IMUS] = {false};
+        bool completed[MAX_IMUS] = {false};
+        for (size_t i = 0; i < imu_count; i++) {
+            if (drdy_pins[i] < 0 && is_single_chip(i)) {
+                planned[i] = accels[i]->plan_read(&completed[i]);
+            }
+        }
+        SpiBus::submit_all();
+
+        for (size_t i = 0; i < imu_count; i++) {
+            if (drdy_pins[i] < 0 && !planned[i] && !fused_imus[i]) {
+                read_imu(i);
+            }
+        }
+
+        // A transfer that failed never decoded, so it's read again instead of republishing the last sample
+        SpiBus::collect_all();
+        for (size_t i = 0; i < imu_count; i++) {
+            if (planned[i] && completed[i]) {
+                publish_imu(i);
+            }
+            else if (planned[i]) {
+                read_imu(i);
+            }
+        }
+
+        // Every unit of a fused IMU is up to date by now
+        for (size_t i = 0; i < imu_count; i++) {
+            if (fused_imus[i] && accels[i]->read()) {
+                publish_imu(i);
+            }
+        }
+
+        TRACE_END("acquisition_pass");
+
+        acquisition_cycles++;
+        add_busy_time(start_us);
+    }
+}
+
+void Pipeline::read_imu(size_t imu_id)
+{
+    accels[imu_id]->read();
+
+    // Only read twice if the accel and gyro are separate chips
+    if (!is_single_chip(imu_id)) {
+        gyros[imu_id]->read();
+    }
+
+    publish_imu(imu_id);
+}
+
+void Pipeline::publish_imu(size_t imu_id)
+{
+    ImuSample sample;
+    Sensor::AccelerometerBase* accel_sensor = accels[imu_id];
+    Sensor::GyroscopeBase* gyro_sensor = gyros[imu_id];
+
+    // Drivers leave the sample time alone when no new data was ready, like an ICM20948 polled faster than its output rate
+    sample.time_us = accel_sensor->get_sample_time_us();
+    if (sample.time_us == published_time_us[imu_id]) {
+        return;
+    }
+    published_time_us[imu_id] = sample.time_us;
+
+    const Vector3<float>& accel = accel_sensor->get_accel_mps2();
+    const Vector3<float>& w = gyro_sensor->get_w_rps();
+
+    sample.imu_id = imu_id;
+    for (size_t j = 0; j < 3; j++) {
+        sample.accel_mps2[j] = accel[j][0];
+        sample.w_rps[j] = w[j][0];
+    }
+    sample.temp_C = accel_sensor->get_temp_C();
+
+    latest_imu_slots[imu_id].write(sample);
+    imu_queue.push(sample);
+}
+
+void Pipeline::slow_acquisition_task(void *arg)
+{
+    int64_t last_callback_us = 0;
+
+    while (true) {
+        int64_t start_us = esp_timer_get_time();
+
+        // Barometer state machines, GPS parsing and every other registered sensor that is due
+        SensorManager::run();
+
+        // FIFO drains and command requests, so no driver is ever touched from the comms core
+        if (acquisition_callback != nullptr && start_us - last_callback_us >= (int64_t)acquisition_interval_ms * 1000) {
+            last_callback_us = start_us;
+            acquisition_callback();
+        }
+
+        add_busy_time(start_us);
+        vTaskDelay(1);
+    }
+}
+
+void Pipeline::publish_baro(void *context)
+{
+    size_t baro_id = (size_t)context;
+    Sensor::BarometerBase* baro = baros[baro_id];
+
+    BaroSample sample;
+    sample.time_us = baro->get_sample_time_us();
+    sample.baro_id = baro_id;
+    sample.pressure_kPa = baro->get_pressure_kPa();
+    sample.altitude_m = baro->get_altitude_m();
+    sample.temp_C = baro->get_temp_C();
+
+    latest_baro_slots[baro_id].write(sample);
+    baro_queue.push(sample);
+}
+
+////////////////////////////////////////////////////////////
+//                     Comms core                         //
+////////////////////////////////////////////////////////////
+
+void Pipeline::comms_task(void *arg)
+{
+    while (true) {
+        if (Serial.available()) {
+            int64_t start_us = esp_timer_get_time();
+            SerialComms::process_uart();
+            add_busy_time(start_us);
+        }
+        else {
+            vTaskDelay(1);
+        }
+    }
+}
+
+void Pipeline::logging_task(void *arg)
+{
+    ImuSample imu_batch[LOG_BATCH];
+    BaroSample baro_batch[LOG_BATCH];
+
+    while (true) {
+        int64_t start_us = esp_timer_get_time();
+
+        // Drain everything that is queued, a batch at a time
+        size_t popped;
+        while ((popped = imu_queue.pop(imu_batch, LOG_BATCH)) > 0) {
+            drain_to_file(imu_log_path, (const uint8_t*)imu_batch, popped * sizeof(ImuSample));
+        }
+        while ((popped = baro_queue.pop(baro_batch, LOG_BATCH)) > 0) {
+            drain_to_file(baro_log_path, (const uint8_t*)baro_batch, popped * sizeof(BaroSample));
+        }
+
+        add_busy_time(start_us);
+        vTaskDelay(pdMS_TO_TICKS(LOGGING_INTERVAL_MS));
+    }
+}
+
+size_t Pipeline::drain_to_file(const char *path, const uint8_t *buffer, size_t len)
+{
+    // Without a filesystem the queue is still drained so acquisition never backs up
+    if (filesystem_ptr == nullptr || path == nullptr) {
+        return 0;
+    }
+
+    return filesystem_ptr->appendFile(path, buffer, len) ? len : 0;
+}
+
+void Pipeline::telemetry_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (true) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(telemetry_interval_ms));
+
+        if (telemetry_callback != nullptr) {
+            int64_t start_us = esp_timer_get_time();
+            telemetry_callback();
+            add_busy_time(start_us);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////
+//                      Readers                           //
+////////////////////////////////////////////////////////////
+
+bool Pipeline::latest_imu(size_t imu_id, ImuSample &sample)
+{
+    if (imu_id >= imu_count) {
+        return false;
+    }
+    return latest_imu_slots[imu_id].read(sample);
+}
+
+bool Pipeline::latest_baro(size_t baro_id, BaroSample &sample)
+{
+    if (baro_id >= baro_count) {
+        return false;
+    }
+    return latest_baro_slots[baro_id].read(sample);
+}
+
+int Pipeline::imu_id_of(const Sensor::SensorBase *sensor)
+{
+    for (size_t i = 0; i < imu_count; i++) {
+        if (static_cast<const Sensor::SensorBase*>(accels[i]) == sensor || static_cast<const Sensor::SensorBase*>(gyros[i]) == sensor) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+////////////////////////////////////////////////////////////
+//                        Stats                           //
+////////////////////////////////////////////////////////////
+
+void Pipeline::add_busy_time(int64_t start_us)
+{
+    uint64_t elapsed_us = esp_timer_get_time() - start_us;
+    BaseType_t core = xPortGetCoreID();
+
+    portENTER_CRITICAL(&stats_mux);
+    busy_us[core] += elapsed_us;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+PipelineStats Pipeline::get_stats()
+{
+    PipelineStats stats{};
+
+    portENTER_CRITICAL(&stats_mux);
+    uint64_t busy_0 = busy_us[0];
+    uint64_t busy_1 = busy_us[1];
+    int64_t window_us = esp_timer_get_time() - stats_start_us;
+    portEXIT_CRITICAL(&stats_mux);
+
+    if (window_us > 0) {
+        stats.core_load[0] = (float)busy_0 / window_us;
+        stats.core_load[1] = (float)busy_1 / window_us;
+    }
+
+    stats.acquisition_cycles = acquisition_cycles;
+    stats.max_jitter_us = max_jitter_us;
+    stats.missed_ticks = missed_ticks;
+    stats.drdy_reads = drdy_reads;
+
+    stats.imu_queue_size = imu_queue.size();
+    stats.imu_queue_high_water = imu_queue.get_high_water();
+    stats.imu_queue_dropped = imu_queue.get_dropped();
+
+    stats.baro_queue_size = baro_queue.size();
+    stats.baro_queue_high_water = baro_queue.get_high_water();
+    stats.baro_queue_dropped = baro_queue.get_dropped();
+
+    return stats;
+}
+
+void Pipeline::reset_stats()
+{
+    portENTER_CRITICAL(&stats_mux);
+    busy_us[0] = 0;
+    busy_us[1] = 0;
+    stats_start_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&stats_mux);
+
+    acquisition_cycles = 0;
+    max_jitter_us = 0;
+    missed_ticks = 0;
+    drdy_reads = 0;
+
+    imu_queue.reset_stats();
+    baro_queue.reset_stats();
+}
+
+} // namespace Cesium
@@ -0,0 +1,165 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Dual-core pipeline. Sensor acquisition runs on one core, comms/logging/telemetry on the other
+
+#include <Arduino.h>
+#include <vector>
+#include <esp_timer.h>
+
+#include "../globals.h"
+#include "spsc_queue.h"
+#include "filesystem.h"
+#include "log_records.h"
+
+#include "../drivers/sensor_bases/AccelerometerBase.h"
+#include "../drivers/sensor_bases/GyroscopeBase.h"
+#include "../drivers/sensor_bases/BarometerBase.h"
+#include "../drivers/sensor_bases/GpsBase.h"
+#include "../gnc/FusedImu.h"
+
+namespace Cesium {
+
+struct PipelineStats {
+    float core_load[2];             // Fraction of wall time spent in pipeline tasks per core
+    uint32_t acquisition_cycles;    // Number of fast acquisition passes
+    uint32_t max_jitter_us;         // Worst lateness of a fast acquisition pass vs. its timer tick
+    uint32_t missed_ticks;          // Timer ticks that arrived while the previous pass was still running
+    uint32_t drdy_reads;            // IMU reads triggered by a data-ready interrupt instead of the timer
+
+    size_t imu_queue_size;
+    size_t imu_queue_high_water;
+    uint32_t imu_queue_dropped;
+
+    size_t baro_queue_size;
+    size_t baro_queue_high_water;
+    uint32_t baro_queue_dropped;
+};
+
+class Pipeline {
+
+public:
+    static constexpr BaseType_t ACQUISITION_CORE = 1; // APP core, away from the WiFi/BT stack
+    static constexpr BaseType_t COMMS_CORE = 0;
+
+    static constexpr size_t MAX_IMUS = 4;
+    static constexpr size_t MAX_BAROS = 2;
+    static constexpr size_t MAX_GPSES = 1;
+
+    static constexpr size_t IMU_QUEUE_LENGTH = 512; // ~0.6 s at 800 Hz
+    static constexpr size_t BARO_QUEUE_LENGTH = 64;
+
+    // Adding sensors must happen before begin()
+    // With a DRDY pin the IMU is read on its own interrupt instead of the timer tick, timestamped at the edge
+    static bool add_imu(Sensor::AccelerometerBase* accel, Sensor::GyroscopeBase* gyro, int drdy_pin = -1);
+    // Takes the next IMU id. Fused at the end of every acquisition pass from what its units just read
+    static bool add_fused_imu(Sensor::FusedImu* fused);
+    // Barometers pace their own conversions at interval_ms, the SensorManager polls them every slow tick
+    static bool add_barometer(Sensor::BarometerBase* baro, uint32_t interval_ms = 20);
+    // Polled every slow tick. The driver keeps its own newest fix (GpsBase::get_fix), nothing is logged
+    static bool add_gps(Sensor::GpsBase* gps);
+    // Anything else added to the SensorManager before begin() is read by the slow task at its own interval
+
+    static inline void attach_filesystem(FileSystem* filesystem) {filesystem_ptr = filesystem;}
+    static inline void set_log_paths(const char* imu_path, const char* baro_path) {imu_log_path = imu_path; baro_log_path = baro_path;}
+
+    // Periodic callback run by the telemetry task on the comms core
+    static inline void set_telemetry_callback(void (*callback)(), uint32_t interval_ms) {telemetry_callback = callback; telemetry_interval_ms = interval_ms;}
+
+    // Periodic callback run by the slow acquisition task, for anything else that talks to the sensors
+    static inline void set_acquisition_callback(void (*callback)(), uint32_t interval_ms) {acquisition_callback = callback; acquisition_interval_ms = interval_ms;}
+
+    // Creates the timer and all tasks. 800 Hz matches the BMI323 gyro ODR
+    static bool begin(uint32_t acquisition_rate_hz = 800);
+
+    // Newest sample without consuming the log queues. False if no sample yet
+    static bool latest_imu(size_t imu_id, ImuSample& sample);
+    static bool latest_baro(size_t baro_id, BaroSample& sample);
+
+    // IMU id whose accel or gyro is this sensor, -1 if the pipeline doesn't read it
+    static int imu_id_of(const Sensor::SensorBase* sensor);
+
+    static PipelineStats get_stats();
+    static void reset_stats();
+
+    static inline bool is_running() {return running;}
+
+private:
+    static Sensor::AccelerometerBase* accels[MAX_IMUS];
+    static Sensor::GyroscopeBase* gyros[MAX_IMUS];
+    static int drdy_pins[MAX_IMUS];
+    static bool fused_imus[MAX_IMUS];
+    static size_t imu_count;
+
+    // Fast acquisition notification bits: one per DRDY IMU (bit = imu id), plus the timer tick
+    static constexpr uint32_t TIMER_NOTIFY_BIT = 1UL << 31;
+
+    static Sensor::BarometerBase* baros[MAX_BAROS];
+    static size_t baro_count;
+
+    static Sensor::GpsBase* gpses[MAX_GPSES];
+    static size_t gps_count;
+
+    // Acquisition -> logging (every sample)
+    static SpscQueue<ImuSample, IMU_QUEUE_LENGTH> imu_queue;
+    static SpscQueue<BaroSample, BARO_QUEUE_LENGTH> baro_queue;
+
+    // Acquisition -> anyone who only needs the newest value
+    static SeqLock<ImuSample> latest_imu_slots[MAX_IMUS];
+    static SeqLock<BaroSample> latest_baro_slots[MAX_BAROS];
+
+    // Sample time last published per IMU, so a driver with nothing new never repeats a sample
+    static uint64_t published_time_us[MAX_IMUS];
+
+    static FileSystem* filesystem_ptr;
+    static const char* imu_log_path;
+    static const char* baro_log_path;
+
+    static void (*telemetry_callback)();
+    static uint32_t telemetry_interval_ms;
+    static void (*acquisition_callback)();
+    static uint32_t acquisition_interval_ms;
+
+    static TaskHandle_t fast_acquisition_handle;
+    static TaskHandle_t slow_acquisition_handle;
+    static TaskHandle_t comms_handle;
+    static TaskHandle_t logging_handle;
+    static TaskHandle_t telemetry_handle;
+    static esp_timer_handle_t acquisition_timer;
+
+    static uint32_t acquisition_period_us;
+    static volatile uint32_t last_tick_us;
+    static volatile uint32_t tick_count;
+    static bool running;
+
+    // Busy time is written by every task on a core, so it sits behind a spinlock
+    static portMUX_TYPE stats_mux;
+    static uint64_t busy_us[2];
+    static int64_t stats_start_us;
+
+    // Only written by the fast acquisition task
+    static volatile uint32_t acquisition_cycles;
+    static volatile uint32_t max_jitter_us;
+    static volatile uint32_t missed_ticks;
+    static volatile uint32_t drdy_reads;
+
+    static void acquisition_timer_callback(void* arg);
+
+    static void fast_acquisition_task(void* arg);
+    static void read_imu(size_t imu_id);
+    static void publish_imu(size_t imu_id); // Queues whatever the sensors last read
+    static inline bool is_single_chip(size_t imu_id) {
+        return static_cast<Sensor::SensorBase*>(accels[imu_id]) == static_cast<Sensor::SensorBase*>(gyros[imu_id]);
+    }
+    static void publish_baro(void* context); // SensorCallback, context is the baro id
+    static void slow_acquisition_task(void* arg);
+    static void comms_task(void* arg);
+    static void logging_task(void* arg);
+    static void telemetry_task(void* arg);
+
+    static void add_busy_time(int64_t start_us);
+    static size_t drain_to_file(const char* path, const uint8_t* buffer, size_t len);
+};
+
+} // namespace Cesium
@@ -0,0 +1,251 @@
+#include "sensor_manager.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "../comms/packet.h"
+#include <esp_timer.h>
+
+using namespace std;
+
+namespace Cesium {
+
+SensorManager::Entry SensorManager::entries[MAX_SENSORS] = {};
+size_t SensorManager::sensor_count = 0;
+
+const void* SensorManager::current_bus = nullptr;
+uint32_t SensorManager::bus_switches = 0;
+
+int64_t SensorManager::stats_start_us = 0;
+portMUX_TYPE SensorManager::stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+////////////////////////////////////////////////////////////
+//                     Registration                       //
+////////////////////////////////////////////////////////////
+
+uint8_t SensorManager::add_sensor(Sensor::SensorBase *sensor, uint32_t interval_ms, uint8_t priority,
+                                  ReadMode mode, SensorCallback on_sample, void *context)
+{
+    if (sensor == nullptr || sensor_count >= MAX_SENSORS || interval_ms == 0) {
+        DEBUGLN("Could not add sensor to manager");
+        return INVALID_SENSOR;
+    }
+
+    sensor->set_interval_ms(interval_ms);
+
+    Entry& entry = entries[sensor_count];
+    entry.sensor = sensor;
+    entry.bus = sensor->get_bus();
+    entry.interval_ms = interval_ms;
+    entry.next_due_ms = 0;
+    entry.priority = priority;
+    entry.mode = mode;
+    entry.on_sample = on_sample;
+    entry.context = context;
+    entry.stats = {};
+
+    if (sensor_count == 0) {
+        stats_start_us = esp_timer_get_time();
+    }
+
+    return sensor_count++;
+}
+
+////////////////////////////////////////////////////////////
+//                      Scheduling                        //
+////////////////////////////////////////////////////////////
+
+bool SensorManager::is_due(const Entry &entry, uint32_t now_ms)
+{
+    // Signed difference so millis() wrapping doesn't matter
+    return entry.mode == ReadMode::POLLED || (int32_t)(now_ms - entry.next_due_ms) >= 0;
+}
+
+size_t SensorManager::due_list(uint32_t now_ms, uint8_t *order)
+{
+    bool pending[MAX_SENSORS] = {false};
+    size_t pending_count = 0;
+
+    for (size_t i = 0; i < sensor_count; i++) {
+        pending[i] = is_due(entries[i], now_ms);
+        pending_count += pending[i];
+    }
+
+    const void* bus = current_bus;
+    size_t count = 0;
+
+    while (count < pending_count) {
+        // Best on the bus we are already on, else best overall. Ties go to the lower id
+        int best_on_bus = -1;
+        int best = -1;
+        for (size_t i = 0; i < sensor_count; i++) {
+            if (!pending[i]) {
+                continue;
+            }
+            if (best < 0 || entries[i].priority < entries[best].priority) {
+                best = i;
+            }
+            if (entries[i].bus == bus && (best_on_bus < 0 || entries[i].priority < entries[best_on_bus].priority)) {
+                best_on_bus = i;
+            }
+        }
+
+        int next = best_on_bus >= 0 ? best_on_bus : best;
+        order[count++] = next;
+        pending[next] = false;
+        bus = entries[next].bus;
+    }
+
+    return count;
+}
+
+size_t SensorManager::run(uint32_t now_ms)
+{
+    PROBE_SCOPE("SensorManager::run");
+    TRACE_SCOPE("SensorManager::run");
+
+    uint8_t order[MAX_SENSORS];
+    size_t due = due_list(now_ms, order);
+
+    size_t samples = 0;
+    for (size_t i = 0; i < due; i++) {
+        uint32_t before = entries[order[i]].stats.samples;
+        read_sensor(order[i], now_ms);
+        samples += entries[order[i]].stats.samples - before;
+    }
+
+    return samples;
+}
+
+void SensorManager::read_sensor(size_t sensor_id, uint32_t now_ms)
+{
+    Entry& entry = entries[sensor_id];
+
+    if (entry.bus != current_bus) {
+        // The first read of all isn't a switch
+        if (current_bus != nullptr && entry.bus != nullptr) {
+            bus_switches++;
+        }
+        current_bus = entry.bus;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    bool ok = entry.sensor->read();
+    uint32_t latency_us = esp_timer_get_time() - start_us;
+
+    // Keeps the phase, unless the sensor is so late that whole intervals were missed
+    uint32_t overruns = 0;
+    if (entry.mode == ReadMode::PERIODIC) {
+        entry.next_due_ms += entry.interval_ms;
+        if ((int32_t)(now_ms - entry.next_due_ms) >= 0) {
+            // The very first read starts the schedule, it didn't miss anything
+            if (entry.stats.reads > 0) {
+                overruns = (now_ms - entry.next_due_ms) / entry.interval_ms + 1;
+            }
+            entry.next_due_ms = now_ms + entry.interval_ms;
+        }
+    }
+
+    // Read from the comms core for MCU_STATS
+    portENTER_CRITICAL(&stats_mux);
+    SensorStats& stats = entry.stats;
+    stats.reads++;
+    stats.overruns += overruns;
+    stats.total_latency_us += latency_us;
+    if (latency_us > stats.max_latency_us) {
+        stats.max_latency_us = latency_us;
+    }
+    if (ok) {
+        stats.samples++;
+    } else if (entry.mode == ReadMode::PERIODIC) {
+        stats.failures++;
+    }
+    portEXIT_CRITICAL(&stats_mux);
+
+    if (ok && entry.on_sample != nullptr) {
+        entry.on_sample(entry.context);
+    }
+}
+
+////////////////////////////////////////////////////////////
+//                        Stats                           //
+////////////////////////////////////////////////////////////
+
+SensorStats SensorManager::get_stats(size_t sensor_id)
+{
+    if (sensor_id >= sensor_count) {
+        return {};
+    }
+
+    portENTER_CRITICAL(&stats_mux);
+    SensorStats stats = entries[sensor_id].stats;
+    portEXIT_CRITICAL(&stats_mux);
+
+    return stats;
+}
+
+float SensorManager::get_achieved_rate_hz(size_t sensor_id)
+{
+    int64_t window_us = esp_timer_get_time() - stats_start_us;
+    if (sensor_id >= sensor_count || window_us <= 0) {
+        return 0;
+    }
+    return get_stats(sensor_id).samples * 1e6f / window_us;
+}
+
+void SensorManager::reset_stats()
+{
+    portENTER_CRITICAL(&stats_mux);
+    for (size_t i = 0; i < sensor_count; i++) {
+        entries[i].stats = {};
+    }
+    bus_switches = 0;
+    stats_start_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+/*
+SENSORS record (little-endian)
+- u8  record type (3)
+- u32 window_us
+- u32 bus switches
+- u8  sensor count, then per sensor:
+    - u8  interface (SPI, I2C, Serial, NOT_SET)
+    - u8  priority
+    - u8  mode (0 periodic, 1 polled)
+    - u32 interval_ms
+    - u32 reads
+    - u32 samples
+    - u32 failures
+    - u32 overruns
+    - u32 mean_latency_us
+    - u32 max_latency_us
+*/
+vector<uint8_t> SensorManager::stats_record()
+{
+    vector<uint8_t> data;
+    data.reserve(10 + MAX_SENSORS * 31);
+
+    data.push_back((uint8_t)StatsRecord::SENSORS);
+    append_bytes(data, (uint32_t)(esp_timer_get_time() - stats_start_us));
+    append_bytes(data, bus_switches);
+
+    data.push_back((uint8_t)sensor_count);
+    for (size_t i = 0; i < sensor_count; i++) {
+        const Entry& entry = entries[i];
+        SensorStats stats = get_stats(i);
+
+        data.push_back((uint8_t)entry.sensor->get_interface());
+        data.push_back(entry.priority);
+        data.push_back((uint8_t)entry.mode);
+        append_bytes(data, entry.interval_ms);
+        append_bytes(data, stats.reads);
+        append_bytes(data, stats.samples);
+        append_bytes(data, stats.failures);
+        append_bytes(data, stats.overruns);
+        append_bytes(data, stats.mean_latency_us());
+        append_bytes(data, stats.max_latency_us);
+    }
+
+    return data;
+}
+
+} // namespace Cesium
@@ -0,0 +1,91 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Registry that reads every sensor at its own interval, grouped by bus, with per-sensor read stats
+
+#include <Arduino.h>
+#include <vector>
+
+#include "../globals.h"
+#include "../drivers/sensor_bases/SensorBase.h"
+
+namespace Cesium {
+
+// Runs in the task that calls run(), right after a read() that returned true
+typedef void (*SensorCallback)(void* context);
+
+struct SensorStats {
+    uint32_t reads;             // read() calls
+    uint32_t samples;           // read() returned true
+    uint32_t failures;          // read() returned false (periodic sensors only)
+    uint32_t overruns;          // Intervals skipped because the sensor was read too late
+    uint32_t max_latency_us;    // Longest read()
+    uint64_t total_latency_us;
+
+    inline uint32_t mean_latency_us() const {return reads == 0 ? 0 : total_latency_us / reads;}
+};
+
+class SensorManager {
+
+public:
+    static constexpr size_t MAX_SENSORS = 12;
+    static constexpr uint8_t INVALID_SENSOR = 0xFF;
+
+    enum class ReadMode : uint8_t {
+        PERIODIC,   // read() once per interval, false is a failed read
+        POLLED      // read() every run(), the driver paces itself at the interval and false means no sample yet
+    };
+
+    // Sets the sensor's read_interval_ms. Lower priority values are read first when several sensors are due.
+    // Returns the sensor id, or INVALID_SENSOR if the registry is full
+    static uint8_t add_sensor(Sensor::SensorBase* sensor, uint32_t interval_ms, uint8_t priority = 0,
+                              ReadMode mode = ReadMode::PERIODIC, SensorCallback on_sample = nullptr, void* context = nullptr);
+
+    // Fills order with the ids due at now_ms, in read order, and returns how many there are.
+    // Highest priority first, but once on a bus everything due on it is read before switching
+    static size_t due_list(uint32_t now_ms, uint8_t* order);
+
+    // Reads everything due. Returns how many reads produced a sample
+    static size_t run(uint32_t now_ms);
+    static inline size_t run() {return run(millis());}
+
+    static inline size_t get_sensor_count() {return sensor_count;}
+    static inline Sensor::SensorBase* get_sensor(size_t sensor_id) {return sensor_id < sensor_count ? entries[sensor_id].sensor : nullptr;}
+
+    static SensorStats get_stats(size_t sensor_id);
+    static float get_achieved_rate_hz(size_t sensor_id);
+    static inline uint32_t get_bus_switches() {return bus_switches;}
+
+    // MCU_STATS payload, see sensor_manager.cpp
+    static std::vector<uint8_t> stats_record();
+    static void reset_stats();
+
+private:
+    struct Entry {
+        Sensor::SensorBase* sensor;
+        const void* bus;
+        uint32_t interval_ms;
+        uint32_t next_due_ms;
+        uint8_t priority;
+        ReadMode mode;
+        SensorCallback on_sample;
+        void* context;
+        SensorStats stats;
+    };
+
+    static Entry entries[MAX_SENSORS];
+    static size_t sensor_count;
+
+    // Bus of the last read, so the next run() starts where this one ended
+    static const void* current_bus;
+    static uint32_t bus_switches;
+
+    static int64_t stats_start_us;
+    static portMUX_TYPE stats_mux;
+
+    static bool is_due(const Entry& entry, uint32_t now_ms);
+    static void read_sensor(size_t sensor_id, uint32_t now_ms);
+};
+
+} // namespace Cesium
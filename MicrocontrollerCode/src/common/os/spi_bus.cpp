@@ -0,0 +1,409 @@
+#include "spi_bus.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "../comms/packet.h"
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+
+using namespace std;
+
+namespace Cesium {
+
+SpiBus* SpiBus::buses[MAX_BUSES] = {nullptr};
+size_t SpiBus::bus_count = 0;
+
+SpiBus::SpiBus(spi_host_device_t host, int8_t sck, int8_t miso, int8_t mosi)
+    : host{host}
+    , sck_pin{sck}
+    , miso_pin{miso}
+    , mosi_pin{mosi}
+    , started{false}
+    , devices{}
+    , device_count{0}
+    , plan{}
+    , plan_count{0}
+    , submitted_count{0}
+    , cycles{0}
+    , busy_us{0}
+    , stats_start_us{0}
+{
+    portMUX_INITIALIZE(&stats_mux);
+}
+
+////////////////////////////////////////////////////////////
+//                        Setup                           //
+////////////////////////////////////////////////////////////
+
+bool SpiBus::begin()
+{
+    if (started || bus_count >= MAX_BUSES) {
+        return false;
+    }
+
+    spi_bus_config_t bus_config = {};
+    bus_config.mosi_io_num = mosi_pin;
+    bus_config.miso_io_num = miso_pin;
+    bus_config.sclk_io_num = sck_pin;
+    bus_config.quadwp_io_num = -1;
+    bus_config.quadhd_io_num = -1;
+    bus_config.max_transfer_sz = 4096;
+
+    if (spi_bus_initialize(host, &bus_config, SPI_DMA_CH_AUTO) != ESP_OK) {
+        DEBUGLN("Could not initialize SPI bus");
+        return false;
+    }
+
+    started = true;
+    buses[bus_count++] = this;
+    reset_stats();
+
+    return true;
+}
+
+uint8_t SpiBus::add_device(uint8_t cs_pin, uint32_t clock_hz, uint8_t mode, size_t max_transfer_bytes)
+{
+    if (!started || device_count >= MAX_DEVICES) {
+        DEBUGLN("Could not add SPI device");
+        return INVALID_DEVICE;
+    }
+
+    Device& device = devices[device_count];
+
+    spi_device_interface_config_t device_config = {};
+    device_config.mode = mode;
+    device_config.clock_speed_hz = clock_hz;
+    device_config.spics_io_num = cs_pin;
+    device_config.queue_size = 2;
+    device_config.pre_cb = pre_transfer;
+    device_config.post_cb = post_transfer;
+
+    if (spi_bus_add_device(host, &device_config, &device.handle) != ESP_OK) {
+        DEBUGLN("Could not add SPI device");
+        return INVALID_DEVICE;
+    }
+
+    // DMA wants word-aligned lengths
+    size_t buffer_bytes = (max_transfer_bytes + 3) & ~3;
+    device.tx_buffer = (uint8_t*)heap_caps_malloc(buffer_bytes, MALLOC_CAP_DMA);
+    device.rx_buffer = (uint8_t*)heap_caps_malloc(buffer_bytes, MALLOC_CAP_DMA);
+    device.lock = xSemaphoreCreateMutex();
+
+    if (device.tx_buffer == nullptr || device.rx_buffer == nullptr || device.lock == nullptr) {
+        DEBUGLN("Could not allocate SPI device buffers");
+        return INVALID_DEVICE;
+    }
+
+    device.cs_pin = cs_pin;
+    device.clock_hz = clock_hz;
+    device.max_transfer_bytes = max_transfer_bytes;
+    device.stats = {};
+
+    return device_count++;
+}
+
+////////////////////////////////////////////////////////////
+//                  Blocking transfers                    //
+////////////////////////////////////////////////////////////
+
+bool SpiBus::read(uint8_t device_id, const uint8_t *header, size_t header_len, uint8_t *rx, size_t rx_len)
+{
+    if (device_id >= device_count || header_len + rx_len > devices[device_id].max_transfer_bytes) {
+        return false;
+    }
+    Device& device = devices[device_id];
+
+    xSemaphoreTake(device.lock, portMAX_DELAY);
+
+    memcpy(device.tx_buffer, header, header_len);
+    memset(device.tx_buffer + header_len, 0, rx_len);
+
+    TransferTimes times = {};
+    bool ok = transfer(device_id, header_len + rx_len, times);
+    if (ok) {
+        memcpy(rx, device.rx_buffer + header_len, rx_len);
+    }
+
+    xSemaphoreGive(device.lock);
+    return ok;
+}
+
+bool SpiBus::write(uint8_t device_id, const uint8_t *tx, size_t len)
+{
+    if (device_id >= device_count || len > devices[device_id].max_transfer_bytes) {
+        return false;
+    }
+    Device& device = devices[device_id];
+
+    xSemaphoreTake(device.lock, portMAX_DELAY);
+
+    memcpy(device.tx_buffer, tx, len);
+
+    TransferTimes times = {};
+    bool ok = transfer(device_id, len, times);
+
+    xSemaphoreGive(device.lock);
+    return ok;
+}
+
+// Caller holds the device lock and has filled tx_buffer
+bool SpiBus::transfer(uint8_t device_id, size_t len, TransferTimes& times)
+{
+    Device& device = devices[device_id];
+
+    spi_transaction_t transaction = {};
+    transaction.length = len * 8;
+    transaction.tx_buffer = device.tx_buffer;
+    transaction.rx_buffer = device.rx_buffer;
+    transaction.user = &times;
+
+    int64_t queued_us = esp_timer_get_time();
+    RETURN_FALSE_IF_FALSE(spi_device_transmit(device.handle, &transaction) == ESP_OK);
+
+    record_transfer(device, len, queued_us, times);
+    return true;
+}
+
+////////////////////////////////////////////////////////////
+//                   Transaction plan                     //
+////////////////////////////////////////////////////////////
+
+bool SpiBus::plan_read(uint8_t device_id, const uint8_t *header, size_t header_len, size_t rx_len, SpiCallback callback, void *context,
+                       bool *completed)
+{
+    if (!started || plan_count >= MAX_PLAN || device_id >= device_count
+        || header_len + rx_len > devices[device_id].max_transfer_bytes) {
+        return false;
+    }
+    Device& device = devices[device_id];
+
+    // Held until collect(), so a second plan on the same device or a blocking transfer mid-flight fails here
+    if (xSemaphoreTake(device.lock, 0) != pdTRUE) {
+        return false;
+    }
+
+    memcpy(device.tx_buffer, header, header_len);
+    memset(device.tx_buffer + header_len, 0, rx_len);
+
+    PlanEntry& entry = plan[plan_count++];
+    entry.transaction = {};
+    entry.transaction.length = (header_len + rx_len) * 8;
+    entry.transaction.tx_buffer = device.tx_buffer;
+    entry.transaction.rx_buffer = device.rx_buffer;
+    entry.transaction.user = &entry.times;
+    entry.times = {};
+    entry.device_id = device_id;
+    entry.header_len = header_len;
+    entry.rx_len = rx_len;
+    entry.callback = callback;
+    entry.context = context;
+    entry.completed = completed;
+    entry.queued = false;
+
+    if (completed != nullptr) {
+        *completed = false;
+    }
+
+    return true;
+}
+
+size_t SpiBus::submit()
+{
+    TRACE_SCOPE("SpiBus::submit");
+
+    // The driver runs queued transactions back-to-back from its ISR
+    size_t queued = 0;
+    for (size_t i = submitted_count; i < plan_count; i++) {
+        PlanEntry& entry = plan[i];
+        entry.queued_us = esp_timer_get_time();
+        entry.queued = spi_device_queue_trans(devices[entry.device_id].handle, &entry.transaction, 0) == ESP_OK;
+        if (entry.queued) {
+            queued++;
+        }
+    }
+    submitted_count = plan_count;
+
+    if (queued > 0) {
+        portENTER_CRITICAL(&stats_mux);
+        cycles++;
+        portEXIT_CRITICAL(&stats_mux);
+    }
+    return queued;
+}
+
+size_t SpiBus::collect()
+{
+    PROBE_SCOPE("SpiBus::collect");
+    TRACE_SCOPE("SpiBus::collect");
+
+    size_t completed = 0;
+
+    // Entries planned but never submitted still hold their device lock
+    for (size_t i = 0; i < plan_count; i++) {
+        PlanEntry& entry = plan[i];
+        Device& device = devices[entry.device_id];
+
+        // Never times out, the buffers can't be reused while a transfer is still in flight
+        spi_transaction_t* result = nullptr;
+        if (entry.queued && spi_device_get_trans_result(device.handle, &result, portMAX_DELAY) == ESP_OK) {
+            record_transfer(device, entry.header_len + entry.rx_len, entry.queued_us, entry.times);
+
+            if (entry.callback != nullptr) {
+                entry.callback(entry.context, device.rx_buffer + entry.header_len, entry.rx_len, entry.times.start_us);
+            }
+            if (entry.completed != nullptr) {
+                *entry.completed = true;
+            }
+            completed++;
+        }
+
+        xSemaphoreGive(device.lock);
+    }
+
+    plan_count = 0;
+    submitted_count = 0;
+    return completed;
+}
+
+size_t SpiBus::submit_all()
+{
+    size_t submitted = 0;
+    for (size_t i = 0; i < bus_count; i++) {
+        submitted += buses[i]->submit();
+    }
+    return submitted;
+}
+
+size_t SpiBus::collect_all()
+{
+    size_t completed = 0;
+    for (size_t i = 0; i < bus_count; i++) {
+        completed += buses[i]->collect();
+    }
+    return completed;
+}
+
+void IRAM_ATTR SpiBus::pre_transfer(spi_transaction_t *transaction)
+{
+    TransferTimes* times = (TransferTimes*)transaction->user;
+    if (times != nullptr) {
+        times->start_us = esp_timer_get_time();
+    }
+}
+
+void IRAM_ATTR SpiBus::post_transfer(spi_transaction_t *transaction)
+{
+    TransferTimes* times = (TransferTimes*)transaction->user;
+    if (times != nullptr) {
+        times->end_us = esp_timer_get_time();
+    }
+}
+
+////////////////////////////////////////////////////////////
+//                        Stats                           //
+////////////////////////////////////////////////////////////
+
+void SpiBus::record_transfer(Device &device, size_t len, int64_t queued_us, const TransferTimes &times)
+{
+    uint32_t latency_us = times.end_us - queued_us;
+
+    // Blocking transfers on the comms core and planned ones on the acquisition core both land here
+    portENTER_CRITICAL(&stats_mux);
+    busy_us += times.end_us - times.start_us;
+
+    SpiDeviceStats& stats = device.stats;
+    stats.transactions++;
+    stats.bytes += len;
+    stats.total_latency_us += latency_us;
+    if (latency_us > stats.max_latency_us) {
+        stats.max_latency_us = latency_us;
+    }
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+SpiDeviceStats SpiBus::get_device_stats(uint8_t device_id) const
+{
+    if (device_id >= device_count) {
+        return {};
+    }
+
+    portENTER_CRITICAL(&stats_mux);
+    SpiDeviceStats stats = devices[device_id].stats;
+    portEXIT_CRITICAL(&stats_mux);
+
+    return stats;
+}
+
+float SpiBus::get_utilisation() const
+{
+    portENTER_CRITICAL(&stats_mux);
+    int64_t window_us = esp_timer_get_time() - stats_start_us;
+    uint64_t busy = busy_us;
+    portEXIT_CRITICAL(&stats_mux);
+
+    return window_us > 0 ? (float)busy / window_us : 0;
+}
+
+void SpiBus::reset_stats()
+{
+    portENTER_CRITICAL(&stats_mux);
+    busy_us = 0;
+    cycles = 0;
+    stats_start_us = esp_timer_get_time();
+    for (size_t i = 0; i < device_count; i++) {
+        devices[i].stats = {};
+    }
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+/*
+SPI_BUS record (little-endian)
+- u8  record type (2)
+- u8  host
+- u32 window_us
+- u32 busy_us
+- u32 cycles (submitted plans)
+- u8  device count, then per device:
+    - u8  cs pin
+    - u32 clock_hz
+    - u32 transactions
+    - u32 bytes
+    - u32 mean_latency_us
+    - u32 max_latency_us
+*/
+vector<uint8_t> SpiBus::stats_record() const
+{
+    // Copied out first, record_transfer() may be updating them from the other core
+    SpiDeviceStats stats[MAX_DEVICES];
+    portENTER_CRITICAL(&stats_mux);
+    uint32_t window_us = esp_timer_get_time() - stats_start_us;
+    uint32_t busy = busy_us;
+    uint32_t cycle_count = cycles;
+    for (size_t i = 0; i < device_count; i++) {
+        stats[i] = devices[i].stats;
+    }
+    portEXIT_CRITICAL(&stats_mux);
+
+    vector<uint8_t> data;
+    data.reserve(16 + MAX_DEVICES * 21);
+
+    data.push_back((uint8_t)StatsRecord::SPI_BUS);
+    data.push_back((uint8_t)host);
+    append_bytes(data, window_us);
+    append_bytes(data, busy);
+    append_bytes(data, cycle_count);
+
+    data.push_back((uint8_t)device_count);
+    for (size_t i = 0; i < device_count; i++) {
+        const Device& device = devices[i];
+        data.push_back(device.cs_pin);
+        append_bytes(data, device.clock_hz);
+        append_bytes(data, stats[i].transactions);
+        append_bytes(data, stats[i].bytes);
+        append_bytes(data, stats[i].mean_latency_us());
+        append_bytes(data, stats[i].max_latency_us);
+    }
+
+    return data;
+}
+
+} // namespace Cesium
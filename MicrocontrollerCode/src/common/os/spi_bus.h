@@ -0,0 +1,135 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Shared SPI bus on the ESP-IDF master driver. Queued DMA transactions with completion callbacks
+
+#include <Arduino.h>
+#include <vector>
+#include <driver/spi_master.h>
+#include <freertos/semphr.h>
+
+#include "../globals.h"
+
+namespace Cesium {
+
+// Runs in the task that calls collect(), not in the ISR. rx starts after the header bytes,
+// start_us is when the transfer actually started on the bus
+typedef void (*SpiCallback)(void* context, const uint8_t* rx, size_t len, uint64_t start_us);
+
+struct SpiDeviceStats {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t max_latency_us;    // Queued to completed
+    uint64_t total_latency_us;
+
+    inline uint32_t mean_latency_us() const {return transactions == 0 ? 0 : total_latency_us / transactions;}
+};
+
+class SpiBus {
+
+public:
+    static constexpr size_t MAX_BUSES = 2;
+    static constexpr size_t MAX_DEVICES = 4;
+    static constexpr size_t MAX_PLAN = 8;
+    static constexpr uint8_t INVALID_DEVICE = 0xFF;
+
+    SpiBus(spi_host_device_t host, int8_t sck, int8_t miso, int8_t mosi);
+
+    // Takes the bus over from the Arduino SPIClass, which has to be end()ed first
+    bool begin();
+
+    // Each device has its own clock, mode and hardware CS. Returns INVALID_DEVICE on failure
+    uint8_t add_device(uint8_t cs_pin, uint32_t clock_hz, uint8_t mode, size_t max_transfer_bytes = 64);
+
+    // Blocking transfers for configuration and FIFO drains. The header is clocked out first,
+    // then rx_len bytes are clocked in (full duplex, the header's rx bytes are dropped)
+    bool read(uint8_t device_id, const uint8_t* header, size_t header_len, uint8_t* rx, size_t rx_len);
+    bool write(uint8_t device_id, const uint8_t* tx, size_t len);
+
+    // Per-cycle transaction plan. Everything planned is queued back-to-back by submit(),
+    // and the CPU is free until collect() runs the callbacks.
+    // False if the device is busy with a blocking transfer or the plan is full.
+    // collect() sets completed to whether the transfer finished and the callback ran
+    bool plan_read(uint8_t device_id, const uint8_t* header, size_t header_len, size_t rx_len, SpiCallback callback, void* context,
+                   bool* completed = nullptr);
+    size_t submit();  // Number of entries the driver queued
+    size_t collect(); // Number of entries that completed
+
+    // Every bus that has begun, for the acquisition pass and stats
+    static size_t submit_all();
+    static size_t collect_all();
+    static inline size_t get_bus_count() {return bus_count;}
+    static inline SpiBus* get_bus(size_t bus_id) {return bus_id < bus_count ? buses[bus_id] : nullptr;}
+
+    SpiDeviceStats get_device_stats(uint8_t device_id) const;
+    inline size_t get_device_count() const {return device_count;}
+    inline uint32_t get_cycles() const {return cycles;}
+    float get_utilisation() const;
+
+    // MCU_STATS payload, see spi_bus.cpp
+    std::vector<uint8_t> stats_record() const;
+    void reset_stats();
+
+    DELETE_COPY_AND_ASSIGNMENT(SpiBus)
+
+private:
+    // Written from the driver ISR through spi_transaction_t::user
+    struct TransferTimes {
+        volatile int64_t start_us;
+        volatile int64_t end_us;
+    };
+
+    struct Device {
+        spi_device_handle_t handle;
+        uint8_t cs_pin;
+        uint32_t clock_hz;
+        size_t max_transfer_bytes;
+        uint8_t* tx_buffer;     // DMA-capable
+        uint8_t* rx_buffer;     // DMA-capable
+        SemaphoreHandle_t lock; // One transaction per device in flight
+        SpiDeviceStats stats;
+    };
+
+    struct PlanEntry {
+        spi_transaction_t transaction;
+        TransferTimes times;
+        uint8_t device_id;
+        size_t header_len;
+        size_t rx_len;
+        SpiCallback callback;
+        void* context;
+        bool* completed;
+        int64_t queued_us;
+        bool queued;
+    };
+
+    spi_host_device_t host;
+    int8_t sck_pin;
+    int8_t miso_pin;
+    int8_t mosi_pin;
+    bool started;
+
+    Device devices[MAX_DEVICES];
+    size_t device_count;
+
+    PlanEntry plan[MAX_PLAN];
+    size_t plan_count;
+    size_t submitted_count;
+
+    uint32_t cycles;
+    uint64_t busy_us;
+    int64_t stats_start_us;
+    mutable portMUX_TYPE stats_mux; // Taken by the const stats readers too
+
+    static SpiBus* buses[MAX_BUSES];
+    static size_t bus_count;
+
+    bool transfer(uint8_t device_id, size_t len, TransferTimes& times);
+    void record_transfer(Device& device, size_t len, int64_t queued_us, const TransferTimes& times);
+
+    static void IRAM_ATTR pre_transfer(spi_transaction_t* transaction);
+    static void IRAM_ATTR post_transfer(spi_transaction_t* transaction);
+};
+
+} // namespace Cesium
@@ -0,0 +1,153 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Lock-free single-producer/single-consumer queue and seqlock "latest value" slot
+
+#include <array>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../globals.h"
+
+namespace Cesium {
+
+// Fixed-size ring of T records. Exactly one task may push and exactly one task may pop,
+// which lets the indices be plain atomics with no mutex (safe across the two ESP32 cores).
+// N must be a power of 2 so the free-running indices can be masked instead of wrapped.
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of 2");
+
+private:
+    std::array<T, N> buffer;
+
+    std::atomic<size_t> head; // Next slot to write, only modified by producer
+    std::atomic<size_t> tail; // Next slot to read, only modified by consumer
+
+    // Producer-side bookkeeping
+    size_t high_water;
+    uint32_t dropped;
+
+public:
+    SpscQueue() : buffer{}, head{0}, tail{0}, high_water{0}, dropped{0} {}
+
+    DELETE_COPY_AND_ASSIGNMENT(SpscQueue)
+
+    // Producer: returns false (and counts a drop) if the queue is full
+    bool push(const T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+
+        if (h - t >= N) {
+            dropped++;
+            return false;
+        }
+
+        buffer[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+
+        if (h + 1 - t > high_water) {
+            high_water = h + 1 - t;
+        }
+        return true;
+    }
+
+    // Consumer: returns false if the queue is empty
+    bool pop(T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+
+        if (t == h) {
+            return false;
+        }
+
+        item = buffer[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: pops up to max_items into items, returns number popped
+    size_t pop(T* items, size_t max_items) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+
+        size_t count = h - t;
+        if (count > max_items) {
+            count = max_items;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            items[i] = buffer[(t + i) & (N - 1)];
+        }
+        tail.store(t + count, std::memory_order_release);
+        return count;
+    }
+
+    // Approximate when called from a third task, exact from producer or consumer
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {return size() == 0;}
+    static constexpr size_t capacity() {return N;}
+
+    size_t get_high_water() const {return high_water;}
+    uint32_t get_dropped() const {return dropped;}
+
+    // Stats only, racing a push at worst loses one update
+    void reset_stats() {
+        high_water = 0;
+        dropped = 0;
+    }
+};
+
+// Single-writer "latest value" slot. The writer never blocks; readers retry if they
+// raced a write. Used for consumers that only want the newest sample, not every sample.
+template <typename T>
+class SeqLock {
+private:
+    std::atomic<uint32_t> sequence; // Odd while a write is in progress
+    T value;
+
+public:
+    SeqLock() : sequence{0}, value{} {}
+
+    DELETE_COPY_AND_ASSIGNMENT(SeqLock)
+
+    // Only one task may write
+    void write(const T& new_value) {
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        value = new_value;
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Any number of readers. Returns false if nothing has been written yet
+    bool read(T& result) const {
+        uint32_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue; // Write in progress
+            }
+
+            result = value;
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        return before != 0;
+    }
+
+    // Number of completed writes, useful to check if a new value has arrived
+    uint32_t get_version() const {return sequence.load(std::memory_order_acquire) / 2;}
+};
+
+} // namespace Cesium
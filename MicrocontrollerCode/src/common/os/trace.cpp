@@ -0,0 +1,210 @@
+#include "trace.h"
+#include "../comms/packet.h"
+#include <esp_ipc.h>
+#include <esp_timer.h>
+
+using namespace std;
+
+namespace Cesium {
+
+TraceEvent Trace::rings[2][RING_LENGTH] = {};
+uint32_t Trace::heads[2] = {0, 0};
+volatile bool Trace::frozen = false;
+
+const char* Trace::event_names[MAX_EVENT_NAMES] = {nullptr};
+size_t Trace::name_count = 0;
+portMUX_TYPE Trace::register_mux = portMUX_INITIALIZER_UNLOCKED;
+
+uint32_t Trace::sync_ccount[2] = {0, 0};
+int64_t Trace::sync_time_us[2] = {0, 0};
+
+static_assert((Trace::RING_LENGTH & (Trace::RING_LENGTH - 1)) == 0, "RING_LENGTH must be a power of 2");
+
+////////////////////////////////////////////////////////////
+//                     Registration                       //
+////////////////////////////////////////////////////////////
+
+uint16_t Trace::register_event(const char *name)
+{
+    uint16_t id = INVALID_EVENT;
+
+    portENTER_CRITICAL(&register_mux);
+    for (size_t i = 0; i < name_count; i++) {
+        if (strcmp(event_names[i], name) == 0) {
+            id = i;
+            break;
+        }
+    }
+
+    if (id == INVALID_EVENT && name_count < MAX_EVENT_NAMES) {
+        event_names[name_count] = name;
+        id = name_count;
+        name_count++;
+    }
+    portEXIT_CRITICAL(&register_mux);
+
+    return id;
+}
+
+////////////////////////////////////////////////////////////
+//                       Control                          //
+////////////////////////////////////////////////////////////
+
+void Trace::capture_sync(void *arg)
+{
+    uint32_t core = xPortGetCoreID();
+    sync_ccount[core] = ESP.getCycleCount();
+    sync_time_us[core] = esp_timer_get_time();
+}
+
+void Trace::freeze()
+{
+    frozen = true;
+
+    capture_sync(nullptr);
+    esp_ipc_call_blocking(xPortGetCoreID() == 0 ? 1 : 0, capture_sync, nullptr);
+}
+
+void Trace::resume()
+{
+    frozen = false;
+}
+
+void Trace::clear()
+{
+    heads[0] = 0;
+    heads[1] = 0;
+}
+
+////////////////////////////////////////////////////////////
+//                      Records                           //
+////////////////////////////////////////////////////////////
+
+/*
+HEADER record (little-endian)
+- u8  record type (0)
+- u32 cpu_freq_mhz
+- per core (0, 1): u32 event count, u32 sync ccount, i64 sync esp_timer us
+- u16 name count
+*/
+vector<uint8_t> Trace::header_record()
+{
+    vector<uint8_t> data;
+    data.reserve(40);
+
+    data.push_back((uint8_t)TraceRecord::HEADER);
+    append_bytes(data, (uint32_t)ESP.getCpuFreqMHz());
+
+    for (size_t core = 0; core < 2; core++) {
+        append_bytes(data, heads[core]);
+        append_bytes(data, sync_ccount[core]);
+        append_bytes(data, sync_time_us[core]);
+    }
+
+    append_bytes(data, (uint16_t)name_count);
+
+    return data;
+}
+
+/*
+NAMES record
+- u8  record type (1)
+- u16 first event id
+- u8  name count, then per name: u8 length, name
+*/
+vector<vector<uint8_t>> Trace::name_records()
+{
+    vector<vector<uint8_t>> records;
+
+    size_t id = 0;
+    while (id < name_count) {
+        vector<uint8_t> data;
+        data.push_back((uint8_t)TraceRecord::NAMES);
+        append_bytes(data, (uint16_t)id);
+        data.push_back(0);
+
+        uint8_t count = 0;
+        while (id < name_count) {
+            uint8_t len = strnlen(event_names[id], 255);
+            if (data.size() + 1 + len > NAMES_RECORD_BYTES) {
+                break;
+            }
+            data.push_back(len);
+            data.insert(data.end(), event_names[id], event_names[id] + len);
+            count++;
+            id++;
+        }
+
+        data[3] = count;
+        records.push_back(data);
+    }
+
+    return records;
+}
+
+/*
+EVENTS record
+- u8  record type (2)
+- u8  core
+- u16 event count, then TraceEvent (12 bytes) per event, oldest first
+*/
+vector<vector<uint8_t>> Trace::event_records(size_t core)
+{
+    vector<vector<uint8_t>> records;
+
+    uint32_t head = heads[core];
+    uint32_t start = head > RING_LENGTH ? head - RING_LENGTH : 0;
+
+    for (uint32_t i = start; i < head; i += EVENTS_PER_RECORD) {
+        uint16_t count = min((uint32_t)EVENTS_PER_RECORD, head - i);
+
+        vector<uint8_t> data;
+        data.reserve(4 + count * sizeof(TraceEvent));
+        data.push_back((uint8_t)TraceRecord::EVENTS);
+        data.push_back(core);
+        append_bytes(data, count);
+
+        for (uint32_t j = i; j < i + count; j++) {
+            append_bytes(data, rings[core][j & (RING_LENGTH - 1)]);
+        }
+        records.push_back(data);
+    }
+
+    return records;
+}
+
+vector<uint8_t> Trace::end_record()
+{
+    return vector<uint8_t>{(uint8_t)TraceRecord::END};
+}
+
+bool Trace::write_file(FileSystem *filesystem, const char *path)
+{
+    RETURN_FALSE_IF_FALSE(filesystem != nullptr);
+
+    vector<vector<uint8_t>> records;
+    records.push_back(header_record());
+
+    for (auto& record : name_records()) {
+        records.push_back(record);
+    }
+    for (size_t core = 0; core < 2; core++) {
+        for (auto& record : event_records(core)) {
+            records.push_back(record);
+        }
+    }
+    records.push_back(end_record());
+
+    // One write instead of an append per record
+    vector<uint8_t> buffer;
+    for (auto& record : records) {
+        append_bytes(buffer, (uint16_t)record.size());
+        buffer.insert(buffer.end(), record.begin(), record.end());
+    }
+
+    RETURN_FALSE_IF_FALSE(filesystem->writeFile(path, buffer.data(), buffer.size()));
+
+    return true;
+}
+
+} // namespace Cesium
@@ -0,0 +1,143 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Cycle-counter trace ring buffer. Dumped with SystemStatusCMD::TRACE_DUMP, converted with PyCommander/trace_to_chrome.py
+
+#include <Arduino.h>
+#include <vector>
+
+#include "../globals.h"
+#include "filesystem.h"
+
+// Trace points only exist when built with -D ENABLE_TRACE (debug and test envs).
+//
+// Usage:
+//     TRACE_SCOPE("Bmi323::read");             // BEGIN now, END when the scope exits
+//     TRACE_BEGIN("flush"); ... TRACE_END("flush");
+//     TRACE_INSTANT("acquisition_late", late_us);
+#ifdef ENABLE_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) \
+    static const uint16_t TRACE_CONCAT(_trace_id_, __LINE__) = Cesium::Trace::register_event(name); \
+    Cesium::TraceScope TRACE_CONCAT(_trace_scope_, __LINE__)(TRACE_CONCAT(_trace_id_, __LINE__))
+#define TRACE_BEGIN(name) do { \
+    static const uint16_t _trace_id = Cesium::Trace::register_event(name); \
+    Cesium::Trace::record(_trace_id, Cesium::TracePhase::BEGIN); } while (0)
+#define TRACE_END(name) do { \
+    static const uint16_t _trace_id = Cesium::Trace::register_event(name); \
+    Cesium::Trace::record(_trace_id, Cesium::TracePhase::END); } while (0)
+#define TRACE_INSTANT(name, arg) do { \
+    static const uint16_t _trace_id = Cesium::Trace::register_event(name); \
+    Cesium::Trace::record(_trace_id, Cesium::TracePhase::INSTANT, (uint32_t)(arg)); } while (0)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_BEGIN(name) do {} while (0)
+#define TRACE_END(name) do {} while (0)
+#define TRACE_INSTANT(name, arg) do {} while (0)
+#endif
+
+namespace Cesium {
+
+// Same letters as the Chrome trace "ph" field
+enum class TracePhase : uint8_t {
+    BEGIN = 'B',
+    END = 'E',
+    INSTANT = 'i'
+};
+
+struct __attribute__((packed)) TraceEvent {
+    uint32_t ccount;    // CPU cycle counter of the core that recorded it (wraps every ~17.9 s at 240 MHz)
+    uint8_t core;
+    uint8_t phase;      // TracePhase
+    uint16_t event_id;
+    uint32_t arg;
+};
+
+enum class TraceRecord {
+    HEADER = 0,
+    NAMES = 1,
+    EVENTS = 2,
+    END = 3
+};
+
+class Trace {
+
+public:
+    static constexpr size_t RING_LENGTH = 1024; // Per core, must be a power of 2 (12 KB each)
+    static constexpr size_t MAX_EVENT_NAMES = 64;
+    static constexpr uint16_t INVALID_EVENT = 0xFFFF;
+
+    static constexpr size_t EVENTS_PER_RECORD = 128; // 1536 bytes, fits in one packet
+    static constexpr size_t NAMES_RECORD_BYTES = 1800;
+
+    // Returns the existing id if the name was already registered
+    static uint16_t register_event(const char* name);
+
+    static inline void record(uint16_t event_id, TracePhase phase, uint32_t arg = 0) {
+        if (frozen) {
+            return;
+        }
+
+        // Each core owns its ring. Tasks on the same core can still preempt each other,
+        // so the slot is claimed atomically before it is written
+        uint32_t core = xPortGetCoreID();
+        uint32_t index = __atomic_fetch_add(&heads[core], 1, __ATOMIC_RELAXED) & (RING_LENGTH - 1);
+
+        TraceEvent& event = rings[core][index];
+        event.ccount = ESP.getCycleCount();
+        event.core = core;
+        event.phase = (uint8_t)phase;
+        event.event_id = event_id;
+        event.arg = arg;
+    }
+
+    // Stops recording and captures a (cycle count, esp_timer) pair on both cores so the host can align them
+    static void freeze();
+    static void resume();
+    static void clear();
+    static inline bool is_frozen() {return frozen;}
+
+    // Total events recorded on a core since the last clear (more than RING_LENGTH means the oldest were overwritten)
+    static inline uint32_t get_event_count(size_t core) {return heads[core];}
+    static inline size_t get_name_count() {return name_count;}
+
+    // Dump records. Only valid while frozen
+    static std::vector<uint8_t> header_record();
+    static std::vector<std::vector<uint8_t>> name_records();
+    static std::vector<std::vector<uint8_t>> event_records(size_t core);
+    static std::vector<uint8_t> end_record();
+
+    // All records, each prefixed with a u16 length
+    static bool write_file(FileSystem* filesystem, const char* path);
+
+private:
+    static TraceEvent rings[2][RING_LENGTH];
+    static uint32_t heads[2];
+    static volatile bool frozen;
+
+    static const char* event_names[MAX_EVENT_NAMES];
+    static size_t name_count;
+    static portMUX_TYPE register_mux;
+
+    // Captured by freeze()
+    static uint32_t sync_ccount[2];
+    static int64_t sync_time_us[2];
+
+    static void capture_sync(void* arg);
+};
+
+// Records BEGIN on construction and END on destruction
+class TraceScope {
+private:
+    uint16_t event_id;
+
+public:
+    inline explicit TraceScope(uint16_t id) : event_id{id} {Trace::record(event_id, TracePhase::BEGIN);}
+    inline ~TraceScope() {Trace::record(event_id, TracePhase::END);}
+
+    DELETE_COPY_AND_ASSIGNMENT(TraceScope)
+};
+
+} // namespace Cesium
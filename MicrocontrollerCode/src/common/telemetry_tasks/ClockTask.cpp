@@ -1,6 +1,7 @@
 #include "ClockTask.h"
 #include "SystemStatusTask.h"
 #include "../comms/serial_comms.h"
+#include "../os/instrumentation.h"
 
 using namespace std;
 
@@ -10,6 +11,7 @@ size_t ClockTask::routed_packets = 0;
 
 ClockCMD ClockTask::route_packet(BasePacket &packet)
 {
+    PROBE_SCOPE("ClockTask::route_packet");
     ClockCMD command = (ClockCMD)packet.get_command();
     switch(command) {
     case ClockCMD::STATUS:
@@ -1,5 +1,6 @@
 #include "FilesystemTask.h"
 #include "SystemStatusTask.h"
+#include "../os/instrumentation.h"
 
 using namespace std;
 
@@ -10,6 +11,7 @@ FileSystem* FilesystemTask::filesystem_ptr = nullptr;
 
 FilesystemCMD FilesystemTask::route_packet(BasePacket & packet)
 {
+    PROBE_SCOPE("FilesystemTask::route_packet");
     FilesystemCMD command = (FilesystemCMD)packet.get_command();
     switch(command) {
     case FilesystemCMD::LIST_DIR: {
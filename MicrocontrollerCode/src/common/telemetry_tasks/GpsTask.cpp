@@ -0,0 +1,200 @@
+#include "GpsTask.h"
+#include "SystemStatusTask.h"
+
+#include "../comms/serial_comms.h"
+#include "../os/instrumentation.h"
+#include <esp_timer.h>
+
+using namespace std;
+
+namespace Cesium {
+
+std::vector<Sensor::GpsBase*> GpsTask::gpses{};
+
+GpsCMD GpsTask::route_packet(BasePacket& packet) {
+    PROBE_SCOPE("GpsTask::route_packet");
+    GpsCMD command = (GpsCMD)packet.get_command();
+    switch(command) {
+    case GpsCMD::BASIC_TELEM:
+        DEBUGLN("BASIC_TELEM");
+        send_basic_telem(packet.get_data());
+        break;
+
+    case GpsCMD::POSITION_ACCURACY:
+        DEBUGLN("POSITION_ACCURACY");
+        send_position_accuracy(packet.get_data());
+        break;
+
+    case GpsCMD::SPEED_HEADING:
+        DEBUGLN("SPEED_HEADING");
+        send_speed_heading(packet.get_data());
+        break;
+
+    case GpsCMD::TIME_TELEM:
+        DEBUGLN("TIME_TELEM");
+        send_time_telem(packet.get_data());
+        break;
+
+    case GpsCMD::READ_REG: // TODO
+        DEBUGLN("READ_REG");
+        SystemStatusTask::send_not_implemented("GPS::READ_REG");
+        break;
+
+    case GpsCMD::WRITE_REG: // TODO
+        DEBUGLN("WRITE_REG");
+        SystemStatusTask::send_not_implemented("GPS::WRITE_REG");
+        break;
+
+    default:
+        DEBUGLN("Did not finish routing packet");
+        SystemStatusTask::send_nack("BAD COMMAND");
+        return GpsCMD(-1);
+    }
+
+    return command;
+}
+
+bool GpsTask::get_fix(const vector<uint8_t>& data, Sensor::GpsFix& fix)
+{
+    if (data.size() < 1 || data[0] >= gpses.size()) {
+        String err = "GPS ID with maximum of " + String((int)gpses.size() - 1);
+        DEBUGLN(err);
+        SystemStatusTask::send_nack(err.c_str());
+        return false;
+    }
+
+    if (!gpses[data[0]]->get_fix(fix)) {
+        SystemStatusTask::send_nack("GPS has no solution yet");
+        return false;
+    }
+
+    return true;
+}
+
+void GpsTask::emit_response(GpsCMD command, vector<uint8_t>& response)
+{
+    BasePacket packet;
+    packet.configure((int)Topic::GPS, (int)command, response);
+    packet.packetize();
+
+    SerialComms::emit_packet(packet, SERIAL_UART);
+}
+
+/*
+BASIC_TELEM response (little-endian)
+- u8  gps id
+- u8  fix type
+- u8  flags (bit 0 gnssFixOK)
+- u8  satellites
+- i32 latitude (deg * 1e7)
+- i32 longitude (deg * 1e7)
+- i32 height above MSL (mm)
+- u32 age of the solution (ms)
+*/
+bool GpsTask::send_basic_telem(const vector<uint8_t>& data)
+{
+    Sensor::GpsFix fix;
+    RETURN_FALSE_IF_FALSE(get_fix(data, fix));
+
+    uint32_t age_ms = (esp_timer_get_time() - fix.time_us) / 1000;
+
+    vector<uint8_t> response;
+    response.push_back(data[0]);
+    response.push_back(fix.fix_type);
+    response.push_back(fix.flags);
+    response.push_back(fix.satellites);
+    append_bytes(response, fix.latitude_e7);
+    append_bytes(response, fix.longitude_e7);
+    append_bytes(response, fix.height_msl_mm);
+    append_bytes(response, age_ms);
+
+    emit_response(GpsCMD::BASIC_TELEM, response);
+    return true;
+}
+
+/*
+POSITION_ACCURACY response (little-endian)
+- u8  gps id
+- u32 horizontal accuracy (mm)
+- u32 vertical accuracy (mm)
+- u16 position DOP (* 0.01)
+- i32 height above the ellipsoid (mm)
+*/
+bool GpsTask::send_position_accuracy(const vector<uint8_t>& data)
+{
+    Sensor::GpsFix fix;
+    RETURN_FALSE_IF_FALSE(get_fix(data, fix));
+
+    vector<uint8_t> response;
+    response.push_back(data[0]);
+    append_bytes(response, fix.h_acc_mm);
+    append_bytes(response, fix.v_acc_mm);
+    append_bytes(response, fix.pdop_e2);
+    append_bytes(response, fix.height_mm);
+
+    emit_response(GpsCMD::POSITION_ACCURACY, response);
+    return true;
+}
+
+/*
+SPEED_HEADING response (little-endian)
+- u8  gps id
+- i32 north, east, down velocity (mm/s)
+- i32 ground speed (mm/s)
+- i32 heading of motion (deg * 1e5)
+- u32 speed accuracy (mm/s)
+- u32 heading accuracy (deg * 1e5)
+*/
+bool GpsTask::send_speed_heading(const vector<uint8_t>& data)
+{
+    Sensor::GpsFix fix;
+    RETURN_FALSE_IF_FALSE(get_fix(data, fix));
+
+    vector<uint8_t> response;
+    response.push_back(data[0]);
+    append_bytes(response, fix.vel_n_mmps);
+    append_bytes(response, fix.vel_e_mmps);
+    append_bytes(response, fix.vel_d_mmps);
+    append_bytes(response, fix.ground_speed_mmps);
+    append_bytes(response, fix.heading_motion_e5);
+    append_bytes(response, fix.speed_acc_mmps);
+    append_bytes(response, fix.heading_acc_e5);
+
+    emit_response(GpsCMD::SPEED_HEADING, response);
+    return true;
+}
+
+/*
+TIME_TELEM response (little-endian)
+- u8  gps id
+- u16 year, u8 month, day, hour, minute, second (UTC)
+- u8  valid (bit 0 date, bit 1 time, bit 2 fully resolved)
+- i32 nanoseconds
+- u32 time accuracy (ns)
+- u32 GPS time of week (ms)
+- u64 esp_timer time of the solution (us)
+*/
+bool GpsTask::send_time_telem(const vector<uint8_t>& data)
+{
+    Sensor::GpsFix fix;
+    RETURN_FALSE_IF_FALSE(get_fix(data, fix));
+
+    vector<uint8_t> response;
+    response.push_back(data[0]);
+    append_bytes(response, fix.year);
+    response.push_back(fix.month);
+    response.push_back(fix.day);
+    response.push_back(fix.hour);
+    response.push_back(fix.minute);
+    response.push_back(fix.second);
+    response.push_back(fix.valid);
+    append_bytes(response, fix.nano_ns);
+    append_bytes(response, fix.t_acc_ns);
+    append_bytes(response, fix.iTOW_ms);
+    append_bytes(response, fix.time_us);
+
+    emit_response(GpsCMD::TIME_TELEM, response);
+    return true;
+}
+
+}
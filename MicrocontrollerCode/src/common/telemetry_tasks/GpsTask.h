@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Arduino.h>
+#include "../globals.h"
+#include "../comms/packet.h"
+#include "../comms/packet_schema.h"
+
+#include "../drivers/sensor_bases/GpsBase.h"
+#include <vector>
+
+namespace Cesium {
+
+class PacketBroker; // Forward definition
+
+// Serves GpsCMD from each receiver's newest fix, so a command never waits on the GPS
+class GpsTask {
+
+private:
+    static PacketBroker* broker;
+
+    static std::vector<Sensor::GpsBase*> gpses;
+
+    // Fills fix from data = {gps_id}, NACKs on a bad ID or before the first solution
+    static bool get_fix(const std::vector<uint8_t>& data, Sensor::GpsFix& fix);
+    static void emit_response(GpsCMD command, std::vector<uint8_t>& response);
+
+public:
+
+    static inline void add_gps(Sensor::GpsBase* gps) {gpses.push_back(gps);}
+
+    inline static void assign_broker(PacketBroker* broker) {GpsTask::broker = broker;};
+
+    // Returns GpsCMD for unit_testing verification
+    static GpsCMD route_packet(BasePacket& packet);
+
+    // data = {gps_id} for all four
+    static bool send_basic_telem(const std::vector<uint8_t>& data);
+    static bool send_position_accuracy(const std::vector<uint8_t>& data);
+    static bool send_speed_heading(const std::vector<uint8_t>& data);
+    static bool send_time_telem(const std::vector<uint8_t>& data);
+};
+
+}
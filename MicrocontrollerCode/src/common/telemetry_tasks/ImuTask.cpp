@@ -2,6 +2,8 @@
 #include "SystemStatusTask.h"
 
 #include "../comms/serial_comms.h"
+#include "../os/instrumentation.h"
+#include "../os/pipeline.h"
 
 using namespace std;
 
@@ -10,9 +12,18 @@ namespace Cesium {
 std::vector<Sensor::AccelerometerBase*> ImuTask::accels{};
 std::vector<Sensor::GyroscopeBase*> ImuTask::gyros{};
 std::vector<Sensor::MagnetometerBase*> ImuTask::mags{};
+std::vector<Sensor::ImuFifoBase*> ImuTask::fifos{};
+std::vector<bool> ImuTask::fifo_streaming{};
 
+FileSystem* ImuTask::filesystem_ptr = nullptr;
+Sensor::ImuFifoSample ImuTask::fifo_samples[FIFO_BATCH_SAMPLES];
+
+ImuTask::FifoRequest ImuTask::fifo_request{};
+std::atomic<bool> ImuTask::fifo_request_pending{false};
+SemaphoreHandle_t ImuTask::fifo_request_done = nullptr;
 
 ImuCMD ImuTask::route_packet(BasePacket& packet) {
+    PROBE_SCOPE("ImuTask::route_packet");
     ImuCMD command = (ImuCMD)packet.get_command();
     switch(command) {
     case ImuCMD::TELEM:
@@ -20,14 +31,14 @@ ImuCMD ImuTask::route_packet(BasePacket& packet) {
         ImuTask::create_telem_packet(packet.get_data());
         break;
 
-    case ImuCMD::FIFO_STATUS: // TODO
+    case ImuCMD::FIFO_STATUS:
         DEBUGLN("FIFO_STATUS");
-        SystemStatusTask::send_not_implemented("IMU::FIFO_STATUS");
+        send_fifo_status(packet.get_data());
         break;
 
-    case ImuCMD::FIFO_READ: // TODO
+    case ImuCMD::FIFO_READ:
         DEBUGLN("FIFO_READ");
-        SystemStatusTask::send_not_implemented("IMU::FIFO_READ");
+        fifo_read(packet.get_data());
         break;
 
     case ImuCMD::READ_REG: // TODO
@@ -66,7 +77,6 @@ bool ImuTask::create_telem_packet(vector<uint8_t> data)
 
     uint8_t accel_id = data[0];
     uint8_t gyro_id = data[1];
-    uint8_t mag_id = data[2];
     CoordFrame frame = (CoordFrame)data[3];
     
     RETURN_FALSE_IF_FALSE(check_ranges(data));
@@ -74,18 +84,35 @@ bool ImuTask::create_telem_packet(vector<uint8_t> data)
 
     Vector3<float> accel_data{};
     Vector3<float> gyro_data{};
-    Vector3<float> mag_data{};
     float temp_data{};
 
-    // Get data here, but for now, make fake vector
-    // TODO: Implement real data
-    if (frame == CoordFrame::Sensor) {
+    // Nothing else reads the drivers, so it's safe to do here
+    if (frame == CoordFrame::Sensor && !Pipeline::is_running()) {
         accels[accel_id]->read();
+        if (static_cast<Sensor::SensorBase*>(accels[accel_id]) != static_cast<Sensor::SensorBase*>(gyros[gyro_id])) {
+            gyros[gyro_id]->read();
+        }
         accel_data = accels[accel_id]->get_accel_mps2();
         gyro_data = gyros[gyro_id]->get_w_rps();
-        mag_data = mags[mag_id]->get_B_uT();
         temp_data = accels[accel_id]->get_temp_C();
     }
+    // Otherwise the acquisition core owns the drivers, so this only serves its newest samples
+    else if (frame == CoordFrame::Sensor) {
+        int accel_imu = Pipeline::imu_id_of(accels[accel_id]);
+        int gyro_imu = Pipeline::imu_id_of(gyros[gyro_id]);
+        ImuSample accel_sample, gyro_sample;
+
+        if (accel_imu < 0 || gyro_imu < 0 || !Pipeline::latest_imu(accel_imu, accel_sample) || !Pipeline::latest_imu(gyro_imu, gyro_sample)) {
+            send_telem_response("IMU not sampled by the pipeline");
+            return false;
+        }
+
+        for (size_t i = 0; i < 3; i++) {
+            accel_data[i][0] = accel_sample.accel_mps2[i];
+            gyro_data[i][0] = gyro_sample.w_rps[i];
+        }
+        temp_data = accel_sample.temp_C;
+    }
     // else if (frame == Frame::Sensor) {
     //     accel_data = accels[accel_id]->get_accel_mps2();
     //     gyro_data = gyros[gyro_id]->get_w_rps();
@@ -153,6 +180,216 @@ bool ImuTask::send_telem_response(const char* message)
 }
 
 
+////////////////////////////////////////////////////////////
+//                         FIFO                           //
+////////////////////////////////////////////////////////////
+
+bool ImuTask::check_fifo_id(const vector<uint8_t>& data)
+{
+    if (data.size() < 1 || data[0] >= fifos.size()) {
+        String err = "FIFO ID with maximum of " + String((int)fifos.size() - 1);
+        DEBUGLN(err);
+        SystemStatusTask::send_nack(err.c_str());
+        return false;
+    }
+    return true;
+}
+
+/*
+FIFO_STATUS response (little-endian)
+- u8  fifo id
+- u16 frames waiting
+- u16 capacity frames
+- u16 watermark frames
+- u32 frames read since flush
+- u32 frames skipped since flush
+- u8  streaming
+*/
+bool ImuTask::send_fifo_status(const vector<uint8_t>& data)
+{
+    RETURN_FALSE_IF_FALSE(check_fifo_id(data));
+
+    FifoRequest request{};
+    request.status = true;
+    request.fifo_id = data[0];
+
+    if (!run_fifo_request(request)) {
+        SystemStatusTask::send_nack("IMU::FIFO_STATUS timed out");
+        return false;
+    }
+
+    vector<uint8_t> response;
+    response.push_back(request.fifo_id);
+    append_bytes(response, request.frames);
+    append_bytes(response, request.capacity_frames);
+    append_bytes(response, request.watermark_frames);
+    append_bytes(response, request.frames_read);
+    append_bytes(response, request.frames_skipped);
+    response.push_back(request.streaming);
+
+    BasePacket packet;
+    packet.configure((int)Topic::IMU, (int)ImuCMD::FIFO_STATUS, response);
+    packet.packetize();
+
+    SerialComms::emit_packet(packet, SERIAL_UART);
+
+    return true;
+}
+
+/*
+FIFO_READ response (little-endian)
+- u8  fifo id
+- u8  mode
+- u32 samples written to the file by this command
+- file path
+*/
+bool ImuTask::fifo_read(const vector<uint8_t>& data)
+{
+    RETURN_FALSE_IF_FALSE(check_fifo_id(data));
+
+    if (filesystem_ptr == nullptr) {
+        SystemStatusTask::send_nack("IMU::FIFO_READ no filesystem");
+        return false;
+    }
+
+    uint8_t fifo_id = data[0];
+    FifoReadMode mode = data.size() > 1 ? (FifoReadMode)data[1] : FifoReadMode::DRAIN;
+
+    if (mode != FifoReadMode::DRAIN && mode != FifoReadMode::START_STREAM && mode != FifoReadMode::STOP_STREAM) {
+        SystemStatusTask::send_nack("IMU::FIFO_READ bad mode");
+        return false;
+    }
+
+    FifoRequest request{};
+    request.status = false;
+    request.mode = mode;
+    request.fifo_id = fifo_id;
+
+    if (!run_fifo_request(request)) {
+        SystemStatusTask::send_nack("IMU::FIFO_READ timed out");
+        return false;
+    }
+
+    String path = fifo_path(fifo_id);
+
+    vector<uint8_t> response;
+    response.push_back(fifo_id);
+    response.push_back((uint8_t)mode);
+    append_bytes(response, request.written);
+    response.insert(response.end(), path.begin(), path.end());
+
+    BasePacket packet;
+    packet.configure((int)Topic::IMU, (int)ImuCMD::FIFO_READ, response);
+    packet.packetize();
+
+    SerialComms::emit_packet(packet, SERIAL_UART);
+
+    return true;
+}
+
+bool ImuTask::run_fifo_request(FifoRequest& request)
+{
+    // Nothing else reads the drivers, so it's safe to do here
+    if (!Pipeline::is_running()) {
+        execute_fifo_request(request);
+        return true;
+    }
+
+    if (fifo_request_done == nullptr) {
+        fifo_request_done = xSemaphoreCreateBinary();
+        RETURN_FALSE_IF_FALSE(fifo_request_done != nullptr);
+    }
+
+    fifo_request = request;
+    fifo_request_pending.store(true, std::memory_order_release);
+
+    if (xSemaphoreTake(fifo_request_done, pdMS_TO_TICKS(FIFO_REQUEST_TIMEOUT_MS)) != pdTRUE) {
+        // Whoever clears the flag owns the request. If update() already has it, it's running, so wait it out
+        if (fifo_request_pending.exchange(false, std::memory_order_acquire)) {
+            return false;
+        }
+        xSemaphoreTake(fifo_request_done, portMAX_DELAY);
+    }
+
+    request = fifo_request;
+    return true;
+}
+
+void ImuTask::execute_fifo_request(FifoRequest& request)
+{
+    uint8_t fifo_id = request.fifo_id;
+    Sensor::ImuFifoBase* fifo = fifos[fifo_id];
+
+    if (request.status) {
+        request.frames = (uint16_t)fifo->get_fifo_frames();
+        request.capacity_frames = (uint16_t)fifo->get_fifo_capacity_frames();
+        request.watermark_frames = fifo->get_fifo_watermark_frames();
+        request.frames_read = fifo->get_fifo_frames_read();
+        request.frames_skipped = fifo->get_fifo_frames_skipped();
+        request.streaming = fifo_streaming[fifo_id];
+        return;
+    }
+
+    request.written = 0;
+
+    switch (request.mode) {
+    case FifoReadMode::DRAIN:
+        request.written = drain_fifo_to_file(fifo_id);
+        break;
+
+    case FifoReadMode::START_STREAM:
+        // Starts from an empty file and FIFO so the file is one continuous stream
+        filesystem_ptr->deleteFile(fifo_path(fifo_id).c_str());
+        fifo->flush_fifo();
+        fifo_streaming[fifo_id] = true;
+        break;
+
+    case FifoReadMode::STOP_STREAM:
+        request.written = drain_fifo_to_file(fifo_id);
+        fifo_streaming[fifo_id] = false;
+        break;
+    }
+}
+
+void ImuTask::update()
+{
+    if (fifo_request_pending.exchange(false, std::memory_order_acquire)) {
+        execute_fifo_request(fifo_request);
+        xSemaphoreGive(fifo_request_done);
+    }
+
+    for (size_t i = 0; i < fifos.size(); i++) {
+        if (fifo_streaming[i]) {
+            drain_fifo_to_file(i);
+        }
+    }
+}
+
+size_t ImuTask::drain_fifo_to_file(size_t fifo_id)
+{
+    String path = fifo_path(fifo_id);
+    size_t total = 0;
+
+    // Whole batches mean there may be more waiting
+    while (true) {
+        size_t count = fifos[fifo_id]->read_fifo(fifo_samples, FIFO_BATCH_SAMPLES);
+        if (count == 0) {
+            break;
+        }
+
+        if (!filesystem_ptr->appendFile(path.c_str(), (const uint8_t*)fifo_samples, count * sizeof(Sensor::ImuFifoSample))) {
+            break;
+        }
+        total += count;
+
+        if (count < FIFO_BATCH_SAMPLES) {
+            break;
+        }
+    }
+
+    return total;
+}
+
 bool ImuTask::check_ranges(vector<uint8_t>& data) {
 
     uint8_t accel_id = data[0];
@@ -160,19 +397,19 @@ bool ImuTask::check_ranges(vector<uint8_t>& data) {
     uint8_t mag_id = data[2];
 
     // Range checking for Accel, gyro, and mag
-    if (accel_id < 0 || accel_id > ImuTask::accels.size()) {
+    if (accel_id >= ImuTask::accels.size()) {
         String err = "accel ID '" + String(accel_id) + "' with maximum of " + String(ImuTask::accels.size()-1);
         DEBUGLN(err);
         send_telem_response(err.c_str());
         return false;
     }
-    if (gyro_id < 0 || gyro_id > ImuTask::gyros.size()) {
+    if (gyro_id >= ImuTask::gyros.size()) {
         String err = "gyro ID '" + String(gyro_id) + "' with maximum of " + String(ImuTask::gyros.size()-1);
         DEBUGLN(err);
         send_telem_response(err.c_str());
         return false;
     }
-    if (mag_id < 0 || mag_id > ImuTask::mags.size()) {
+    if (mag_id >= ImuTask::mags.size()) {
         String err = "mag ID '" + String(mag_id) + "' with maximum of " + String(ImuTask::mags.size()-1);
         DEBUGLN(err);
         send_telem_response(err.c_str());
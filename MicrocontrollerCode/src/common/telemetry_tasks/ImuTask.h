@@ -8,7 +8,11 @@
 #include "../drivers/sensor_bases/AccelerometerBase.h"
 #include "../drivers/sensor_bases/GyroscopeBase.h"
 #include "../drivers/sensor_bases/MagnetometerBase.h"
+#include "../drivers/sensor_bases/ImuFifoBase.h"
+#include "../os/filesystem.h"
+#include <atomic>
 #include <vector>
+#include <freertos/semphr.h>
 
 namespace Cesium {
 
@@ -24,13 +28,47 @@ private:
     static std::vector<Sensor::AccelerometerBase*> accels;
     static std::vector<Sensor::GyroscopeBase*> gyros;
     static std::vector<Sensor::MagnetometerBase*> mags;
+    static std::vector<Sensor::ImuFifoBase*> fifos;
+    static std::vector<bool> fifo_streaming;
+
+    static FileSystem* filesystem_ptr;
+
+    static constexpr size_t FIFO_BATCH_SAMPLES = 64;
+    static Sensor::ImuFifoSample fifo_samples[FIFO_BATCH_SAMPLES];
 
     static bool check_ranges(std::vector<uint8_t>& data);
+    static bool check_fifo_id(const std::vector<uint8_t>& data);
 public:
+
+    enum class FifoReadMode {
+        DRAIN = 0,          // Drain once to the file
+        START_STREAM = 1,   // Drain from update() until STOP_STREAM
+        STOP_STREAM = 2
+    };
+
+    // One FIFO command's hardware work. While the pipeline runs, the comms core hands it to update()
+    // on the acquisition core and waits, so the drivers are only ever touched from one core
+    struct FifoRequest {
+        bool status;            // Otherwise a FifoReadMode
+        FifoReadMode mode;
+        uint8_t fifo_id;
+
+        // Results
+        uint16_t frames;
+        uint16_t capacity_frames;
+        uint16_t watermark_frames;
+        uint32_t frames_read;
+        uint32_t frames_skipped;
+        bool streaming;
+        uint32_t written;
+    };
     
     static inline void add_accel(Sensor::AccelerometerBase* accel) {accels.push_back(accel);}
     static inline void add_gyro(Sensor::GyroscopeBase* gyro) {gyros.push_back(gyro);}
     static inline void add_mag(Sensor::MagnetometerBase* mag) {mags.push_back(mag);}
+    static inline void add_fifo(Sensor::ImuFifoBase* fifo) {fifos.push_back(fifo); fifo_streaming.push_back(false);}
+
+    static void attach_filesystem(FileSystem* filesystem) {ImuTask::filesystem_ptr = filesystem;};
 
     inline static void assign_broker(PacketBroker* broker) {ImuTask::broker = broker;};
 
@@ -40,6 +78,30 @@ public:
     static bool create_telem_packet(std::vector<uint8_t> data);
 
     static bool send_telem_response(const char* message);
+
+    // data = {fifo_id}. Replies with fill level, capacity, watermark and frame counters
+    static bool send_fifo_status(const std::vector<uint8_t>& data);
+
+    // data = {fifo_id, FifoReadMode}. Samples are appended to fifo_path() as packed ImuFifoSamples
+    static bool fifo_read(const std::vector<uint8_t>& data);
+
+    // Runs any waiting FIFO request, then appends every waiting frame of the streaming FIFOs to their files.
+    // Call periodically from the core that reads the IMUs (Pipeline::set_acquisition_callback)
+    static void update();
+
+    static String fifo_path(size_t fifo_id) {return "/imu_fifo_" + String(fifo_id) + ".bin";}
+
+private:
+    static constexpr uint32_t FIFO_REQUEST_TIMEOUT_MS = 500;
+
+    static FifoRequest fifo_request;
+    static std::atomic<bool> fifo_request_pending;
+    static SemaphoreHandle_t fifo_request_done;
+
+    // False if the acquisition core didn't get to it in time
+    static bool run_fifo_request(FifoRequest& request);
+    static void execute_fifo_request(FifoRequest& request);
+    static size_t drain_fifo_to_file(size_t fifo_id);
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "PowerTask.h"
+#include "SystemStatusTask.h"
+
+#include "../comms/serial_comms.h"
+#include "../os/instrumentation.h"
+#include <esp_timer.h>
+
+using namespace std;
+
+namespace Cesium {
+
+std::vector<Sensor::Ina233*> PowerTask::monitors{};
+std::vector<PowerTask::Rail> PowerTask::rails{};
+uint32_t PowerTask::last_poll_ms = 0;
+
+PowerCMD PowerTask::route_packet(BasePacket& packet) {
+    PROBE_SCOPE("PowerTask::route_packet");
+    PowerCMD command = (PowerCMD)packet.get_command();
+    switch(command) {
+    case PowerCMD::BATTERY_STATS:
+        DEBUGLN("BATTERY_STATS");
+        send_rail_stats(command, Rail::BATTERY);
+        break;
+
+    case PowerCMD::GSE_STATS:
+        DEBUGLN("GSE_STATS");
+        send_rail_stats(command, Rail::GSE);
+        break;
+
+    case PowerCMD::BUS_STATS:
+        DEBUGLN("BUS_STATS");
+        send_rail_stats(command, Rail::BUS);
+        break;
+
+    case PowerCMD::POWER_STATES: // TODO
+        DEBUGLN("POWER_STATES");
+        SystemStatusTask::send_not_implemented("POWER::POWER_STATES");
+        break;
+
+    case PowerCMD::BOARD_SWITCHES: // TODO
+        DEBUGLN("BOARD_SWITCHES");
+        SystemStatusTask::send_not_implemented("POWER::BOARD_SWITCHES");
+        break;
+
+    default:
+        DEBUGLN("Did not finish routing packet");
+        SystemStatusTask::send_nack("BAD COMMAND");
+        return PowerCMD(-1);
+    }
+
+    return command;
+}
+
+void PowerTask::update()
+{
+    uint32_t now_ms = millis();
+    if (now_ms - last_poll_ms < POLL_PERIOD_MS) {
+        return;
+    }
+    last_poll_ms = now_ms;
+
+    for (Sensor::Ina233* monitor : monitors) {
+        monitor->read();
+    }
+}
+
+void PowerTask::emit_response(PowerCMD command, vector<uint8_t>& response)
+{
+    BasePacket packet;
+    packet.configure((int)Topic::POWER, (int)command, response);
+    packet.packetize();
+
+    SerialComms::emit_packet(packet, SERIAL_UART);
+}
+
+/*
+BATTERY_STATS / GSE_STATS / BUS_STATS response (little-endian)
+- u8  rail
+- f32 bus voltage (V)
+- f32 current (mA)
+- f32 average power over the last window (mW)
+- f32 energy since setup (J)
+- f32 window length (s)
+- u32 conversions in the window
+- u32 age of the reading (ms)
+*/
+bool PowerTask::send_rail_stats(PowerCMD command, Rail rail)
+{
+    size_t i = 0;
+    while (i < rails.size() && rails[i] != rail) {
+        i++;
+    }
+    if (i == rails.size()) {
+        SystemStatusTask::send_nack("No monitor on this rail");
+        return false;
+    }
+
+    Sensor::PowerReading reading;
+    if (!monitors[i]->get_reading(reading)) {
+        SystemStatusTask::send_nack("Power monitor has no reading yet");
+        return false;
+    }
+
+    uint32_t age_ms = (esp_timer_get_time() - reading.time_us) / 1000;
+
+    vector<uint8_t> response;
+    response.push_back((uint8_t)rail);
+    append_bytes(response, reading.bus_voltage_V);
+    append_bytes(response, reading.current_mA);
+    append_bytes(response, reading.average_power_mW);
+    append_bytes(response, reading.energy_J);
+    append_bytes(response, reading.window_s);
+    append_bytes(response, reading.window_samples);
+    append_bytes(response, age_ms);
+
+    emit_response(command, response);
+    return true;
+}
+
+}
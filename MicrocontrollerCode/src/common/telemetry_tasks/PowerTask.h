@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include "../globals.h"
+#include "../comms/packet.h"
+#include "../comms/packet_schema.h"
+
+#include "../drivers/ina233.h"
+#include <vector>
+
+namespace Cesium {
+
+class PacketBroker; // Forward definition
+
+// Polls the power monitors at 1 Hz and serves PowerCMD from their newest readings.
+// Averages come from the INA233 energy accumulator, so spikes between polls are still counted
+class PowerTask {
+
+public:
+    enum class Rail : uint8_t {
+        BATTERY = 0,
+        GSE = 1,
+        BUS = 2
+    };
+
+    static constexpr uint32_t POLL_PERIOD_MS = 1000;
+
+private:
+    static PacketBroker* broker;
+
+    static std::vector<Sensor::Ina233*> monitors;
+    static std::vector<Rail> rails;
+    static uint32_t last_poll_ms;
+
+    static void emit_response(PowerCMD command, std::vector<uint8_t>& response);
+
+public:
+
+    static inline void add_monitor(Sensor::Ina233* monitor, Rail rail) {monitors.push_back(monitor); rails.push_back(rail);}
+
+    inline static void assign_broker(PacketBroker* broker) {PowerTask::broker = broker;};
+
+    // Returns PowerCMD for unit_testing verification
+    static PowerCMD route_packet(BasePacket& packet);
+
+    // Reads every monitor once POLL_PERIOD_MS has passed. Call periodically
+    static void update();
+
+    // Replies with the newest reading of the rail's monitor, NACKs if it has none yet
+    static bool send_rail_stats(PowerCMD command, Rail rail);
+};
+
+}
@@ -3,12 +3,19 @@
 
 
 #include "../comms/serial_comms.h"
+#include "../os/instrumentation.h"
+#include "../os/trace.h"
+#include "../os/spi_bus.h"
+#include "../os/sensor_manager.h"
 
 namespace Cesium {
 
+FileSystem* SystemStatusTask::filesystem_ptr = nullptr;
+
 
 SystemStatusCMD SystemStatusTask::route_packet(BasePacket &packet)
 {
+    PROBE_SCOPE("SystemStatusTask::route_packet");
     SystemStatusCMD command = (SystemStatusCMD)packet.get_command();
     switch(command) {
     case SystemStatusCMD::REQUEST_ACK:
@@ -33,14 +40,14 @@ SystemStatusCMD SystemStatusTask::route_packet(BasePacket &packet)
         send_not_implemented("SYSTEM_STATUS::RESET");
         break;
 
-    case SystemStatusCMD::RESET_STATS: // TODO
+    case SystemStatusCMD::RESET_STATS:
         DEBUGLN("RESET_STATS");
-        send_not_implemented("SYSTEM_STATUS::RESET_STATS");
+        reset_stats();
         break;
 
-    case SystemStatusCMD::MCU_STATS: // TODO
+    case SystemStatusCMD::MCU_STATS:
         DEBUGLN("MCU_STATS");
-        send_not_implemented("SYSTEM_STATUS::MCU_STATS");
+        send_mcu_stats();
         break;
 
     case SystemStatusCMD::SYSTEM_UPDATE: // TODO
@@ -52,6 +59,19 @@ SystemStatusCMD SystemStatusTask::route_packet(BasePacket &packet)
     DEBUGLN("SUM");
         send_sum(packet);
         break;
+
+    case SystemStatusCMD::TRACE_DUMP: {
+        DEBUGLN("TRACE_DUMP");
+
+        // First data byte selects the destination, 0 (or no data) = serial, 1 = file
+        bool to_file = packet.get_data_length() > 0 && packet.get_data()[0] == 1;
+        if (send_trace_dump(to_file)) {
+            if (to_file) send_ack(TRACE_PATH);
+        } else {
+            send_nack("TRACE_DUMP");
+        }
+        break;
+        }
     default:
         DEBUGLN("Did not finish routing packet");
         SystemStatusTask::send_nack("BAD COMMAND");
@@ -99,6 +119,92 @@ void SystemStatusTask::send_sum(BasePacket &packet)
     DEBUGLN("Emitted SUM Packet");
 }
 
+void SystemStatusTask::send_mcu_stats()
+{
+    BasePacket packet;
+    std::vector<uint8_t> data = Instrumentation::system_record();
+    packet.configure((size_t)Topic::SYSTEM_STATUS, (size_t)SystemStatusCMD::MCU_STATS, data);
+    packet.packetize();
+
+    SerialComms::emit_packet(packet, SERIAL_UART);
+
+    for (size_t i = 0; i < Instrumentation::get_probe_count(); i++) {
+        BasePacket probe_packet;
+        std::vector<uint8_t> probe_data = Instrumentation::probe_record(i);
+        probe_packet.configure((size_t)Topic::SYSTEM_STATUS, (size_t)SystemStatusCMD::MCU_STATS, probe_data);
+        probe_packet.packetize();
+
+        SerialComms::emit_packet(probe_packet, SERIAL_UART);
+    }
+
+    for (size_t i = 0; i < SpiBus::get_bus_count(); i++) {
+        BasePacket bus_packet;
+        std::vector<uint8_t> bus_data = SpiBus::get_bus(i)->stats_record();
+        bus_packet.configure((size_t)Topic::SYSTEM_STATUS, (size_t)SystemStatusCMD::MCU_STATS, bus_data);
+        bus_packet.packetize();
+
+        SerialComms::emit_packet(bus_packet, SERIAL_UART);
+    }
+
+    if (SensorManager::get_sensor_count() > 0) {
+        BasePacket sensor_packet;
+        std::vector<uint8_t> sensor_data = SensorManager::stats_record();
+        sensor_packet.configure((size_t)Topic::SYSTEM_STATUS, (size_t)SystemStatusCMD::MCU_STATS, sensor_data);
+        sensor_packet.packetize();
+
+        SerialComms::emit_packet(sensor_packet, SERIAL_UART);
+    }
+    DEBUGLN("Emitted MCU_STATS Packets");
+}
+
+void SystemStatusTask::reset_stats()
+{
+    Instrumentation::reset();
+    for (size_t i = 0; i < SpiBus::get_bus_count(); i++) {
+        SpiBus::get_bus(i)->reset_stats();
+    }
+    SensorManager::reset_stats();
+    send_ack("RESET_STATS");
+}
+
+bool SystemStatusTask::send_trace_dump(bool to_file)
+{
+    bool success = true;
+
+    Trace::freeze();
+
+    if (to_file) {
+        success = Trace::write_file(filesystem_ptr, TRACE_PATH);
+    } else {
+        std::vector<std::vector<uint8_t>> records;
+        records.push_back(Trace::header_record());
+
+        for (auto& record : Trace::name_records()) {
+            records.push_back(record);
+        }
+        for (size_t core = 0; core < 2; core++) {
+            for (auto& record : Trace::event_records(core)) {
+                records.push_back(record);
+            }
+        }
+        records.push_back(Trace::end_record());
+
+        for (auto& record : records) {
+            BasePacket packet;
+            packet.configure((size_t)Topic::SYSTEM_STATUS, (size_t)SystemStatusCMD::TRACE_DUMP, record);
+            packet.packetize();
+
+            SerialComms::emit_packet(packet, SERIAL_UART);
+        }
+        DEBUGLN("Emitted TRACE_DUMP Packets");
+    }
+
+    Trace::clear();
+    Trace::resume();
+
+    return success;
+}
+
 void SystemStatusTask::send_not_implemented(const char* message) {
     BasePacket packet;
     std::vector<uint8_t> data(message, message + strlen(message));
@@ -2,6 +2,7 @@
 
 #include "../comms/packet.h"
 #include "../comms/packet_schema.h"
+#include "../os/filesystem.h"
 
 namespace Cesium {
 
@@ -11,11 +12,15 @@ class SystemStatusTask {
     
 private:
     static PacketBroker* broker;
+    static FileSystem* filesystem_ptr;
 
 public:
     
     inline static void assign_broker(PacketBroker* broker) {SystemStatusTask::broker = broker;};
 
+    // Needed for TRACE_DUMP to a file
+    static void attach_filesystem(FileSystem* filesystem) {SystemStatusTask::filesystem_ptr = filesystem;};
+
     // Returns SystemStatusCMD for unit_testing to verify packet routing for commands that don't do anything (ACK, NACK)
     static SystemStatusCMD route_packet(BasePacket& packet);
 
@@ -25,6 +30,14 @@ public:
 
     static void send_sum(BasePacket& packet);
 
+    // One SYSTEM record packet followed by one PROBE record packet per probe
+    static void send_mcu_stats();
+    static void reset_stats();
+
+    // Freezes the trace ring, dumps it over serial (HEADER, NAMES, EVENTS..., END packets) or to TRACE_PATH, then clears and resumes it
+    static bool send_trace_dump(bool to_file);
+    static constexpr const char* TRACE_PATH = "/trace.bin";
+
     static void send_not_implemented(const char* message = "");
 
     
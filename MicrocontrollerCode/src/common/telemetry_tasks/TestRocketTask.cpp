@@ -3,6 +3,7 @@
 
 #include "../comms/serial_comms.h"
 #include "../math/vector.h"
+#include "../os/instrumentation.h"
 
 using namespace std;
 
@@ -28,6 +29,7 @@ array<Frame, 7> TestRocketTask::frames{};
 array<Packet, 3> TestRocketTask::packets{};
 
 TestRocketCMD TestRocketTask::route_packet(BasePacket& packet) {
+    PROBE_SCOPE("TestRocketTask::route_packet");
     TestRocketCMD command = (TestRocketCMD)packet.get_command();
     switch(command) {
     case TestRocketCMD::CONFIGURE:
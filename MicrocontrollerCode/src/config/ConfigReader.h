@@ -1,19 +1,17 @@
-//TODO: Make config reader
+#pragma once
+
 #include <ArduinoJson.h>
 #include "all_configs.h"
-#include <unordered_map>
+#include "../common/globals.h"
 #include "../common/math/vector.h"
+#include "../common/drivers/sensor_bases/Calibration.h"
 
 namespace Cesium {
 namespace File {
 
-// TODO: unit test
-
 // Read in document to JsonDocument object
 
-bool json_open(const char* config_name, JsonDocument& doc) {
-    
-    const size_t json_size = strlen(config_name);
+inline bool json_open(const char* config_name, JsonDocument& doc) {
 
     DeserializationError error = deserializeJson(doc, config_name);
 
@@ -27,43 +25,74 @@ bool json_open(const char* config_name, JsonDocument& doc) {
 }
 
 template <typename T>
-bool json_extract(JsonDocument doc, const char* name, T& value) {
+bool json_extract(const JsonDocument& doc, const char* name, T& value) {
 
-    // RETURN_FALSE_IF_FALSE(doc[name].is<T>()); 
+    RETURN_FALSE_IF_FALSE(doc[name].is<T>());
 
-    // value = doc[name].as<T>();
+    value = doc[name].as<T>();
     return true;
 }
 
-template <typename T, int rows, int cols>
-bool json_extract(JsonDocument doc, const char* name, Matrix<T, rows, cols>& value) {
-    // JsonObject json_obj = doc.as<JsonObject>();
-
-    // JsonArray matrix = json_obj[name].as<JsonArray>();
-
-    // // Return if number of rows doesn't match
-    // Serial.println(matrix.size());
-    // RETURN_FALSE_IF_FALSE(matrix.size() == rows);
-    // for (size_t i = 0; i < rows; i++) {
-        
-    //     // Return if not an array, or number of cols doesn't match
-    //     RETURN_FALSE_IF_FALSE(matrix[i].is<JsonArray>());
-    //     Serial.print(matrix[i].size());
-    //     RETURN_FALSE_IF_FALSE(matrix[i].size() == cols);
-    //     for (size_t j = 0; j < cols; j++) {
-    //         // Return if not datatype
-    //         RETURN_FALSE_IF_FALSE(matrix[i][j].is<T>());
-    //         value[i][j] = matrix[i][j].as<T>();
-    //     }
-    // }
+// Nested rows ([[1, 2], [3, 4]], or [[1], [2]] for a vector) or flat row-major ([1, 2, 3, 4], or [1, 2] for a vector)
+template <typename T, size_t rows, size_t cols>
+bool json_extract(const JsonDocument& doc, const char* name, Matrix<T, rows, cols>& value) {
+
+    JsonArrayConst matrix = doc[name].as<JsonArrayConst>();
+    RETURN_FALSE_IF_FALSE(!matrix.isNull());
+
+    if (matrix.size() == rows * cols && !matrix[0].is<JsonArrayConst>()) {
+        for (size_t i = 0; i < rows * cols; i++) {
+            RETURN_FALSE_IF_FALSE(matrix[i].is<T>());
+            value[i / cols][i % cols] = matrix[i].as<T>();
+        }
+        return true;
+    }
+
+    // Return if number of rows doesn't match
+    RETURN_FALSE_IF_FALSE(matrix.size() == rows);
+    for (size_t i = 0; i < rows; i++) {
+
+        // Return if not an array, or number of cols doesn't match
+        RETURN_FALSE_IF_FALSE(matrix[i].is<JsonArrayConst>());
+        RETURN_FALSE_IF_FALSE(matrix[i].size() == cols);
+        for (size_t j = 0; j < cols; j++) {
+            // Return if not datatype
+            RETURN_FALSE_IF_FALSE(matrix[i][j].is<T>());
+            value[i][j] = matrix[i][j].as<T>();
+        }
+    }
 
     return true;
 }
 
-// template <typename T, int rows>
-// bool json_extract(JsonDocument doc, const char* name, Vector<T, rows>& value) {
-//     RETURN_FALSE_IF_FALSE(json_extract(doc, name, value));
-// }
+// Sensor mounting, "body_to_sensor" (nested) or "transformation_matrix" (flat). Either one maps body vectors into the sensor frame
+inline bool json_extract_body_to_sensor(const JsonDocument& doc, Matrix3<float>& body_to_sensor) {
+    return json_extract(doc, "body_to_sensor", body_to_sensor) || json_extract(doc, "transformation_matrix", body_to_sensor);
 }
+
+// "<prefix>_bias" is required, "<prefix>_scale" (3) and "<prefix>_misalignment" (3x3) default to none.
+// Bias is in the sensor frame and output units, e.g. "acceleration_bias" in m/s2
+inline bool json_extract_calibration(const JsonDocument& doc, const char* prefix, const Matrix3<float>& sensor_to_body,
+                                     Sensor::Calibration3& calibration) {
+    String key = String(prefix) + "_bias";
+    Vector3<float> bias;
+    RETURN_FALSE_IF_FALSE(json_extract(doc, key.c_str(), bias));
+
+    Vector3<float> scale = {{{1}, {1}, {1}}};
+    key = String(prefix) + "_scale";
+    if (doc[key.c_str()].is<JsonArrayConst>()) {
+        RETURN_FALSE_IF_FALSE(json_extract(doc, key.c_str(), scale));
+    }
+
+    Matrix3<float> misalignment = {{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}};
+    key = String(prefix) + "_misalignment";
+    if (doc[key.c_str()].is<JsonArrayConst>()) {
+        RETURN_FALSE_IF_FALSE(json_extract(doc, key.c_str(), misalignment));
+    }
+
+    calibration = Sensor::Calibration3(sensor_to_body, misalignment, scale, bias);
+    return true;
 }
 
+} // namespace File
+} // namespace Cesium
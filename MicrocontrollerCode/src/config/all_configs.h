@@ -9,11 +9,10 @@ const char imu_1_config[] = R"(
 {
     "acceleration_bias": [0.01, -0.02, 0.03],
     "gyroscope_bias": [0.001, -0.002, 0.003],
-    "magnetometer_bias": [0.001, -0.002, 0.003],
-    "body_to_sensor": [
-        [1.0, 0.0, 0.0],
-        [0.0, 1.0, 0.0],
-        [0.0, 0, 1.0]
+    "transformation_matrix": [
+        0.0, 1.0, 0.0,
+        0.0, 0.0, -1.0,
+        -1.0, 0.0, 0.0
         ],
     "name": "IMU1"
 }
@@ -53,12 +52,13 @@ const char imu_2_config[] = R"(
 {
     "acceleration_bias": [0.01, -0.02, 0.03],
     "gyroscope_bias": [0.001, -0.002, 0.003],
-    "transformation_matrix": [
-        1.0, 0.0, 0.0,
-        0.0, 1.0, 0.0,
-        0.0, 0.0, 1.0
+    "magnetometer_bias": [0.001, -0.002, 0.003],
+    "body_to_sensor": [
+        [0.0, 1.0, 0.0],
+        [0.0, 0.0, 1.0],
+        [1.0, 0.0, 0.0]
         ],
-    "name": "leia"
+    "name": "IMU2"
 }
 )";
 
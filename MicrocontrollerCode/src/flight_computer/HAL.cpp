@@ -4,6 +4,7 @@ namespace Cesium {
 
     SPIClass hspi(HSPI);
     SPIClass vspi(VSPI);
+    SpiBus vspi_bus(VSPI_HOST, VSCK, VMISO, VMOSI);
     CanBus can_bus(CAN_RX, CAN_TX);
     FileSystem filesystem;
     Sensor::Ms5607 altimeter2(ALTIMETER2_CS, &vspi);
@@ -26,11 +27,22 @@ namespace Cesium {
         // digitalWrite(TRANSMITTER_CS, HIGH);
     }
 
-    void init_interfaces() {
+    bool init_interfaces() {
         hspi.begin(HSCK, HMISO, HMOSI);
-        vspi.begin(VSCK, VMISO, VMOSI);
         can_bus.setup();
-    }   
+
+        // Every VSPI device goes through the IDF driver, vspi itself is only begun if that fails,
+        // so the sensors can still be read through it
+        if (!vspi_bus.begin()) {
+            vspi.begin(VSCK, VMISO, VMOSI);
+            return false;
+        }
+        RETURN_FALSE_IF_FALSE(imu1.attach_spi_bus(&vspi_bus));
+        RETURN_FALSE_IF_FALSE(imu2.attach_spi_bus(&vspi_bus));
+        RETURN_FALSE_IF_FALSE(altimeter2.attach_spi_bus(&vspi_bus));
+
+        return true;
+    }
 
     void init_sensors() {
         imu1.setup();
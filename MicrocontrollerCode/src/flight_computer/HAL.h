@@ -8,11 +8,16 @@
 #include "../common/globals.h"
 #include "../common/os/filesystem.h"
 #include "../common/comms/CanBus.h"
+#include "../common/os/spi_bus.h"
 
+#ifdef SIL
+#include "../common/drivers/replay/ReplaySensors.h"
+#else
 #include "../common/drivers/Icm20948.h"
 #include "../common/drivers/Ms5607.h"
 #include "../common/drivers/Bmi323.h"
 #include "../common/drivers/Bmp388.h"
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //                                            Variables                                                           //
@@ -91,10 +96,18 @@ namespace Cesium {
     ////////////////////////////////////////////////////////////
 
     // Objects
+    extern SpiBus vspi_bus;
     extern FileSystem filesystem;
+#ifdef SIL
+    // Replayed from a flight's pipeline logs, see HAL_sil.cpp
+    extern Sensor::ReplayBarometer altimeter2;
+    extern Sensor::ReplayImu imu2;
+    extern Sensor::ReplayImu imu1;
+#else
     extern Sensor::Ms5607 altimeter2;
     extern Sensor::Icm20948 imu2;
     extern Sensor::Bmi323 imu1;
+#endif
 
     ////////////////////////////////////////////////////////////
     //                     Functions                          //
@@ -102,7 +115,8 @@ namespace Cesium {
 
     void init_cs_pins();
 
-    void init_interfaces();
+    // False if a bus or a device on it failed to start
+    bool init_interfaces();
 
     void init_sensors();
     
@@ -0,0 +1,79 @@
+#include "HAL.h"
+#include <sil.h>
+
+#include <stdio.h>
+#include <string>
+
+// HAL.cpp for the SIL build. Same objects, but the sensors replay logs from Sil::options.replay_dir
+
+namespace Cesium {
+
+    SPIClass hspi(HSPI);
+    SPIClass vspi(VSPI);
+    SpiBus vspi_bus(VSPI_HOST, VSCK, VMISO, VMOSI);
+    CanBus can_bus(CAN_RX, CAN_TX);
+    FileSystem filesystem;
+    Sensor::ReplayBarometer altimeter2(0);
+    Sensor::ReplayImu imu2(Sensor::ReplayImu::Format::PIPELINE, 1);
+    Sensor::ReplayImu imu1(Sensor::ReplayImu::Format::PIPELINE, 0);
+
+    static bool open_log(Sensor::ReplaySource& source, const char* file_name)
+    {
+        std::string path = std::string(Sil::options.replay_dir) + "/" + file_name;
+        if (!source.open(path.c_str())) {
+            fprintf(stderr, "SIL: could not replay %s\n", path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    void init_cs_pins() {
+        pinMode(IMU1_CS, OUTPUT);
+        pinMode(IMU2_CS, OUTPUT);
+        pinMode(ALTIMETER1_CS, OUTPUT);
+        pinMode(ALTIMETER2_CS, OUTPUT);
+        pinMode(SD_CS, OUTPUT);
+
+        digitalWrite(IMU1_CS, HIGH);
+        digitalWrite(IMU2_CS, HIGH);
+        digitalWrite(ALTIMETER1_CS, HIGH);
+        digitalWrite(ALTIMETER2_CS, HIGH);
+        digitalWrite(SD_CS, HIGH);
+    }
+
+    bool init_interfaces() {
+        hspi.begin(HSCK, HMISO, HMOSI);
+        can_bus.setup();
+        RETURN_FALSE_IF_FALSE(vspi_bus.begin());
+
+        return true;
+    }
+
+    void init_sensors() {
+        if (Sil::options.replay_dir == nullptr) {
+            fprintf(stderr, "SIL: no --replay directory, the sensors have no data\n");
+            return;
+        }
+
+        // One pipeline log feeds both IMUs, split by imu_id
+        open_log(imu1.get_source(), "log_imu.bin");
+        open_log(imu2.get_source(), "log_imu.bin");
+        open_log(altimeter2.get_source(), "log_baro.bin");
+
+        // The flight starts now. Sil::Clock already applies --speed
+        uint64_t start_us = UINT64_MAX;
+        for (Sensor::ReplaySource* source : {&imu1.get_source(), &imu2.get_source(), &altimeter2.get_source()}) {
+            // 0 when a log has none of this sensor's records
+            uint64_t first_us = source->first_time_us();
+            if (first_us > 0) {
+                start_us = min(start_us, first_us);
+            }
+        }
+        Sensor::ReplayClock::start(start_us == UINT64_MAX ? 0 : start_us);
+
+        imu1.setup();
+        imu2.setup();
+        altimeter2.setup();
+    }
+
+}
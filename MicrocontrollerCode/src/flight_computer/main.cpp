@@ -6,12 +6,17 @@
 
 
 #include "../common/telemetry_tasks/ImuTask.h"
+#include "../common/telemetry_tasks/SystemStatusTask.h"
 #include "../common/telemetry_tasks/FilesystemTask.h"
+#include "../common/telemetry_tasks/PowerTask.h"
 #include "../common/telemetry_tasks/TestRocketTask.h"
 
 
 
 #include "../common/math/quaternion.h"
+#include "../common/os/pipeline.h"
+#include "../common/gnc/FusedImu.h"
+#include "../config/all_configs.h"
 
 #include "HAL.h"
 // using namespace Cesium::Config;
@@ -19,15 +24,23 @@
 using namespace Cesium;
 using namespace std;
 
-Quaternion<float> ICM2Body;
-Quaternion<float> BMI2Body;
+// Datasheet noise densities squared. Both units are filtered alike, so only their ratio matters
+constexpr float BMI_ACCEL_VARIANCE = (180e-6f * 9.81f) * (180e-6f * 9.81f);
+constexpr float BMI_GYRO_VARIANCE = (0.008f * DEG2RAD) * (0.008f * DEG2RAD);
+constexpr float ICM_ACCEL_VARIANCE = (230e-6f * 9.81f) * (230e-6f * 9.81f);
+constexpr float ICM_GYRO_VARIANCE = (0.015f * DEG2RAD) * (0.015f * DEG2RAD);
+
+Sensor::FusedImu fused_imu;
+
+void print_telemetry();
 
 void setup() {
     Serial.begin(115200);
     
     // Attaching Filesystem to FilesystemTask
-    filesystem.begin(true);
-    FilesystemTask::attach_filesystem(&filesystem);
+    Cesium::filesystem.begin(true);
+    FilesystemTask::attach_filesystem(&Cesium::filesystem);
+    SystemStatusTask::attach_filesystem(&Cesium::filesystem);
 
     // Adding IMUs to ImuTask
     ImuTask::add_accel(&imu1);
@@ -35,6 +48,9 @@ void setup() {
     ImuTask::add_gyro(&imu1);
     ImuTask::add_gyro(&imu2);
     ImuTask::add_mag(&imu2);
+    ImuTask::add_fifo(&imu1);
+    ImuTask::add_fifo(&imu2);
+    ImuTask::attach_filesystem(&Cesium::filesystem);
 
     // Adding sensors to GNC task
 
@@ -42,20 +58,27 @@ void setup() {
 
     init_cs_pins();
 
-    init_interfaces();
+    if (!init_interfaces()) {
+        Serial.println("Failed to initialize interfaces");
+    }
 
     init_sensors();
+
+    // 16 frames = 20 ms at 800 Hz
+    imu1.configure_fifo(16);
+    // ICM FIFO holds 22 frames = 220 ms at 100 Hz, drained every 20 ms by the acquisition callback
+    imu2.configure_fifo(10);
     
     
     
 
-    // Matrix3<float> R_ICM2Body = {{{0,1,0}, {0,0,-1}, {-1,0,0}}};
-    // Matrix3<float> R_ICM2Body = {{{0,0,-1}, {1,0,0}, {0,-1,0}}};
-    // Matrix3<float> R_ICM2Body = {{{0,1,0}, {0,0,1}, {1,0,0}}};
-    Matrix3<float> R_ICM2Body = {{{0,0,1}, {1,0,0}, {0,1,0}}};
-    Matrix3<float> R_BMI2Body = {{{0,0,-1}, {1,0,0}, {0,-1,0}}};
-    ICM2Body = quat_from_R(R_ICM2Body);
-    BMI2Body = quat_from_R(R_BMI2Body);
+    // Mounting and biases, so the drivers fill the body-frame outputs themselves
+    if (!imu1.configure(Config::imu_1_config)) {
+        Serial.println("Failed to configure IMU1");
+    }
+    if (!imu2.configure(Config::imu_2_config)) {
+        Serial.println("Failed to configure IMU2");
+    }
 
     // TestRocketTask::configure_frame_234(
     //     []() { return imu2.get_accel_mps2(); } ,
@@ -63,31 +86,46 @@ void setup() {
     // );
     // TestRocketTask::attach_CAN_obj(&can_bus);
 
+    // Acquisition on the APP core, comms/logging/telemetry on the PRO core
+    Pipeline::add_imu(&imu1, &imu1);
+    Pipeline::add_imu(&imu2, &imu2);
+
+    // Both IMUs voted and averaged in the body frame, IMU id 2
+    fused_imu.add_unit(&imu1, &imu1, BMI_ACCEL_VARIANCE, BMI_GYRO_VARIANCE);
+    fused_imu.add_unit(&imu2, &imu2, ICM_ACCEL_VARIANCE, ICM_GYRO_VARIANCE);
+    Pipeline::add_fused_imu(&fused_imu);
+    Pipeline::add_barometer(&altimeter2, 20);
+    Pipeline::attach_filesystem(&Cesium::filesystem);
+    Pipeline::set_telemetry_callback(print_telemetry, 100);
+    // FIFO commands and streams are run where the IMUs are read
+    Pipeline::set_acquisition_callback(ImuTask::update, 20);
+    if (!Pipeline::begin(800)) {
+        Serial.println("Failed to start the pipeline");
+    }
+
 }
 
 void loop() {
+    // Everything runs in the pipeline tasks
+    vTaskDelay(portMAX_DELAY);
+}
 
-    // if (Serial.available()) {
-    //     uint32_t time = millis();
-    //     digitalWrite(LED, HIGH);
-    //     SerialComms::process_uart();
-    //     // Serial.println(millis() - time);
-    // }
-    // else {
-    //     digitalWrite(LED, LOW);
-    // }
-    // delay(10);
-
-    altimeter2.read();
-    imu1.read();
-    imu2.read();
-
-    auto icm_result = quat_apply(ICM2Body, imu2.get_accel_mps2());
-    auto bmi_result = quat_apply(BMI2Body, imu1.get_accel_mps2());
-
-    Serial.println(altimeter2.get_altitude_m());
-    Serial.println(imu1.get_accel_mps2()[0][0]);
-    Serial.println(imu2.get_accel_mps2()[0][0]);
+// Runs on the comms core from the pipeline telemetry task
+void print_telemetry() {
+    PowerTask::update();
+
+    ImuSample bmi_sample, icm_sample;
+    BaroSample baro_sample;
+
+    if (Pipeline::latest_baro(0, baro_sample)) {
+        Serial.println(baro_sample.altitude_m);
+    }
+    if (Pipeline::latest_imu(0, bmi_sample)) {
+        Serial.println(bmi_sample.accel_mps2[0]);
+    }
+    if (Pipeline::latest_imu(1, icm_sample)) {
+        Serial.println(icm_sample.accel_mps2[0]);
+    }
     // auto result = quat_apply(quat_from_axis_rot<float>(90, {{1,0,0}}), imu2.get_accel_mps2());
     // Serial.print(String(icm_result[0][0],4) + " " + String(icm_result[0][1],4) + " " + String(icm_result[0][2],4) + ",");
     // Serial.println(String(bmi_result[0][0],4) + "," + String(bmi_result[0][1],4) + "," + String(bmi_result[0][2],4));
@@ -102,7 +140,6 @@ void loop() {
 
     // Serial.println(String(mat[0][0],7) + "," + String(mat[0][1],7) + "," + String(mat[0][2],7));
     // TestRocketTask::send_frames();
-    delay(100);
 }
 
 
@@ -9,6 +9,7 @@
 #include "common/drivers/Bmp388.h"
 
 #include "common/telemetry_tasks/ImuTask.h"
+#include "common/os/sensor_manager.h"
 
 // using namespace Cesium::Config;
 // using namespace Cesium::File;
@@ -66,6 +67,11 @@ void setup() {
     altimeter2.setup();
     altimeter1.setup();
 
+    // Each sensor at its own rate, IMUs first. The barometers pace their own conversions
+    SensorManager::add_sensor(&imu1, 1, 0);
+    SensorManager::add_sensor(&imu2, 10, 1);
+    SensorManager::add_sensor(&altimeter2, 20, 2, SensorManager::ReadMode::POLLED);
+    SensorManager::add_sensor(&altimeter1, 20, 3, SensorManager::ReadMode::POLLED);
 
     // Adding sensors to tasks
     // ImuTask::add_accel(&imu2);
@@ -84,9 +90,7 @@ void setup() {
 }
 
 void loop() {
-    altimeter2.read();
-    imu1.read();
-    imu2.read();
+    SensorManager::run();
 
     // Serial.println(100);
     // delay(1000);
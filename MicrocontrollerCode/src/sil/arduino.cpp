@@ -0,0 +1,385 @@
+#include <Arduino.h>
+#include <SPI.h>
+#include <Wire.h>
+#include <CAN.h>
+#include <sil.h>
+
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <stdarg.h>
+#include <stdio.h>
+
+EspClass ESP;
+SPIClass SPI(VSPI);
+TwoWire Wire(0);
+TwoWire Wire1(1);
+ESP32SJA1000Class CAN;
+
+////////////////////////////////////////////////////////////
+//                        String                          //
+////////////////////////////////////////////////////////////
+
+static std::string to_base(unsigned long long value, unsigned char base)
+{
+    if (base < 2 || base > 36) {
+        base = 10;
+    }
+
+    char digits[65];
+    size_t i = sizeof(digits);
+    do {
+        unsigned digit = value % base;
+        digits[--i] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value > 0);
+
+    return std::string(digits + i, sizeof(digits) - i);
+}
+
+// Negative numbers only get a sign in base 10, like itoa() on the ESP32
+static std::string to_base_signed(long long value, unsigned char base)
+{
+    if (value < 0 && base == 10) {
+        return "-" + to_base(-(unsigned long long)value, base);
+    }
+    return to_base((unsigned long long)value, base);
+}
+
+static std::string to_decimal(double value, unsigned char decimal_places)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimal_places, value);
+    return buffer;
+}
+
+String::String(unsigned char value, unsigned char base) : std::string(to_base(value, base)) {}
+String::String(int value, unsigned char base) : std::string(to_base_signed(value, base)) {}
+String::String(unsigned int value, unsigned char base) : std::string(to_base(value, base)) {}
+String::String(long value, unsigned char base) : std::string(to_base_signed(value, base)) {}
+String::String(unsigned long value, unsigned char base) : std::string(to_base(value, base)) {}
+String::String(long long value, unsigned char base) : std::string(to_base_signed(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : std::string(to_base(value, base)) {}
+String::String(float value, unsigned char decimal_places) : std::string(to_decimal(value, decimal_places)) {}
+String::String(double value, unsigned char decimal_places) : std::string(to_decimal(value, decimal_places)) {}
+
+int String::indexOf(char c, unsigned int from) const
+{
+    size_t index = find(c, from);
+    return index == npos ? -1 : (int)index;
+}
+
+int String::indexOf(const String &str, unsigned int from) const
+{
+    size_t index = find(str, from);
+    return index == npos ? -1 : (int)index;
+}
+
+String String::substring(unsigned int from) const
+{
+    return from < size() ? String(substr(from)) : String();
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > to) {
+        std::swap(from, to);
+    }
+    return from < size() ? String(substr(from, to - from)) : String();
+}
+
+void String::trim()
+{
+    size_t first = find_first_not_of(" \t\r\n\f\v");
+    if (first == npos) {
+        clear();
+        return;
+    }
+    size_t last = find_last_not_of(" \t\r\n\f\v");
+    assign(substr(first, last - first + 1));
+}
+
+long String::toInt() const
+{
+    return atol(c_str());
+}
+
+float String::toFloat() const
+{
+    return (float)atof(c_str());
+}
+
+double String::toDouble() const
+{
+    return atof(c_str());
+}
+
+////////////////////////////////////////////////////////////
+//                        Print                           //
+////////////////////////////////////////////////////////////
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    if (len < 0) {
+        return 0;
+    }
+    if ((size_t)len < sizeof(buffer)) {
+        return write((const uint8_t*)buffer, len);
+    }
+
+    std::string long_buffer(len + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&long_buffer[0], long_buffer.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)long_buffer.data(), len);
+}
+
+// Print uses upper-case digits, unlike String
+size_t Print::print_number(unsigned long long value, uint8_t base)
+{
+    std::string digits = to_base(value, base);
+    for (char& c : digits) {
+        c = toupper(c);
+    }
+    return write(digits.c_str(), digits.size());
+}
+
+size_t Print::print_float(double value, uint8_t digits)
+{
+    if (isnan(value)) {
+        return print("nan");
+    }
+    if (isinf(value)) {
+        return print("inf");
+    }
+    if (value > 4294967040.0 || value < -4294967040.0) {
+        return print("ovf");
+    }
+    return print(to_decimal(value, digits).c_str());
+}
+
+size_t Print::print(const __FlashStringHelper *str) {return print(reinterpret_cast<const char*>(str));}
+size_t Print::print(const String &str) {return write(str.c_str(), str.length());}
+size_t Print::print(const char str[]) {return write(str);}
+size_t Print::print(char c) {return write((uint8_t)c);}
+size_t Print::print(unsigned char value, int base) {return print((unsigned long long)value, base);}
+size_t Print::print(int value, int base) {return print((long long)value, base);}
+size_t Print::print(unsigned int value, int base) {return print((unsigned long long)value, base);}
+size_t Print::print(long value, int base) {return print((long long)value, base);}
+size_t Print::print(unsigned long value, int base) {return print((unsigned long long)value, base);}
+
+size_t Print::print(long long value, int base)
+{
+    // Other bases print the two's complement, like the core
+    if (base == 10 && value < 0) {
+        return print('-') + print_number(-(unsigned long long)value, 10);
+    }
+    if (base == 0) {
+        return write((uint8_t)value);
+    }
+    return print_number((unsigned long long)value, base);
+}
+
+size_t Print::print(unsigned long long value, int base)
+{
+    if (base == 0) {
+        return write((uint8_t)value);
+    }
+    return print_number(value, base);
+}
+
+size_t Print::print(double value, int digits) {return print_float(value, digits);}
+
+size_t Print::println() {return write("\r\n");}
+
+////////////////////////////////////////////////////////////
+//                        Stream                          //
+////////////////////////////////////////////////////////////
+
+// Timeouts are firmware time, so a sped-up SIL does not wait longer than the ESP32 would
+int Stream::timed_read()
+{
+    auto deadline = std::chrono::steady_clock::now()
+                    + std::chrono::microseconds(Sil::Clock::wall_timeout_us((uint64_t)timeout_ms * 1000));
+    do {
+        if (available() > 0) {
+            return read();
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    } while (std::chrono::steady_clock::now() < deadline);
+
+    return -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+    size_t count = 0;
+    while (count < length) {
+        int c = timed_read();
+        if (c < 0) {
+            break;
+        }
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+String Stream::readString()
+{
+    String result;
+    int c;
+    while ((c = timed_read()) >= 0) {
+        result += (char)c;
+    }
+    return result;
+}
+
+String Stream::readStringUntil(char terminator)
+{
+    String result;
+    int c;
+    while ((c = timed_read()) >= 0 && c != terminator) {
+        result += (char)c;
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////
+//                        Pins                            //
+////////////////////////////////////////////////////////////
+
+namespace {
+
+constexpr uint8_t PIN_COUNT = 40;
+
+struct PinInterrupt {
+    void (*handler)(void) = nullptr;
+    void (*handler_arg)(void*) = nullptr;
+    void* arg = nullptr;
+};
+
+std::mutex pin_lock;
+uint8_t pin_levels[PIN_COUNT] = {0};
+PinInterrupt pin_interrupts[PIN_COUNT];
+
+} // namespace
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin < PIN_COUNT) {
+        pin_levels[pin] = value ? HIGH : LOW;
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    return pin < PIN_COUNT ? pin_levels[pin] : LOW;
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+    return 0;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode)
+{
+    std::lock_guard<std::mutex> guard(pin_lock);
+    if (pin < PIN_COUNT) {
+        pin_interrupts[pin] = PinInterrupt{};
+        pin_interrupts[pin].handler = handler;
+    }
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void *arg, int mode)
+{
+    std::lock_guard<std::mutex> guard(pin_lock);
+    if (pin < PIN_COUNT) {
+        pin_interrupts[pin] = PinInterrupt{};
+        pin_interrupts[pin].handler_arg = handler;
+        pin_interrupts[pin].arg = arg;
+    }
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    std::lock_guard<std::mutex> guard(pin_lock);
+    if (pin < PIN_COUNT) {
+        pin_interrupts[pin] = PinInterrupt{};
+    }
+}
+
+void Sil::raise_pin(uint8_t pin)
+{
+    if (pin >= PIN_COUNT) {
+        return;
+    }
+
+    PinInterrupt interrupt;
+    {
+        std::lock_guard<std::mutex> guard(pin_lock);
+        interrupt = pin_interrupts[pin];
+    }
+
+    if (interrupt.handler != nullptr) {
+        interrupt.handler();
+    }
+    else if (interrupt.handler_arg != nullptr) {
+        interrupt.handler_arg(interrupt.arg);
+    }
+}
+
+////////////////////////////////////////////////////////////
+//                        Chip                            //
+////////////////////////////////////////////////////////////
+
+uint32_t EspClass::getCycleCount()
+{
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return (uint32_t)(ns * getCpuFreqMHz() / 1000);
+}
+
+void EspClass::restart()
+{
+    fprintf(stderr, "ESP.restart() called, exiting\n");
+    exit(0);
+}
+
+static std::mt19937& generator()
+{
+    static std::mt19937 gen;
+    return gen;
+}
+
+long random(long max)
+{
+    return max <= 0 ? 0 : (long)(generator()() % (unsigned long)max);
+}
+
+long random(long min, long max)
+{
+    return min >= max ? min : min + random(max - min);
+}
+
+void randomSeed(unsigned long seed)
+{
+    generator().seed(seed);
+}
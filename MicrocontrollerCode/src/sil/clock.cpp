@@ -0,0 +1,166 @@
+#include <sil.h>
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace std::chrono;
+
+namespace Sil {
+
+namespace {
+
+// Function-local so millis() works from other static constructors
+struct ClockState {
+    std::mutex lock;
+    std::condition_variable changed;
+    Clock::Mode mode = Clock::Mode::REAL_TIME;
+    float speed = 1.0f;
+    uint64_t base_us = 0;                               // Firmware time at base_wall
+    steady_clock::time_point base_wall = steady_clock::now();
+};
+
+ClockState& state()
+{
+    static ClockState clock_state;
+    return clock_state;
+}
+
+uint64_t now_locked(ClockState& s)
+{
+    if (s.mode == Clock::Mode::STEPPED) {
+        return s.base_us;
+    }
+    int64_t wall_ns = duration_cast<nanoseconds>(steady_clock::now() - s.base_wall).count();
+    return s.base_us + (uint64_t)(wall_ns * (double)s.speed / 1000.0);
+}
+
+// Restarts the wall reference, so speed and mode changes never make time jump
+void rebase_locked(ClockState& s)
+{
+    s.base_us = now_locked(s);
+    s.base_wall = steady_clock::now();
+}
+
+} // namespace
+
+uint64_t Clock::now_us()
+{
+    ClockState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+    return now_locked(s);
+}
+
+void Clock::set_speed(float speed)
+{
+    ClockState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+    rebase_locked(s);
+    s.speed = speed > 0 ? speed : 1.0f;
+    s.changed.notify_all();
+}
+
+float Clock::get_speed()
+{
+    ClockState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+    return s.speed;
+}
+
+void Clock::set_mode(Mode mode)
+{
+    ClockState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+    rebase_locked(s);
+    s.mode = mode;
+    s.changed.notify_all();
+}
+
+Clock::Mode Clock::get_mode()
+{
+    ClockState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+    return s.mode;
+}
+
+void Clock::advance_us(uint64_t us)
+{
+    ClockState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+    if (s.mode == Mode::STEPPED) {
+        s.base_us += us;
+        s.changed.notify_all();
+    }
+}
+
+void Clock::sleep_until_us(uint64_t time_us)
+{
+    ClockState& s = state();
+    std::unique_lock<std::mutex> guard(s.lock);
+
+    while (true) {
+        uint64_t now_us = now_locked(s);
+        if (now_us >= time_us) {
+            return;
+        }
+
+        if (s.mode == Mode::STEPPED) {
+            s.changed.wait(guard);
+            continue;
+        }
+
+        // At most a second at a time, so portMAX_DELAY waits cannot overflow the wall time
+        double wall_us = (time_us - now_us) / (double)s.speed;
+        s.changed.wait_for(guard, microseconds((int64_t)std::min(wall_us, 1e6) + 1));
+    }
+}
+
+uint64_t Clock::wall_timeout_us(uint64_t us)
+{
+    ClockState& s = state();
+    std::lock_guard<std::mutex> guard(s.lock);
+    if (s.mode == Mode::STEPPED) {
+        return us;
+    }
+    return (uint64_t)(us / (double)s.speed);
+}
+
+} // namespace Sil
+
+////////////////////////////////////////////////////////////
+//                     Arduino time                       //
+////////////////////////////////////////////////////////////
+
+// 32-bit like the ESP32, so wraparound behaves the same
+unsigned long millis()
+{
+    return (uint32_t)(Sil::Clock::now_us() / 1000);
+}
+
+unsigned long micros()
+{
+    return (uint32_t)Sil::Clock::now_us();
+}
+
+void delay(uint32_t ms)
+{
+    Sil::Clock::sleep_until_us(Sil::Clock::now_us() + (uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    Sil::Clock::sleep_until_us(Sil::Clock::now_us() + us);
+}
+
+void yield()
+{
+    std::this_thread::yield();
+}
+
+int64_t esp_timer_get_time()
+{
+    return (int64_t)Sil::Clock::now_us();
+}
@@ -0,0 +1,108 @@
+#include <esp_timer.h>
+#include <sil.h>
+#include "sil_os.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct SilTimer {
+    esp_timer_create_args_t args;
+
+    std::mutex lock;
+    std::condition_variable changed;
+    bool armed = false;
+    uint64_t due_us = 0;
+    uint64_t period_us = 0;         // 0 for one-shot
+    uint32_t generation = 0;        // Bumped by every start and stop, so a stale wait does not fire
+};
+
+// One thread per timer, standing in for the esp_timer task on core 0
+static void timer_thread(SilTimer* timer)
+{
+    sil_adopt_thread("esp_timer", 0, 4096);
+
+    while (true) {
+        std::unique_lock<std::mutex> guard(timer->lock);
+        timer->changed.wait(guard, [timer]() {return timer->armed;});
+        uint64_t due_us = timer->due_us;
+        uint32_t generation = timer->generation;
+        guard.unlock();
+
+        Sil::Clock::sleep_until_us(due_us);
+
+        guard.lock();
+        if (!timer->armed || timer->generation != generation) {
+            continue;
+        }
+
+        if (timer->period_us == 0) {
+            timer->armed = false;
+        }
+        else {
+            // Periods run back to back after a stall unless told to skip them, like the IDF
+            timer->due_us += timer->period_us;
+            uint64_t now_us = Sil::Clock::now_us();
+            if (timer->args.skip_unhandled_events && timer->due_us <= now_us) {
+                timer->due_us = now_us + timer->period_us;
+            }
+        }
+        guard.unlock();
+
+        timer->args.callback(timer->args.arg);
+    }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+    if (args == nullptr || args->callback == nullptr || handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    SilTimer* timer = new SilTimer;
+    timer->args = *args;
+    std::thread(timer_thread, timer).detach();
+
+    *handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t start_timer(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+    std::lock_guard<std::mutex> guard(timer->lock);
+    if (timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    timer->armed = true;
+    timer->due_us = Sil::Clock::now_us() + timeout_us;
+    timer->period_us = period_us;
+    timer->generation++;
+    timer->changed.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return start_timer(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if (period_us == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return start_timer(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    std::lock_guard<std::mutex> guard(timer->lock);
+    if (!timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    timer->armed = false;
+    timer->generation++;
+    return ESP_OK;
+}
@@ -0,0 +1,299 @@
+#include <Arduino.h>
+#include <freertos/semphr.h>
+#include <sil.h>
+#include "sil_os.h"
+#include "../common/globals.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct SilTask {
+    std::string name;
+    BaseType_t core_id;
+    uint32_t stack_depth;
+
+    std::mutex lock;
+    std::condition_variable notified;
+    uint32_t notify_value = 0;
+    bool notify_pending = false;
+};
+
+struct SilSemaphore {
+    std::mutex lock;
+    std::condition_variable given;
+    UBaseType_t count;
+    UBaseType_t max_count;
+};
+
+static thread_local SilTask* current_task = nullptr;
+
+// Waits on a host condition variable for ticks of firmware time. The wait is sliced, so it also
+// ends on time when Sil::Clock is stepped or its speed changes
+template <typename Ready>
+static bool wait_ticks(std::unique_lock<std::mutex>& guard, std::condition_variable& cv, TickType_t ticks, Ready ready)
+{
+    uint64_t deadline_us = Sil::Clock::now_us() + (uint64_t)ticks * portTICK_PERIOD_MS * 1000;
+
+    while (!ready()) {
+        if (ticks != portMAX_DELAY && Sil::Clock::now_us() >= deadline_us) {
+            return false;
+        }
+        cv.wait_for(guard, std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+TaskHandle_t sil_adopt_thread(const char* name, BaseType_t core_id, uint32_t stack_depth)
+{
+    SilTask* task = new SilTask;
+    task->name = name;
+    task->core_id = core_id;
+    task->stack_depth = stack_depth;
+    current_task = task;
+    return task;
+}
+
+////////////////////////////////////////////////////////////
+//                        Tasks                           //
+////////////////////////////////////////////////////////////
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core_id)
+{
+    SilTask* task = new SilTask;
+    task->name = name;
+    task->core_id = core_id;
+    task->stack_depth = stack_depth;
+
+    // Before the thread starts, the task may look its own handle up straight away
+    if (handle != nullptr) {
+        *handle = task;
+    }
+
+    // Tasks never return, so their threads and SilTasks live for the whole process
+    std::thread([task, function, arg]() {
+        current_task = task;
+        function(arg);
+    }).detach();
+
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+                       UBaseType_t priority, TaskHandle_t* handle)
+{
+    return xTaskCreatePinnedToCore(function, name, stack_depth, arg, priority, handle, tskNO_AFFINITY);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    // Only the main thread gets here without a task. It runs setup() and loop() like the core's loopTask
+    if (current_task == nullptr) {
+        sil_adopt_thread("loopTask", 1, 8192);
+    }
+    return current_task;
+}
+
+const char* pcTaskGetName(TaskHandle_t task)
+{
+    if (task == nullptr) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    return task->name.c_str();
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    if (task == nullptr) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    return task->stack_depth;
+}
+
+BaseType_t xPortGetCoreID()
+{
+    BaseType_t core_id = xTaskGetCurrentTaskHandle()->core_id;
+    return core_id == tskNO_AFFINITY ? 0 : core_id;
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return (TickType_t)(Sil::Clock::now_us() / (portTICK_PERIOD_MS * 1000));
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        Sil::Clock::sleep_until_us(UINT64_MAX);
+    }
+    Sil::Clock::sleep_until_us(Sil::Clock::now_us() + (uint64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+void vTaskDelayUntil(TickType_t* previous_wake, TickType_t increment)
+{
+    *previous_wake += increment;
+    Sil::Clock::sleep_until_us((uint64_t)*previous_wake * portTICK_PERIOD_MS * 1000);
+}
+
+////////////////////////////////////////////////////////////
+//                    Notifications                       //
+////////////////////////////////////////////////////////////
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    std::lock_guard<std::mutex> guard(task->lock);
+
+    switch (action) {
+    case eNoAction:
+        break;
+    case eSetBits:
+        task->notify_value |= value;
+        break;
+    case eIncrement:
+        task->notify_value++;
+        break;
+    case eSetValueWithOverwrite:
+        task->notify_value = value;
+        break;
+    case eSetValueWithoutOverwrite:
+        if (task->notify_pending) {
+            return pdFAIL;
+        }
+        task->notify_value = value;
+        break;
+    }
+
+    task->notify_pending = true;
+    task->notified.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action,
+                              BaseType_t* higher_priority_woken)
+{
+    if (higher_priority_woken != nullptr) {
+        *higher_priority_woken = pdFALSE;
+    }
+    return xTaskNotify(task, value, action);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t* value, TickType_t ticks)
+{
+    SilTask* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> guard(task->lock);
+
+    if (!task->notify_pending) {
+        task->notify_value &= ~clear_on_entry;
+    }
+
+    bool received = wait_ticks(guard, task->notified, ticks, [task]() {return task->notify_pending;});
+
+    if (value != nullptr) {
+        *value = task->notify_value;
+    }
+    if (!received) {
+        return pdFALSE;
+    }
+
+    task->notify_value &= ~clear_on_exit;
+    task->notify_pending = false;
+    return pdTRUE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    return xTaskNotify(task, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_woken)
+{
+    xTaskNotifyFromISR(task, 0, eIncrement, higher_priority_woken);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    SilTask* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> guard(task->lock);
+
+    wait_ticks(guard, task->notified, ticks, [task]() {return task->notify_value != 0;});
+
+    uint32_t value = task->notify_value;
+    if (value != 0) {
+        task->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+    task->notify_pending = false;
+    return value;
+}
+
+////////////////////////////////////////////////////////////
+//                  Critical sections                     //
+////////////////////////////////////////////////////////////
+
+void vPortEnterCritical(portMUX_TYPE* mux)
+{
+    while (mux->locked.exchange(true, std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+void vPortExitCritical(portMUX_TYPE* mux)
+{
+    mux->locked.store(false, std::memory_order_release);
+}
+
+////////////////////////////////////////////////////////////
+//                     Semaphores                         //
+////////////////////////////////////////////////////////////
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    SilSemaphore* semaphore = new SilSemaphore;
+    semaphore->count = initial_count;
+    semaphore->max_count = max_count;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> guard(semaphore->lock);
+    RETURN_FALSE_IF_FALSE(wait_ticks(guard, semaphore->given, ticks, [semaphore]() {return semaphore->count > 0;}));
+
+    semaphore->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    std::lock_guard<std::mutex> guard(semaphore->lock);
+    RETURN_FALSE_IF_FALSE(semaphore->count < semaphore->max_count);
+
+    semaphore->count++;
+    semaphore->given.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higher_priority_woken)
+{
+    if (higher_priority_woken != nullptr) {
+        *higher_priority_woken = pdFALSE;
+    }
+    return xSemaphoreGive(semaphore);
+}
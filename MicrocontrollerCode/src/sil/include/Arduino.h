@@ -0,0 +1,123 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: The parts of the ESP32 Arduino core the firmware uses, for the SIL build
+
+// The core pulls these in transitively and the firmware relies on it
+#include <algorithm>
+#include <functional>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "pgmspace.h"
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+
+using std::max;
+using std::min;
+using std::abs;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+
+////////////////////////////////////////////////////////////
+//                        Time                            //
+////////////////////////////////////////////////////////////
+
+// Firmware time from Sil::Clock, not the wall clock
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+////////////////////////////////////////////////////////////
+//                        Pins                            //
+////////////////////////////////////////////////////////////
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define ONLOW 0x04
+#define ONHIGH 0x05
+
+#define digitalPinToInterrupt(p) (p)
+
+// Outputs are remembered so inputs read back what was written. Interrupts only fire from Sil::raise_pin()
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+////////////////////////////////////////////////////////////
+//                        Chip                            //
+////////////////////////////////////////////////////////////
+
+// Cycle counts come from the host's steady clock at the ESP32's 240 MHz, so profiles stay in the same units.
+// There is no heap limit in the SIL, so heap figures are the ESP32's
+class EspClass {
+
+public:
+    uint32_t getCycleCount();
+    inline uint32_t getCpuFreqMHz() {return 240;}
+    inline uint32_t getHeapSize() {return 327680;}
+    inline uint32_t getFreeHeap() {return 327680;}
+    inline uint32_t getMinFreeHeap() {return 327680;}
+    inline uint32_t getMaxAllocHeap() {return 327680;}
+    void restart();
+};
+
+extern EspClass ESP;
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// Provided by the sketch, here flight_computer/main.cpp
+void setup();
+void loop();
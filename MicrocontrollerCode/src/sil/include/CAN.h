@@ -0,0 +1,47 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: The ESP32 CAN controller for the SIL build, with no transceiver attached
+
+#include "Arduino.h"
+
+// Same interface as arduino-CAN's ESP32SJA1000Class. begin() fails, so CanBus::setup() reports it like a missing transceiver
+class ESP32SJA1000Class : public Stream {
+
+public:
+    ESP32SJA1000Class() {}
+    virtual ~ESP32SJA1000Class() {}
+
+    inline void setPins(int rx, int tx) {}
+
+    virtual int begin(long baud_rate) {return 0;}
+    virtual void end() {}
+
+    inline int beginPacket(int id, int dlc = -1, bool rtr = false) {return 0;}
+    inline int beginExtendedPacket(long id, int dlc = -1, bool rtr = false) {return 0;}
+    virtual int endPacket() {return 0;}
+
+    virtual int parsePacket() {return 0;}
+    inline long packetId() {return -1;}
+    inline bool packetExtended() {return false;}
+    inline bool packetRtr() {return false;}
+    inline int packetDlc() {return -1;}
+
+    virtual size_t write(uint8_t byte) {return 0;}
+    virtual size_t write(const uint8_t* buffer, size_t size) {return 0;}
+    using Print::write;
+
+    virtual int available() {return 0;}
+    virtual int read() {return -1;}
+    virtual int peek() {return -1;}
+
+    virtual void onReceive(void (*callback)(int)) {}
+    virtual int filter(int id, int mask = 0x7ff) {return 0;}
+    virtual int observe() {return 0;}
+    virtual int loopback() {return 0;}
+    virtual int sleep() {return 0;}
+    virtual int wakeup() {return 0;}
+};
+
+extern ESP32SJA1000Class CAN;
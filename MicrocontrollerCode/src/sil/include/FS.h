@@ -0,0 +1,85 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Arduino fs::File and fs::FS for the SIL build, backed by a host directory
+
+#include <memory>
+
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+struct FileImpl;
+
+// Copies share the open file, like the core's File
+class File : public Stream {
+
+private:
+    std::shared_ptr<FileImpl> impl;
+
+public:
+    File() {}
+    File(std::shared_ptr<FileImpl> impl) : impl{impl} {}
+
+    size_t write(uint8_t byte);
+    size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+
+    int available();
+    int read();
+    int peek();
+    void flush();
+    size_t read(uint8_t* buffer, size_t size);
+    inline size_t readBytes(char* buffer, size_t length) {return read((uint8_t*)buffer, length);}
+
+    bool seek(uint32_t position, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    operator bool() const;
+
+    // Name without the directory, path with it, both relative to the filesystem root
+    const char* name() const;
+    const char* path() const;
+
+    bool isDirectory() const;
+    File openNextFile(const char* mode = FILE_READ);
+    void rewindDirectory();
+};
+
+class FS {
+
+protected:
+    std::string root;       // Host directory, no trailing slash
+    bool mounted;
+
+    std::string host_path(const char* path) const;
+
+public:
+    FS() : mounted{false} {}
+
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    inline File open(const String& path, const char* mode = FILE_READ, bool create = false) {return open(path.c_str(), mode, create);}
+
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool rename(const char* from_path, const char* to_path);
+    bool mkdir(const char* path);
+    bool rmdir(const char* path);
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
@@ -0,0 +1,47 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: UARTs for the SIL build. Serial is a pseudo-terminal, the others have nothing attached
+
+#include <deque>
+#include <mutex>
+
+#include "Stream.h"
+
+class HardwareSerial : public Stream {
+
+private:
+    int uart_num;
+    int master_fd;
+    int slave_fd;           // Held open so the pty survives PyCommander disconnecting
+    std::mutex tx_lock;
+    std::deque<uint8_t> rx_buffer;
+    std::mutex rx_lock;
+
+    // Moves whatever the other end of the pty sent into rx_buffer
+    void poll_rx();
+
+public:
+    HardwareSerial(int uart_num);
+    ~HardwareSerial();
+
+    // UART0 opens the pty and prints its path, the baud rate only matters to the terminal settings
+    void begin(unsigned long baud, uint32_t config = 0, int8_t rx_pin = -1, int8_t tx_pin = -1);
+    void end();
+
+    int available();
+    int read();
+    int peek();
+    void flush();
+
+    size_t write(uint8_t byte);
+    size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+
+    inline operator bool() const {return master_fd >= 0;}
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
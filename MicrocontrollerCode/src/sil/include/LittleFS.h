@@ -0,0 +1,31 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: LittleFS for the SIL build, mounted on the host directory in Sil::options.fs_root
+
+#include "FS.h"
+
+namespace fs {
+
+class LittleFSFS : public FS {
+
+public:
+    // Partition size the usage figures are reported against, the default ESP32 "spiffs" partition
+    static constexpr size_t PARTITION_BYTES = 0x160000;
+
+    // Creates the directory if it is missing, so format_on_fail has nothing to do
+    bool begin(bool format_on_fail = false, const char* base_path = "/littlefs", uint8_t max_open_files = 10,
+               const char* partition_label = "spiffs");
+    void end();
+
+    // Empties the directory
+    bool format();
+
+    size_t totalBytes();
+    size_t usedBytes();
+};
+
+} // namespace fs
+
+extern fs::LittleFSFS LittleFS;
@@ -0,0 +1,53 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Arduino Print for the SIL build
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print {
+
+private:
+    size_t print_number(unsigned long long value, uint8_t base);
+    size_t print_float(double value, uint8_t digits);
+
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t byte) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    inline size_t write(const char* str) {return str == nullptr ? 0 : write((const uint8_t*)str, strlen(str));}
+    inline size_t write(const char* buffer, size_t size) {return write((const uint8_t*)buffer, size);}
+    virtual void flush() {}
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t print(const __FlashStringHelper* str);
+    size_t print(const String& str);
+    size_t print(const char str[]);
+    size_t print(char c);
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(long long value, int base = DEC);
+    size_t print(unsigned long long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    template <typename T>
+    inline size_t println(T value) {size_t n = print(value); return n + println();}
+    template <typename T>
+    inline size_t println(T value, int format) {size_t n = print(value, format); return n + println();}
+};
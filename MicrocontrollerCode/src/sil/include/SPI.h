@@ -0,0 +1,60 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Arduino SPIClass for the SIL build. Nothing drives MISO, simulated chips go through driver/spi_master.h
+
+#include "Arduino.h"
+
+#define FSPI 1
+#define HSPI 2
+#define VSPI 3
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+#define SPI_LSBFIRST 0
+#define SPI_MSBFIRST 1
+#define LSBFIRST SPI_LSBFIRST
+#define MSBFIRST SPI_MSBFIRST
+
+class SPISettings {
+
+public:
+    uint32_t clock;
+    uint8_t bit_order;
+    uint8_t data_mode;
+
+    SPISettings() : clock{1000000}, bit_order{SPI_MSBFIRST}, data_mode{SPI_MODE0} {}
+    SPISettings(uint32_t clock, uint8_t bit_order, uint8_t data_mode)
+        : clock{clock}, bit_order{bit_order}, data_mode{data_mode} {}
+};
+
+class SPIClass {
+
+private:
+    uint8_t spi_bus;
+
+public:
+    SPIClass(uint8_t spi_bus = HSPI) : spi_bus{spi_bus} {}
+
+    inline void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+    inline void end() {}
+
+    inline void beginTransaction(SPISettings settings) {}
+    inline void endTransaction() {}
+
+    // A floating MISO reads all ones
+    inline uint8_t transfer(uint8_t data) {return 0xFF;}
+    inline uint16_t transfer16(uint16_t data) {return 0xFFFF;}
+    inline uint32_t transfer32(uint32_t data) {return 0xFFFFFFFF;}
+    inline void transfer(void* data, uint32_t size) {memset(data, 0xFF, size);}
+    inline void transferBytes(const uint8_t* data, uint8_t* out, uint32_t size) {if (out != nullptr) {memset(out, 0xFF, size);}}
+    inline void writeBytes(const uint8_t* data, uint32_t size) {}
+
+    inline uint8_t bus() const {return spi_bus;}
+};
+
+extern SPIClass SPI;
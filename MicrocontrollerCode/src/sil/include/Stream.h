@@ -0,0 +1,31 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Arduino Stream for the SIL build
+
+#include "Print.h"
+
+class Stream : public Print {
+
+protected:
+    unsigned long timeout_ms;
+
+    // -1 once timeout_ms has passed without a byte
+    int timed_read();
+
+public:
+    Stream() : timeout_ms{1000} {}
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    inline void setTimeout(unsigned long timeout) {timeout_ms = timeout;}
+    inline unsigned long getTimeout() const {return timeout_ms;}
+
+    size_t readBytes(char* buffer, size_t length);
+    inline size_t readBytes(uint8_t* buffer, size_t length) {return readBytes((char*)buffer, length);}
+    String readString();
+    String readStringUntil(char terminator);
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Arduino String for the SIL build, on top of std::string
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+
+class String : public std::string {
+
+public:
+    String() {}
+    String(const char* cstr) : std::string(cstr == nullptr ? "" : cstr) {}
+    String(const char* cstr, unsigned int length) : std::string(cstr, length) {}
+    String(const std::string& str) : std::string(str) {}
+    String(const __FlashStringHelper* str) : String(reinterpret_cast<const char*>(str)) {}
+
+    // Characters stay characters, every other integer is written out in base
+    explicit String(char c) : std::string(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimal_places = 2);
+    explicit String(double value, unsigned char decimal_places = 2);
+
+    inline unsigned int length() const {return size();}
+    inline bool reserve(unsigned int size) {std::string::reserve(size); return true;}
+
+    inline bool concat(const String& str) {append(str); return true;}
+    inline bool concat(const char* cstr) {if (cstr != nullptr) {append(cstr);} return true;}
+    inline bool concat(const char* cstr, unsigned int length) {append(cstr, length); return true;}
+    inline bool concat(char c) {push_back(c); return true;}
+    template <typename T>
+    inline bool concat(T value) {return concat(String(value));}
+
+    template <typename T>
+    inline String& operator+=(T value) {concat(value); return *this;}
+
+    inline char charAt(unsigned int index) const {return index < size() ? (*this)[index] : 0;}
+    inline bool equals(const String& str) const {return compare(str) == 0;}
+    inline bool startsWith(const String& prefix) const {return rfind(prefix, 0) == 0;}
+    inline bool endsWith(const String& suffix) const {
+        return size() >= suffix.size() && compare(size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& str, unsigned int from = 0) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    void trim();
+
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+};
+
+inline String operator+(const String& lhs, const String& rhs) {String result(lhs); result.concat(rhs); return result;}
+inline String operator+(const String& lhs, const char* rhs) {String result(lhs); result.concat(rhs); return result;}
+inline String operator+(const char* lhs, const String& rhs) {String result(lhs); result.concat(rhs); return result;}
+inline String operator+(const String& lhs, char rhs) {String result(lhs); result.concat(rhs); return result;}
+template <typename T>
+inline String operator+(const String& lhs, T rhs) {String result(lhs); result.concat(rhs); return result;}
@@ -0,0 +1,39 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Arduino TwoWire for the SIL build, an I2C bus with nothing on it
+
+#include "Arduino.h"
+
+class TwoWire : public Stream {
+
+private:
+    uint8_t bus_num;
+
+public:
+    TwoWire(uint8_t bus_num) : bus_num{bus_num} {}
+
+    inline bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {return true;}
+    inline bool end() {return true;}
+    inline bool setClock(uint32_t frequency) {return true;}
+
+    inline void beginTransmission(uint16_t address) {}
+
+    // Every address NACKs (2), like a bus whose devices are unpowered
+    inline uint8_t endTransmission(bool send_stop = true) {return 2;}
+    // One template for the core's many address/size overloads
+    template <typename Address, typename Size, typename Stop = bool>
+    inline uint8_t requestFrom(Address address, Size size, Stop send_stop = true) {return 0;}
+
+    inline size_t write(uint8_t byte) {return 1;}
+    inline size_t write(const uint8_t* buffer, size_t size) {return size;}
+    using Print::write;
+
+    inline int available() {return 0;}
+    inline int read() {return -1;}
+    inline int peek() {return -1;}
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
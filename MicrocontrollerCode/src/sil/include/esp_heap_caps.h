@@ -0,0 +1,19 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Capability allocations for the SIL build, where every allocation can do everything
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_EXEC (1 << 0)
+#define MALLOC_CAP_32BIT (1 << 1)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+inline void* heap_caps_malloc(size_t size, uint32_t caps) {return malloc(size);}
+inline void* heap_caps_calloc(size_t count, size_t size, uint32_t caps) {return calloc(count, size);}
+inline void heap_caps_free(void* ptr) {free(ptr);}
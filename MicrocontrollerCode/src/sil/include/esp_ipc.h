@@ -0,0 +1,21 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: esp_ipc for the SIL build, where there is no other core to run on
+
+#include "esp_err.h"
+
+typedef void (*esp_ipc_func_t)(void* arg);
+
+// Runs func on the calling thread
+inline esp_err_t esp_ipc_call_blocking(uint32_t cpu_id, esp_ipc_func_t func, void* arg)
+{
+    func(arg);
+    return ESP_OK;
+}
+
+inline esp_err_t esp_ipc_call(uint32_t cpu_id, esp_ipc_func_t func, void* arg)
+{
+    return esp_ipc_call_blocking(cpu_id, func, arg);
+}
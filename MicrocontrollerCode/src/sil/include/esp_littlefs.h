@@ -0,0 +1,12 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: esp_littlefs partition info for the SIL build
+
+#include <stddef.h>
+
+#include "esp_err.h"
+
+// Only the mounted LittleFS, whatever the label
+esp_err_t esp_littlefs_info(const char* partition_label, size_t* total_bytes, size_t* used_bytes);
@@ -0,0 +1,65 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Controls for the software-in-the-loop build, where the flight firmware runs as a Linux process
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Sil {
+
+// Command line of the SIL process, see sil/main.cpp
+struct Options {
+    const char* fs_root = "sil_fs";     // Host directory that stands in for the LittleFS partition
+    const char* replay_dir = nullptr;   // Directory with log_imu.bin and log_baro.bin pulled off a flight
+    const char* pty_link = nullptr;     // Symlink to the UART pty, so PyCommander can use a fixed port
+    float speed = 1.0f;                 // Firmware time per wall time
+};
+
+extern Options options;
+
+// The one clock behind millis(), micros(), esp_timer and FreeRTOS ticks. Starts at 0 like a reset ESP32
+class Clock {
+
+public:
+    enum class Mode : uint8_t {
+        REAL_TIME,      // Follows the wall clock, scaled by speed
+        STEPPED         // Only moves with advance_us(), for lockstep with a simulator
+    };
+
+    static uint64_t now_us();
+
+    static void set_speed(float speed);
+    static float get_speed();
+
+    static void set_mode(Mode mode);
+    static Mode get_mode();
+
+    // STEPPED only. Wakes every task and timer that became due
+    static void advance_us(uint64_t us);
+
+    // Blocks the calling thread until firmware time reaches time_us
+    static void sleep_until_us(uint64_t time_us);
+
+    // Wall time a timeout of firmware time would take right now, for timed waits
+    static uint64_t wall_timeout_us(uint64_t us);
+};
+
+// Stands in for the chip on the other end of a spi_bus_add_device() CS pin
+class SpiDeviceModel {
+
+public:
+    virtual ~SpiDeviceModel() {}
+
+    // Full duplex, rx may be nullptr
+    virtual void transfer(const uint8_t* tx, uint8_t* rx, size_t len) = 0;
+};
+
+// Must be attached before the driver adds its device. Devices without a model fail to add, like a missing chip
+void attach_spi_device(int cs_pin, SpiDeviceModel* model);
+
+// Runs the interrupt attached to pin, like an edge on a DRDY line
+void raise_pin(uint8_t pin);
+
+} // namespace Sil
@@ -0,0 +1,320 @@
+#include <LittleFS.h>
+#include <esp_littlefs.h>
+#include <sil.h>
+
+#include <dirent.h>
+#include <filesystem>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace host_fs = std::filesystem;
+
+fs::LittleFSFS LittleFS;
+
+namespace fs {
+
+struct FileImpl {
+    FILE* file = nullptr;
+    DIR* dir = nullptr;
+    std::string host_path;
+    std::string path;       // From the filesystem root, starting with '/'
+    std::string name;
+    bool is_directory = false;
+
+    ~FileImpl() {
+        if (file != nullptr) {
+            fclose(file);
+        }
+        if (dir != nullptr) {
+            closedir(dir);
+        }
+    }
+};
+
+////////////////////////////////////////////////////////////
+//                         File                           //
+////////////////////////////////////////////////////////////
+
+size_t File::write(uint8_t byte)
+{
+    return write(&byte, 1);
+}
+
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+    if (!impl || impl->file == nullptr) {
+        return 0;
+    }
+    return fwrite(buffer, 1, size, impl->file);
+}
+
+int File::available()
+{
+    if (!impl || impl->file == nullptr) {
+        return 0;
+    }
+    return size() - position();
+}
+
+int File::read()
+{
+    if (!impl || impl->file == nullptr) {
+        return -1;
+    }
+    int c = fgetc(impl->file);
+    return c == EOF ? -1 : c;
+}
+
+int File::peek()
+{
+    int c = read();
+    if (c >= 0) {
+        ungetc(c, impl->file);
+    }
+    return c;
+}
+
+void File::flush()
+{
+    if (impl && impl->file != nullptr) {
+        fflush(impl->file);
+    }
+}
+
+size_t File::read(uint8_t *buffer, size_t size)
+{
+    if (!impl || impl->file == nullptr) {
+        return 0;
+    }
+    return fread(buffer, 1, size, impl->file);
+}
+
+bool File::seek(uint32_t position, SeekMode mode)
+{
+    if (!impl || impl->file == nullptr) {
+        return false;
+    }
+    int whence = mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END);
+    return fseek(impl->file, position, whence) == 0;
+}
+
+size_t File::position() const
+{
+    if (!impl || impl->file == nullptr) {
+        return 0;
+    }
+    return ftell(impl->file);
+}
+
+size_t File::size() const
+{
+    if (!impl || impl->file == nullptr) {
+        return 0;
+    }
+    fflush(impl->file);
+    struct stat st;
+    return fstat(fileno(impl->file), &st) == 0 ? st.st_size : 0;
+}
+
+void File::close()
+{
+    impl.reset();
+}
+
+File::operator bool() const
+{
+    return (bool)impl;
+}
+
+const char* File::name() const
+{
+    return impl ? impl->name.c_str() : nullptr;
+}
+
+const char* File::path() const
+{
+    return impl ? impl->path.c_str() : nullptr;
+}
+
+bool File::isDirectory() const
+{
+    return impl && impl->is_directory;
+}
+
+File File::openNextFile(const char *mode)
+{
+    if (!impl || impl->dir == nullptr) {
+        return File();
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(impl->dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            break;
+        }
+    }
+    if (entry == nullptr) {
+        return File();
+    }
+
+    std::string name(entry->d_name);
+    std::string child = impl->path == "/" ? "/" + name : impl->path + "/" + name;
+    return LittleFS.open(child.c_str(), mode);
+}
+
+void File::rewindDirectory()
+{
+    if (impl && impl->dir != nullptr) {
+        rewinddir(impl->dir);
+    }
+}
+
+////////////////////////////////////////////////////////////
+//                          FS                            //
+////////////////////////////////////////////////////////////
+
+std::string FS::host_path(const char *path) const
+{
+    if (path == nullptr || path[0] != '/') {
+        return root + "/" + (path == nullptr ? "" : path);
+    }
+    return root + path;
+}
+
+File FS::open(const char *path, const char *mode, bool create)
+{
+    if (!mounted || path == nullptr) {
+        return File();
+    }
+
+    auto impl = std::make_shared<FileImpl>();
+    impl->host_path = host_path(path);
+    impl->path = path[0] == '/' ? path : "/" + std::string(path);
+    impl->name = host_fs::path(impl->path).filename().string();
+    if (impl->path == "/") {
+        impl->name = "/";
+    }
+
+    bool writing = mode[0] == 'w' || mode[0] == 'a';
+    if (writing && create) {
+        std::error_code error;
+        host_fs::create_directories(host_fs::path(impl->host_path).parent_path(), error);
+    }
+
+    struct stat st;
+    if (!writing && stat(impl->host_path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        impl->dir = opendir(impl->host_path.c_str());
+        impl->is_directory = true;
+        return impl->dir == nullptr ? File() : File(impl);
+    }
+
+    // Binary on every host, the firmware writes raw structs
+    std::string host_mode = std::string(mode) + "b";
+    impl->file = fopen(impl->host_path.c_str(), host_mode.c_str());
+    return impl->file == nullptr ? File() : File(impl);
+}
+
+bool FS::exists(const char *path)
+{
+    struct stat st;
+    return mounted && stat(host_path(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char *path)
+{
+    return mounted && unlink(host_path(path).c_str()) == 0;
+}
+
+bool FS::rename(const char *from_path, const char *to_path)
+{
+    return mounted && ::rename(host_path(from_path).c_str(), host_path(to_path).c_str()) == 0;
+}
+
+bool FS::mkdir(const char *path)
+{
+    return mounted && ::mkdir(host_path(path).c_str(), 0755) == 0;
+}
+
+bool FS::rmdir(const char *path)
+{
+    return mounted && ::rmdir(host_path(path).c_str()) == 0;
+}
+
+////////////////////////////////////////////////////////////
+//                       LittleFS                         //
+////////////////////////////////////////////////////////////
+
+bool LittleFSFS::begin(bool format_on_fail, const char *base_path, uint8_t max_open_files, const char *partition_label)
+{
+    if (mounted) {
+        return true;
+    }
+
+    root = host_fs::absolute(Sil::options.fs_root).lexically_normal().string();
+    if (!root.empty() && root.back() == '/') {
+        root.pop_back();
+    }
+
+    std::error_code error;
+    host_fs::create_directories(root, error);
+    if (error) {
+        fprintf(stderr, "SIL: could not create %s for LittleFS\n", root.c_str());
+        return false;
+    }
+
+    mounted = true;
+    return true;
+}
+
+void LittleFSFS::end()
+{
+    mounted = false;
+}
+
+bool LittleFSFS::format()
+{
+    if (!mounted) {
+        return false;
+    }
+
+    std::error_code error;
+    for (const auto& entry : host_fs::directory_iterator(root, error)) {
+        host_fs::remove_all(entry.path(), error);
+    }
+    return !error;
+}
+
+size_t LittleFSFS::totalBytes()
+{
+    return PARTITION_BYTES;
+}
+
+size_t LittleFSFS::usedBytes()
+{
+    if (!mounted) {
+        return 0;
+    }
+
+    size_t used = 0;
+    std::error_code error;
+    for (const auto& entry : host_fs::recursive_directory_iterator(root, error)) {
+        if (entry.is_regular_file(error)) {
+            used += entry.file_size(error);
+        }
+    }
+    return used;
+}
+
+} // namespace fs
+
+esp_err_t esp_littlefs_info(const char *partition_label, size_t *total_bytes, size_t *used_bytes)
+{
+    if (!LittleFS.exists("/")) {
+        return ESP_FAIL;
+    }
+
+    *total_bytes = LittleFS.totalBytes();
+    *used_bytes = LittleFS.usedBytes();
+    return ESP_OK;
+}
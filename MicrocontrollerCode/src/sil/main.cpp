@@ -0,0 +1,65 @@
+#include <Arduino.h>
+#include <sil.h>
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Runs the sketch (flight_computer/main.cpp) the way the ESP32 core's loopTask does
+
+Sil::Options Sil::options;
+
+static void usage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --fs DIR          Host directory for LittleFS (default sil_fs)\n"
+            "  --replay DIR      Replay log_imu.bin and log_baro.bin from DIR\n"
+            "  --pty-link PATH   Symlink PATH to the Serial pty\n"
+            "  --speed X         Firmware seconds per wall second (default 1)\n",
+            program);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option long_options[] = {
+        {"fs", required_argument, nullptr, 'f'},
+        {"replay", required_argument, nullptr, 'r'},
+        {"pty-link", required_argument, nullptr, 'p'},
+        {"speed", required_argument, nullptr, 's'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "f:r:p:s:h", long_options, nullptr)) != -1) {
+        switch (option) {
+        case 'f':
+            Sil::options.fs_root = optarg;
+            break;
+        case 'r':
+            Sil::options.replay_dir = optarg;
+            break;
+        case 'p':
+            Sil::options.pty_link = optarg;
+            break;
+        case 's':
+            Sil::options.speed = atof(optarg);
+            if (Sil::options.speed <= 0) {
+                fprintf(stderr, "--speed must be positive\n");
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return option == 'h' ? 0 : 1;
+        }
+    }
+
+    Sil::Clock::set_speed(Sil::options.speed);
+
+    setup();
+    while (true) {
+        loop();
+    }
+}
@@ -0,0 +1,145 @@
+#include <HardwareSerial.h>
+#include <sil.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+
+HardwareSerial::HardwareSerial(int uart_num)
+    : uart_num{uart_num}
+    , master_fd{-1}
+    , slave_fd{-1}
+{}
+
+HardwareSerial::~HardwareSerial()
+{
+    end();
+}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rx_pin, int8_t tx_pin)
+{
+    // Only UART0, the one PyCommander talks to, is wired up
+    if (uart_num != 0 || master_fd >= 0) {
+        return;
+    }
+
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+        perror("SIL: could not open a pty for Serial");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+    const char* slave_path = ptsname(fd);
+
+    // Raw, so COBS frames and their 0x00 delimiters pass through untouched
+    slave_fd = open(slave_path, O_RDWR | O_NOCTTY);
+    struct termios settings;
+    if (slave_fd >= 0 && tcgetattr(slave_fd, &settings) == 0) {
+        cfmakeraw(&settings);
+        tcsetattr(slave_fd, TCSANOW, &settings);
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    master_fd = fd;
+
+    if (Sil::options.pty_link != nullptr) {
+        unlink(Sil::options.pty_link);
+        if (symlink(slave_path, Sil::options.pty_link) != 0) {
+            perror("SIL: could not link the pty");
+        }
+    }
+
+    fprintf(stderr, "SIL: Serial on %s at %lu baud\n", slave_path, baud);
+}
+
+void HardwareSerial::end()
+{
+    if (master_fd >= 0) {
+        close(master_fd);
+        master_fd = -1;
+    }
+    if (slave_fd >= 0) {
+        close(slave_fd);
+        slave_fd = -1;
+    }
+}
+
+void HardwareSerial::poll_rx()
+{
+    if (master_fd < 0) {
+        return;
+    }
+
+    uint8_t buffer[256];
+    ssize_t count;
+    while ((count = ::read(master_fd, buffer, sizeof(buffer))) > 0) {
+        rx_buffer.insert(rx_buffer.end(), buffer, buffer + count);
+    }
+}
+
+int HardwareSerial::available()
+{
+    std::lock_guard<std::mutex> guard(rx_lock);
+    poll_rx();
+    return rx_buffer.size();
+}
+
+int HardwareSerial::read()
+{
+    std::lock_guard<std::mutex> guard(rx_lock);
+    poll_rx();
+    if (rx_buffer.empty()) {
+        return -1;
+    }
+
+    uint8_t byte = rx_buffer.front();
+    rx_buffer.pop_front();
+    return byte;
+}
+
+int HardwareSerial::peek()
+{
+    std::lock_guard<std::mutex> guard(rx_lock);
+    poll_rx();
+    return rx_buffer.empty() ? -1 : rx_buffer.front();
+}
+
+void HardwareSerial::flush() {}
+
+size_t HardwareSerial::write(uint8_t byte)
+{
+    return write(&byte, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    std::lock_guard<std::mutex> guard(tx_lock);
+    if (master_fd < 0) {
+        return 0;
+    }
+
+    // With nobody reading, the pty fills up and the rest is dropped instead of blocking the firmware
+    size_t written = 0;
+    while (written < size) {
+        ssize_t count = ::write(master_fd, buffer + written, size - written);
+        if (count > 0) {
+            written += count;
+        }
+        else if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        else {
+            break;
+        }
+    }
+    return size;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// AUTHOR: Colin Skinner / Cesium FSW
+// VERSION: X.X.X
+// PURPOSE: Shared between the SIL FreeRTOS and esp_timer, not for firmware code
+
+#include <freertos/task.h>
+
+// Gives a thread the SilTask that xTaskGetCurrentTaskHandle() and xPortGetCoreID() report for it
+TaskHandle_t sil_adopt_thread(const char* name, BaseType_t core_id, uint32_t stack_depth);
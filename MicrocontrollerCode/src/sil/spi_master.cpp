@@ -0,0 +1,120 @@
+#include <driver/spi_master.h>
+#include <sil.h>
+
+#include <deque>
+#include <map>
+#include <mutex>
+
+struct SilSpiDevice {
+    spi_device_interface_config_t config;
+    Sil::SpiDeviceModel* model;
+    std::deque<spi_transaction_t*> done;
+};
+
+static std::mutex spi_lock;
+static std::map<int, Sil::SpiDeviceModel*> models;     // By CS pin
+static bool host_started[3] = {false};
+
+void Sil::attach_spi_device(int cs_pin, SpiDeviceModel *model)
+{
+    std::lock_guard<std::mutex> guard(spi_lock);
+    models[cs_pin] = model;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus_config, int dma_chan)
+{
+    std::lock_guard<std::mutex> guard(spi_lock);
+    if (host_started[host]) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    host_started[host] = true;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host)
+{
+    std::lock_guard<std::mutex> guard(spi_lock);
+    host_started[host] = false;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *device_config,
+                             spi_device_handle_t *handle)
+{
+    std::lock_guard<std::mutex> guard(spi_lock);
+    if (!host_started[host]) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    auto model = models.find(device_config->spics_io_num);
+    if (model == models.end()) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    SilSpiDevice* device = new SilSpiDevice;
+    device->config = *device_config;
+    device->model = model->second;
+    *handle = device;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    delete handle;
+    return ESP_OK;
+}
+
+// The whole transfer happens inside the callbacks, so SpiBus timing reads as zero-length wire time
+static void run_transaction(spi_device_handle_t handle, spi_transaction_t *transaction)
+{
+    if (handle->config.pre_cb != nullptr) {
+        handle->config.pre_cb(transaction);
+    }
+
+    size_t len = (transaction->length + 7) / 8;
+    const uint8_t* tx = (transaction->flags & SPI_TRANS_USE_TXDATA) ? transaction->tx_data
+                                                                     : (const uint8_t*)transaction->tx_buffer;
+    uint8_t* rx = (transaction->flags & SPI_TRANS_USE_RXDATA) ? transaction->rx_data
+                                                               : (uint8_t*)transaction->rx_buffer;
+    handle->model->transfer(tx, rx, len);
+
+    if (handle->config.post_cb != nullptr) {
+        handle->config.post_cb(transaction);
+    }
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *transaction, TickType_t ticks)
+{
+    std::lock_guard<std::mutex> guard(spi_lock);
+    if (handle->done.size() >= (size_t)handle->config.queue_size) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    run_transaction(handle, transaction);
+    handle->done.push_back(transaction);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **transaction, TickType_t ticks)
+{
+    std::lock_guard<std::mutex> guard(spi_lock);
+    if (handle->done.empty()) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    *transaction = handle->done.front();
+    handle->done.pop_front();
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *transaction)
+{
+    std::lock_guard<std::mutex> guard(spi_lock);
+    run_transaction(handle, transaction);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *transaction)
+{
+    return spi_device_transmit(handle, transaction);
+}
@@ -8,6 +8,7 @@
 #include "../common/globals.h"
 #include "../common/os/filesystem.h"
 #include "../common/comms/CanBus.h"
+#include "../common/os/spi_bus.h"
 
 #include "../common/drivers/Icm20948.h"
 #include "../common/drivers/Ms5607.h"
@@ -91,6 +92,7 @@ namespace Cesium {
     ////////////////////////////////////////////////////////////
 
     // Objects
+    extern SpiBus vspi_bus;
     extern FileSystem filesystem;
     extern Sensor::Ms5607 altimeter2;
     extern Sensor::Icm20948 imu2;
@@ -102,7 +104,8 @@ namespace Cesium {
 
     void init_cs_pins();
 
-    void init_interfaces();
+    // False if a bus or a device on it failed to start
+    bool init_interfaces();
 
     void init_sensors();
     
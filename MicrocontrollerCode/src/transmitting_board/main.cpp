@@ -44,7 +44,9 @@ void setup() {
 
     init_cs_pins();
 
-    init_interfaces();
+    if (!init_interfaces()) {
+        Serial.println("Failed to initialize interfaces");
+    }
 
     
     
@@ -77,4 +77,25 @@ const char vectors[] = R"(
     ]
 
 }
-)";
\ No newline at end of file
+)";
+const char calibration[] = R"(
+{
+    "acceleration_bias": [0.1, 0.2, 0.3],
+    "acceleration_scale": [2, 1, 1],
+    "gyroscope_bias": [0.01, 0.02, 0.03],
+    "gyroscope_misalignment": [
+        [1, 0, 0],
+        [0, 1, 0],
+        [0, "bad", 1]
+    ],
+    "transformation_matrix": [
+        0, 1, 0,
+        -1, 0, 0,
+        0, 0, 1
+    ],
+    "short_matrix": [
+        0, 1, 0,
+        -1, 0, 0
+    ]
+}
+)";
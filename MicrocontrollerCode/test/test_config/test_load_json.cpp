@@ -103,6 +103,52 @@ void test_bad_vector_type() {
     TEST_ASSERT_FALSE((json_extract<float,3,1>(doc, "bad_datatype", test_int_vec)));
 }
 
+////////////////////////////////////////////////////////////
+//                 Test sensor calibration                //
+////////////////////////////////////////////////////////////
+
+void test_extracting_flat_matrix() {
+    JsonDocument doc;
+    TEST_ASSERT_TRUE(json_open(calibration, doc));
+
+    Matrix3<float> body_to_sensor;
+    Matrix3<float> expected = {{{0, 1, 0}, {-1, 0, 0}, {0, 0, 1}}};
+    TEST_ASSERT_TRUE(json_extract_body_to_sensor(doc, body_to_sensor));
+    TEST_ASSERT_TRUE(matrix_float_equals(expected, body_to_sensor));
+
+    // Flat vectors too
+    Vector3<float> bias;
+    Vector3<float> expected_bias = {{{0.1}, {0.2}, {0.3}}};
+    TEST_ASSERT_TRUE(json_extract(doc, "acceleration_bias", bias));
+    TEST_ASSERT_TRUE(matrix_float_equals(expected_bias, bias));
+
+    TEST_ASSERT_FALSE(json_extract(doc, "short_matrix", body_to_sensor));
+}
+
+void test_extracting_calibration() {
+    JsonDocument doc;
+    TEST_ASSERT_TRUE(json_open(calibration, doc));
+
+    Matrix3<float> body_to_sensor;
+    TEST_ASSERT_TRUE(json_extract_body_to_sensor(doc, body_to_sensor));
+
+    Cesium::Sensor::Calibration3 accel;
+    TEST_ASSERT_TRUE(json_extract_calibration(doc, "acceleration", transpose(body_to_sensor), accel));
+
+    // Sensor y is body -x, sensor x is scaled by 2 and ends up on body y
+    Vector3<float> raw = {{{0.6}, {1.2}, {10.11}}};
+    Vector3<float> body;
+    accel.apply(raw, body);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, -1.0, body[0][0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 1.0, body[1][0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 9.81, body[2][0]);
+
+    // Bad misalignment, and no magnetometer bias at all
+    Cesium::Sensor::Calibration3 gyro, mag;
+    TEST_ASSERT_FALSE(json_extract_calibration(doc, "gyroscope", transpose(body_to_sensor), gyro));
+    TEST_ASSERT_FALSE(json_extract_calibration(doc, "magnetometer", transpose(body_to_sensor), mag));
+}
+
 ////////////////////////////////////////////////////////////
 //                    Run all tests                       //
 ////////////////////////////////////////////////////////////
@@ -117,4 +163,7 @@ void test_all_load_json() {
     RUN_TEST(test_extracting_vector);
     RUN_TEST(test_bad_rows_and_cols);
     RUN_TEST(test_bad_vector_type);
+
+    RUN_TEST(test_extracting_flat_matrix);
+    RUN_TEST(test_extracting_calibration);
 }
@@ -0,0 +1,56 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/drivers/ads1256.h"
+
+
+using namespace std;
+using namespace Cesium;
+
+////////////////////////////////////////////////////////////
+//                    Test sample packing                 //
+////////////////////////////////////////////////////////////
+
+void test_ads1256_sample_packing() {
+    // 24-bit two's complement as shifted out by the chip, channel in the low byte
+    AdcSample negative = {100, (int32_t)(0xFE1DC0u << 8 | 5)};
+    TEST_ASSERT_EQUAL(-123456, negative.raw());
+    TEST_ASSERT_EQUAL(5, negative.channel());
+
+    AdcSample full_scale = {200, (int32_t)(0x7FFFFFu << 8 | 7)};
+    TEST_ASSERT_EQUAL(8388607, full_scale.raw());
+    TEST_ASSERT_EQUAL(7, full_scale.channel());
+}
+
+////////////////////////////////////////////////////////////
+//                    Test calibration                    //
+////////////////////////////////////////////////////////////
+
+void test_ads1256_calibration() {
+    static Ads1256 adc(0, 0, &SPI, 4);
+
+    float slopes[8] = {2, 3, 4, 5, 1, 1, 1, 1};
+    float intercepts[8] = {0.5, -1, 0, 1, 0, 0, 0, 0};
+    TEST_ASSERT_TRUE(adc.set_calibration(slopes, intercepts));
+
+    // PGA 1: +-5 V over 2^23 counts
+    float lsb = adc.get_volts_per_lsb();
+    TEST_ASSERT_FLOAT_WITHIN(1e-12, 5.0 / 8388608, lsb);
+
+    AdcSample sample = {0, (int32_t)(0x100000u << 8 | 1)};
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 0x100000 * lsb * 3 - 1, adc.calibrate(sample));
+
+    // Nothing acquired yet
+    AdcReading readings[4];
+    TEST_ASSERT_EQUAL(0, adc.read_samples(readings, 4));
+    TEST_ASSERT_EQUAL(Ads1256::AcquisitionMode::STOPPED, adc.get_mode());
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void run_all_ads1256_tests() {
+    RUN_TEST(test_ads1256_sample_packing);
+    RUN_TEST(test_ads1256_calibration);
+}
@@ -0,0 +1,117 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/drivers/Bmi323.h"
+
+
+using namespace std;
+using namespace Cesium;
+using namespace Cesium::Sensor;
+
+// Little-endian headerless frame: accel xyz, gyro xyz, temperature, sensortime
+static void make_frame(uint8_t* frame, const int16_t accel[3], const int16_t gyro[3], uint16_t temp, uint16_t sensortime)
+{
+    uint16_t words[Bmi323::FIFO_FRAME_WORDS] = {
+        (uint16_t)accel[0], (uint16_t)accel[1], (uint16_t)accel[2],
+        (uint16_t)gyro[0], (uint16_t)gyro[1], (uint16_t)gyro[2],
+        temp, sensortime
+    };
+
+    for (size_t i = 0; i < Bmi323::FIFO_FRAME_WORDS; i++) {
+        frame[2 * i] = words[i] & 0xFF;
+        frame[2 * i + 1] = words[i] >> 8;
+    }
+}
+
+////////////////////////////////////////////////////////////
+//                    Test FIFO decode                    //
+////////////////////////////////////////////////////////////
+
+void test_bmi323_fifo_scaling() {
+    // Fresh decoder state per test, only decode_fifo is used so nothing touches the bus
+    static Bmi323 bmi323;
+
+    uint8_t raw[Bmi323::FIFO_FRAME_BYTES];
+    int16_t accel[3] = {4096, -4096, 0};  // 8 g range: 4096 LSB = 1 g
+    int16_t gyro[3] = {16384, 0, -16384}; // 2000 dps range: 16384 LSB = 1000 dps
+    make_frame(raw, accel, gyro, 1024, 100); // 1024 LSB = 25 C
+
+    ImuFifoSample sample;
+    TEST_ASSERT_EQUAL(1, bmi323.decode_fifo(raw, 1, &sample));
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 9.80665f, sample.accel_mps2[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, -9.80665f, sample.accel_mps2[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 0.0f, sample.accel_mps2[2]);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 1000.0f * DEG2RAD, sample.w_rps[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, -1000.0f * DEG2RAD, sample.w_rps[2]);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 25.0f, sample.temp_C);
+}
+
+void test_bmi323_fifo_sensortime_wrap() {
+    static Bmi323 bmi323;
+
+    uint8_t raw[3 * Bmi323::FIFO_FRAME_BYTES];
+    int16_t zeros[3] = {0, 0, 0};
+
+    // 32 ticks = 1.25 ms (800 Hz), wrapping through 0xFFFF
+    make_frame(raw, zeros, zeros, 0, 0xFFE0);
+    make_frame(raw + Bmi323::FIFO_FRAME_BYTES, zeros, zeros, 0, 0x0000);
+    make_frame(raw + 2 * Bmi323::FIFO_FRAME_BYTES, zeros, zeros, 0, 0x0020);
+
+    ImuFifoSample samples[3];
+    TEST_ASSERT_EQUAL(3, bmi323.decode_fifo(raw, 3, samples));
+
+    TEST_ASSERT_EQUAL(1250, samples[1].time_us - samples[0].time_us);
+    TEST_ASSERT_EQUAL(1250, samples[2].time_us - samples[1].time_us);
+}
+
+void test_bmi323_fifo_skips_dummy_frames() {
+    static Bmi323 bmi323;
+
+    uint8_t raw[3 * Bmi323::FIFO_FRAME_BYTES];
+    int16_t accel[3] = {1, 2, 3};
+    int16_t accel_dummy[3] = {(int16_t)BMI3_FIFO_ACCEL_DUMMY_FRAME, 0, 0};
+    int16_t gyro[3] = {4, 5, 6};
+
+    make_frame(raw, accel, gyro, 0, 10);
+    make_frame(raw + Bmi323::FIFO_FRAME_BYTES, accel_dummy, gyro, 0, 42);
+    make_frame(raw + 2 * Bmi323::FIFO_FRAME_BYTES, accel, gyro, BMI3_FIFO_TEMP_DUMMY_FRAME, 74);
+
+    ImuFifoSample samples[3];
+    TEST_ASSERT_EQUAL(2, bmi323.decode_fifo(raw, 3, samples));
+    TEST_ASSERT_EQUAL(1, bmi323.get_fifo_frames_skipped());
+    TEST_ASSERT_EQUAL(2, bmi323.get_fifo_frames_read());
+
+    // Missing temperature only invalidates the temperature
+    TEST_ASSERT_TRUE(isnan(samples[1].temp_C));
+    TEST_ASSERT_EQUAL(2500, samples[1].time_us - samples[0].time_us);
+}
+
+void test_bmi323_data_decode() {
+    static Bmi323 bmi323;
+
+    // Same scaling as the FIFO, minus the sensortime word
+    uint8_t raw[Bmi323::FIFO_FRAME_BYTES];
+    int16_t accel[3] = {0, 0, 4096};
+    int16_t gyro[3] = {0, -16384, 0};
+    make_frame(raw, accel, gyro, (uint16_t)-512, 0);
+
+    bmi323.decode_data(raw);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 9.80665f, bmi323.get_accel_mps2()[2][0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, -1000.0f * DEG2RAD, bmi323.get_w_rps()[1][0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 22.0f, bmi323.get_temp_C());
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void run_all_bmi323_tests() {
+    RUN_TEST(test_bmi323_fifo_scaling);
+    RUN_TEST(test_bmi323_fifo_sensortime_wrap);
+    RUN_TEST(test_bmi323_fifo_skips_dummy_frames);
+    RUN_TEST(test_bmi323_data_decode);
+}
@@ -0,0 +1,22 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "../test/test_drivers/test_drivers_main.h"
+
+using namespace std;
+
+void setup(){
+
+    delay(2000);
+    Serial.begin(115200);
+    UNITY_BEGIN();
+    run_all_bmi323_tests();
+    run_all_icm20948_tests();
+    run_all_ms5607_tests();
+    run_all_ads1256_tests();
+    run_all_ubx_tests();
+    run_all_ina233_tests();
+    run_all_replay_tests();
+    UNITY_END();
+}
+void loop(){}
\ No newline at end of file
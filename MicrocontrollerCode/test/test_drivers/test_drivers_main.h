@@ -0,0 +1,7 @@
+void run_all_bmi323_tests();
+void run_all_icm20948_tests();
+void run_all_ms5607_tests();
+void run_all_ads1256_tests();
+void run_all_ubx_tests();
+void run_all_ina233_tests();
+void run_all_replay_tests();
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/drivers/Icm20948.h"
+
+
+using namespace std;
+using namespace Cesium;
+using namespace Cesium::Sensor;
+
+// Big-endian accel xyz, gyro xyz, temperature, then little-endian ST1, HX, HY, HZ, TMPS, ST2
+static void make_frame(uint8_t* frame, const int16_t accel[3], const int16_t gyro[3], int16_t temp,
+                       uint8_t st1, const int16_t mag[3], uint8_t st2)
+{
+    for (size_t i = 0; i < 3; i++) {
+        frame[2 * i] = (uint16_t)accel[i] >> 8;
+        frame[2 * i + 1] = accel[i] & 0xFF;
+        frame[6 + 2 * i] = (uint16_t)gyro[i] >> 8;
+        frame[7 + 2 * i] = gyro[i] & 0xFF;
+    }
+    frame[12] = (uint16_t)temp >> 8;
+    frame[13] = temp & 0xFF;
+
+    frame[14] = st1;
+    for (size_t i = 0; i < 3; i++) {
+        frame[15 + 2 * i] = mag[i] & 0xFF;
+        frame[16 + 2 * i] = (uint16_t)mag[i] >> 8;
+    }
+    frame[21] = 0;
+    frame[22] = st2;
+}
+
+////////////////////////////////////////////////////////////
+//                    Test FIFO decode                    //
+////////////////////////////////////////////////////////////
+
+void test_icm20948_fifo_scaling() {
+    // Fresh decoder state per test, only decode_fifo is used so nothing touches the bus
+    static Icm20948 icm20948;
+
+    uint8_t raw[Icm20948::FIFO_FRAME_BYTES];
+    int16_t accel[3] = {2048, -2048, 0};   // 16 g range: 2048 LSB = 1 g
+    int16_t gyro[3] = {16400, 0, -16400};  // 2000 dps range: 16.4 LSB = 1 dps
+    int16_t mag[3] = {100, 200, -300};     // 0.15 uT/LSB
+    make_frame(raw, accel, gyro, 0, AK09916_ST1_DRDY, mag, 0);
+
+    ImuFifoSample sample;
+    TEST_ASSERT_EQUAL(1, icm20948.decode_fifo(raw, 1, &sample));
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 9.80665f, sample.accel_mps2[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, -9.80665f, sample.accel_mps2[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 0.0f, sample.accel_mps2[2]);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 1000.0f * DEG2RAD, sample.w_rps[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, -1000.0f * DEG2RAD, sample.w_rps[2]);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 21.0f, sample.temp_C);
+
+    // Y and Z flipped into the accel/gyro frame
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 15.0f, sample.B_uT[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, -30.0f, sample.B_uT[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 45.0f, sample.B_uT[2]);
+}
+
+void test_icm20948_fifo_holds_stale_mag() {
+    static Icm20948 icm20948;
+
+    uint8_t raw[4 * Icm20948::FIFO_FRAME_BYTES];
+    int16_t zeros[3] = {0, 0, 0};
+    int16_t mag_a[3] = {10, 0, 0};
+    int16_t mag_b[3] = {20, 0, 0};
+
+    // No data before the first DRDY, then not ready, then overflowed
+    make_frame(raw, zeros, zeros, 0, 0, mag_b, 0);
+    make_frame(raw + Icm20948::FIFO_FRAME_BYTES, zeros, zeros, 0, AK09916_ST1_DRDY, mag_a, 0);
+    make_frame(raw + 2 * Icm20948::FIFO_FRAME_BYTES, zeros, zeros, 0, 0, mag_b, 0);
+    make_frame(raw + 3 * Icm20948::FIFO_FRAME_BYTES, zeros, zeros, 0, AK09916_ST1_DRDY, mag_b, AK09916_ST2_HOFL);
+
+    ImuFifoSample samples[4];
+    TEST_ASSERT_EQUAL(4, icm20948.decode_fifo(raw, 4, samples));
+
+    TEST_ASSERT_TRUE(isnan(samples[0].B_uT[0]));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 1.5f, samples[1].B_uT[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 1.5f, samples[2].B_uT[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 1.5f, samples[3].B_uT[0]);
+
+    // Frames are one sample period apart
+    TEST_ASSERT_EQUAL(Icm20948::FIFO_PERIOD_US, samples[1].time_us - samples[0].time_us);
+    TEST_ASSERT_EQUAL(3 * Icm20948::FIFO_PERIOD_US, samples[3].time_us - samples[0].time_us);
+    TEST_ASSERT_EQUAL(4, icm20948.get_fifo_frames_read());
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void run_all_icm20948_tests() {
+    RUN_TEST(test_icm20948_fifo_scaling);
+    RUN_TEST(test_icm20948_fifo_holds_stale_mag);
+}
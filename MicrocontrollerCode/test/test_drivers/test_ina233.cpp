@@ -0,0 +1,71 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/drivers/ina233.h"
+
+
+using namespace std;
+using namespace Cesium;
+using namespace Cesium::Sensor;
+
+////////////////////////////////////////////////////////////
+//                    Energy accumulator                  //
+////////////////////////////////////////////////////////////
+
+void test_ina233_decode_energy() {
+    // Accumulator 0x1234, rollover 3, sample count 0x0A0B0C
+    const uint8_t block[Ina233::EIN_BYTES] = {0x34, 0x12, 0x03, 0x0C, 0x0B, 0x0A};
+
+    EnergyCounters counters = Ina233::decode_energy(block);
+    TEST_ASSERT_EQUAL_UINT32(3 * 65536 + 0x1234, counters.accumulator);
+    TEST_ASSERT_EQUAL_UINT32(0x0A0B0C, counters.sample_count);
+}
+
+void test_ina233_average_power() {
+    EnergyCounters previous = {1000, 50};
+    EnergyCounters current = {1000 + 40 * 250, 50 + 40};
+
+    float raw_power;
+    uint32_t samples;
+    TEST_ASSERT_TRUE(Ina233::average_power_raw(previous, current, raw_power, samples));
+    TEST_ASSERT_EQUAL_UINT32(40, samples);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 250, raw_power);
+}
+
+void test_ina233_average_power_wraps() {
+    // Both 24-bit counters roll over between the reads
+    EnergyCounters previous = {0xFFFF00, 0xFFFFF0};
+    EnergyCounters current = {0x000100, 0x000010};
+
+    float raw_power;
+    uint32_t samples;
+    TEST_ASSERT_TRUE(Ina233::average_power_raw(previous, current, raw_power, samples));
+    TEST_ASSERT_EQUAL_UINT32(0x20, samples);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 0x200 / 32.0f, raw_power);
+}
+
+void test_ina233_no_new_samples() {
+    EnergyCounters counters = {1234, 99};
+
+    float raw_power;
+    uint32_t samples;
+    TEST_ASSERT_FALSE(Ina233::average_power_raw(counters, counters, raw_power, samples));
+}
+
+void test_ina233_adc_config_word() {
+    // Datasheet default: 1 average, 1.1 ms conversions, continuous
+    TEST_ASSERT_EQUAL_HEX16(0x4127, Ina233::adc_config_word(Ina233::Averaging::AVG_1, Ina233::ConversionTime::US_1100));
+    TEST_ASSERT_EQUAL_HEX16(0x4527, Ina233::adc_config_word(Ina233::Averaging::AVG_16, Ina233::ConversionTime::US_1100));
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void run_all_ina233_tests() {
+    RUN_TEST(test_ina233_decode_energy);
+    RUN_TEST(test_ina233_average_power);
+    RUN_TEST(test_ina233_average_power_wraps);
+    RUN_TEST(test_ina233_no_new_samples);
+    RUN_TEST(test_ina233_adc_config_word);
+}
@@ -0,0 +1,81 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/drivers/Ms5607.h"
+
+
+using namespace std;
+using namespace Cesium;
+using namespace Cesium::Sensor;
+
+// Calibration words from the MS5607 datasheet example, CRC filled in by make_prom
+static void make_prom(uint16_t* words)
+{
+    const uint16_t C[6] = {46372, 43981, 29059, 27842, 31553, 28165};
+
+    words[0] = 0;
+    for (size_t i = 0; i < 6; i++) {
+        words[1 + i] = C[i];
+    }
+    words[7] = 0x1230;
+    words[7] |= Ms5607::prom_crc4(words);
+}
+
+////////////////////////////////////////////////////////////
+//                        Test PROM                       //
+////////////////////////////////////////////////////////////
+
+void test_ms5607_prom_crc() {
+    static Ms5607 ms5607(0, nullptr);
+
+    uint16_t words[Ms5607::PROM_WORDS];
+    make_prom(words);
+    TEST_ASSERT_TRUE(ms5607.load_prom(words));
+
+    words[3] ^= 0x0100;
+    TEST_ASSERT_FALSE(ms5607.load_prom(words));
+
+    // Nothing on the bus
+    uint16_t zeros[Ms5607::PROM_WORDS] = {0};
+    TEST_ASSERT_FALSE(ms5607.load_prom(zeros));
+}
+
+////////////////////////////////////////////////////////////
+//                    Test compensation                   //
+////////////////////////////////////////////////////////////
+
+void test_ms5607_compensation() {
+    static Ms5607 ms5607(0, nullptr);
+
+    uint16_t words[Ms5607::PROM_WORDS];
+    make_prom(words);
+    TEST_ASSERT_TRUE(ms5607.load_prom(words));
+
+    // Datasheet example: TEMP = 2000 (20.00 C), P = 110002 (1100.02 mbar)
+    ms5607.compensate(6465444, 8077636);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 20.0f, ms5607.get_temp_C());
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 110.002f, ms5607.get_pressure_kPa());
+}
+
+void test_ms5607_second_order_compensation() {
+    static Ms5607 ms5607(0, nullptr);
+
+    uint16_t words[Ms5607::PROM_WORDS];
+    make_prom(words);
+    TEST_ASSERT_TRUE(ms5607.load_prom(words));
+
+    // Below 20 C the second order terms kick in: dT = -599932, T2 = 167
+    ms5607.compensate(6465444, 7477636);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, -1.81f, ms5607.get_temp_C());
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 104.861f, ms5607.get_pressure_kPa());
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void run_all_ms5607_tests() {
+    RUN_TEST(test_ms5607_prom_crc);
+    RUN_TEST(test_ms5607_compensation);
+    RUN_TEST(test_ms5607_second_order_compensation);
+}
@@ -0,0 +1,259 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/drivers/replay/ReplaySensors.h"
+
+
+using namespace std;
+using namespace Cesium;
+using namespace Cesium::Sensor;
+
+// 1 ms apart from t = 1000 us, alternating between IMU 0 and IMU 1
+static ImuSample pipeline_log[6];
+
+// 10 ms apart from t = 500 us
+static ImuFifoSample fifo_log[4];
+
+static void make_logs()
+{
+    for (size_t i = 0; i < 6; i++) {
+        pipeline_log[i].time_us = 1000 + i * 1000;
+        pipeline_log[i].imu_id = i % 2;
+        for (size_t j = 0; j < 3; j++) {
+            pipeline_log[i].accel_mps2[j] = i;
+            pipeline_log[i].w_rps[j] = -(float)i;
+        }
+        pipeline_log[i].temp_C = 25.0f;
+    }
+
+    for (size_t i = 0; i < 4; i++) {
+        fifo_log[i].time_us = 500 + i * 10000;
+        for (size_t j = 0; j < 3; j++) {
+            fifo_log[i].accel_mps2[j] = i;
+            fifo_log[i].w_rps[j] = 0;
+            fifo_log[i].B_uT[j] = 40.0f + j;
+        }
+        fifo_log[i].temp_C = NAN;
+    }
+}
+
+////////////////////////////////////////////////////////////
+//                        Source                          //
+////////////////////////////////////////////////////////////
+
+void test_replay_source_filter() {
+    make_logs();
+
+    ReplaySource source(sizeof(ImuSample));
+    TEST_ASSERT_FALSE(source.open("/not/a/log"));
+
+    // Half a record on the end is dropped
+    source.attach((const uint8_t*)pipeline_log, sizeof(pipeline_log) - 3);
+    TEST_ASSERT_EQUAL(5, source.size());
+
+    source.set_id_filter(offsetof(ImuSample, imu_id), 1);
+    TEST_ASSERT_EQUAL(2000, source.first_time_us());
+
+    ReplayClock::start(0, ReplayClock::Mode::FREE_RUNNING);
+    TEST_ASSERT_EQUAL_PTR(&pipeline_log[1], source.next());
+    TEST_ASSERT_EQUAL_PTR(&pipeline_log[3], source.next());
+    TEST_ASSERT_NULL(source.next());
+    TEST_ASSERT_TRUE(source.finished());
+
+    // Free running moves the clock with what was read
+    TEST_ASSERT_EQUAL(4000, ReplayClock::now_us());
+}
+
+void test_replay_source_free_running_order() {
+    make_logs();
+
+    BaroSample baro_log[2] = {};
+    baro_log[0].time_us = 2000;
+    baro_log[1].time_us = 4000;
+
+    ReplaySource imu_source(sizeof(ImuSample));
+    imu_source.attach((const uint8_t*)pipeline_log, sizeof(pipeline_log));
+    imu_source.set_id_filter(offsetof(ImuSample, imu_id), 0);
+
+    ReplaySource baro_source(sizeof(BaroSample));
+    baro_source.attach((const uint8_t*)baro_log, sizeof(baro_log));
+
+    ReplayClock::start(0, ReplayClock::Mode::FREE_RUNNING);
+    TEST_ASSERT_EQUAL_PTR(&pipeline_log[0], imu_source.next());
+    TEST_ASSERT_EQUAL_PTR(&baro_log[0], baro_source.next());
+    TEST_ASSERT_EQUAL_PTR(&pipeline_log[2], imu_source.next());
+
+    // The barometer record at 4000 comes first, so the IMU waits for it
+    TEST_ASSERT_NULL(imu_source.next());
+    TEST_ASSERT_EQUAL(4000, ReplayClock::now_us());
+    TEST_ASSERT_EQUAL_PTR(&baro_log[1], baro_source.next());
+    TEST_ASSERT_EQUAL_PTR(&pipeline_log[4], imu_source.next());
+    TEST_ASSERT_EQUAL(0, imu_source.get_skipped());
+
+    // Both logs done, the clock stays on the last record
+    TEST_ASSERT_NULL(baro_source.next());
+    TEST_ASSERT_NULL(imu_source.next());
+    TEST_ASSERT_EQUAL(5000, ReplayClock::now_us());
+}
+
+void test_replay_source_manual_clock() {
+    make_logs();
+
+    ReplaySource source(sizeof(ImuSample));
+    source.attach((const uint8_t*)pipeline_log, sizeof(pipeline_log));
+
+    ReplayClock::start(0, ReplayClock::Mode::MANUAL);
+    TEST_ASSERT_NULL(source.next());
+
+    // Two due, the older one is skipped
+    ReplayClock::advance_to(2500);
+    TEST_ASSERT_EQUAL(1, source.due_count(1));
+    TEST_ASSERT_EQUAL(2, source.due_count(SIZE_MAX));
+    const uint8_t* record = source.next();
+    TEST_ASSERT_EQUAL_PTR(&pipeline_log[1], record);
+    TEST_ASSERT_EQUAL(1, source.get_skipped());
+    TEST_ASSERT_NULL(source.next());
+
+    // Without skipping, one per call
+    ReplayClock::advance_to(4000);
+    TEST_ASSERT_EQUAL_PTR(&pipeline_log[2], source.next(false));
+    TEST_ASSERT_EQUAL_PTR(&pipeline_log[3], source.next(false));
+    TEST_ASSERT_NULL(source.next(false));
+
+    // Never backwards
+    ReplayClock::advance_to(1000);
+    TEST_ASSERT_EQUAL(4000, ReplayClock::now_us());
+}
+
+////////////////////////////////////////////////////////////
+//                       Drivers                          //
+////////////////////////////////////////////////////////////
+
+void test_replay_imu_pipeline_log() {
+    make_logs();
+
+    ReplayImu imu(ReplayImu::Format::PIPELINE, 0);
+    TEST_ASSERT_FALSE(imu.setup());
+    imu.get_source().attach((const uint8_t*)pipeline_log, sizeof(pipeline_log));
+    TEST_ASSERT_TRUE(imu.setup());
+
+    // Body frame through the calibration, like a real driver
+    Matrix3<float> R_sensor_to_body = {{{0, -1, 0}, {1, 0, 0}, {0, 0, 1}}};
+    imu.set_accel_calibration(Calibration3(R_sensor_to_body, Vector3<float>{}));
+
+    ReplayClock::start(1000, ReplayClock::Mode::MANUAL);
+    TEST_ASSERT_TRUE(imu.read());
+    TEST_ASSERT_EQUAL(1000, imu.get_sample_time_us());
+    TEST_ASSERT_FALSE(imu.read());
+
+    // Only IMU 0 records, the newest due one
+    ReplayClock::advance_to(5500);
+    TEST_ASSERT_TRUE(imu.read());
+    TEST_ASSERT_EQUAL(5000, imu.get_sample_time_us());
+    TEST_ASSERT_EQUAL_FLOAT(4, imu.get_accel_mps2()[0][0]);
+    TEST_ASSERT_EQUAL_FLOAT(-4, imu.get_accel_body_mps2()[0][0]);
+    TEST_ASSERT_EQUAL_FLOAT(-4, imu.get_w_rps()[2][0]);
+    TEST_ASSERT_EQUAL_FLOAT(25, imu.get_temp_C());
+}
+
+void test_replay_imu_fifo_log() {
+    make_logs();
+
+    ReplayImu imu;
+    imu.get_source().attach((const uint8_t*)fifo_log, sizeof(fifo_log));
+
+    ReplayClock::start(imu.get_source().first_time_us(), ReplayClock::Mode::FREE_RUNNING);
+
+    size_t reads = 0;
+    while (imu.read()) {
+        reads++;
+    }
+    TEST_ASSERT_EQUAL(4, reads);
+    TEST_ASSERT_EQUAL(30500, imu.get_sample_time_us());
+    TEST_ASSERT_EQUAL_FLOAT(3, imu.get_accel_mps2()[2][0]);
+    TEST_ASSERT_EQUAL_FLOAT(42, imu.get_B_body_uT()[2][0]);
+}
+
+void test_replay_imu_fifo_interface() {
+    make_logs();
+
+    ReplayImu imu(ReplayImu::Format::PIPELINE, 1);
+    TEST_ASSERT_TRUE(imu.configure_fifo(8));
+    imu.get_source().attach((const uint8_t*)pipeline_log, sizeof(pipeline_log));
+
+    Matrix3<float> R_sensor_to_body = {{{0, -1, 0}, {1, 0, 0}, {0, 0, 1}}};
+    imu.set_accel_calibration(Calibration3(R_sensor_to_body, Vector3<float>{}));
+
+    ReplayClock::start(0, ReplayClock::Mode::MANUAL);
+    ReplayClock::advance_to(4500);
+    TEST_ASSERT_EQUAL(2, imu.get_fifo_frames());
+
+    // Every due frame in order, in the body frame, and read() still has its own cursor
+    ImuFifoSample samples[4];
+    TEST_ASSERT_EQUAL(2, imu.read_fifo(samples, 4));
+    TEST_ASSERT_EQUAL(2000, samples[0].time_us);
+    TEST_ASSERT_EQUAL(4000, samples[1].time_us);
+    TEST_ASSERT_EQUAL_FLOAT(-3, samples[1].accel_mps2[0]);
+    TEST_ASSERT_TRUE(isnan(samples[1].B_uT[0]));
+    TEST_ASSERT_EQUAL(2, imu.get_fifo_frames_read());
+    TEST_ASSERT_EQUAL(0, imu.get_fifo_frames());
+    TEST_ASSERT_TRUE(imu.read());
+    TEST_ASSERT_EQUAL(4000, imu.get_sample_time_us());
+
+    ReplayClock::advance_to(7000);
+    TEST_ASSERT_TRUE(imu.flush_fifo());
+    TEST_ASSERT_EQUAL(0, imu.get_fifo_frames());
+    TEST_ASSERT_EQUAL(0, imu.get_fifo_frames_read());
+}
+
+void test_replay_barometer_and_gps() {
+    BaroSample baro_log[3];
+    for (size_t i = 0; i < 3; i++) {
+        baro_log[i] = {(uint64_t)(i + 1) * 20000, (uint8_t)(i == 1), 101.325f - i, 10.0f * i, 20.0f};
+    }
+
+    ReplayBarometer baro(0);
+    baro.get_source().attach((const uint8_t*)baro_log, sizeof(baro_log));
+
+    ReplayClock::start(0, ReplayClock::Mode::MANUAL);
+    ReplayClock::advance_to(60000);
+    TEST_ASSERT_TRUE(baro.read());
+    TEST_ASSERT_EQUAL(60000, baro.get_sample_time_us());
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, baro.get_altitude_m());
+    TEST_ASSERT_FALSE(baro.read());
+
+    GpsFix gps_log[2] = {};
+    gps_log[0].time_us = 100000;
+    gps_log[0].latitude_e7 = 340000000;
+    gps_log[1].time_us = 200000;
+    gps_log[1].latitude_e7 = 340000100;
+
+    ReplayGps gps;
+    gps.get_source().attach((const uint8_t*)gps_log, sizeof(gps_log));
+
+    ReplayClock::advance_to(150000);
+    TEST_ASSERT_TRUE(gps.read());
+    GpsFix fix;
+    TEST_ASSERT_TRUE(gps.get_fix(fix));
+    TEST_ASSERT_EQUAL(340000000, fix.latitude_e7);
+    TEST_ASSERT_FALSE(gps.read());
+
+    ReplayClock::advance_to(250000);
+    TEST_ASSERT_TRUE(gps.read());
+    TEST_ASSERT_TRUE(gps.get_fix(fix));
+    TEST_ASSERT_EQUAL(340000100, fix.latitude_e7);
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void run_all_replay_tests() {
+    RUN_TEST(test_replay_source_filter);
+    RUN_TEST(test_replay_source_free_running_order);
+    RUN_TEST(test_replay_source_manual_clock);
+    RUN_TEST(test_replay_imu_pipeline_log);
+    RUN_TEST(test_replay_imu_fifo_log);
+    RUN_TEST(test_replay_imu_fifo_interface);
+    RUN_TEST(test_replay_barometer_and_gps);
+}
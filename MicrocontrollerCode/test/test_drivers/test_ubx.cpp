@@ -0,0 +1,157 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/drivers/UbxParser.h"
+#include "common/drivers/UBloxGps.h"
+
+
+using namespace std;
+using namespace Cesium;
+using namespace Cesium::Sensor;
+
+template <typename T>
+static void put_le(uint8_t* payload, size_t offset, T value)
+{
+    memcpy(payload + offset, &value, sizeof(T));
+}
+
+// NAV-PVT of a 3D fix over Los Angeles
+static void make_nav_pvt(uint8_t* payload)
+{
+    memset(payload, 0, UBX_NAV_PVT_LENGTH);
+    put_le<uint32_t>(payload, 0, 345600000);
+    put_le<uint16_t>(payload, 4, 2024);
+    payload[6] = 5;
+    payload[7] = 17;
+    payload[8] = 12;
+    payload[9] = 30;
+    payload[10] = 45;
+    payload[11] = 0x07;
+    put_le<uint32_t>(payload, 12, 25);
+    put_le<int32_t>(payload, 16, -1200);
+    payload[20] = 3;
+    payload[21] = 0x01;
+    payload[23] = 14;
+    put_le<int32_t>(payload, 24, -1182437000);
+    put_le<int32_t>(payload, 28, 340522000);
+    put_le<int32_t>(payload, 32, 71000);
+    put_le<int32_t>(payload, 36, 105000);
+    put_le<uint32_t>(payload, 40, 1800);
+    put_le<uint32_t>(payload, 44, 2500);
+    put_le<int32_t>(payload, 48, 1500);
+    put_le<int32_t>(payload, 52, -2000);
+    put_le<int32_t>(payload, 56, -35000);
+    put_le<int32_t>(payload, 60, 2500);
+    put_le<int32_t>(payload, 64, 12687000);
+    put_le<uint32_t>(payload, 68, 300);
+    put_le<uint32_t>(payload, 72, 150000);
+    put_le<uint16_t>(payload, 76, 132);
+}
+
+static bool feed(UbxParser& parser, const uint8_t* bytes, size_t len)
+{
+    bool complete = false;
+    for (size_t i = 0; i < len; i++) {
+        complete = parser.parse(bytes[i]);
+    }
+    return complete;
+}
+
+////////////////////////////////////////////////////////////
+//                      Test parser                       //
+////////////////////////////////////////////////////////////
+
+void test_ubx_checksum() {
+    // UBX-CFG-RATE poll, checksum from the interface description
+    uint8_t frame[UbxParser::FRAME_OVERHEAD];
+    TEST_ASSERT_EQUAL(8, UbxParser::build_frame(0x06, 0x08, nullptr, 0, frame));
+    TEST_ASSERT_EQUAL_HEX8(0x0E, frame[6]);
+    TEST_ASSERT_EQUAL_HEX8(0x30, frame[7]);
+}
+
+void test_ubx_parse_stream() {
+    static UbxParser parser;
+
+    uint8_t payload[UBX_NAV_PVT_LENGTH];
+    make_nav_pvt(payload);
+    uint8_t frame[UBX_NAV_PVT_LENGTH + UbxParser::FRAME_OVERHEAD];
+    size_t frame_len = UbxParser::build_frame(UBX_CLASS_NAV_ID, UBX_NAV_PVT_ID, payload, UBX_NAV_PVT_LENGTH, frame);
+
+    // NMEA leftovers and a stray sync byte before the frame
+    const char* noise = "$GPGGA,,*66\r\n\xB5";
+    TEST_ASSERT_FALSE(feed(parser, (const uint8_t*)noise, strlen(noise)));
+
+    // Completes on the very last byte only
+    TEST_ASSERT_FALSE(feed(parser, frame, frame_len - 1));
+    TEST_ASSERT_TRUE(parser.parse(frame[frame_len - 1]));
+    TEST_ASSERT_EQUAL(UBX_CLASS_NAV_ID, parser.get_class());
+    TEST_ASSERT_EQUAL(UBX_NAV_PVT_ID, parser.get_id());
+    TEST_ASSERT_EQUAL(UBX_NAV_PVT_LENGTH, parser.get_length());
+    TEST_ASSERT_EQUAL_MEMORY(payload, parser.get_payload(), UBX_NAV_PVT_LENGTH);
+
+    // Corrupt payload is dropped, the next good frame still parses
+    frame[30] ^= 0xFF;
+    TEST_ASSERT_FALSE(feed(parser, frame, frame_len));
+    TEST_ASSERT_EQUAL(1, parser.get_checksum_errors());
+    frame[30] ^= 0xFF;
+    TEST_ASSERT_TRUE(feed(parser, frame, frame_len));
+    TEST_ASSERT_EQUAL(2, parser.get_frames());
+}
+
+void test_ubx_parse_oversized() {
+    static UbxParser parser;
+
+    uint8_t payload[UBX_NAV_PVT_LENGTH];
+    make_nav_pvt(payload);
+    uint8_t frame[UBX_NAV_PVT_LENGTH + UbxParser::FRAME_OVERHEAD];
+    size_t frame_len = UbxParser::build_frame(UBX_CLASS_NAV_ID, UBX_NAV_PVT_ID, payload, UBX_NAV_PVT_LENGTH, frame);
+
+    // A corrupt length is dropped at once instead of swallowing the next frame as its payload
+    const uint8_t header[] = {0xB5, 0x62, UBX_CLASS_NAV_ID, UBX_NAV_PVT_ID, 0xFF, 0xFF};
+    TEST_ASSERT_FALSE(feed(parser, header, sizeof(header)));
+    TEST_ASSERT_EQUAL(1, parser.get_oversized());
+    TEST_ASSERT_EQUAL(UbxParser::State::SYNC_1, parser.get_state());
+
+    TEST_ASSERT_TRUE(feed(parser, frame, frame_len));
+    TEST_ASSERT_EQUAL(0, parser.get_checksum_errors());
+    TEST_ASSERT_EQUAL(1, parser.get_frames());
+}
+
+////////////////////////////////////////////////////////////
+//                      Test NAV-PVT                      //
+////////////////////////////////////////////////////////////
+
+void test_ubx_decode_nav_pvt() {
+    uint8_t payload[UBX_NAV_PVT_LENGTH];
+    make_nav_pvt(payload);
+
+    GpsFix fix;
+    TEST_ASSERT_FALSE(UBloxGps::decode_nav_pvt(payload, 40, fix));
+    TEST_ASSERT_TRUE(UBloxGps::decode_nav_pvt(payload, UBX_NAV_PVT_LENGTH, fix));
+
+    TEST_ASSERT_EQUAL(345600000, fix.iTOW_ms);
+    TEST_ASSERT_EQUAL(2024, fix.year);
+    TEST_ASSERT_EQUAL(45, fix.second);
+    TEST_ASSERT_EQUAL(-1200, fix.nano_ns);
+    TEST_ASSERT_EQUAL(3, fix.fix_type);
+    TEST_ASSERT_EQUAL(14, fix.satellites);
+    TEST_ASSERT_EQUAL(-1182437000, fix.longitude_e7);
+    TEST_ASSERT_EQUAL(340522000, fix.latitude_e7);
+    TEST_ASSERT_EQUAL(105000, fix.height_msl_mm);
+    TEST_ASSERT_EQUAL(2500, fix.v_acc_mm);
+    TEST_ASSERT_EQUAL(-35000, fix.vel_d_mmps);
+    TEST_ASSERT_EQUAL(12687000, fix.heading_motion_e5);
+    TEST_ASSERT_EQUAL(150000, fix.heading_acc_e5);
+    TEST_ASSERT_EQUAL(132, fix.pdop_e2);
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void run_all_ubx_tests() {
+    RUN_TEST(test_ubx_checksum);
+    RUN_TEST(test_ubx_parse_stream);
+    RUN_TEST(test_ubx_parse_oversized);
+    RUN_TEST(test_ubx_decode_nav_pvt);
+}
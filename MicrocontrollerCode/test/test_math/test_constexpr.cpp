@@ -0,0 +1,69 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/math/quaternion.h"
+using namespace std;
+using namespace ConstexprMath;
+
+// All built by the compiler. Each static_assert fails the build if it isn't
+constexpr Matrix3<float> R_ROLL_90 = {{{1, 0, 0}, {0, 0, -1}, {0, 1, 0}}};
+constexpr Matrix3<float> R_YAW_90 = {{{0, -1, 0}, {1, 0, 0}, {0, 0, 1}}};
+constexpr Matrix3<float> R_COMBINED = R_YAW_90 * R_ROLL_90;
+constexpr Quaternion<float> Q_ROLL_90 = quat_from_R(R_ROLL_90);
+constexpr Quaternion<float> Q_AXIS = quat_from_axis_rot<float>(90, {{{1}, {0}, {0}}});
+constexpr Vector3<float> ROTATED = quat_rotate(Q_ROLL_90, Vector3<float>{{{0}, {1}, {0}}});
+constexpr Matrix<int, 2, 2> INT_PRODUCT = Matrix<int, 2, 2>{{{1, 2}, {3, 4}}} * Matrix<int, 2, 2>{{{0, 1}, {1, 0}}};
+
+static_assert(R_COMBINED[0][2] == 1, "3x3 product at compile time");
+static_assert(matrix_float_equals(transpose(R_ROLL_90) * R_ROLL_90, Matrix3<float>{{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}}),
+              "transpose at compile time");
+static_assert(const_abs(Q_ROLL_90[0][0] - 0.70710678f) < 1e-6f, "quat_from_R at compile time");
+static_assert(matrix_float_equals(Q_ROLL_90, Q_AXIS), "quat_from_axis_rot at compile time");
+static_assert(const_abs(ROTATED[2][0] - 1) < 1e-6f, "quat_rotate at compile time");
+static_assert(INT_PRODUCT[1][0] == 4, "int product at compile time");
+static_assert(const_abs(norm(Vector<float, 2>{{{3}, {4}}}) - 5) < 1e-6f, "norm at compile time");
+
+////////////////////////////////////////////////////////////
+//                   Test portable math                   //
+////////////////////////////////////////////////////////////
+
+// What other compilers use, against libm
+void test_portable_math() {
+    static_assert(portable_sqrt(16.0) == 4.0, "portable sqrt at compile time");
+
+    const float values[] = {0, 1e-6f, 0.25f, 1, 2, 10, 12345.678f};
+    for (float x : values) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f * (1 + x), sqrtf(x), portable_sqrt(x));
+    }
+    TEST_ASSERT_TRUE(isnan(portable_sqrt(-1.0f)));
+
+    for (float x = -20; x <= 20; x += 0.37f) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, sinf(x), portable_sin(x));
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, cosf(x), portable_cos(x));
+    }
+}
+
+// Constant results match what the same code computes at runtime
+void test_constexpr_matches_runtime() {
+    Matrix3<float> roll = R_ROLL_90;
+    Matrix3<float> yaw = R_YAW_90;
+    TEST_ASSERT_TRUE(matrix_float_equals(R_COMBINED, yaw * roll));
+    TEST_ASSERT_TRUE(matrix_float_equals(Q_ROLL_90, quat_from_R(roll)));
+
+    Matrix<float, 6, 6> A{};
+    for (size_t i = 0; i < 6; i++) {
+        A[i][5 - i] = i + 1;
+    }
+    constexpr Matrix<float, 6, 6> IDENTITY = {{{1, 0, 0, 0, 0, 0}, {0, 1, 0, 0, 0, 0}, {0, 0, 1, 0, 0, 0},
+                                              {0, 0, 0, 1, 0, 0}, {0, 0, 0, 0, 1, 0}, {0, 0, 0, 0, 0, 1}}};
+    TEST_ASSERT_TRUE(matrix_float_equals(A, A * IDENTITY));
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void test_all_constexpr() {
+    RUN_TEST(test_portable_math);
+    RUN_TEST(test_constexpr_matches_runtime);
+}
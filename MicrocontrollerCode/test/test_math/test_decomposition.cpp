@@ -0,0 +1,372 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/math/decomposition.h"
+#include "common/math/fixed.h"
+#include "common/math/vector.h"
+using namespace std;
+
+template <typename T, size_t row, size_t col>
+static void fill_matrix(Matrix<T, row, col>& mat, uint32_t seed) {
+    for (size_t i = 0; i < row; i++) {
+        for (size_t j = 0; j < col; j++) {
+            seed = seed * 1664525 + 1013904223;
+            mat[i][j] = (seed >> 8) / (float)(1 << 24) * 4 - 2;
+        }
+    }
+}
+
+// M M^T + N I, symmetric and well away from singular, like a covariance
+template <size_t N>
+static Matrix<float, N, N> make_spd(uint32_t seed) {
+    Matrix<float, N, N> M;
+    fill_matrix(M, seed);
+    Matrix<float, N, N> A = M * transpose(M);
+    for (size_t i = 0; i < N; i++) {
+        A[i][i] += N;
+    }
+    return A;
+}
+
+template <size_t N>
+static Matrix<float, N, N> identity() {
+    Matrix<float, N, N> result{};
+    for (size_t i = 0; i < N; i++) {
+        result[i][i] = 1;
+    }
+    return result;
+}
+
+template <size_t row, size_t col>
+static float max_difference(const Matrix<float, row, col>& mat1, const Matrix<float, row, col>& mat2) {
+    float difference = 0;
+    for (size_t i = 0; i < row; i++) {
+        for (size_t j = 0; j < col; j++) {
+            difference = fmaxf(difference, fabsf(mat1[i][j] - mat2[i][j]));
+        }
+    }
+    return difference;
+}
+
+////////////////////////////////////////////////////////////
+//                 Triangular solves                      //
+////////////////////////////////////////////////////////////
+
+void test_forward_substitution() {
+    Matrix<float, 3, 3> L = {{{2, 9, 9}, {1, 4, 9}, {-3, 2, 0.5}}};
+    Vector3<float> b = {4, 6, 1};
+
+    // Upper triangle is ignored
+    Vector3<float> x = forward_substitution(L, b);
+    TEST_ASSERT_EQUAL_FLOAT(2, x[0][0]);
+    TEST_ASSERT_EQUAL_FLOAT(1, x[1][0]);
+    TEST_ASSERT_EQUAL_FLOAT(10, x[2][0]);
+
+    Vector3<float> x_unit = forward_substitution(L, b, true);
+    TEST_ASSERT_EQUAL_FLOAT(4, x_unit[0][0]);
+    TEST_ASSERT_EQUAL_FLOAT(2, x_unit[1][0]);
+    TEST_ASSERT_EQUAL_FLOAT(9, x_unit[2][0]);
+}
+
+void test_back_substitution() {
+    Matrix<float, 3, 3> U = {{{2, 1, -1}, {9, 4, 2}, {9, 9, 0.5}}};
+    Vector3<float> b = {1, 10, 1};
+
+    Vector3<float> x = back_substitution(U, b);
+    TEST_ASSERT_EQUAL_FLOAT(2, x[2][0]);
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, x[1][0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.75f, x[0][0]);
+}
+
+////////////////////////////////////////////////////////////
+//                       LDL^T                            //
+////////////////////////////////////////////////////////////
+
+template <size_t N>
+static void check_ldlt() {
+    Matrix<float, N, N> A = make_spd<N>(N * 7);
+    Matrix<float, N, N> LD{};
+    TEST_ASSERT_TRUE(ldlt_decompose(A, LD));
+
+    // L D L^T gives A back
+    Matrix<float, N, N> L{}, D{};
+    for (size_t i = 0; i < N; i++) {
+        L[i][i] = 1;
+        D[i][i] = LD[i][i];
+        TEST_ASSERT_TRUE(LD[i][i] > 0);
+        for (size_t j = 0; j < i; j++) {
+            L[i][j] = LD[i][j];
+        }
+        for (size_t j = i + 1; j < N; j++) {
+            TEST_ASSERT_EQUAL_FLOAT(0, LD[i][j]);
+        }
+    }
+    TEST_ASSERT_TRUE(max_difference(L * D * transpose(L), A) < 1e-4f * N);
+
+    // Solves to a small residual
+    Matrix<float, N, 2> b;
+    fill_matrix(b, N * 11);
+    Matrix<float, N, 2> x = ldlt_solve(LD, b);
+    TEST_ASSERT_TRUE(max_difference(A * x, b) < 1e-4f * N);
+
+    // Packed storage gives the same numbers
+    SymMatrix<float, N> LD_packed{};
+    TEST_ASSERT_TRUE(ldlt_decompose(sym_pack(A), LD_packed));
+    TEST_ASSERT_TRUE(max_difference(sym_unpack(LD_packed), LD + transpose(LD) - D) < 1e-6f);
+    TEST_ASSERT_TRUE(max_difference(ldlt_solve(LD_packed, b), x) < 1e-6f);
+}
+
+void test_ldlt() {
+    check_ldlt<1>();
+    check_ldlt<3>();
+    check_ldlt<6>();
+    check_ldlt<9>();
+    check_ldlt<15>();
+}
+
+void test_ldlt_not_positive_definite() {
+    Matrix<float, 3, 3> indefinite = {{{1, 2, 0}, {2, 1, 0}, {0, 0, 1}}};
+    Matrix<float, 3, 3> singular = {{{1, 1, 0}, {1, 1, 0}, {0, 0, 1}}};
+    Matrix<float, 3, 3> LD = identity<3>();
+
+    TEST_ASSERT_FALSE(ldlt_decompose(indefinite, LD));
+    TEST_ASSERT_FALSE(ldlt_decompose(singular, LD));
+
+    // Left alone on failure
+    TEST_ASSERT_TRUE(matrix_float_equals(LD, identity<3>()));
+
+    Matrix<float, 3, 3> inv = identity<3>();
+    TEST_ASSERT_FALSE(sym_inverse(singular, inv));
+    TEST_ASSERT_TRUE(matrix_float_equals(inv, identity<3>()));
+}
+
+////////////////////////////////////////////////////////////
+//                         LU                             //
+////////////////////////////////////////////////////////////
+
+template <size_t N>
+static void check_lu() {
+    Matrix<float, N, N> A;
+    fill_matrix(A, N * 13);
+    for (size_t i = 0; i < N; i++) {
+        A[i][i] += 2;
+    }
+
+    Matrix<float, N, N> LU{};
+    std::array<size_t, N> perm{};
+    TEST_ASSERT_TRUE(lu_decompose(A, LU, perm));
+
+    // L U gives back A with its rows in perm order
+    Matrix<float, N, N> L{}, U{}, PA{};
+    for (size_t i = 0; i < N; i++) {
+        PA[i] = A[perm[i]];
+        L[i][i] = 1;
+        for (size_t j = 0; j < N; j++) {
+            if (j < i) {
+                L[i][j] = LU[i][j];
+                TEST_ASSERT_TRUE(fabsf(L[i][j]) <= 1);
+            } else {
+                U[i][j] = LU[i][j];
+            }
+        }
+    }
+    TEST_ASSERT_TRUE(max_difference(L * U, PA) < 1e-4f * N);
+
+    Matrix<float, N, 1> b;
+    fill_matrix(b, N * 17);
+    TEST_ASSERT_TRUE(max_difference(A * lu_solve(LU, perm, b), b) < 1e-4f * N);
+}
+
+void test_lu() {
+    check_lu<1>();
+    check_lu<3>();
+    check_lu<6>();
+    check_lu<9>();
+    check_lu<15>();
+}
+
+void test_lu_pivoting() {
+    // Without the row swap the first pivot is zero
+    Matrix<float, 3, 3> A = {{{0, 2, 1}, {1, 1, 1}, {4, 0, 3}}};
+    Vector3<float> b = {5, 6, 15};
+
+    Matrix<float, 3, 3> LU{};
+    std::array<size_t, 3> perm{};
+    TEST_ASSERT_TRUE(lu_decompose(A, LU, perm));
+    TEST_ASSERT_EQUAL_INT(2, perm[0]);
+
+    Vector3<float> x = lu_solve(LU, perm, b);
+    TEST_ASSERT_EQUAL_FLOAT(3, x[0][0]);
+    TEST_ASSERT_EQUAL_FLOAT(2, x[1][0]);
+    TEST_ASSERT_EQUAL_FLOAT(1, x[2][0]);
+
+    Matrix<float, 3, 3> singular = {{{1, 2, 3}, {2, 4, 6}, {0, 1, 1}}};
+    TEST_ASSERT_FALSE(lu_decompose(singular, LU, perm));
+}
+
+////////////////////////////////////////////////////////////
+//                       Inverse                          //
+////////////////////////////////////////////////////////////
+
+template <size_t N>
+static void check_inverse() {
+    Matrix<float, N, N> A = make_spd<N>(N * 19);
+    Matrix<float, N, N> inv{}, inv_sym{};
+
+    TEST_ASSERT_TRUE(inverse(A, inv));
+    TEST_ASSERT_TRUE(max_difference(A * inv, identity<N>()) < 1e-5f * N);
+
+    TEST_ASSERT_TRUE(sym_inverse(A, inv_sym));
+    TEST_ASSERT_TRUE(max_difference(A * inv_sym, identity<N>()) < 1e-5f * N);
+    TEST_ASSERT_TRUE(matrix_float_equals(inv_sym, transpose(inv_sym)));
+
+    SymMatrix<float, N> inv_packed{};
+    TEST_ASSERT_TRUE(sym_inverse(sym_pack(A), inv_packed));
+    TEST_ASSERT_TRUE(max_difference(sym_unpack(inv_packed), inv_sym) < 1e-6f);
+
+    // In place
+    Matrix<float, N, N> A_copy = A;
+    TEST_ASSERT_TRUE(inverse(A_copy, A_copy));
+    TEST_ASSERT_TRUE(matrix_float_equals(A_copy, inv));
+}
+
+void test_inverse() {
+    check_inverse<1>();
+    check_inverse<3>();
+    check_inverse<6>();
+    check_inverse<9>();
+    check_inverse<15>();
+
+    Matrix<float, 2, 2> singular = {{{1, 2}, {2, 4}}};
+    Matrix<float, 2, 2> result{};
+    TEST_ASSERT_FALSE(inverse(singular, result));
+}
+
+void test_inverse_fixed() {
+    // Fixed goes through the same code
+    using Q15_16 = Fixed<15, 16>;
+    Matrix<float, 3, 3> A = {{{4, 1, 0.5f}, {1, 3, -0.25f}, {0.5f, -0.25f, 2}}};
+    Matrix<Q15_16, 3, 3> inv_fixed{};
+    Matrix<float, 3, 3> inv{};
+
+    TEST_ASSERT_TRUE(sym_inverse(matrix_cast<Q15_16>(A), inv_fixed));
+    TEST_ASSERT_TRUE(sym_inverse(A, inv));
+    TEST_ASSERT_TRUE(max_difference(matrix_cast<float>(inv_fixed), inv) < 1e-4f);
+}
+
+////////////////////////////////////////////////////////////
+//                 Symmetric operations                   //
+////////////////////////////////////////////////////////////
+
+void test_sym_storage() {
+    Matrix<float, 3, 3> A = {{{1, 9, 9}, {2, 3, 9}, {4, 5, 6}}};
+    SymMatrix<float, 3> packed = sym_pack(A);
+
+    TEST_ASSERT_EQUAL_INT(6, packed.size());
+    TEST_ASSERT_EQUAL_FLOAT(5, packed(2, 1));
+    TEST_ASSERT_EQUAL_FLOAT(5, packed(1, 2));
+
+    Matrix<float, 3, 3> expected = {{{1, 2, 4}, {2, 3, 5}, {4, 5, 6}}};
+    TEST_ASSERT_TRUE(matrix_float_equals(sym_unpack(packed), expected));
+}
+
+void test_sym_transform() {
+    Matrix<float, 6, 6> F;
+    fill_matrix(F, 23);
+    Matrix<float, 6, 6> P = make_spd<6>(29);
+    Matrix<float, 6, 6> Q = make_spd<6>(31);
+
+    Matrix<float, 6, 6> expected = F * P * transpose(F) + Q;
+    SymMatrix<float, 6> result = sym_transform(F, sym_pack(P)) + sym_pack(Q);
+    TEST_ASSERT_TRUE(max_difference(sym_unpack(result), expected) < 1e-4f);
+}
+
+////////////////////////////////////////////////////////////
+//                      Benchmark                         //
+////////////////////////////////////////////////////////////
+
+template <size_t N>
+static void benchmark_decomposition() {
+    constexpr uint32_t ITERATIONS = 100;
+    Matrix<float, N, N> A = make_spd<N>(N);
+    SymMatrix<float, N> A_packed = sym_pack(A);
+    Matrix<float, N, N> result{};
+    SymMatrix<float, N> result_packed{};
+    std::array<size_t, N> perm{};
+
+    // Each feeds its result back in so nothing is hoisted out of the loop
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        ldlt_decompose(A, result);
+        A[0][0] += result[N - 1][N - 1] * 1e-9f;
+    }
+    uint32_t ldlt_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        lu_decompose(A, result, perm);
+        A[0][0] += result[N - 1][N - 1] * 1e-9f;
+    }
+    uint32_t lu_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        inverse(A, result);
+        A[0][0] += result[N - 1][N - 1] * 1e-9f;
+    }
+    uint32_t inverse_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        sym_inverse(A, result);
+        A[0][0] += result[N - 1][N - 1] * 1e-9f;
+    }
+    uint32_t sym_inverse_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        sym_inverse(A_packed, result_packed);
+        A_packed(0, 0) += result_packed(N - 1, N - 1) * 1e-9f;
+    }
+    uint32_t packed_inverse_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    char line[128];
+    snprintf(line, sizeof(line), "%2ux%-2u  ldlt %6lu  lu %6lu  inverse %7lu  sym %7lu  packed %7lu cycles",
+             (unsigned)N, (unsigned)N,
+             (unsigned long)ldlt_cycles, (unsigned long)lu_cycles, (unsigned long)inverse_cycles,
+             (unsigned long)sym_inverse_cycles, (unsigned long)packed_inverse_cycles);
+    TEST_MESSAGE(line);
+}
+
+void test_decomposition_benchmark() {
+    benchmark_decomposition<3>();
+    benchmark_decomposition<4>();
+    benchmark_decomposition<6>();
+    benchmark_decomposition<9>();
+    benchmark_decomposition<15>();
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void test_all_decomposition() {
+
+    RUN_TEST(test_forward_substitution);
+    RUN_TEST(test_back_substitution);
+
+    RUN_TEST(test_ldlt);
+    RUN_TEST(test_ldlt_not_positive_definite);
+
+    RUN_TEST(test_lu);
+    RUN_TEST(test_lu_pivoting);
+
+    RUN_TEST(test_inverse);
+    RUN_TEST(test_inverse_fixed);
+
+    RUN_TEST(test_sym_storage);
+    RUN_TEST(test_sym_transform);
+
+    RUN_TEST(test_decomposition_benchmark);
+
+}
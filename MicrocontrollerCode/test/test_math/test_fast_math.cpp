@@ -0,0 +1,252 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/math/fast_math.h"
+using namespace std;
+
+// The chip would take hours to go through every float, so it checks a spread of them. So does the host by
+// default, every 61st float. -D FAST_MATH_EXHAUSTIVE checks all of them, which takes a few minutes
+#if defined(ARDUINO_ARCH_ESP32)
+constexpr uint32_t SWEEP_STRIDE = 65521;
+constexpr uint32_t ANGLE_STEPS = 1 << 12;
+#elif defined(FAST_MATH_EXHAUSTIVE)
+constexpr uint32_t SWEEP_STRIDE = 1;
+constexpr uint32_t ANGLE_STEPS = 1 << 24;
+#else
+constexpr uint32_t SWEEP_STRIDE = 61;
+constexpr uint32_t ANGLE_STEPS = 1 << 20;
+#endif
+
+static double error_of(float fast, double exact, bool relative) {
+    double error = fabs((double)fast - exact);
+    return relative && exact != 0 ? error / fabs(exact) : error;
+}
+
+// Largest error of fast against the double exact, over the positive floats in [lo, hi] and their negatives
+// when negative is set. Relative, or absolute in the units of the result
+template <typename Fast, typename Exact>
+static double sweep(float lo, float hi, bool negative, bool relative, Fast fast, Exact exact) {
+    double worst = 0;
+    uint32_t last = FastMath::float_bits(hi);
+    for (uint32_t bits = FastMath::float_bits(lo); bits <= last && bits >= FastMath::float_bits(lo); bits += SWEEP_STRIDE) {
+        float x = FastMath::bits_float(bits);
+        worst = fmax(worst, error_of(fast(x), exact((double)x), relative));
+        if (negative) {
+            worst = fmax(worst, error_of(fast(-x), exact(-(double)x), relative));
+        }
+    }
+    return worst;
+}
+
+static void report(const char* name, double error) {
+    char line[96];
+    snprintf(line, sizeof(line), "%-14s max error %.3g", name, error);
+    TEST_MESSAGE(line);
+}
+
+////////////////////////////////////////////////////////////
+//                      Log and exp                       //
+////////////////////////////////////////////////////////////
+
+void test_fast_log() {
+    double error = sweep(FLT_MIN, FLT_MAX, false, true,
+                         [](float x) {return FastMath::log(x);}, [](double x) {return ::log(x);});
+    report("log", error);
+    TEST_ASSERT_TRUE(error < 3e-7);
+
+    // Exactly 0 at 1, and libm outside the domain
+    TEST_ASSERT_EQUAL_FLOAT(0, FastMath::log(1));
+    TEST_ASSERT_TRUE(isinf(FastMath::log(0)));
+    TEST_ASSERT_TRUE(isnan(FastMath::log(-1)));
+    TEST_ASSERT_TRUE(isinf(FastMath::log(INFINITY)));
+}
+
+void test_fast_exp() {
+    double error = sweep(FLT_MIN, 88.0f, true, true,
+                         [](float x) {return FastMath::exp(x);}, [](double x) {return ::exp(x);});
+    report("exp", error);
+    TEST_ASSERT_TRUE(error < 3e-7);
+
+    TEST_ASSERT_EQUAL_FLOAT(1, FastMath::exp(0));
+    TEST_ASSERT_TRUE(isinf(FastMath::exp(100)));
+    TEST_ASSERT_EQUAL_FLOAT(0, FastMath::exp(-200));
+
+    double expm1_error = sweep(FLT_MIN, 1.0f, true, true,
+                               [](float y) {return FastMath::expm1(y);}, [](double y) {return ::expm1(y);});
+    report("expm1", expm1_error);
+    TEST_ASSERT_TRUE(expm1_error < 3e-7);
+}
+
+void test_fast_pow() {
+    const float exponents[] = {0.190263f, 0.1903f, -2.5f, 3.7f, 0.5f};
+
+    // Within 3e-7 plus 1.2e-7 |y ln x|, the rounding of y ln x, over the whole range pow is used on
+    double worst = 0;
+    for (float y : exponents) {
+        uint32_t last = FastMath::float_bits(100.0f);
+        for (uint32_t bits = FastMath::float_bits(0.01f); bits <= last; bits += SWEEP_STRIDE) {
+            float x = FastMath::bits_float(bits);
+            double exact = ::pow((double)x, (double)y);
+            double bound = 3e-7 + 1.2e-7 * fabs(y * ::log((double)x));
+            worst = fmax(worst, error_of(FastMath::pow(x, y), exact, true) / bound);
+        }
+    }
+    report("pow / bound", worst);
+    TEST_ASSERT_TRUE(worst < 1);
+
+    TEST_ASSERT_EQUAL_FLOAT(8, FastMath::pow(2, 3));
+    TEST_ASSERT_EQUAL_FLOAT(0, FastMath::pow(0, 2));
+    TEST_ASSERT_TRUE(isnan(FastMath::pow(-2, 0.5f)));
+}
+
+void test_fast_baro_altitude() {
+    // The MS5607's constants, from 30 km (1.2 kPa) to below sea level
+    const float exponent = 0.0065f * 287.052f / 9.80665f;
+    const float scale = (273.15f + 15) / 0.0065f;
+
+    double worst = 0;
+    double worst_m = 0;
+    uint32_t last = FastMath::float_bits(1.2f);
+    for (uint32_t bits = FastMath::float_bits(0.0118f); bits <= last; bits += SWEEP_STRIDE) {
+        float ratio = FastMath::bits_float(bits);
+        double exact = scale * -::expm1(exponent * ::log((double)ratio));
+        float fast = FastMath::baro_altitude(ratio, exponent, scale);
+        worst = fmax(worst, error_of(fast, exact, true));
+        worst_m = fmax(worst_m, error_of(fast, exact, false));
+    }
+    report("baro relative", worst);
+    report("baro m", worst_m);
+    TEST_ASSERT_TRUE(worst < 4e-7);
+    TEST_ASSERT_TRUE(worst_m < 5e-3);
+
+    // Same numbers as the libm version, to well under what the sensor resolves
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, LibMath::baro_altitude(0.8f, exponent, scale),
+                             FastMath::baro_altitude(0.8f, exponent, scale));
+    TEST_ASSERT_EQUAL_FLOAT(0, FastMath::baro_altitude(1, exponent, scale));
+}
+
+////////////////////////////////////////////////////////////
+//                        Angles                          //
+////////////////////////////////////////////////////////////
+
+void test_fast_atan2() {
+    // Around the circle, at radii from tiny to huge so the divide and the octants all get exercised
+    const float radii[] = {1e-30f, 1e-3f, 1, 7.5f, 1e30f};
+
+    double worst = 0;
+    for (float radius : radii) {
+        for (uint32_t i = 0; i < ANGLE_STEPS; i++) {
+            double angle = -M_PI + 2 * M_PI * i / ANGLE_STEPS;
+            float x = (float)(radius * cos(angle));
+            float y = (float)(radius * sin(angle));
+            worst = fmax(worst, error_of(FastMath::atan2(y, x), ::atan2((double)y, (double)x), false));
+        }
+    }
+    report("atan2 rad", worst);
+    TEST_ASSERT_TRUE(worst < 2.5e-7);
+
+    // The axes and zeros, signs included
+    TEST_ASSERT_EQUAL_FLOAT(0, FastMath::atan2(0, 1));
+    TEST_ASSERT_EQUAL_FLOAT(PI, FastMath::atan2(0, -1));
+    TEST_ASSERT_EQUAL_FLOAT(-PI / 2, FastMath::atan2(-1, 0));
+    TEST_ASSERT_EQUAL_FLOAT(atan2f(-0.0f, -0.0f), FastMath::atan2(-0.0f, -0.0f));
+}
+
+void test_fast_asin_acos() {
+    double asin_error = sweep(0.0f, 1.0f, true, false,
+                              [](float x) {return FastMath::asin(x);}, [](double x) {return ::asin(x);});
+    double acos_error = sweep(0.0f, 1.0f, true, false,
+                              [](float x) {return FastMath::acos(x);}, [](double x) {return ::acos(x);});
+    report("asin rad", asin_error);
+    report("acos rad", acos_error);
+    TEST_ASSERT_TRUE(asin_error < 2.5e-7);
+    TEST_ASSERT_TRUE(acos_error < 3.5e-7);
+
+    // Small angles near 1 stay accurate, which acos = pi/2 - asin would lose
+    TEST_ASSERT_FLOAT_WITHIN(1e-9f, ::acos((double)0.99999994f), FastMath::acos(0.99999994f));
+    TEST_ASSERT_TRUE(isnan(FastMath::asin(1.5f)));
+}
+
+////////////////////////////////////////////////////////////
+//                        Roots                           //
+////////////////////////////////////////////////////////////
+
+void test_fast_rsqrt() {
+    double rsqrt_error = sweep(FLT_MIN, FLT_MAX, false, true,
+                               [](float x) {return FastMath::rsqrt(x);}, [](double x) {return 1 / ::sqrt(x);});
+    double sqrt_error = sweep(FLT_MIN, FLT_MAX, false, true,
+                              [](float x) {return FastMath::sqrt(x);}, [](double x) {return ::sqrt(x);});
+    report("rsqrt", rsqrt_error);
+    report("sqrt", sqrt_error);
+    TEST_ASSERT_TRUE(rsqrt_error < 2e-7);
+    TEST_ASSERT_TRUE(sqrt_error < 1.5e-7);
+
+    TEST_ASSERT_EQUAL_FLOAT(0, FastMath::sqrt(0));
+    TEST_ASSERT_TRUE(isinf(FastMath::rsqrt(0)));
+}
+
+////////////////////////////////////////////////////////////
+//                      Benchmark                         //
+////////////////////////////////////////////////////////////
+
+// Cycles per call, libm -> FastMath. Each call feeds the next so neither can be hoisted or batched
+template <typename Lib, typename Fast>
+static void benchmark(const char* name, float start_value, Lib lib, Fast fast) {
+    constexpr uint32_t ITERATIONS = 1000;
+
+    float value = start_value;
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        value = lib(value);
+    }
+    uint32_t lib_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+    float lib_value = value;
+
+    value = start_value;
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        value = fast(value);
+    }
+    uint32_t fast_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    char line[96];
+    snprintf(line, sizeof(line), "%-14s %5lu -> %5lu cycles", name, (unsigned long)lib_cycles, (unsigned long)fast_cycles);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, lib_value, value);
+}
+
+void test_fast_math_benchmark() {
+    const float exponent = 0.0065f * 287.052f / 9.80665f;
+    const float scale = (273.15f + 15) / 0.0065f;
+
+    // Each maps the value back into its own domain for the next call
+    benchmark("log", 2.5f, [](float x) {return logf(x) + 2;}, [](float x) {return FastMath::log(x) + 2;});
+    benchmark("exp", 0.5f, [](float x) {return expf(x) - 1.2f;}, [](float x) {return FastMath::exp(x) - 1.2f;});
+    benchmark("pow", 0.9f, [](float x) {return powf(x, 0.19f) - 0.05f;}, [](float x) {return FastMath::pow(x, 0.19f) - 0.05f;});
+    benchmark("baro (double)", 0.9f, [=](float x) {return 0.9f + LibMath::baro_altitude(x, exponent, scale) * 1e-6f;},
+              [=](float x) {return 0.9f + FastMath::baro_altitude(x, exponent, scale) * 1e-6f;});
+    benchmark("atan2", 0.3f, [](float x) {return atan2f(x, 0.7f);}, [](float x) {return FastMath::atan2(x, 0.7f);});
+    benchmark("asin", 0.3f, [](float x) {return asinf(x) * 0.9f;}, [](float x) {return FastMath::asin(x) * 0.9f;});
+    benchmark("acos", 0.3f, [](float x) {return acosf(x) * 0.5f;}, [](float x) {return FastMath::acos(x) * 0.5f;});
+    benchmark("rsqrt", 3.0f, [](float x) {return 1 / sqrtf(x) + 2;}, [](float x) {return FastMath::rsqrt(x) + 2;});
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void test_all_fast_math() {
+
+    RUN_TEST(test_fast_log);
+    RUN_TEST(test_fast_exp);
+    RUN_TEST(test_fast_pow);
+    RUN_TEST(test_fast_baro_altitude);
+
+    RUN_TEST(test_fast_atan2);
+    RUN_TEST(test_fast_asin_acos);
+
+    RUN_TEST(test_fast_rsqrt);
+
+    RUN_TEST(test_fast_math_benchmark);
+
+}
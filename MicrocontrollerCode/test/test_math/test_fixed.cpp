@@ -0,0 +1,295 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/math/fixed.h"
+#include "common/math/quaternion.h"
+using namespace std;
+
+using Q15_16 = Fixed<15, 16>;
+using Q7_24 = Fixed<7, 24>;
+using Q1_30 = Fixed<1, 30>;
+
+// Largest element-wise difference between a fixed result and the float one
+template <typename F, size_t row, size_t col>
+static float max_error(const Matrix<F, row, col>& fixed, const Matrix<float, row, col>& expected) {
+    float error = 0;
+    for (size_t i = 0; i < row; i++) {
+        for (size_t j = 0; j < col; j++) {
+            error = fmaxf(error, fabsf((float)fixed[i][j] - expected[i][j]));
+        }
+    }
+    return error;
+}
+
+////////////////////////////////////////////////////////////
+//                      Arithmetic                        //
+////////////////////////////////////////////////////////////
+
+void test_fixed_conversion() {
+    TEST_ASSERT_EQUAL_INT32(65536, Q15_16(1).raw);
+    TEST_ASSERT_EQUAL_INT32(-32768, Q15_16(-0.5).raw);
+    TEST_ASSERT_EQUAL_INT32(1 << 30, Q1_30(1).raw);
+
+    TEST_ASSERT_EQUAL_FLOAT(3.25f, (float)Q15_16(3.25f));
+    TEST_ASSERT_EQUAL_INT(-3, (int)Q15_16(-3.75));
+    TEST_ASSERT_TRUE(fabs((double)Q1_30(0.1) - 0.1) < 1e-9);
+}
+
+void test_fixed_saturation() {
+    // Out of range on the way in
+    TEST_ASSERT_TRUE(Q15_16(40000) == Q15_16::max());
+    TEST_ASSERT_TRUE(Q15_16(-1e9) == Q15_16::min());
+    TEST_ASSERT_TRUE(Q1_30(3) == Q1_30::max());
+
+    // and out of every operator
+    TEST_ASSERT_TRUE(Q15_16::max() + 1 == Q15_16::max());
+    TEST_ASSERT_TRUE(Q15_16::min() - 1 == Q15_16::min());
+    TEST_ASSERT_TRUE(Q15_16(300) * Q15_16(300) == Q15_16::max());
+    TEST_ASSERT_TRUE(Q15_16(-300) * Q15_16(300) == Q15_16::min());
+    TEST_ASSERT_TRUE(Q15_16(20000) / Q15_16(0.5) == Q15_16::max());
+    TEST_ASSERT_TRUE(-Q15_16::min() == Q15_16::max());
+
+    // Divide by zero goes to the end with the numerator's sign
+    TEST_ASSERT_TRUE(Q15_16(2) / Q15_16(0) == Q15_16::max());
+    TEST_ASSERT_TRUE(Q15_16(-2) / Q15_16(0) == Q15_16::min());
+    TEST_ASSERT_TRUE(reciprocal(Q15_16(0)) == Q15_16::max());
+}
+
+void test_fixed_arithmetic() {
+    Q15_16 a = 2.5;
+    Q15_16 b = -1.25;
+
+    TEST_ASSERT_EQUAL_FLOAT(1.25f, (float)(a + b));
+    TEST_ASSERT_EQUAL_FLOAT(3.75f, (float)(a - b));
+    TEST_ASSERT_EQUAL_FLOAT(-3.125f, (float)(a * b));
+    TEST_ASSERT_EQUAL_FLOAT(-2.0f, (float)(a / b));
+
+    // Mixed with int and double literals, like the templates use them
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, (float)(2 * a));
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, (float)(1 - a / 5));
+    TEST_ASSERT_TRUE(b < 0 && a > 0.001);
+
+    // Products round to nearest, the two halves of one epsilon land on either side
+    Q15_16 half_epsilon = Q15_16::from_raw(1) * Q15_16(0.5);
+    TEST_ASSERT_EQUAL_INT32(1, half_epsilon.raw);
+    TEST_ASSERT_EQUAL_INT32(0, (Q15_16::from_raw(1) * Q15_16(0.25)).raw);
+
+    // All constexpr, like the templates
+    static_assert(Q15_16(1.5) * 2 == Q15_16(3), "Fixed arithmetic must be constexpr");
+    static_assert(sqrt(Q15_16(6.25)) == Q15_16(2.5), "Fixed sqrt must be constexpr");
+}
+
+////////////////////////////////////////////////////////////
+//                  Reciprocal and sqrt                   //
+////////////////////////////////////////////////////////////
+
+void test_fixed_reciprocal() {
+    const double values[] = {1, 2, 3, 0.5, 0.1, 0.001, 7.77, 123.456, 9999, 30000, -1, -0.3, -250};
+
+    for (double value : values) {
+        Q15_16 x = value;
+        double expected = 1.0 / (double)x;
+
+        // Within a rounding of the exact reciprocal of the stored value
+        TEST_ASSERT_FLOAT_WITHIN(1.5 / 65536, expected, (double)reciprocal(x));
+    }
+
+    // Finer than float, so checked in double
+    for (double value : {0.7, 1.3, 1.9, -0.6}) {
+        Q1_30 x = value;
+        TEST_ASSERT_TRUE(fabs((double)reciprocal(x) - 1.0 / (double)x) < 2e-9);
+    }
+
+    // Too big to hold
+    TEST_ASSERT_TRUE(reciprocal(Q15_16::from_raw(1)) == Q15_16::max());
+    TEST_ASSERT_TRUE(reciprocal(Q15_16::from_raw(-1)) == Q15_16::min());
+}
+
+void test_fixed_sqrt() {
+    const double values[] = {0, 1, 2, 4, 0.25, 0.001, 3.14159, 100, 12345.678, 32767};
+
+    for (double value : values) {
+        Q15_16 x = value;
+        double expected = std::sqrt((double)x);
+
+        // Rounded down, so never above and less than an epsilon below
+        double result = (double)sqrt(x);
+        TEST_ASSERT_TRUE(result <= expected);
+        TEST_ASSERT_FLOAT_WITHIN(1.0 / 65536, expected, result);
+    }
+
+    TEST_ASSERT_TRUE(fabs((double)sqrt(Q1_30(0.5)) - std::sqrt(0.5)) < 2e-9);
+    TEST_ASSERT_TRUE(sqrt(Q15_16(-4)) == Q15_16(0));
+}
+
+////////////////////////////////////////////////////////////
+//              Templates, against float                  //
+////////////////////////////////////////////////////////////
+
+void test_fixed_matrix() {
+    Matrix<float, 3, 3> A = {{{0.9f, -0.2f, 1.5f}, {0.1f, 2.25f, -0.7f}, {-3.0f, 0.4f, 0.05f}}};
+    Matrix<float, 3, 3> B = {{{1.1f, 0.0f, -0.6f}, {0.3f, -1.9f, 0.8f}, {2.0f, 0.5f, 0.25f}}};
+
+    auto A_fixed = matrix_cast<Q15_16>(A);
+    auto B_fixed = matrix_cast<Q15_16>(B);
+
+    // Each input is off by up to half an epsilon, and each product rounds, so a few epsilon at these sizes
+    const float bound = 8.0f / 65536;
+    TEST_ASSERT_TRUE(max_error(A_fixed * B_fixed, A * B) < bound);
+    TEST_ASSERT_TRUE(max_error(A_fixed + B_fixed, A + B) < bound);
+    TEST_ASSERT_TRUE(max_error(A_fixed - B_fixed, A - B) < bound);
+    TEST_ASSERT_TRUE(max_error(transpose(A_fixed), transpose(A)) < bound);
+}
+
+void test_fixed_vector() {
+    Vector3<float> v = {3.0f, -4.0f, 12.0f};
+    Vector3<float> w = {0.5f, 0.25f, -2.0f};
+
+    Vector3<Q15_16> v_fixed = matrix_cast<Q15_16>(v);
+    Vector3<Q15_16> w_fixed = matrix_cast<Q15_16>(w);
+
+    TEST_ASSERT_FLOAT_WITHIN(4.0f / 65536, dot(v, w), (float)dot(v_fixed, w_fixed));
+    TEST_ASSERT_FLOAT_WITHIN(2.0f / 65536, norm(v), (float)norm(v_fixed));
+    TEST_ASSERT_TRUE(max_error(unit(v_fixed), unit(v)) < 4.0f / 65536);
+    TEST_ASSERT_TRUE(max_error(cross(v_fixed, w_fixed), cross(v, w)) < 8.0f / 65536);
+}
+
+void test_fixed_quat_mult() {
+    Quaternion<float> q1 = quat_normalize(Quaternion<float>{0.8f, 0.1f, -0.5f, 0.3f});
+    Quaternion<float> q2 = quat_normalize(Quaternion<float>{-0.2f, 0.7f, 0.4f, 0.55f});
+
+    Quaternion<Q1_30> q1_fixed = matrix_cast<Q1_30>(q1);
+    Quaternion<Q1_30> q2_fixed = matrix_cast<Q1_30>(q2);
+
+    // Q1.30 is finer than float here, so float's own rounding is most of the bound
+    TEST_ASSERT_TRUE(max_error(quat_mult(q1_fixed, q2_fixed), quat_mult(q1, q2)) < 1e-6f);
+    TEST_ASSERT_TRUE(max_error(quat_normalize(q1_fixed), q1) < 1e-6f);
+    TEST_ASSERT_TRUE(max_error(quat_normalize_fast(q1_fixed), quat_normalize_fast(q1)) < 1e-6f);
+}
+
+void test_fixed_quat_integrate() {
+    Quaternion<float> quat = {1, 0, 0, 0};
+    Vector3<float> w_rps = {0.8f, -1.7f, 3.1f};
+    float dt_s = 0.01f;
+
+    Quaternion<Q7_24> quat_fixed = matrix_cast<Q7_24>(quat);
+    Vector3<Q7_24> w_fixed = matrix_cast<Q7_24>(w_rps);
+    Q7_24 dt_fixed = dt_s;
+
+    // 10 s at 100 Hz. The error of both grows with the steps, so this bounds the drift between them
+    for (int i = 0; i < 1000; i++) {
+        quat = quat_integrate(quat, w_rps, dt_s);
+        quat_fixed = quat_integrate(quat_fixed, w_fixed, dt_fixed);
+    }
+
+    TEST_ASSERT_TRUE(max_error(quat_fixed, quat) < 1e-4f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 1.0f, (float)norm(quat_fixed));
+}
+
+////////////////////////////////////////////////////////////
+//                      Benchmark                         //
+////////////////////////////////////////////////////////////
+
+// Reports cycles per call, float vs fixed, for the two loops the filters run every step
+void test_fixed_benchmark() {
+    constexpr uint32_t ITERATIONS = 500;
+    char line[128];
+
+    // Quaternion propagation
+    Quaternion<float> quat = {1, 0, 0, 0};
+    Vector3<float> w_rps = {0.8f, -1.7f, 3.1f};
+    Quaternion<Q7_24> quat_fixed = matrix_cast<Q7_24>(quat);
+    Vector3<Q7_24> w_fixed = matrix_cast<Q7_24>(w_rps);
+    Q7_24 dt_fixed = 0.01f;
+
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        quat = quat_integrate(quat, w_rps, 0.01f);
+    }
+    uint32_t float_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        quat_fixed = quat_integrate(quat_fixed, w_fixed, dt_fixed);
+    }
+    uint32_t fixed_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    snprintf(line, sizeof(line), "quat_integrate       float %6lu  Q7.24  %6lu cycles",
+             (unsigned long)float_cycles, (unsigned long)fixed_cycles);
+    TEST_MESSAGE(line);
+
+    Quaternion<Q1_30> q1_fixed = matrix_cast<Q1_30>(quat);
+    Quaternion<Q1_30> q2_fixed = q1_fixed;
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        quat = quat_normalize_fast(quat_mult(quat, quat));
+    }
+    float_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        q1_fixed = quat_normalize_fast(quat_mult(q1_fixed, q2_fixed));
+    }
+    fixed_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    snprintf(line, sizeof(line), "quat_mult + normalize float %6lu  Q1.30  %6lu cycles",
+             (unsigned long)float_cycles, (unsigned long)fixed_cycles);
+    TEST_MESSAGE(line);
+
+    // Covariance update, P = F P F^T + Q
+    Matrix<float, 6, 6> F{}, P{}, Q{};
+    for (size_t i = 0; i < 6; i++) {
+        F[i][i] = 1;
+        P[i][i] = 0.5f;
+        Q[i][i] = 1.0f / 1024;
+    }
+    for (size_t i = 0; i < 3; i++) {
+        F[i][i + 3] = 1.0f / 128;
+    }
+    auto F_fixed = matrix_cast<Q15_16>(F);
+    auto P_fixed = matrix_cast<Q15_16>(P);
+    auto Q_fixed = matrix_cast<Q15_16>(Q);
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        P = F * P * transpose(F) + Q;
+    }
+    float_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        P_fixed = F_fixed * P_fixed * transpose(F_fixed) + Q_fixed;
+    }
+    fixed_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    snprintf(line, sizeof(line), "6x6 F P F^T + Q      float %6lu  Q15.16 %6lu cycles",
+             (unsigned long)float_cycles, (unsigned long)fixed_cycles);
+    TEST_MESSAGE(line);
+
+    // F and Q are powers of two so both start from the same values. Q = 1e-3 would already be 0.7% off in
+    // Q15.16. What's left is each product rounding to 1.5e-5, over 500 updates, on elements growing to 11
+    TEST_ASSERT_TRUE(max_error(P_fixed, P) < 2e-2f);
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void test_all_fixed() {
+
+    RUN_TEST(test_fixed_conversion);
+    RUN_TEST(test_fixed_saturation);
+    RUN_TEST(test_fixed_arithmetic);
+
+    RUN_TEST(test_fixed_reciprocal);
+    RUN_TEST(test_fixed_sqrt);
+
+    RUN_TEST(test_fixed_matrix);
+    RUN_TEST(test_fixed_vector);
+    RUN_TEST(test_fixed_quat_mult);
+    RUN_TEST(test_fixed_quat_integrate);
+
+    RUN_TEST(test_fixed_benchmark);
+
+}
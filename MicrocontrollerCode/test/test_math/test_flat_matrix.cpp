@@ -0,0 +1,96 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/math/flat_matrix.h"
+using namespace std;
+
+////////////////////////////////////////////////////////////
+//                     Test layout                        //
+////////////////////////////////////////////////////////////
+
+void test_flat_layout() {
+    Mat<float, 2, 3> mat = {1, 2, 3, 4, 5, 6};
+    TEST_ASSERT_EQUAL_FLOAT(6, mat[1][2]);
+    TEST_ASSERT_EQUAL_FLOAT(4, mat(1, 0));
+    TEST_ASSERT_EQUAL_PTR(&mat[1][0], mat.data() + 3);
+
+    // Sizes that fill vector registers are aligned, the rest overlay packed floats
+    TEST_ASSERT_EQUAL(16, alignof(Vec<float, 4>));
+    TEST_ASSERT_EQUAL(16, alignof(Mat<float, 4, 4>));
+    TEST_ASSERT_EQUAL(sizeof(float[3]), sizeof(Vec<float, 3>));
+    TEST_ASSERT_EQUAL(sizeof(float[9]), sizeof(Mat<float, 3, 3>));
+
+    float packed[7] = {9, 1, 2, 3, 9, 9, 9};
+    Vec<float, 3> vec = Vec<float, 3>::load(packed + 1);
+    TEST_ASSERT_EQUAL_FLOAT(3, vec[2]);
+    vec[0] = -1;
+    vec.store(packed + 4);
+    TEST_ASSERT_EQUAL_FLOAT(-1, packed[4]);
+    TEST_ASSERT_EQUAL_FLOAT(3, packed[6]);
+
+    float sum = 0;
+    for (float val : vec) {
+        sum += val;
+    }
+    TEST_ASSERT_EQUAL_FLOAT(4, sum);
+}
+
+void test_flat_conversion() {
+    Matrix<float, 2, 3> matrix = {{{1, 2, 3}, {4, 5, 6}}};
+    Mat<float, 2, 3> mat = to_mat(matrix);
+    TEST_ASSERT_EQUAL_FLOAT(5, mat[1][1]);
+
+    Matrix<float, 2, 3> round_trip = mat;
+    TEST_ASSERT_TRUE(matrix_float_equals(matrix, round_trip));
+
+    Vector3<float> vector = {{{1}, {2}, {3}}};
+    Vec<float, 3> vec = to_vec(vector);
+    TEST_ASSERT_EQUAL_FLOAT(2, vec[1]);
+    Vector3<float> vector_back = vec;
+    TEST_ASSERT_EQUAL_FLOAT(3, vector_back[2][0]);
+}
+
+////////////////////////////////////////////////////////////
+//                    Test operators                      //
+////////////////////////////////////////////////////////////
+
+void test_flat_operators() {
+    Matrix<float, 3, 3> R = {{{0, -1, 0}, {1, 0, 0}, {0, 0, 1}}};
+    Matrix<float, 3, 3> S = {{{2, 0, 1}, {0, 3, 0}, {1, 0, 4}}};
+    Vector3<float> x = {{{1}, {2}, {3}}};
+
+    // Same answers as the aliases
+    TEST_ASSERT_TRUE(matrix_float_equals(R * S, (Matrix<float, 3, 3>)(to_mat(R) * to_mat(S))));
+    TEST_ASSERT_TRUE(matrix_float_equals(R + S, (Matrix<float, 3, 3>)(to_mat(R) + to_mat(S))));
+    TEST_ASSERT_TRUE(matrix_float_equals(R - S, (Matrix<float, 3, 3>)(to_mat(R) - to_mat(S))));
+    TEST_ASSERT_TRUE(matrix_float_equals(transpose(S), (Matrix<float, 3, 3>)transpose(to_mat(S))));
+    TEST_ASSERT_TRUE(matrix_float_equals(R * x, (Vector3<float>)(to_mat(R) * to_vec(x))));
+
+    Vec<float, 3> a = {1, 2, 3};
+    Vec<float, 3> b = {12, 5, 7};
+    Vec<float, 3> c = cross(a, b);
+    TEST_ASSERT_EQUAL_FLOAT(-1, c[0]);
+    TEST_ASSERT_EQUAL_FLOAT(29, c[1]);
+    TEST_ASSERT_EQUAL_FLOAT(-19, c[2]);
+    TEST_ASSERT_EQUAL_FLOAT(43, dot(a, b));
+    TEST_ASSERT_EQUAL_FLOAT(5, norm(Vec<float, 2>{3, 4}));
+    TEST_ASSERT_EQUAL_FLOAT(6, (2.0f * a)[2]);
+    TEST_ASSERT_EQUAL_FLOAT(-11, (a - b)[0]);
+
+    Mat<int, 2, 2> m = {1, 2, 3, 4};
+    Mat<int, 2, 2> squared = m * m;
+    TEST_ASSERT_EQUAL_INT(22, squared[1][1]);
+    Mat<int, 3, 3> identity = Mat<int, 3, 3>::identity();
+    TEST_ASSERT_EQUAL_INT(1, identity[2][2]);
+    TEST_ASSERT_EQUAL_INT(0, identity[2][1]);
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void test_all_flat_matrix() {
+    RUN_TEST(test_flat_layout);
+    RUN_TEST(test_flat_conversion);
+    RUN_TEST(test_flat_operators);
+}
@@ -12,8 +12,15 @@ void setup(){
     UNITY_BEGIN();
     test_all_bitmath();
     test_all_matrix();
+    test_all_matrix_expr();
+    test_all_flat_matrix();
     test_all_vector();
     test_all_quat();
+    test_all_constexpr();
+    test_all_fixed();
+    test_all_decomposition();
+    test_all_fast_math();
+    test_all_sample_aligner();
     UNITY_END();
 }
 void loop(){}
\ No newline at end of file
@@ -1,4 +1,11 @@
 void test_all_bitmath();
 void test_all_matrix();
+void test_all_matrix_expr();
+void test_all_flat_matrix();
 void test_all_vector();
-void test_all_quat();
\ No newline at end of file
+void test_all_quat();
+void test_all_constexpr();
+void test_all_fixed();
+void test_all_decomposition();
+void test_all_fast_math();
+void test_all_sample_aligner();
\ No newline at end of file
@@ -502,6 +502,122 @@ void test_transposition_int() {
             TEST_ASSERT_EQUAL_INT(expected[i][j], transposed[i][j]);
 }
 
+////////////////////////////////////////////////////////////
+//                  Test float kernels                    //
+////////////////////////////////////////////////////////////
+
+// Deterministic values in [-2, 2), different for each seed
+template <size_t row, size_t col>
+static void fill_matrix(Matrix<float, row, col>& mat, uint32_t seed) {
+    for (size_t i = 0; i < row; i++) {
+        for (size_t j = 0; j < col; j++) {
+            seed = seed * 1664525 + 1013904223;
+            mat[i][j] = (seed >> 8) / (float)(1 << 24) * 4 - 2;
+        }
+    }
+}
+
+// Every backend against the reference loops
+template <size_t row_f, size_t dim_int, size_t col_f>
+static void check_float_kernels() {
+    Matrix<float, row_f, dim_int> mat1;
+    Matrix<float, dim_int, col_f> mat2;
+    Matrix<float, row_f, col_f> mat3;
+    fill_matrix(mat1, row_f * 100 + dim_int);
+    fill_matrix(mat2, dim_int * 100 + col_f);
+    fill_matrix(mat3, col_f * 100 + row_f);
+
+    Matrix<float, row_f, col_f> expected;
+    matrix_mult_scalar(mat1, mat2, expected);
+    Matrix<float, row_f, col_f> product = mat1 * mat2;
+    for (size_t i = 0; i < row_f; i++)
+        for (size_t j = 0; j < col_f; j++)
+            TEST_ASSERT_FLOAT_WITHIN(1e-5f * dim_int, expected[i][j], product[i][j]);
+
+    matrix_add_scalar(product, mat3, expected);
+    Matrix<float, row_f, col_f> sum = product + mat3;
+    TEST_ASSERT_TRUE(matrix_float_equals(expected, sum));
+
+    matrix_sub_scalar(product, mat3, expected);
+    Matrix<float, row_f, col_f> difference = product - mat3;
+    TEST_ASSERT_TRUE(matrix_float_equals(expected, difference));
+}
+
+void test_matrix_float_kernels() {
+    TEST_MESSAGE("Matrix backend: " MATRIX_BACKEND_NAME);
+
+    // Unrolled
+    check_float_kernels<3, 3, 3>();
+    check_float_kernels<3, 3, 1>();
+    check_float_kernels<4, 4, 4>();
+
+    // General, including rows that don't fill a vector register
+    check_float_kernels<6, 6, 6>();
+    check_float_kernels<9, 9, 9>();
+    check_float_kernels<15, 15, 15>();
+    check_float_kernels<5, 7, 6>();
+    check_float_kernels<15, 9, 1>();
+}
+
+////////////////////////////////////////////////////////////
+//                      Benchmark                         //
+////////////////////////////////////////////////////////////
+
+// Mean cycles per N x N multiply and add for the reference loops and the selected backend.
+// Each result feeds the next call so none of them can be skipped
+template <size_t N>
+static void benchmark_size() {
+    constexpr uint32_t ITERATIONS = 200;
+
+    Matrix<float, N, N> mat1, mat2, result{};
+    fill_matrix(mat1, N);
+    fill_matrix(mat2, N + 1);
+
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        matrix_mult_scalar(mat1, mat2, result);
+        mat1[0][0] = result[N - 1][N - 1] * 1e-3f;
+    }
+    uint32_t scalar_mult_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        matrix_mult(mat1, mat2, result);
+        mat1[0][0] = result[N - 1][N - 1] * 1e-3f;
+    }
+    uint32_t backend_mult_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        matrix_add_scalar(mat1, mat2, result);
+        mat1[0][0] = result[N - 1][N - 1] * 1e-3f;
+    }
+    uint32_t scalar_add_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        matrix_add(mat1, mat2, result);
+        mat1[0][0] = result[N - 1][N - 1] * 1e-3f;
+    }
+    uint32_t backend_add_cycles = (ESP.getCycleCount() - start) / ITERATIONS;
+
+    char line[128];
+    snprintf(line, sizeof(line), "%2ux%-2u  mult %7lu -> %7lu  add %6lu -> %6lu cycles",
+             (unsigned)N, (unsigned)N,
+             (unsigned long)scalar_mult_cycles, (unsigned long)backend_mult_cycles,
+             (unsigned long)scalar_add_cycles, (unsigned long)backend_add_cycles);
+    TEST_MESSAGE(line);
+}
+
+void test_matrix_benchmark() {
+    TEST_MESSAGE("Matrix benchmark, scalar -> " MATRIX_BACKEND_NAME);
+    benchmark_size<3>();
+    benchmark_size<4>();
+    benchmark_size<6>();
+    benchmark_size<9>();
+    benchmark_size<15>();
+}
+
 ////////////////////////////////////////////////////////////
 //                    Run all tests                       //
 ////////////////////////////////////////////////////////////
@@ -525,6 +641,9 @@ void test_all_matrix() {
     RUN_TEST(test_matrix_subtraction_int);
     RUN_TEST(test_matrix_subtraction_float);
 
+    RUN_TEST(test_matrix_float_kernels);
+    RUN_TEST(test_matrix_benchmark);
+
     RUN_TEST(test_transposition_single);
     RUN_TEST(test_transposition_int);
     RUN_TEST(test_transposition_float);
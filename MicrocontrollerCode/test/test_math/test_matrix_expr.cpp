@@ -0,0 +1,98 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/math/matrix_expr.h"
+#include "common/math/vector.h"
+using namespace std;
+
+// Small integers, so the lazy and eager results are exactly equal
+template <size_t row, size_t col>
+static Matrix<float, row, col> counting_matrix(int start) {
+    Matrix<float, row, col> mat;
+    for (size_t i = 0; i < row; i++) {
+        for (size_t j = 0; j < col; j++) {
+            mat[i][j] = (float)((start + (int)(i * col + j)) % 7 - 3);
+        }
+    }
+    return mat;
+}
+
+////////////////////////////////////////////////////////////
+//                  Test element-wise                     //
+////////////////////////////////////////////////////////////
+
+void test_matrix_expr_elementwise() {
+    Matrix<float, 3, 4> A = counting_matrix<3, 4>(0);
+    Matrix<float, 3, 4> B = counting_matrix<3, 4>(1);
+    Matrix<float, 3, 4> C = counting_matrix<3, 4>(2);
+
+    Matrix<float, 3, 4> expected = A + B - C;
+    Matrix<float, 3, 4> result = lazy(A) + B - C;
+    TEST_ASSERT_TRUE(matrix_float_equals(expected, result));
+
+    // Scaling and an expression on the right
+    expected = A - (B + C);
+    for (auto& r : expected) {
+        for (auto& val : r) {
+            val *= 0.5f;
+        }
+    }
+    result = 0.5f * (A - (lazy(B) + C));
+    TEST_ASSERT_TRUE(matrix_float_equals(expected, result));
+}
+
+////////////////////////////////////////////////////////////
+//                    Test products                       //
+////////////////////////////////////////////////////////////
+
+void test_matrix_expr_product() {
+    Matrix<float, 6, 6> F = counting_matrix<6, 6>(0);
+    Matrix<float, 6, 6> P = counting_matrix<6, 6>(3);
+    Matrix<float, 6, 6> Q = counting_matrix<6, 6>(5);
+
+    // Covariance propagation, in one assignment
+    Matrix<float, 6, 6> expected = F * P * transpose(F) + Q;
+    Matrix<float, 6, 6> result = lazy(F) * P * transpose(lazy(F)) + Q;
+    TEST_ASSERT_TRUE(matrix_float_equals(expected, result));
+
+    // A product on its own, and with an expression operand
+    TEST_ASSERT_TRUE(matrix_float_equals(F * P, (lazy(F) * P).eval()));
+    TEST_ASSERT_TRUE(matrix_float_equals(F * (P - Q), (lazy(F) * (lazy(P) - Q)).eval()));
+
+    // Non-square, through a vector
+    Matrix<float, 2, 6> H = counting_matrix<2, 6>(1);
+    Vector<float, 6> x = counting_matrix<6, 1>(4);
+    Vector<float, 2> z = counting_matrix<2, 1>(2);
+    Vector<float, 2> innovation = lazy(z) - H * x;
+    Vector<float, 2> expected_innovation = z - H * x;
+    TEST_ASSERT_TRUE(matrix_float_equals(expected_innovation, innovation));
+}
+
+void test_matrix_expr_aliasing() {
+    Matrix<float, 4, 4> F = counting_matrix<4, 4>(0);
+    Matrix<float, 4, 4> P = counting_matrix<4, 4>(2);
+
+    Matrix<float, 4, 4> expected = F * P + P;
+    P = lazy(F) * P + P;
+    TEST_ASSERT_TRUE(matrix_float_equals(expected, P));
+}
+
+void test_matrix_expr_int() {
+    Matrix<int, 2, 3> A = {{{1, 2, 3}, {4, 5, 6}}};
+    Matrix<int, 3, 2> B = {{{1, 0}, {0, 1}, {1, 1}}};
+
+    Matrix<int, 2, 2> result = lazy(A) * B + transpose(lazy(B)) * transpose(A);
+    Matrix<int, 2, 2> expected = {{{8, 15}, {15, 22}}};
+    TEST_ASSERT_TRUE(matrix_int_equals(expected, result));
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void test_all_matrix_expr() {
+    RUN_TEST(test_matrix_expr_elementwise);
+    RUN_TEST(test_matrix_expr_product);
+    RUN_TEST(test_matrix_expr_aliasing);
+    RUN_TEST(test_matrix_expr_int);
+}
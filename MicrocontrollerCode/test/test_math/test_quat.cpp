@@ -399,6 +399,93 @@ void test_apply_random() {
 }
 
 
+// The 15-multiply kernel against q * v * inv(q)
+void test_rotate_matches_sandwich() {
+    Vector3<float> axis = {0.444, 0.235, 0.134};
+    Quaternion<float> quat = quat_from_axis_rot<float>(157, unit(axis));
+    Vector3<float> vec = {1.234, 2.345, 3.456};
+
+    Quaternion<float> sandwich = quat_mult(quat_mult(quat, vec_as_quat(vec)), inv(quat));
+    auto result = quat_rotate(quat, vec);
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, sandwich[i + 1][0], result[i][0]);
+    }
+}
+
+////////////////////////////////////////////////////////////
+//                  Normalise, integrate                  //
+////////////////////////////////////////////////////////////
+
+void test_normalize() {
+    Quaternion<float> quat = {0.5, 0.5, 0.5, 0.5};
+    Quaternion<float> stretched = {0.51, 0.5, 0.5, 0.5};
+
+    // Exact for any length, the fast one converges from near unit
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 1, norm(quat_normalize(Quaternion<float>{3, 0, 4, 0})));
+    Quaternion<float> fast = quat_normalize_fast(stretched);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 1, norm(fast));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 1, norm(quat_normalize_fast(fast)));
+    TEST_ASSERT_TRUE(matrix_float_equals(quat, quat_normalize_fast(quat)));
+
+    // R_from_quat doesn't need a unit quaternion
+    Quaternion<float> doubled = {1, 1, 1, 1};
+    TEST_ASSERT_TRUE(matrix_float_equals(R_from_quat(quat), R_from_quat(doubled)));
+}
+
+void test_integrate() {
+    // 90 deg/s about z for 1 s, in 800 Hz steps
+    Quaternion<float> quat = {1, 0, 0, 0};
+    Vector3<float> w_rps = {0, 0, 90 * DEG2RAD};
+    for (int i = 0; i < 800; i++) {
+        quat = quat_integrate(quat, w_rps, 1.0f / 800);
+    }
+
+    Quaternion<float> expected = quat_from_axis_rot<float>(90, {0, 0, 1});
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-4, expected[i][0], quat[i][0]);
+    }
+
+    // No rate, no change
+    Vector3<float> still = {0, 0, 0};
+    TEST_ASSERT_TRUE(matrix_float_equals(expected, quat_integrate(expected, still, 0.01f)));
+}
+
+////////////////////////////////////////////////////////////
+//                        Batch                           //
+////////////////////////////////////////////////////////////
+
+void test_rotate_batch() {
+    Vector3<float> axis = {0.444, 0.235, 0.134};
+    Quaternion<float> quat = quat_from_axis_rot<float>(90, unit(axis));
+
+    const size_t COUNT = 5;
+    float x[COUNT], y[COUNT], z[COUNT];
+    // Packed like ImuFifoSample, so the floats aren't aligned
+    struct __attribute__((packed)) Record {uint8_t id; float xyz[3]; uint32_t time;};
+    Record records[COUNT];
+    for (size_t n = 0; n < COUNT; n++) {
+        x[n] = records[n].xyz[0] = n;
+        y[n] = records[n].xyz[1] = 2.0f - n;
+        z[n] = records[n].xyz[2] = 0.5f * n;
+        records[n].time = n;
+    }
+
+    quat_rotate_batch(quat, x, y, z, COUNT);
+    quat_rotate_batch(quat, reinterpret_cast<uint8_t*>(records), offsetof(Record, xyz), sizeof(Record), COUNT);
+
+    for (size_t n = 0; n < COUNT; n++) {
+        Vector3<float> expected = quat_rotate(quat, Vector3<float>{{{(float)n}, {2.0f - n}, {0.5f * n}}});
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, expected[0][0], x[n]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, expected[1][0], y[n]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, expected[2][0], z[n]);
+        for (int i = 0; i < 3; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-5, expected[i][0], records[n].xyz[i]);
+        }
+        TEST_ASSERT_EQUAL(n, records[n].time);
+    }
+}
+
 
 ////////////////////////////////////////////////////////////
 //                    Run all tests                       //
@@ -435,6 +522,11 @@ void test_all_quat() {
     RUN_TEST(test_apply_identity);
     RUN_TEST(test_apply_x);
     RUN_TEST(test_apply_random);
+    RUN_TEST(test_rotate_matches_sandwich);
+
+    RUN_TEST(test_normalize);
+    RUN_TEST(test_integrate);
+    RUN_TEST(test_rotate_batch);
 
     
 }
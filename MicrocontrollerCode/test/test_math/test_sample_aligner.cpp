@@ -0,0 +1,98 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/gnc/SampleAligner.h"
+
+using namespace std;
+using namespace Cesium;
+using namespace Cesium::Sensor;
+
+////////////////////////////////////////////////////////////
+//                     Interpolation                      //
+////////////////////////////////////////////////////////////
+
+void test_aligner_interpolates() {
+    SampleAligner<float, 8> aligner;
+    float value;
+
+    TEST_ASSERT_FALSE(aligner.sample_at(1000, value));
+
+    // 50 Hz baro-like stream
+    aligner.push(1000, 10.0f);
+    aligner.push(21000, 20.0f);
+
+    TEST_ASSERT_TRUE(aligner.sample_at(1000, value));
+    TEST_ASSERT_EQUAL_FLOAT(10.0, value);
+    TEST_ASSERT_TRUE(aligner.sample_at(6000, value));
+    TEST_ASSERT_EQUAL_FLOAT(12.5, value);
+
+    // Past the newest sample it is held
+    TEST_ASSERT_TRUE(aligner.sample_at(30000, value));
+    TEST_ASSERT_EQUAL_FLOAT(20.0, value);
+
+    // Before the history
+    TEST_ASSERT_FALSE(aligner.sample_at(500, value));
+}
+
+void test_aligner_vector() {
+    SampleAligner<Vector3<float>, 4> aligner;
+
+    aligner.push(0, {{{0}, {10}, {-4}}});
+    aligner.push(10000, {{{1}, {20}, {4}}});
+
+    Vector3<float> value;
+    TEST_ASSERT_TRUE(aligner.sample_at(2500, value));
+    TEST_ASSERT_EQUAL_FLOAT(0.25, value[0][0]);
+    TEST_ASSERT_EQUAL_FLOAT(12.5, value[1][0]);
+    TEST_ASSERT_EQUAL_FLOAT(-2.0, value[2][0]);
+}
+
+////////////////////////////////////////////////////////////
+//                    Hold and history                    //
+////////////////////////////////////////////////////////////
+
+void test_aligner_hold() {
+    SampleAligner<BaroReading, 4> aligner(SampleAligner<BaroReading, 4>::Mode::HOLD, 30000);
+
+    aligner.push(1000, {100.0f, 50.0f, 20.0f});
+    aligner.push(21000, {99.0f, 60.0f, 21.0f});
+
+    BaroReading value;
+    TEST_ASSERT_TRUE(aligner.sample_at(20000, value));
+    TEST_ASSERT_EQUAL_FLOAT(50.0, value.altitude_m);
+
+    // Too stale to hold
+    TEST_ASSERT_TRUE(aligner.sample_at(50000, value));
+    TEST_ASSERT_FALSE(aligner.sample_at(52000, value));
+}
+
+void test_aligner_ring() {
+    SampleAligner<float, 4> aligner;
+
+    TEST_ASSERT_TRUE(aligner.push(100, 1.0f));
+    TEST_ASSERT_FALSE(aligner.push(100, 2.0f));
+    TEST_ASSERT_FALSE(aligner.push(50, 2.0f));
+
+    for (uint64_t t = 200; t <= 600; t += 100) {
+        aligner.push(t, t / 100.0f);
+    }
+    TEST_ASSERT_EQUAL(4, aligner.size());
+    TEST_ASSERT_EQUAL(600, aligner.newest().time_us);
+
+    // 100 and 200 were pushed out
+    float value;
+    TEST_ASSERT_FALSE(aligner.sample_at(250, value));
+    TEST_ASSERT_TRUE(aligner.sample_at(350, value));
+    TEST_ASSERT_EQUAL_FLOAT(3.5, value);
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void test_all_sample_aligner() {
+    RUN_TEST(test_aligner_interpolates);
+    RUN_TEST(test_aligner_vector);
+    RUN_TEST(test_aligner_hold);
+    RUN_TEST(test_aligner_ring);
+}
@@ -0,0 +1,107 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/os/instrumentation.h"
+
+
+using namespace std;
+using namespace Cesium;
+
+////////////////////////////////////////////////////////////
+//                  Test registration                     //
+////////////////////////////////////////////////////////////
+
+void test_probe_register_same_name() {
+    uint8_t id = Instrumentation::register_probe("test_probe_a");
+    TEST_ASSERT_NOT_EQUAL(Instrumentation::INVALID_PROBE, id);
+
+    TEST_ASSERT_EQUAL(id, Instrumentation::register_probe("test_probe_a"));
+    TEST_ASSERT_NOT_EQUAL(id, Instrumentation::register_probe("test_probe_b"));
+    TEST_ASSERT_EQUAL_STRING("test_probe_a", Instrumentation::get_probe_name(id));
+}
+
+////////////////////////////////////////////////////////////
+//                     Test stats                         //
+////////////////////////////////////////////////////////////
+
+void test_probe_record_stats() {
+    uint8_t id = Instrumentation::register_probe("test_probe_stats");
+    Instrumentation::reset();
+
+    Instrumentation::record(id, 100);
+    Instrumentation::record(id, 300);
+    Instrumentation::record(id, 200);
+
+    ProbeStats stats = Instrumentation::get_probe_stats(id);
+    TEST_ASSERT_EQUAL(3, stats.count);
+    TEST_ASSERT_EQUAL(100, stats.min_cycles);
+    TEST_ASSERT_EQUAL(300, stats.max_cycles);
+    TEST_ASSERT_EQUAL(200, stats.mean_cycles());
+
+    // 100 -> [64, 128), 200 and 300 -> [128, 256) and [256, 512)
+    TEST_ASSERT_EQUAL(1, stats.histogram[6]);
+    TEST_ASSERT_EQUAL(1, stats.histogram[7]);
+    TEST_ASSERT_EQUAL(1, stats.histogram[8]);
+}
+
+void test_probe_reset() {
+    uint8_t id = Instrumentation::register_probe("test_probe_reset");
+    Instrumentation::record(id, 50);
+
+    Instrumentation::reset();
+
+    ProbeStats stats = Instrumentation::get_probe_stats(id);
+    TEST_ASSERT_EQUAL(0, stats.count);
+    TEST_ASSERT_EQUAL(0, stats.max_cycles);
+
+    // Still registered
+    TEST_ASSERT_EQUAL(id, Instrumentation::register_probe("test_probe_reset"));
+}
+
+void test_probe_scope() {
+    Instrumentation::reset();
+    {
+        PROBE_SCOPE("test_probe_scope");
+        delayMicroseconds(10);
+    }
+
+    uint8_t id = Instrumentation::register_probe("test_probe_scope");
+    ProbeStats stats = Instrumentation::get_probe_stats(id);
+    TEST_ASSERT_EQUAL(1, stats.count);
+    TEST_ASSERT_GREATER_THAN(0, stats.max_cycles);
+}
+
+////////////////////////////////////////////////////////////
+//                    Test records                        //
+////////////////////////////////////////////////////////////
+
+void test_probe_record_layout() {
+    uint8_t id = Instrumentation::register_probe("test_probe_stats");
+    vector<uint8_t> data = Instrumentation::probe_record(id);
+
+    size_t name_len = strlen("test_probe_stats");
+    TEST_ASSERT_EQUAL((uint8_t)StatsRecord::PROBE, data[0]);
+    TEST_ASSERT_EQUAL(id, data[1]);
+    TEST_ASSERT_EQUAL(name_len, data[2]);
+    TEST_ASSERT_EQUAL(3 + name_len + 16 + 1 + ProbeStats::BUCKETS * 4, data.size());
+}
+
+void test_system_record_type() {
+    vector<uint8_t> data = Instrumentation::system_record();
+
+    TEST_ASSERT_EQUAL((uint8_t)StatsRecord::SYSTEM, data[0]);
+    TEST_ASSERT_EQUAL(Instrumentation::get_probe_count(), data[29]);
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void run_all_instrumentation_tests() {
+    RUN_TEST(test_probe_register_same_name);
+    RUN_TEST(test_probe_record_stats);
+    RUN_TEST(test_probe_reset);
+    RUN_TEST(test_probe_scope);
+    RUN_TEST(test_probe_record_layout);
+    RUN_TEST(test_system_record_type);
+}
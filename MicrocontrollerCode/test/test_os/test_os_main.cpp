@@ -11,6 +11,11 @@ void setup(){
     
     UNITY_BEGIN();
     run_all_filesystem_tests();
+    run_all_spsc_queue_tests();
+    run_all_instrumentation_tests();
+    run_all_trace_tests();
+    run_all_spi_bus_tests();
+    run_all_sensor_manager_tests();
     UNITY_END();
 }
 void loop(){}
\ No newline at end of file
@@ -1 +1,6 @@
-void run_all_filesystem_tests();
\ No newline at end of file
+void run_all_filesystem_tests();
+void run_all_spsc_queue_tests();
+void run_all_instrumentation_tests();
+void run_all_trace_tests();
+void run_all_spi_bus_tests();
+void run_all_sensor_manager_tests();
@@ -0,0 +1,152 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/os/sensor_manager.h"
+#include "common/os/instrumentation.h"
+#include "common/drivers/sensor_bases/MockBases.h"
+
+
+using namespace std;
+using namespace Cesium;
+using namespace Cesium::Sensor;
+
+// read() succeeds unless told otherwise, and counts its calls
+class ScheduledMock : public MockSensorBase {
+public:
+    bool result = true;
+    uint32_t calls = 0;
+
+    virtual bool read() {
+        calls++;
+        SensorBase::read();
+        return result;
+    }
+};
+
+// Two buses that are never begun, only their addresses are used for grouping
+static SPIClass bus_a(HSPI);
+static SPIClass bus_b(VSPI);
+
+static ScheduledMock fast_a;     // bus a, 10 ms, priority 0
+static ScheduledMock slow_b;     // bus b, 100 ms, priority 1
+static ScheduledMock fast_b;     // bus b, 10 ms, priority 2
+static ScheduledMock polled_a;   // bus a, polled, priority 3
+
+static uint8_t ids[4];
+static uint32_t callbacks = 0;
+
+static void count_callback(void* context)
+{
+    (*(uint32_t*)context)++;
+}
+
+////////////////////////////////////////////////////////////
+//                         Setup                          //
+////////////////////////////////////////////////////////////
+
+void start_sensor_manager() {
+    fast_a.attach_SPI(&bus_a);
+    slow_b.attach_SPI(&bus_b);
+    fast_b.attach_SPI(&bus_b);
+    polled_a.attach_SPI(&bus_a);
+
+    ids[0] = SensorManager::add_sensor(&fast_a, 10, 0);
+    ids[1] = SensorManager::add_sensor(&slow_b, 100, 1, SensorManager::ReadMode::PERIODIC, count_callback, &callbacks);
+    ids[2] = SensorManager::add_sensor(&fast_b, 10, 2);
+    ids[3] = SensorManager::add_sensor(&polled_a, 20, 3, SensorManager::ReadMode::POLLED);
+
+    for (size_t i = 0; i < 4; i++) {
+        TEST_ASSERT_NOT_EQUAL(SensorManager::INVALID_SENSOR, ids[i]);
+    }
+    TEST_ASSERT_EQUAL(4, SensorManager::get_sensor_count());
+    TEST_ASSERT_EQUAL(100, slow_b.get_interval_ms());
+
+    TEST_ASSERT_EQUAL(SensorManager::INVALID_SENSOR, SensorManager::add_sensor(nullptr, 10));
+    TEST_ASSERT_EQUAL(SensorManager::INVALID_SENSOR, SensorManager::add_sensor(&fast_a, 0));
+}
+
+////////////////////////////////////////////////////////////
+//                      Scheduling                        //
+////////////////////////////////////////////////////////////
+
+void test_sensor_manager_groups_by_bus() {
+    // Everything is due on the first pass. fast_a goes first, then the rest of bus a before bus b
+    uint8_t order[SensorManager::MAX_SENSORS];
+    TEST_ASSERT_EQUAL(4, SensorManager::due_list(1000, order));
+    TEST_ASSERT_EQUAL(ids[0], order[0]);
+    TEST_ASSERT_EQUAL(ids[3], order[1]);
+    TEST_ASSERT_EQUAL(ids[1], order[2]);
+    TEST_ASSERT_EQUAL(ids[2], order[3]);
+}
+
+void test_sensor_manager_intervals() {
+    SensorManager::reset_stats();
+
+    TEST_ASSERT_EQUAL(4, SensorManager::run(1000));
+    TEST_ASSERT_EQUAL(1, callbacks);
+    TEST_ASSERT_EQUAL(1, SensorManager::get_bus_switches());
+
+    // Only the polled sensor before the 10 ms sensors come due
+    TEST_ASSERT_EQUAL(1, SensorManager::run(1005));
+    TEST_ASSERT_EQUAL(3, SensorManager::run(1010));
+    TEST_ASSERT_EQUAL(1, slow_b.calls);
+
+    for (uint32_t now_ms = 1020; now_ms <= 1100; now_ms += 10) {
+        SensorManager::run(now_ms);
+    }
+    TEST_ASSERT_EQUAL(2, slow_b.calls);
+    TEST_ASSERT_EQUAL(2, callbacks);
+    TEST_ASSERT_EQUAL(11, fast_a.calls);
+
+    SensorStats stats = SensorManager::get_stats(ids[0]);
+    TEST_ASSERT_EQUAL(11, stats.reads);
+    TEST_ASSERT_EQUAL(11, stats.samples);
+    TEST_ASSERT_EQUAL(0, stats.overruns);
+}
+
+void test_sensor_manager_failures_and_overruns() {
+    fast_b.result = false;
+    polled_a.result = false;
+
+    // 35 ms late for a 10 ms sensor: three intervals missed, then back on schedule
+    SensorManager::run(1145);
+    TEST_ASSERT_EQUAL(1, SensorManager::run(1155));
+
+    SensorStats fast_b_stats = SensorManager::get_stats(ids[2]);
+    TEST_ASSERT_EQUAL(2, fast_b_stats.failures);
+    TEST_ASSERT_EQUAL(3, fast_b_stats.overruns);
+
+    // A polled sensor without a new sample hasn't failed
+    SensorStats polled_stats = SensorManager::get_stats(ids[3]);
+    TEST_ASSERT_EQUAL(0, polled_stats.failures);
+    TEST_ASSERT_TRUE(polled_stats.reads > polled_stats.samples);
+
+    fast_b.result = true;
+    polled_a.result = true;
+}
+
+void test_sensor_manager_stats_record() {
+    vector<uint8_t> record = SensorManager::stats_record();
+    TEST_ASSERT_EQUAL(10 + 4 * 31, record.size());
+    TEST_ASSERT_EQUAL((uint8_t)StatsRecord::SENSORS, record[0]);
+    TEST_ASSERT_EQUAL(4, record[9]);
+
+    // Sensor 1: interface, priority, mode, then interval
+    TEST_ASSERT_EQUAL((uint8_t)Interfaces::SPI, record[10 + 31]);
+    TEST_ASSERT_EQUAL(1, record[10 + 31 + 1]);
+    uint32_t interval_ms;
+    memcpy(&interval_ms, &record[10 + 31 + 3], sizeof(interval_ms));
+    TEST_ASSERT_EQUAL(100, interval_ms);
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void run_all_sensor_manager_tests() {
+    RUN_TEST(start_sensor_manager);
+    RUN_TEST(test_sensor_manager_groups_by_bus);
+    RUN_TEST(test_sensor_manager_intervals);
+    RUN_TEST(test_sensor_manager_failures_and_overruns);
+    RUN_TEST(test_sensor_manager_stats_record);
+}
@@ -0,0 +1,153 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/os/spi_bus.h"
+#include "common/os/instrumentation.h"
+#include <esp_timer.h>
+
+
+using namespace std;
+using namespace Cesium;
+
+// HSPI pins on the flight computer, with two CS pins nothing is attached to.
+// Nothing answers, so these only check the transaction bookkeeping, not the data
+static constexpr int8_t TEST_SCK = 14;
+static constexpr int8_t TEST_MISO = 36;
+static constexpr int8_t TEST_MOSI = 13;
+static constexpr uint8_t TEST_CS_A = 25;
+static constexpr uint8_t TEST_CS_B = 26;
+
+static SpiBus test_bus(HSPI_HOST, TEST_SCK, TEST_MISO, TEST_MOSI);
+static uint8_t device_a = SpiBus::INVALID_DEVICE;
+static uint8_t device_b = SpiBus::INVALID_DEVICE;
+
+struct CallbackResult {
+    size_t calls;
+    size_t len;
+    uint64_t start_us;
+};
+
+static void record_callback(void* context, const uint8_t* rx, size_t len, uint64_t start_us)
+{
+    CallbackResult* result = (CallbackResult*)context;
+    result->calls++;
+    result->len = len;
+    result->start_us = start_us;
+}
+
+////////////////////////////////////////////////////////////
+//                         Setup                          //
+////////////////////////////////////////////////////////////
+
+void start_spi_bus() {
+    TEST_ASSERT_TRUE(test_bus.begin());
+    TEST_ASSERT_FALSE(test_bus.begin());
+
+    device_a = test_bus.add_device(TEST_CS_A, 1000000, 0, 32);
+    device_b = test_bus.add_device(TEST_CS_B, 4000000, 3, 32);
+    TEST_ASSERT_NOT_EQUAL(SpiBus::INVALID_DEVICE, device_a);
+    TEST_ASSERT_NOT_EQUAL(SpiBus::INVALID_DEVICE, device_b);
+    TEST_ASSERT_EQUAL(2, test_bus.get_device_count());
+}
+
+////////////////////////////////////////////////////////////
+//                   Transaction plan                     //
+////////////////////////////////////////////////////////////
+
+void test_spi_bus_plan_runs_callbacks() {
+    test_bus.reset_stats();
+
+    CallbackResult result_a = {};
+    CallbackResult result_b = {};
+    const uint8_t header[2] = {0x80, 0};
+
+    bool completed_a = false;
+    bool completed_b = false;
+
+    int64_t before_us = esp_timer_get_time();
+    TEST_ASSERT_TRUE(test_bus.plan_read(device_a, header, 2, 14, record_callback, &result_a, &completed_a));
+    TEST_ASSERT_TRUE(test_bus.plan_read(device_b, header, 1, 23, record_callback, &result_b, &completed_b));
+
+    TEST_ASSERT_EQUAL(2, test_bus.submit());
+    TEST_ASSERT_EQUAL(2, test_bus.collect());
+    TEST_ASSERT_TRUE(completed_a);
+    TEST_ASSERT_TRUE(completed_b);
+
+    TEST_ASSERT_EQUAL(1, result_a.calls);
+    TEST_ASSERT_EQUAL(14, result_a.len);
+    TEST_ASSERT_EQUAL(1, result_b.calls);
+    TEST_ASSERT_EQUAL(23, result_b.len);
+    TEST_ASSERT_TRUE(result_a.start_us >= (uint64_t)before_us);
+
+    SpiDeviceStats stats = test_bus.get_device_stats(device_a);
+    TEST_ASSERT_EQUAL(1, stats.transactions);
+    TEST_ASSERT_EQUAL(16, stats.bytes);
+    TEST_ASSERT_EQUAL(1, test_bus.get_cycles());
+}
+
+void test_spi_bus_device_busy_until_collect() {
+    CallbackResult result = {};
+    const uint8_t header = 0x80;
+
+    TEST_ASSERT_TRUE(test_bus.plan_read(device_a, &header, 1, 4, record_callback, &result));
+    TEST_ASSERT_FALSE(test_bus.plan_read(device_a, &header, 1, 4, record_callback, &result));
+
+    // Too long for the device's buffers
+    TEST_ASSERT_FALSE(test_bus.plan_read(device_b, &header, 1, 64, record_callback, &result));
+
+    test_bus.submit();
+    TEST_ASSERT_EQUAL(1, test_bus.collect());
+    TEST_ASSERT_EQUAL(1, result.calls);
+
+    // Free again for blocking transfers
+    uint8_t rx[4];
+    TEST_ASSERT_TRUE(test_bus.read(device_a, &header, 1, rx, sizeof(rx)));
+}
+
+void test_spi_bus_reports_failed_entries() {
+    CallbackResult result = {};
+    const uint8_t header = 0x80;
+    bool completed = true;
+
+    // Never queued, so collect() frees the device without a callback and reports it
+    TEST_ASSERT_TRUE(test_bus.plan_read(device_a, &header, 1, 4, record_callback, &result, &completed));
+    TEST_ASSERT_FALSE(completed);
+    TEST_ASSERT_EQUAL(0, test_bus.collect());
+    TEST_ASSERT_FALSE(completed);
+    TEST_ASSERT_EQUAL(0, result.calls);
+
+    TEST_ASSERT_TRUE(test_bus.plan_read(device_a, &header, 1, 4, record_callback, &result, &completed));
+    test_bus.submit();
+    TEST_ASSERT_EQUAL(1, test_bus.collect());
+    TEST_ASSERT_TRUE(completed);
+}
+
+void test_spi_bus_stats_record() {
+    test_bus.reset_stats();
+
+    const uint8_t tx[3] = {1, 2, 3};
+    TEST_ASSERT_TRUE(test_bus.write(device_b, tx, sizeof(tx)));
+
+    vector<uint8_t> record = test_bus.stats_record();
+    TEST_ASSERT_EQUAL(15 + 2 * 21, record.size());
+    TEST_ASSERT_EQUAL((uint8_t)StatsRecord::SPI_BUS, record[0]);
+    TEST_ASSERT_EQUAL(2, record[14]);
+
+    // Device b: cs, clock, then transactions
+    TEST_ASSERT_EQUAL(TEST_CS_B, record[15 + 21]);
+    uint32_t transactions;
+    memcpy(&transactions, &record[15 + 21 + 5], sizeof(transactions));
+    TEST_ASSERT_EQUAL(1, transactions);
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void run_all_spi_bus_tests() {
+    RUN_TEST(start_spi_bus);
+    RUN_TEST(test_spi_bus_plan_runs_callbacks);
+    RUN_TEST(test_spi_bus_device_busy_until_collect);
+    RUN_TEST(test_spi_bus_reports_failed_entries);
+    RUN_TEST(test_spi_bus_stats_record);
+}
@@ -0,0 +1,139 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/os/spsc_queue.h"
+
+
+using namespace std;
+using namespace Cesium;
+
+struct TestRecord {
+    uint32_t time;
+    float value;
+};
+
+////////////////////////////////////////////////////////////
+//                   Test push/pop                        //
+////////////////////////////////////////////////////////////
+
+void test_queue_empty() {
+    SpscQueue<TestRecord, 8> queue;
+    TestRecord record;
+
+    TEST_ASSERT_TRUE(queue.empty());
+    TEST_ASSERT_EQUAL(0, queue.size());
+    TEST_ASSERT_EQUAL(8, queue.capacity());
+    TEST_ASSERT_FALSE(queue.pop(record));
+}
+
+void test_queue_fifo_order() {
+    SpscQueue<TestRecord, 8> queue;
+    TestRecord record;
+
+    for (uint32_t i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(queue.push({i, i * 1.5f}));
+    }
+    TEST_ASSERT_EQUAL(5, queue.size());
+
+    for (uint32_t i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(queue.pop(record));
+        TEST_ASSERT_EQUAL(i, record.time);
+        TEST_ASSERT_EQUAL_FLOAT(i * 1.5f, record.value);
+    }
+    TEST_ASSERT_TRUE(queue.empty());
+}
+
+void test_queue_full_drops() {
+    SpscQueue<TestRecord, 4> queue;
+
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(queue.push({i, 0}));
+    }
+    TEST_ASSERT_FALSE(queue.push({99, 0}));
+    TEST_ASSERT_FALSE(queue.push({100, 0}));
+
+    TEST_ASSERT_EQUAL(2, queue.get_dropped());
+    TEST_ASSERT_EQUAL(4, queue.get_high_water());
+
+    // Oldest record is still the first one pushed
+    TestRecord record;
+    TEST_ASSERT_TRUE(queue.pop(record));
+    TEST_ASSERT_EQUAL(0, record.time);
+
+    queue.reset_stats();
+    TEST_ASSERT_EQUAL(0, queue.get_dropped());
+    TEST_ASSERT_EQUAL(0, queue.get_high_water());
+}
+
+void test_queue_wraparound() {
+    SpscQueue<TestRecord, 4> queue;
+    TestRecord record;
+
+    // Pushes many more records than the capacity, one at a time
+    for (uint32_t i = 0; i < 100; i++) {
+        TEST_ASSERT_TRUE(queue.push({i, 0}));
+        TEST_ASSERT_TRUE(queue.pop(record));
+        TEST_ASSERT_EQUAL(i, record.time);
+    }
+    TEST_ASSERT_EQUAL(1, queue.get_high_water());
+}
+
+void test_queue_batch_pop() {
+    SpscQueue<TestRecord, 16> queue;
+    TestRecord batch[8];
+
+    for (uint32_t i = 0; i < 11; i++) {
+        queue.push({i, 0});
+    }
+
+    TEST_ASSERT_EQUAL(8, queue.pop(batch, 8));
+    for (uint32_t i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL(i, batch[i].time);
+    }
+
+    TEST_ASSERT_EQUAL(3, queue.pop(batch, 8));
+    TEST_ASSERT_EQUAL(8, batch[0].time);
+    TEST_ASSERT_EQUAL(10, batch[2].time);
+
+    TEST_ASSERT_EQUAL(0, queue.pop(batch, 8));
+}
+
+////////////////////////////////////////////////////////////
+//                     Test SeqLock                       //
+////////////////////////////////////////////////////////////
+
+void test_seqlock_unwritten() {
+    SeqLock<TestRecord> slot;
+    TestRecord record;
+
+    TEST_ASSERT_FALSE(slot.read(record));
+    TEST_ASSERT_EQUAL(0, slot.get_version());
+}
+
+void test_seqlock_latest_value() {
+    SeqLock<TestRecord> slot;
+    TestRecord record;
+
+    slot.write({1, 1.0f});
+    slot.write({2, 2.0f});
+
+    TEST_ASSERT_TRUE(slot.read(record));
+    TEST_ASSERT_EQUAL(2, record.time);
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, record.value);
+    TEST_ASSERT_EQUAL(2, slot.get_version());
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void run_all_spsc_queue_tests() {
+    RUN_TEST(test_queue_empty);
+    RUN_TEST(test_queue_fifo_order);
+    RUN_TEST(test_queue_full_drops);
+    RUN_TEST(test_queue_wraparound);
+    RUN_TEST(test_queue_batch_pop);
+
+    RUN_TEST(test_seqlock_unwritten);
+    RUN_TEST(test_seqlock_latest_value);
+}
@@ -0,0 +1,116 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/os/trace.h"
+
+
+using namespace std;
+using namespace Cesium;
+
+////////////////////////////////////////////////////////////
+//                    Test recording                      //
+////////////////////////////////////////////////////////////
+
+void test_trace_register_same_name() {
+    uint16_t id = Trace::register_event("test_trace_a");
+    TEST_ASSERT_NOT_EQUAL(Trace::INVALID_EVENT, id);
+
+    TEST_ASSERT_EQUAL(id, Trace::register_event("test_trace_a"));
+    TEST_ASSERT_NOT_EQUAL(id, Trace::register_event("test_trace_b"));
+}
+
+void test_trace_scope_records_begin_end() {
+    Trace::clear();
+    size_t core = xPortGetCoreID();
+    {
+        TRACE_SCOPE("test_trace_scope");
+    }
+    TRACE_INSTANT("test_trace_instant", 42);
+
+    TEST_ASSERT_EQUAL(3, Trace::get_event_count(core));
+
+    Trace::freeze();
+    vector<vector<uint8_t>> records = Trace::event_records(core);
+    Trace::resume();
+
+    TEST_ASSERT_EQUAL(1, records.size());
+    TEST_ASSERT_EQUAL((uint8_t)TraceRecord::EVENTS, records[0][0]);
+    TEST_ASSERT_EQUAL(core, records[0][1]);
+    TEST_ASSERT_EQUAL(4 + 3 * sizeof(TraceEvent), records[0].size());
+
+    TraceEvent events[3];
+    memcpy(events, records[0].data() + 4, sizeof(events));
+    TEST_ASSERT_EQUAL((uint8_t)TracePhase::BEGIN, events[0].phase);
+    TEST_ASSERT_EQUAL((uint8_t)TracePhase::END, events[1].phase);
+    TEST_ASSERT_EQUAL((uint8_t)TracePhase::INSTANT, events[2].phase);
+    TEST_ASSERT_EQUAL(42, events[2].arg);
+    TEST_ASSERT_EQUAL(events[0].event_id, events[1].event_id);
+}
+
+void test_trace_frozen_ignores_events() {
+    Trace::clear();
+    size_t core = xPortGetCoreID();
+
+    Trace::freeze();
+    TRACE_INSTANT("test_trace_frozen", 0);
+    TEST_ASSERT_EQUAL(0, Trace::get_event_count(core));
+
+    Trace::resume();
+    TRACE_INSTANT("test_trace_frozen", 0);
+    TEST_ASSERT_EQUAL(1, Trace::get_event_count(core));
+}
+
+void test_trace_ring_keeps_newest() {
+    Trace::clear();
+    size_t core = xPortGetCoreID();
+    uint16_t id = Trace::register_event("test_trace_ring");
+
+    for (uint32_t i = 0; i < Trace::RING_LENGTH + 10; i++) {
+        Trace::record(id, TracePhase::INSTANT, i);
+    }
+
+    Trace::freeze();
+    vector<vector<uint8_t>> records = Trace::event_records(core);
+    Trace::resume();
+
+    size_t total = 0;
+    for (auto& record : records) {
+        total += record[2] | (record[3] << 8);
+    }
+    TEST_ASSERT_EQUAL(Trace::RING_LENGTH, total);
+
+    // Oldest kept event is the 11th one recorded
+    TraceEvent first;
+    memcpy(&first, records[0].data() + 4, sizeof(first));
+    TEST_ASSERT_EQUAL(10, first.arg);
+}
+
+////////////////////////////////////////////////////////////
+//                    Test records                        //
+////////////////////////////////////////////////////////////
+
+void test_trace_name_records() {
+    Trace::register_event("test_trace_a");
+
+    vector<vector<uint8_t>> records = Trace::name_records();
+    TEST_ASSERT_GREATER_THAN(0, records.size());
+
+    size_t names = 0;
+    for (auto& record : records) {
+        TEST_ASSERT_EQUAL((uint8_t)TraceRecord::NAMES, record[0]);
+        names += record[3];
+    }
+    TEST_ASSERT_EQUAL(Trace::get_name_count(), names);
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void run_all_trace_tests() {
+    RUN_TEST(test_trace_register_same_name);
+    RUN_TEST(test_trace_scope_records_begin_end);
+    RUN_TEST(test_trace_frozen_ignores_events);
+    RUN_TEST(test_trace_ring_keeps_newest);
+    RUN_TEST(test_trace_name_records);
+}
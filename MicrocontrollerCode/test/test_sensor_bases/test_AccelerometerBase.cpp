@@ -4,6 +4,7 @@
 #include "common/drivers/sensor_bases/AccelerometerBase.h"
 #include "common/drivers/sensor_bases/MockBases.h"
 #include "common/math/vector.h"
+#include <esp_timer.h>
 
 using namespace std;
 using namespace Cesium::Sensor;
@@ -71,6 +72,19 @@ void test_accel_base_read() {
 
 }
 
+void test_accel_base_sample_time() {
+    MockAccelBase sensor;
+
+    uint64_t before_us = esp_timer_get_time();
+    TEST_ASSERT_TRUE(sensor.read());
+
+    TimedVector3 sample = sensor.get_accel_sample();
+    TEST_ASSERT_TRUE(sample.time_us >= before_us);
+    TEST_ASSERT_TRUE(sample.time_us <= (uint64_t)esp_timer_get_time());
+    TEST_ASSERT_EQUAL(sensor.get_sample_time_us(), sample.time_us);
+    TEST_ASSERT_EQUAL_FLOAT(2.0, sample.value[1][0]);
+}
+
 ////////////////////////////////////////////////////////////
 //                    Run all tests                       //
 ////////////////////////////////////////////////////////////
@@ -79,6 +93,7 @@ void test_all_accel_base() {
 
     RUN_TEST(test_accel_base_constructor);
     RUN_TEST(test_accel_base_read);
+    RUN_TEST(test_accel_base_sample_time);
 
     // RUN_TEST(test_interrupt); // The testing function doesn't work unless pin 25 is connected to 3v3
 
@@ -0,0 +1,97 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/drivers/sensor_bases/Calibration.h"
+#include "common/drivers/sensor_bases/ImuFifoBase.h"
+
+using namespace std;
+using namespace Cesium::Sensor;
+
+// Sensor x is body y, sensor y is body -x
+static const Matrix3<float> R_SENSOR_TO_BODY = {{{0, -1, 0}, {1, 0, 0}, {0, 0, 1}}};
+static const Matrix3<float> IDENTITY = {{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}};
+
+////////////////////////////////////////////////////////////
+//                       Folding                          //
+////////////////////////////////////////////////////////////
+
+void test_calibration_identity() {
+    Calibration3 calibration;
+    Vector3<float> raw = {{{1.5}, {-2.0}, {9.81}}};
+    Vector3<float> body;
+
+    calibration.apply(raw, body);
+    TEST_ASSERT_TRUE(matrix_float_equals(raw, body));
+}
+
+void test_calibration_rotation_and_bias() {
+    Vector3<float> bias = {{{0.1}, {0.2}, {0.3}}};
+    Calibration3 calibration(R_SENSOR_TO_BODY, bias);
+
+    // Bias comes off in the sensor frame, before the rotation
+    Vector3<float> raw = {{{1.1}, {0.2}, {10.11}}};
+    Vector3<float> body;
+    calibration.apply(raw, body);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 0, body[0][0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 1.0, body[1][0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 9.81, body[2][0]);
+}
+
+void test_calibration_scale_and_misalignment() {
+    Vector3<float> scale = {{{2}, {1}, {0.5}}};
+    Vector3<float> bias = {{{1}, {0}, {0}}};
+
+    // Sensor z leaks 10% into x
+    Matrix3<float> misalignment = {{{1, 0, 0.1}, {0, 1, 0}, {0, 0, 1}}};
+    Calibration3 calibration(IDENTITY, misalignment, scale, bias);
+
+    // (3 - 1) * 2 + 0.1 * (4 * 0.5) = 4.2
+    float raw[3] = {3, 1, 4};
+    float body[3];
+    calibration.apply(raw, body);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 4.2, body[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 1.0, body[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 2.0, body[2]);
+
+    // In place gives the same answer
+    calibration.apply(raw, raw);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 4.2, raw[0]);
+}
+
+void test_calibration_fifo_batch() {
+    Calibration3 calibration(R_SENSOR_TO_BODY, Vector3<float>{});
+    ImuFifoSample samples[4];
+
+    for (size_t i = 0; i < 4; i++) {
+        samples[i].time_us = i;
+        samples[i].accel_mps2[0] = i;
+        samples[i].accel_mps2[1] = 0;
+        samples[i].accel_mps2[2] = 9.81;
+        samples[i].w_rps[0] = -1.0f;
+    }
+
+    // Only the first three, and only the accel
+    calibration.apply_batch(reinterpret_cast<uint8_t*>(samples), offsetof(ImuFifoSample, accel_mps2), sizeof(ImuFifoSample), 3);
+
+    for (size_t i = 0; i < 3; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, 0, samples[i].accel_mps2[0]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, i, samples[i].accel_mps2[1]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, 9.81, samples[i].accel_mps2[2]);
+        TEST_ASSERT_EQUAL_FLOAT(-1.0, samples[i].w_rps[0]);
+        TEST_ASSERT_EQUAL(i, samples[i].time_us);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(3, samples[3].accel_mps2[0]);
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void test_all_calibration() {
+    RUN_TEST(test_calibration_identity);
+    RUN_TEST(test_calibration_rotation_and_bias);
+    RUN_TEST(test_calibration_scale_and_misalignment);
+    RUN_TEST(test_calibration_fifo_batch);
+}
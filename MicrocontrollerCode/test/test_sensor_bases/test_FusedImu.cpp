@@ -0,0 +1,139 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/gnc/FusedImu.h"
+#include "common/drivers/sensor_bases/MockBases.h"
+
+using namespace std;
+using namespace Cesium::Sensor;
+
+static const Vector3<float> GRAVITY = {{{0}, {0}, {9.81}}};
+static const Vector3<float> STILL = {{{0}, {0}, {0}}};
+
+////////////////////////////////////////////////////////////
+//                        Voting                          //
+////////////////////////////////////////////////////////////
+
+void test_fused_imu_vote() {
+    Vector3<float> values[3] = {
+        {{{0.01}, {0}, {0}}},
+        {{{-0.01}, {0.02}, {0}}},
+        {{{1.5}, {0}, {0}}},
+    };
+    bool keep[3];
+
+    TEST_ASSERT_EQUAL(2, FusedImu::vote(values, 3, 0.2, keep));
+    TEST_ASSERT_TRUE(keep[0]);
+    TEST_ASSERT_TRUE(keep[1]);
+    TEST_ASSERT_FALSE(keep[2]);
+
+    // Two can't be voted on
+    TEST_ASSERT_EQUAL(2, FusedImu::vote(values + 1, 2, 0.2, keep));
+}
+
+////////////////////////////////////////////////////////////
+//                        Fusion                          //
+////////////////////////////////////////////////////////////
+
+void test_fused_imu_inverse_variance() {
+    MockImuBase unit_a, unit_b;
+    FusedImu fused;
+
+    TEST_ASSERT_FALSE(fused.setup());
+    TEST_ASSERT_TRUE(fused.add_unit(&unit_a, &unit_a, 1.0, 1.0));
+    TEST_ASSERT_TRUE(fused.add_unit(&unit_b, &unit_b, 3.0, 1.0));
+    TEST_ASSERT_FALSE(fused.add_unit(&unit_b, &unit_b, 0, 1.0));
+    TEST_ASSERT_TRUE(fused.setup());
+
+    unit_a.inject_sample(1000, {{{1.0}, {0}, {9.81}}}, STILL);
+    unit_b.inject_sample(1000, {{{2.0}, {0}, {9.81}}}, STILL);
+
+    TEST_ASSERT_TRUE(fused.read());
+    TEST_ASSERT_EQUAL(1000, fused.get_sample_time_us());
+    TEST_ASSERT_EQUAL(0b11, fused.get_accel_mask());
+
+    // Weights 1 and 1/3
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 1.25, fused.get_accel_mps2()[0][0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 9.81, fused.get_accel_body_mps2()[2][0]);
+
+    // Nothing new
+    TEST_ASSERT_FALSE(fused.read());
+}
+
+void test_fused_imu_body_frame() {
+    MockImuBase unit;
+    FusedImu fused;
+
+    // Sensor x is body y, set on the unit like a driver's configure()
+    Matrix3<float> R_sensor_to_body = {{{0, -1, 0}, {1, 0, 0}, {0, 0, 1}}};
+    unit.set_accel_calibration(Calibration3(R_sensor_to_body, Vector3<float>{}));
+    unit.set_gyro_calibration(Calibration3(R_sensor_to_body, Vector3<float>{}));
+    fused.add_unit(&unit, &unit, 1.0, 1.0);
+
+    unit.inject_sample(500, {{{1.0}, {0}, {0}}}, {{{0.5}, {0}, {0}}});
+    TEST_ASSERT_TRUE(fused.read());
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 0, fused.get_accel_mps2()[0][0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 1.0, fused.get_accel_mps2()[1][0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 0.5, fused.get_w_rps()[1][0]);
+}
+
+void test_fused_imu_rejects_faulty_gyro() {
+    MockImuBase units[3];
+    FusedImu fused(2.0, 0.2);
+
+    for (auto& unit : units) {
+        fused.add_unit(&unit, &unit, 1.0, 1.0);
+    }
+
+    units[0].inject_sample(1000, GRAVITY, {{{0.10}, {0}, {0}}});
+    units[1].inject_sample(1000, GRAVITY, {{{0.12}, {0}, {0}}});
+    units[2].inject_sample(1000, GRAVITY, {{{3.00}, {0}, {0}}});
+
+    TEST_ASSERT_TRUE(fused.read());
+    TEST_ASSERT_EQUAL(0b011, fused.get_gyro_mask());
+    TEST_ASSERT_EQUAL(0b111, fused.get_accel_mask());
+    TEST_ASSERT_EQUAL(1, fused.get_gyro_rejections(2));
+    TEST_ASSERT_EQUAL(0, fused.get_accel_rejections(2));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 0.11, fused.get_w_rps()[0][0]);
+}
+
+////////////////////////////////////////////////////////////
+//                    Time alignment                      //
+////////////////////////////////////////////////////////////
+
+void test_fused_imu_aligns_rates() {
+    MockImuBase fast, slow;
+    FusedImu fused(2.0, 0.2, 20000);
+
+    fused.add_unit(&fast, &fast, 1.0, 1.0);
+    fused.add_unit(&slow, &slow, 1.0, 1.0);
+
+    fast.inject_sample(1000, {{{0}, {0}, {9.0}}}, STILL);
+    slow.inject_sample(1000, {{{0}, {0}, {9.0}}}, STILL);
+    TEST_ASSERT_TRUE(fused.read());
+
+    // The slow unit is held at the fast unit's newer time
+    fast.inject_sample(2250, {{{0}, {0}, {10.0}}}, STILL);
+    TEST_ASSERT_TRUE(fused.read());
+    TEST_ASSERT_EQUAL(2250, fused.get_sample_time_us());
+    TEST_ASSERT_EQUAL(0b11, fused.get_accel_mask());
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 9.5, fused.get_accel_mps2()[2][0]);
+
+    // Then left out once it is too old
+    fast.inject_sample(30000, {{{0}, {0}, {10.0}}}, STILL);
+    TEST_ASSERT_TRUE(fused.read());
+    TEST_ASSERT_EQUAL(0b01, fused.get_accel_mask());
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 10.0, fused.get_accel_mps2()[2][0]);
+}
+
+////////////////////////////////////////////////////////////
+//                    Run all tests                       //
+////////////////////////////////////////////////////////////
+
+void test_all_fused_imu() {
+    RUN_TEST(test_fused_imu_vote);
+    RUN_TEST(test_fused_imu_inverse_variance);
+    RUN_TEST(test_fused_imu_body_frame);
+    RUN_TEST(test_fused_imu_rejects_faulty_gyro);
+    RUN_TEST(test_fused_imu_aligns_rates);
+}
@@ -6,6 +6,7 @@
 #include "common/math/vector.h"
 #include <Wire.h>
 #include <SPI.h>
+#include <esp_timer.h>
 
 using namespace std;
 using namespace Cesium::Sensor;
@@ -99,6 +100,44 @@ void test_sensor_base_interrupt() {
 
 
 }
+////////////////////////////////////////////////////////////
+//                 Test Data-Ready                        //
+////////////////////////////////////////////////////////////
+
+void test_sensor_base_drdy_timestamp() {
+    MockSensorBase sensor;
+
+    // Mock interrupt source, the ISR is fired directly instead of by a pin
+    SensorBase::drdy_isr(&sensor);
+    uint64_t edge_us = esp_timer_get_time();
+    TEST_ASSERT_TRUE(sensor.is_drdy_pending());
+
+    delay(5);
+    TEST_ASSERT_TRUE(sensor.read());
+    TEST_ASSERT_FALSE(sensor.is_drdy_pending());
+
+    // Sample carries the edge time, not the read time
+    TEST_ASSERT_TRUE(sensor.get_sample_time_us() <= edge_us);
+    TEST_ASSERT_TRUE(edge_us - sensor.get_sample_time_us() < 1000);
+
+    // Without an edge the read time is used
+    TEST_ASSERT_TRUE(sensor.read());
+    TEST_ASSERT_TRUE(sensor.get_sample_time_us() >= edge_us + 5000);
+}
+
+void test_sensor_base_drdy_notify() {
+    MockSensorBase sensor;
+    uint32_t notify_bits = 0;
+
+    sensor.set_drdy_notify(xTaskGetCurrentTaskHandle(), 1UL << 2);
+    xTaskNotifyWait(0, UINT32_MAX, &notify_bits, 0);
+
+    SensorBase::drdy_isr(&sensor);
+
+    TEST_ASSERT_EQUAL(pdTRUE, xTaskNotifyWait(0, UINT32_MAX, &notify_bits, pdMS_TO_TICKS(10)));
+    TEST_ASSERT_EQUAL(1UL << 2, notify_bits);
+}
+
 ////////////////////////////////////////////////////////////
 //                    Run all tests                       //
 ////////////////////////////////////////////////////////////
@@ -111,6 +150,8 @@ void test_all_sensor_base() {
     RUN_TEST(test_sensor_base_set_spi);
     RUN_TEST(test_sensor_base_set_serial);
     RUN_TEST(test_sensor_base_read);
+    RUN_TEST(test_sensor_base_drdy_timestamp);
+    RUN_TEST(test_sensor_base_drdy_notify);
 
     // RUN_TEST(test_sensor_base_interrupt); // The testing function doesn't work unless pin 25 is connected to 3v3
 
@@ -18,6 +18,8 @@ void setup(){
     test_all_gyro_base();
     test_all_mag_base();
     test_all_gps_base();
+    test_all_calibration();
+    test_all_fused_imu();
     UNITY_END();
 }
 void loop(){}
\ No newline at end of file
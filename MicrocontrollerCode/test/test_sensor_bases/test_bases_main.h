@@ -3,4 +3,6 @@ void test_all_sensor_base();
 void test_all_accel_base();
 void test_all_gyro_base();
 void test_all_mag_base();
-void test_all_gps_base();
\ No newline at end of file
+void test_all_gps_base();
+void test_all_calibration();
+void test_all_fused_imu();
\ No newline at end of file
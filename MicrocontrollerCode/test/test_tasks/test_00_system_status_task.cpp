@@ -44,6 +44,7 @@ void test_all_system_routing() {
         {SystemStatusCMD::MCU_STATS, {}},
         {SystemStatusCMD::SYSTEM_UPDATE, {}},
         {SystemStatusCMD::SUM, {1,2}},
+        {SystemStatusCMD::TRACE_DUMP, {}},
         {SystemStatusCMD::NOT_IMPLEMENTED, {}}
     };
     for (auto command : commands) {
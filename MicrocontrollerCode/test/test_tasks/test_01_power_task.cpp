@@ -0,0 +1,64 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include <vector>
+
+#include "common/comms/PacketBroker.h"
+#include "common/telemetry_tasks/PowerTask.h"
+
+using namespace Cesium;
+using namespace std;
+
+// Never set up, so it never has a reading
+static Sensor::Ina233 battery_monitor(0x40);
+
+////////////////////////////////////////////////////////////
+//                         Setup                          //
+////////////////////////////////////////////////////////////
+
+// Testing topic 1 (POWER) command routing
+void test_01_packet_routed(pair<PowerCMD, vector<uint8_t> > command) {
+    BasePacket packet;
+
+    packet.configure((size_t) Topic::POWER, (size_t) command.first, command.second);
+    packet.packetize();
+
+    TEST_ASSERT_EQUAL(Topic::POWER, PacketBroker::route_packet(packet));
+    TEST_ASSERT_EQUAL(command.first, PowerTask::route_packet(packet));
+}
+
+void start_power() {
+    PowerTask::add_monitor(&battery_monitor, PowerTask::Rail::BATTERY);
+}
+
+////////////////////////////////////////////////////////////
+//                    Telemetry commands                  //
+////////////////////////////////////////////////////////////
+
+void test_power_routing() {
+    vector<std::pair<PowerCMD, std::vector<uint8_t>>> commands = {
+        {PowerCMD::BATTERY_STATS, {}},
+        {PowerCMD::GSE_STATS, {}},
+        {PowerCMD::BUS_STATS, {}},
+        {PowerCMD::POWER_STATES, {}},
+        {PowerCMD::BOARD_SWITCHES, {}},
+    };
+    for (auto command : commands) {
+        test_01_packet_routed(command);
+    }
+}
+
+void test_power_no_reading_yet() {
+    TEST_ASSERT_FALSE(PowerTask::send_rail_stats(PowerCMD::BATTERY_STATS, PowerTask::Rail::BATTERY));
+}
+
+void test_power_no_monitor_on_rail() {
+    TEST_ASSERT_FALSE(PowerTask::send_rail_stats(PowerCMD::GSE_STATS, PowerTask::Rail::GSE));
+}
+
+void run_all_power_tests() {
+    RUN_TEST(start_power);
+    RUN_TEST(test_power_routing);
+    RUN_TEST(test_power_no_reading_yet);
+    RUN_TEST(test_power_no_monitor_on_rail);
+}
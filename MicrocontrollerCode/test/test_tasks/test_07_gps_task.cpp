@@ -0,0 +1,90 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include <vector>
+
+#include "common/comms/PacketBroker.h"
+#include "common/telemetry_tasks/GpsTask.h"
+#include "common/drivers/sensor_bases/MockBases.h"
+
+using namespace Cesium;
+using namespace std;
+
+static Sensor::MockGpsBase mock_gps;
+
+////////////////////////////////////////////////////////////
+//                         Setup                          //
+////////////////////////////////////////////////////////////
+
+// Testing topic 7 (GPS) command routing
+void test_07_packet_routed(pair<GpsCMD, vector<uint8_t> > command) {
+    BasePacket packet;
+
+    packet.configure((size_t) Topic::GPS, (size_t) command.first, command.second);
+    packet.packetize();
+
+    TEST_ASSERT_EQUAL(Topic::GPS, PacketBroker::route_packet(packet));
+    TEST_ASSERT_EQUAL(command.first, GpsTask::route_packet(packet));
+}
+
+void start_gps() {
+    GpsTask::add_gps(&mock_gps);
+}
+
+////////////////////////////////////////////////////////////
+//                    Telemetry commands                  //
+////////////////////////////////////////////////////////////
+
+void test_gps_no_fix_yet() {
+    TEST_ASSERT_FALSE(GpsTask::send_basic_telem({0}));
+    TEST_ASSERT_FALSE(GpsTask::send_time_telem({0}));
+}
+
+void test_gps_routing() {
+    Sensor::GpsFix fix = {};
+    fix.fix_type = 3;
+    fix.satellites = 11;
+    fix.latitude_e7 = 340522000;
+    fix.longitude_e7 = -1182437000;
+    fix.height_msl_mm = 105000;
+    mock_gps.inject_fix(fix);
+
+    vector<std::pair<GpsCMD, std::vector<uint8_t>>> commands = {
+        {GpsCMD::BASIC_TELEM, {0}},
+        {GpsCMD::POSITION_ACCURACY, {0}},
+        {GpsCMD::SPEED_HEADING, {0}},
+        {GpsCMD::TIME_TELEM, {0}},
+        {GpsCMD::READ_REG, {}},
+        {GpsCMD::WRITE_REG, {}},
+    };
+    for (auto command : commands) {
+        test_07_packet_routed(command);
+    }
+
+    TEST_ASSERT_TRUE(GpsTask::send_basic_telem({0}));
+    TEST_ASSERT_TRUE(GpsTask::send_speed_heading({0}));
+}
+
+void test_gps_fix_fields() {
+    TEST_ASSERT_EQUAL(11, mock_gps.get_satellites_in_view());
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 34.0522, mock_gps.get_latitude_deg());
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 105.0, mock_gps.get_altitude_m());
+
+    Sensor::GpsFix fix;
+    TEST_ASSERT_TRUE(mock_gps.get_fix(fix));
+    TEST_ASSERT_EQUAL(-1182437000, fix.longitude_e7);
+    TEST_ASSERT_EQUAL(1, mock_gps.get_fix_count());
+}
+
+void test_gps_bad_id() {
+    TEST_ASSERT_FALSE(GpsTask::send_basic_telem({200}));
+    TEST_ASSERT_FALSE(GpsTask::send_position_accuracy({}));
+}
+
+void run_all_gps_tests() {
+    RUN_TEST(start_gps);
+    RUN_TEST(test_gps_no_fix_yet);
+    RUN_TEST(test_gps_routing);
+    RUN_TEST(test_gps_fix_fields);
+    RUN_TEST(test_gps_bad_id);
+}
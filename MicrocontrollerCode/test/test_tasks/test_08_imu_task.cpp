@@ -0,0 +1,127 @@
+#include <unity.h>
+#include <Arduino.h>
+
+#include "common/os/filesystem.h"
+#include <vector>
+
+#include "common/comms/PacketBroker.h"
+#include "common/telemetry_tasks/ImuTask.h"
+#include "common/drivers/sensor_bases/MockBases.h"
+
+using namespace Cesium;
+using namespace std;
+
+static FileSystem imu_filesystem;
+static Sensor::MockImuFifo mock_fifo;
+static Sensor::MockImuBase mock_imu;
+static Sensor::MockMagBase mock_mag;
+
+////////////////////////////////////////////////////////////
+//                         Setup                          //
+////////////////////////////////////////////////////////////
+
+// Testing topic 8 (IMU) command routing
+void test_08_packet_routed(pair<ImuCMD, vector<uint8_t> > command) {
+    BasePacket packet;
+
+    packet.configure((size_t) Topic::IMU, (size_t) command.first, command.second);
+    packet.packetize();
+
+    TEST_ASSERT_EQUAL(Topic::IMU, PacketBroker::route_packet(packet));
+    TEST_ASSERT_EQUAL(command.first, ImuTask::route_packet(packet));
+}
+
+void start_imu_fifo() {
+    TEST_ASSERT_TRUE(imu_filesystem.begin(true));
+
+    ImuTask::add_fifo(&mock_fifo);
+    ImuTask::attach_filesystem(&imu_filesystem);
+    TEST_ASSERT_TRUE(mock_fifo.configure_fifo(16));
+}
+
+////////////////////////////////////////////////////////////
+//                     TELEM command                      //
+////////////////////////////////////////////////////////////
+
+void test_telem_without_pipeline() {
+    ImuTask::add_accel(&mock_imu);
+    ImuTask::add_gyro(&mock_imu);
+    ImuTask::add_mag(&mock_mag);
+    mock_imu.inject_sample(1000, Vector3<float>{0, 0, 9.81f}, Vector3<float>{});
+
+    // No pipeline running, so the drivers are read right here
+    TEST_ASSERT_TRUE(ImuTask::create_telem_packet({0, 0, 0, (uint8_t)CoordFrame::Sensor}));
+}
+
+////////////////////////////////////////////////////////////
+//                     FIFO commands                      //
+////////////////////////////////////////////////////////////
+
+void test_fifo_routing() {
+    vector<std::pair<ImuCMD, std::vector<uint8_t>>> commands = {
+        {ImuCMD::FIFO_STATUS, {0}},
+        {ImuCMD::FIFO_READ, {0, (uint8_t)ImuTask::FifoReadMode::DRAIN}},
+    };
+    for (auto command : commands) {
+        test_08_packet_routed(command);
+    }
+}
+
+void test_fifo_bad_id() {
+    TEST_ASSERT_FALSE(ImuTask::send_fifo_status({200}));
+    TEST_ASSERT_FALSE(ImuTask::fifo_read({200, 0}));
+    TEST_ASSERT_FALSE(ImuTask::send_fifo_status({}));
+}
+
+void test_fifo_drain_to_file() {
+    String path = ImuTask::fifo_path(0);
+    imu_filesystem.deleteFile(path.c_str());
+
+    // More than one batch
+    mock_fifo.frames_waiting = 100;
+    TEST_ASSERT_TRUE(ImuTask::fifo_read({0, (uint8_t)ImuTask::FifoReadMode::DRAIN}));
+    TEST_ASSERT_EQUAL(0, mock_fifo.get_fifo_frames());
+
+    File file = LittleFS.open(path.c_str());
+    TEST_ASSERT_TRUE(file);
+    TEST_ASSERT_EQUAL(100 * sizeof(Sensor::ImuFifoSample), file.size());
+
+    Sensor::ImuFifoSample sample;
+    file.read((uint8_t*)&sample, sizeof(sample));
+    file.close();
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, sample.accel_mps2[0]);
+    TEST_ASSERT_EQUAL_FLOAT(-3.0f, sample.w_rps[2]);
+}
+
+void test_fifo_stream() {
+    String path = ImuTask::fifo_path(0);
+
+    TEST_ASSERT_TRUE(ImuTask::fifo_read({0, (uint8_t)ImuTask::FifoReadMode::START_STREAM}));
+
+    mock_fifo.frames_waiting = 10;
+    ImuTask::update();
+    mock_fifo.frames_waiting = 5;
+    ImuTask::update();
+
+    TEST_ASSERT_TRUE(ImuTask::fifo_read({0, (uint8_t)ImuTask::FifoReadMode::STOP_STREAM}));
+
+    // Not streaming anymore
+    mock_fifo.frames_waiting = 7;
+    ImuTask::update();
+    TEST_ASSERT_EQUAL(7, mock_fifo.get_fifo_frames());
+
+    File file = LittleFS.open(path.c_str());
+    TEST_ASSERT_EQUAL(15 * sizeof(Sensor::ImuFifoSample), file.size());
+    file.close();
+
+    imu_filesystem.deleteFile(path.c_str());
+}
+
+void run_all_imu_tests() {
+    RUN_TEST(start_imu_fifo);
+    RUN_TEST(test_fifo_routing);
+    RUN_TEST(test_telem_without_pipeline);
+    RUN_TEST(test_fifo_bad_id);
+    RUN_TEST(test_fifo_drain_to_file);
+    RUN_TEST(test_fifo_stream);
+}
@@ -1,3 +1,6 @@
 void run_all_system_status_tests();
+void run_all_power_tests();
 void run_all_clock_tests();
-void run_all_filesystem_tests();
\ No newline at end of file
+void run_all_filesystem_tests();
+void run_all_gps_tests();
+void run_all_imu_tests();
\ No newline at end of file
@@ -13,8 +13,11 @@ void setup(){
     Serial.begin(115200);
     UNITY_BEGIN();
     run_all_system_status_tests();
+    run_all_power_tests();
     run_all_clock_tests();
     run_all_filesystem_tests();
+    run_all_gps_tests();
+    run_all_imu_tests();
     UNITY_END();
 }
 void loop(){}
\ No newline at end of file
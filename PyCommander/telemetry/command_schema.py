@@ -38,6 +38,7 @@ class SystemStatusCMD(Enum):
     MCU_STATS = 5
     SYSTEM_UPDATE = 6
     SUM = 7
+    TRACE_DUMP = 8
 
 class PowerCMD(Enum):
     BATTERY_STATS = 0
@@ -5,6 +5,8 @@ from ..command_schema import Topic, SystemStatusCMD
 
 from .packet_task import PacketTask
 
+import struct
+
 
 
 class SystemStatusTask(PacketTask):
@@ -47,18 +49,100 @@ class SystemStatusTask(PacketTask):
 
             case SystemStatusCMD.MCU_STATS:
                 print("MCU_STATS")
-                pass
+                print(SystemStatusTask.decode_mcu_stats(packet.data))
 
             case SystemStatusCMD.SUM:
                 print("SUM")
                 pass
 
+            case SystemStatusCMD.TRACE_DUMP:
+                # Records are collected by trace_to_chrome.py
+                print("TRACE_DUMP")
+                pass
+
             case _:
                 print("Did not route packet")
                 return 
             
         return command
 
+    @staticmethod
+    def decode_mcu_stats(data: bytearray) -> dict:
+        """Decodes one MCU_STATS record (layouts in os/instrumentation.cpp, os/spi_bus.cpp and os/sensor_manager.cpp)"""
+
+        record_type = data[0]
+
+        if record_type == 0: # SYSTEM
+            uptime_ms, cpu_mhz, heap_free, heap_min_free, heap_size = struct.unpack_from("<5I", data, 1)
+            core_load = struct.unpack_from("<2f", data, 21)
+            probe_count = data[29]
+            task_count = data[30]
+
+            tasks = {}
+            i = 31
+            for _ in range(task_count):
+                name_len = data[i]
+                name = bytes(data[i + 1 : i + 1 + name_len]).decode()
+                i += 1 + name_len
+                (tasks[name],) = struct.unpack_from("<I", data, i)
+                i += 4
+
+            return {"type": "SYSTEM", "uptime_ms": uptime_ms, "cpu_mhz": cpu_mhz,
+                    "heap_free": heap_free, "heap_min_free": heap_min_free, "heap_size": heap_size,
+                    "core_load": core_load, "probe_count": probe_count, "stack_high_water": tasks}
+
+        if record_type == 1: # PROBE
+            probe_id = data[1]
+            name_len = data[2]
+            name = bytes(data[3 : 3 + name_len]).decode()
+            i = 3 + name_len
+            count, min_cycles, mean_cycles, max_cycles = struct.unpack_from("<4I", data, i)
+            buckets = data[i + 16]
+            histogram = list(struct.unpack_from(f"<{buckets}I", data, i + 17))
+
+            return {"type": "PROBE", "id": probe_id, "name": name, "count": count,
+                    "min_cycles": min_cycles, "mean_cycles": mean_cycles, "max_cycles": max_cycles,
+                    "histogram": histogram}
+
+        if record_type == 2: # SPI_BUS
+            host = data[1]
+            window_us, busy_us, cycles = struct.unpack_from("<3I", data, 2)
+            device_count = data[14]
+
+            devices = []
+            i = 15
+            for _ in range(device_count):
+                cs_pin = data[i]
+                clock_hz, transactions, total_bytes, mean_latency_us, max_latency_us = struct.unpack_from("<5I", data, i + 1)
+                devices.append({"cs_pin": cs_pin, "clock_hz": clock_hz, "transactions": transactions,
+                                "bytes": total_bytes, "mean_latency_us": mean_latency_us,
+                                "max_latency_us": max_latency_us})
+                i += 21
+
+            return {"type": "SPI_BUS", "host": host, "window_us": window_us, "busy_us": busy_us,
+                    "utilisation": busy_us / window_us if window_us else 0.0, "cycles": cycles,
+                    "devices": devices}
+
+        if record_type == 3: # SENSORS
+            window_us, bus_switches = struct.unpack_from("<2I", data, 1)
+            sensor_count = data[9]
+
+            sensors = []
+            i = 10
+            for _ in range(sensor_count):
+                interface, priority, mode = data[i], data[i + 1], data[i + 2]
+                interval_ms, reads, samples, failures, overruns, mean_latency_us, max_latency_us = struct.unpack_from("<7I", data, i + 3)
+                sensors.append({"interface": interface, "priority": priority, "polled": mode == 1,
+                                "interval_ms": interval_ms, "reads": reads, "samples": samples,
+                                "failures": failures, "overruns": overruns,
+                                "mean_latency_us": mean_latency_us, "max_latency_us": max_latency_us,
+                                "rate_hz": samples * 1e6 / window_us if window_us else 0.0})
+                i += 31
+
+            return {"type": "SENSORS", "window_us": window_us, "bus_switches": bus_switches, "sensors": sensors}
+
+        return {"type": "UNKNOWN", "record_type": record_type}
+
     # @staticmethod
     # def send_ack(method = "serial"):
         
@@ -0,0 +1,123 @@
+import json
+import struct
+
+# Record layouts are documented in MicrocontrollerCode/src/common/os/trace.cpp
+
+HEADER = 0
+NAMES = 1
+EVENTS = 2
+END = 3
+
+EVENT_FORMAT = "<IBBHI" # ccount, core, phase, event_id, arg
+EVENT_BYTES = struct.calcsize(EVENT_FORMAT)
+
+CCOUNT_WRAP = 1 << 32
+
+
+class TraceDump:
+
+    def __init__(self):
+        self.cpu_mhz = 240
+        self.event_counts = [0, 0]
+        self.sync_ccount = [0, 0]
+        self.sync_time_us = [0, 0]
+        self.names: dict[int, str] = {}
+        self.events: list[list[tuple]] = [[], []]
+        self.complete = False
+
+    def add_record(self, data: bytes) -> None:
+        """Adds one record, either a TRACE_DUMP packet payload or one entry of /trace.bin"""
+
+        record_type = data[0]
+
+        if record_type == HEADER:
+            self.cpu_mhz, = struct.unpack_from("<I", data, 1)
+            for core in range(2):
+                self.event_counts[core], self.sync_ccount[core], self.sync_time_us[core] = struct.unpack_from("<IIq", data, 5 + core * 16)
+
+        elif record_type == NAMES:
+            first_id, = struct.unpack_from("<H", data, 1)
+            count = data[3]
+            i = 4
+            for event_id in range(first_id, first_id + count):
+                name_len = data[i]
+                self.names[event_id] = bytes(data[i + 1 : i + 1 + name_len]).decode()
+                i += 1 + name_len
+
+        elif record_type == EVENTS:
+            core = data[1]
+            count, = struct.unpack_from("<H", data, 2)
+            for i in range(count):
+                self.events[core].append(struct.unpack_from(EVENT_FORMAT, data, 4 + i * EVENT_BYTES))
+
+        elif record_type == END:
+            self.complete = True
+
+    @staticmethod
+    def from_file(path: str) -> "TraceDump":
+        """Reads /trace.bin (u16 length-prefixed records)"""
+
+        dump = TraceDump()
+        with open(path, "rb") as file:
+            data = file.read()
+
+        i = 0
+        while i + 2 <= len(data):
+            length, = struct.unpack_from("<H", data, i)
+            dump.add_record(data[i + 2 : i + 2 + length])
+            i += 2 + length
+
+        return dump
+
+    def core_times_us(self, core: int) -> list[float]:
+        """Unwraps the 32-bit cycle counter and converts to esp_timer microseconds using the freeze sync point"""
+
+        times = []
+        base = 0
+        prev = None
+        for event in self.events[core]:
+            ccount = event[0]
+            if prev is not None and ccount < prev:
+                base += CCOUNT_WRAP
+            times.append(base + ccount)
+            prev = ccount
+
+        # Sync point was captured after the last event
+        sync = self.sync_ccount[core]
+        if prev is not None and sync < prev:
+            base += CCOUNT_WRAP
+        sync += base
+
+        if self.sync_time_us[core] == 0:
+            return [t / self.cpu_mhz for t in times]
+
+        return [self.sync_time_us[core] + (t - sync) / self.cpu_mhz for t in times]
+
+    def to_chrome(self) -> dict:
+        """Chrome Trace Event format, opens in chrome://tracing and ui.perfetto.dev"""
+
+        trace_events = []
+
+        for core in range(2):
+            trace_events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": core,
+                                 "args": {"name": f"core {core}"}})
+
+            for event, ts in zip(self.events[core], self.core_times_us(core)):
+                _, event_core, phase, event_id, arg = event
+                chrome_event = {
+                    "name": self.names.get(event_id, f"event_{event_id}"),
+                    "ph": chr(phase),
+                    "ts": ts,
+                    "pid": 0,
+                    "tid": event_core,
+                }
+                if chr(phase) == "i":
+                    chrome_event["s"] = "t"
+                    chrome_event["args"] = {"arg": arg}
+                trace_events.append(chrome_event)
+
+        return {"traceEvents": trace_events, "displayTimeUnit": "ns"}
+
+    def write_chrome(self, path: str) -> None:
+        with open(path, "w") as file:
+            json.dump(self.to_chrome(), file)
@@ -0,0 +1,64 @@
+import struct
+
+from telemetry.trace import TraceDump, HEADER, NAMES, EVENTS, END
+
+
+def header(cpu_mhz, counts, sync_ccount, sync_time_us, name_count):
+    data = bytearray([HEADER]) + struct.pack("<I", cpu_mhz)
+    for core in range(2):
+        data += struct.pack("<IIq", counts[core], sync_ccount[core], sync_time_us[core])
+    return data + struct.pack("<H", name_count)
+
+def names(first_id, name_list):
+    data = bytearray([NAMES]) + struct.pack("<HB", first_id, len(name_list))
+    for name in name_list:
+        data += bytearray([len(name)]) + name.encode()
+    return data
+
+def events(core, event_list):
+    data = bytearray([EVENTS, core]) + struct.pack("<H", len(event_list))
+    for ccount, phase, event_id, arg in event_list:
+        data += struct.pack("<IBBHI", ccount, core, ord(phase), event_id, arg)
+    return data
+
+
+def test_decode_records():
+    dump = TraceDump()
+    dump.add_record(header(240, [2, 1], [0, 0], [0, 0], 2))
+    dump.add_record(names(0, ["Bmi323::read", "late"]))
+    dump.add_record(events(0, [(240, "B", 0, 0), (480, "E", 0, 0)]))
+    dump.add_record(events(1, [(720, "i", 1, 55)]))
+    dump.add_record(bytearray([END]))
+
+    assert dump.complete
+    assert dump.names == {0: "Bmi323::read", 1: "late"}
+    assert dump.core_times_us(0) == [1.0, 2.0]
+
+    chrome = dump.to_chrome()["traceEvents"]
+    instants = [e for e in chrome if e["ph"] == "i"]
+    assert len(instants) == 1
+    assert instants[0]["name"] == "late"
+    assert instants[0]["tid"] == 1
+    assert instants[0]["args"]["arg"] == 55
+
+def test_ccount_wraparound_and_sync():
+    dump = TraceDump()
+    # Second event wraps the 32-bit counter, sync point 240 cycles (1 us) after it at t = 1000 us
+    dump.add_record(header(240, [2, 0], [480, 0], [1000, 0], 0))
+    dump.add_record(events(0, [(0xFFFFFFFF - 239, "B", 0, 0), (240, "E", 0, 0)]))
+
+    times = dump.core_times_us(0)
+    assert times[1] == 999.0
+    assert abs((times[1] - times[0]) - 2.0) < 1e-6
+
+def test_from_file(tmp_path):
+    records = [header(240, [1, 0], [0, 0], [0, 0], 1), names(0, ["x"]), events(0, [(10, "i", 0, 1)]), bytearray([END])]
+
+    path = tmp_path / "trace.bin"
+    with open(path, "wb") as file:
+        for record in records:
+            file.write(struct.pack("<H", len(record)) + record)
+
+    dump = TraceDump.from_file(str(path))
+    assert dump.complete
+    assert len(dump.events[0]) == 1
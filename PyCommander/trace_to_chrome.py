@@ -0,0 +1,55 @@
+from telemetry.topic_packets import *
+from telemetry.serial_comms import DEFAULT_PORT
+from telemetry.trace import TraceDump
+from time import sleep, time
+import sys
+
+# Usage:
+#   python trace_to_chrome.py trace.bin out.json   Converts a /trace.bin pulled off the filesystem
+#   python trace_to_chrome.py out.json             Sends TRACE_DUMP over serial and converts the reply
+# Open out.json in chrome://tracing or ui.perfetto.dev
+
+
+def dump_over_serial(timeout_s: float = 10) -> TraceDump:
+
+    ports = DEFAULT_PORT.list_ports(print_output=True)
+    port_num = int(input("Which port to connect to: "))
+
+    port_name = f"/dev/{ports[port_num].name}"
+    DEFAULT_PORT.connect(port_name)
+    DEFAULT_PORT.restart_port()
+
+    packet = SystemStatusPacket()
+    packet.configure(SystemStatusCMD.TRACE_DUMP, bytearray([0]))
+    packet.packetize()
+    DEFAULT_PORT.emit_packet(packet)
+
+    dump = TraceDump()
+    start = time()
+
+    while not dump.complete and time() - start < timeout_s:
+        while DEFAULT_PORT.port.in_waiting > 0:
+            received_packet = BasePacket.depacketize(DEFAULT_PORT.readline())
+
+            if received_packet.topic == Topic.SYSTEM_STATUS.value and received_packet.command == SystemStatusCMD.TRACE_DUMP.value:
+                dump.add_record(received_packet.data)
+        sleep(0.01)
+
+    if not dump.complete:
+        print("Timed out before END record, trace may be partial")
+
+    return dump
+
+
+if __name__ == "__main__":
+
+    if len(sys.argv) == 3:
+        dump = TraceDump.from_file(sys.argv[1])
+    elif len(sys.argv) == 2:
+        dump = dump_over_serial()
+    else:
+        print("Usage: trace_to_chrome.py [trace.bin] out.json")
+        sys.exit(1)
+
+    dump.write_chrome(sys.argv[-1])
+    print(f"Wrote {sum(len(events) for events in dump.events)} events to {sys.argv[-1]}")